@@ -25,3 +25,4 @@ from .value import *
 from .vector import *
 from .mesh import *
 real = geode_wrap.real
+index_dtype = geode_wrap.index_dtype
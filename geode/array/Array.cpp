@@ -5,8 +5,9 @@
 #include <geode/vector/Vector.h>
 namespace geode {
 
-void out_of_bounds(const type_info& type, const int size, const int i) {
-  throw IndexError(format("array index out of bounds: type %s, len %d, index %d",type.name(),size,i));
+void out_of_bounds(const type_info& type, const index_t size, const index_t i) {
+  throw IndexError(format("array index out of bounds: type %s, len %lld, index %lld",type.name(),
+                          (long long)size,(long long)i));
 }
 
 ARRAY_CONVERSIONS(1,bool)
@@ -70,8 +70,8 @@ private:
   friend class Array<const Element>;
   struct Unusable{};
 
-  int m_;
-  int max_size_; // buffer size
+  index_t m_;
+  index_t max_size_; // buffer size
   T* data_;
   PyObject* owner_; // python object that owns the buffer
 public:
@@ -79,7 +79,7 @@ public:
   Array()
     : m_(0), max_size_(0), data_(0), owner_(0) {}
 
-  explicit Array(const int m_)
+  explicit Array(const index_t m_)
     : m_(m_), max_size_(m_) {
     assert(m_>=0);
     Buffer* buffer = Buffer::new_<T>(m_);
@@ -88,11 +88,11 @@ public:
     if (IsScalarVectorSpace<T>::value)
       memset((void*)data_,0,m_*sizeof(T));
     else
-      for (int i=0;i<m_;i++)
+      for (index_t i=0;i<m_;i++)
         const_cast<Element*>(data_)[i] = T();
   }
 
-  explicit Array(const int m_, Uninit)
+  explicit Array(const index_t m_, Uninit)
     : m_(m_), max_size_(m_) {
     assert(m_>=0);
     auto buffer = Buffer::new_<T>(m_);
@@ -100,10 +100,10 @@ public:
     owner_ = (PyObject*)buffer;
   }
 
-  explicit Array(const Vector<int,d> sizes)
+  explicit Array(const Vector<index_t,d> sizes)
     : Array(sizes.x) {}
 
-  explicit Array(const Vector<int,d> sizes, Uninit)
+  explicit Array(const Vector<index_t,d> sizes, Uninit)
     : Array(sizes.x,uninit) {}
 
   Array(const Array& source)
@@ -136,13 +136,13 @@ public:
     owner_ = array.owner();
   }
 
-  Array(const int m_, T* data, PyObject* owner)
+  Array(const index_t m_, T* data, PyObject* owner)
     : m_(m_), max_size_(m_), data_(data), owner_(owner) {
     assert(owner_ || !data_);
     GEODE_XINCREF(owner_);
   }
 
-  Array(const Vector<int,1> sizes, T* data, PyObject* owner)
+  Array(const Vector<index_t,1> sizes, T* data, PyObject* owner)
     : Array(sizes.x,data,owner) {}
 
   ~Array() {
@@ -153,30 +153,30 @@ public:
     return RawArray<T>(m_,data_);
   }
 
-  int size() const {
+  index_t size() const {
     return m_;
   }
 
-  int total_size() const {
+  index_t total_size() const {
     return m_;
   }
 
-  Vector<int,1> sizes() const {
-    return Vector<int,1>(m_);
+  Vector<index_t,1> sizes() const {
+    return Vector<index_t,1>(m_);
   }
 
-  T& operator[](const int i) const {
-    assert(unsigned(i)<unsigned(m_));
+  T& operator[](const index_t i) const {
+    assert(uindex_t(i)<uindex_t(m_));
     return data_[i];
   }
 
-  T& operator()(const int i) const {
-    assert(unsigned(i)<unsigned(m_));
+  T& operator()(const index_t i) const {
+    assert(uindex_t(i)<uindex_t(m_));
     return data_[i];
   }
 
-  bool valid(const int i) const {
-    return unsigned(i)<unsigned(m_);
+  bool valid(const index_t i) const {
+    return uindex_t(i)<uindex_t(m_);
   }
 
   T* data() const {
@@ -192,7 +192,7 @@ public:
     return owner_;
   }
 
-  int max_size() const {
+  index_t max_size() const {
     return max_size_;
   }
 
@@ -242,12 +242,12 @@ public:
   template<class TArray> void copy(const TArray& source) {
     // Copy data from source array even if it is shareable
     STATIC_ASSERT_SAME(T,typename TArray::value_type);
-    const int source_m = source.size();
+    const index_t source_m = source.size();
     m_ = 0;
     if (max_size_<source_m)
       grow_buffer(source_m);
     if (!same_array(*this,source))
-      for (int i=0;i<source_m;i++)
+      for (index_t i=0;i<source_m;i++)
         data_[i] = source[i];
     m_ = source_m;
   }
@@ -255,19 +255,19 @@ public:
   template<class TArray> void copy(const TArray& source) const {
     // Const, so no resizing allowed
     STATIC_ASSERT_SAME(T,typename TArray::value_type);
-    const int source_m = source.size();
+    const index_t source_m = source.size();
     assert(m_==source_m);
     if (!same_array(*this,source))
-      for (int i=0;i<source_m;i++)
+      for (index_t i=0;i<source_m;i++)
         data_[i] = source[i];
   }
 
 private:
-  void grow_buffer(const int max_size_new) {
+  void grow_buffer(const index_t max_size_new) {
     if (max_size_>=max_size_new) return;
     Buffer* new_owner = Buffer::new_<T>(max_size_new);
-    const int m_ = this->m_; // Teach compiler that m_ is constant
-    for (int i=0;i<m_;i++)
+    const index_t m_ = this->m_; // Teach compiler that m_ is constant
+    for (index_t i=0;i<m_;i++)
       ((Element*)new_owner->data)[i] = data_[i];
     GEODE_XDECREF(owner_);
     max_size_ = max_size_new;
@@ -276,30 +276,30 @@ private:
   }
 public:
 
-  void preallocate(const int m_new) GEODE_ALWAYS_INLINE {
+  void preallocate(const index_t m_new) GEODE_ALWAYS_INLINE {
     if(max_size_<m_new)
       grow_buffer(geode::max(4*max_size_/3+2,m_new));
   }
 
-  void resize(const int m_new) {
+  void resize(const index_t m_new) {
     preallocate(m_new);
     if (m_new>m_) {
       if (IsScalarVectorSpace<T>::value)
         memset((void*)(data_+m_),0,(m_new-m_)*sizeof(T));
       else
-        for (int i=m_;i<m_new;i++) data_[i] = T();
+        for (index_t i=m_;i<m_new;i++) data_[i] = T();
     }
     m_ = m_new;
   }
 
-  void resize(const int m_new, Uninit) GEODE_ALWAYS_INLINE {
+  void resize(const index_t m_new, Uninit) GEODE_ALWAYS_INLINE {
     preallocate(m_new);
     m_ = m_new;
   }
 
-  void exact_resize(const int m_new) { // Zero elbow room
+  void exact_resize(const index_t m_new) { // Zero elbow room
     if (m_==m_new) return;
-    int m_end = geode::min(m_,m_new);
+    index_t m_end = geode::min(m_,m_new);
     if (max_size_!=m_new) {
       Buffer* new_owner = Buffer::new_<T>(m_new);
       std::copy(data_,data_+m_end,(Element*)new_owner->data);
@@ -312,15 +312,15 @@ public:
       if (IsScalarVectorSpace<T>::value)
         memset((void*)(data_+m_end),0,(m_new-m_end)*sizeof(T));
       else
-        for (int i=m_end;i<m_new;i++)
+        for (index_t i=m_end;i<m_new;i++)
           data_[i] = T();
     }
     m_ = m_new;
   }
 
-  void exact_resize(const int m_new, Uninit) { // Zero elbow room
+  void exact_resize(const index_t m_new, Uninit) { // Zero elbow room
     if (m_==m_new) return;
-    int m_end = geode::min(m_,m_new);
+    index_t m_end = geode::min(m_,m_new);
     if (max_size_!=m_new) {
       Buffer* new_owner = Buffer::new_<T>(m_new);
       std::copy(data_,data_+m_end,(Element*)new_owner->data);
@@ -337,12 +337,12 @@ public:
       exact_resize(m_);
   }
 
-  RawArray<T> reshape(int m_new) const {
+  RawArray<T> reshape(index_t m_new) const {
     assert(m_new==m_);
     return RawArray<T>(m_new,data());
   }
 
-  const Array<T>& reshape_own(int m_new) const {
+  const Array<T>& reshape_own(index_t m_new) const {
     assert(m_new==m_);
     return *this;
   }
@@ -375,7 +375,7 @@ public:
     return reshape_own(new_sizes.x,new_sizes.y,new_sizes.z);
   }
 
-  int append(const T& element) GEODE_ALWAYS_INLINE {
+  index_t append(const T& element) GEODE_ALWAYS_INLINE {
     if (m_<max_size_)
       data_[m_++] = element;
     else {
@@ -386,12 +386,12 @@ public:
     return m_-1;
   }
 
-  int append(Uninit) GEODE_ALWAYS_INLINE {
+  index_t append(Uninit) GEODE_ALWAYS_INLINE {
     preallocate(m_+1);
     return m_++;
   }
 
-  int append_assuming_enough_space(const T& element) GEODE_ALWAYS_INLINE {
+  index_t append_assuming_enough_space(const T& element) GEODE_ALWAYS_INLINE {
     assert(m_<max_size_);
     data_[m_++] = element;
     return m_-1;
@@ -399,10 +399,10 @@ public:
 
   template<class TA> void extend(const TA& extra) {
     STATIC_ASSERT_SAME(Element,typename remove_const<typename TA::value_type>::type);
-    const int append_m = extra.size(),
-              m_new = m_+append_m;
+    const index_t append_m = extra.size(),
+                  m_new = m_+append_m;
     preallocate(m_new);
-    for (int i=0;i<append_m;i++)
+    for (index_t i=0;i<append_m;i++)
       geode::const_cast_(data_[m_+i]) = extra[i];
     m_ = m_new;
   }
@@ -410,8 +410,8 @@ public:
   template<class U> void extend(const std::initializer_list<U>& extra) {
     // Perhaps this should be combined with the implementation above, but ConstantMap (and maybe others) don't support begin/end
     STATIC_ASSERT_SAME(Element,typename remove_const<U>::type);
-    const int append_m = extra.size(),
-              m_new = m_+append_m;
+    const index_t append_m = extra.size(),
+                  m_new = m_+append_m;
     preallocate(m_new);
     auto* out = data_ + m_;
     for(const auto& e : extra) {
@@ -424,23 +424,23 @@ public:
 
   template<class TA> void extend_assuming_enough_space(const TA& extra) {
     STATIC_ASSERT_SAME(Element,typename remove_const<typename TA::value_type>::type);
-    const int append_m = extra.size(),
-              m_new = m_+append_m;
+    const index_t append_m = extra.size(),
+                  m_new = m_+append_m;
     assert(m_new <= max_size_);
-    for (int i=0;i<append_m;i++)
+    for (index_t i=0;i<append_m;i++)
       geode::const_cast_(data_[m_+i]) = extra[i];
     m_ = m_new;
   }
 
-  int extend(const int n, Uninit) GEODE_ALWAYS_INLINE {
-    const int m_old = m_,
-              m_new = m_+n;
+  index_t extend(const index_t n, Uninit) GEODE_ALWAYS_INLINE {
+    const index_t m_old = m_,
+                  m_new = m_+n;
     preallocate(m_new);
     m_ = m_new;
     return m_old;
   }
 
-  void extend_assuming_enough_space(const int n, Uninit) GEODE_ALWAYS_INLINE {
+  void extend_assuming_enough_space(const index_t n, Uninit) GEODE_ALWAYS_INLINE {
     assert(n >= 0);
     m_ += n;
     assert(m_ <= max_size_);
@@ -459,33 +459,33 @@ public:
 
   template<class TArray> void append_unique_elements(const TArray& append_array) {
     STATIC_ASSERT_SAME(T,typename TArray::value_type);
-    int append_m = append_array.size();
-    for (int i=0;i<append_m;i++)
+    index_t append_m = append_array.size();
+    for (index_t i=0;i<append_m;i++)
       append_unique(append_array(i));
   }
 
-  void remove_index(const int index) { // Preserves ordering of remaining elements
-    assert(unsigned(index)<unsigned(m_));
-    for (int i=index;i<m_-1;i++)
+  void remove_index(const index_t index) { // Preserves ordering of remaining elements
+    assert(uindex_t(index)<uindex_t(m_));
+    for (index_t i=index;i<m_-1;i++)
       data_[i] = data_[i+1];
     m_--;
   }
 
-  void remove_index_lazy(const int index) { // Fill holes with back()
-    assert(unsigned(index)<unsigned(m_));
+  void remove_index_lazy(const index_t index) { // Fill holes with back()
+    assert(uindex_t(index)<uindex_t(m_));
     data_[index] = data_[--m_];
   }
 
   void remove_first_lazy(T const &k) {
-    int idx = Base::find(k);
+    index_t idx = Base::find(k);
     if (idx != -1)
       remove_index_lazy(idx);
   }
 
-  void insert(const T& element, const int index) {
+  void insert(const T& element, const index_t index) {
     preallocate(m_+1);
     m_++;
-    for (int i=m_-1;i>index;i--)
+    for (index_t i=m_-1;i>index;i--)
       data_[i] = data_[i-1];
     data_[index] = element;
   }
@@ -495,7 +495,7 @@ public:
     return data_[--m_];
   }
 
-  Array<const T> pop_elements(const int count) { // Return value shares ownership with original
+  Array<const T> pop_elements(const index_t count) { // Return value shares ownership with original
     static_assert(is_trivially_destructible<T>::value,"");
     assert(m_-count>=0);
     m_ -= count;
@@ -514,13 +514,13 @@ public:
     return *(const Array<const Element>*)this;
   }
 
-  RawArray<T> slice(int lo,int hi) const {
-    assert(unsigned(lo)<=unsigned(hi) && unsigned(hi)<=unsigned(m_));
+  RawArray<T> slice(index_t lo,index_t hi) const {
+    assert(uindex_t(lo)<=uindex_t(hi) && uindex_t(hi)<=uindex_t(m_));
     return RawArray<T>(hi-lo,data_+lo);
   }
 
-  Array<T> slice_own(int lo,int hi) const {
-    assert(unsigned(lo)<=unsigned(hi) && unsigned(hi)<=unsigned(m_));
+  Array<T> slice_own(index_t lo,index_t hi) const {
+    assert(uindex_t(lo)<=uindex_t(hi) && uindex_t(hi)<=uindex_t(m_));
     return Array(hi-lo,data_+lo,owner_);
   }
 
@@ -543,7 +543,7 @@ public:
 
   template<class T2> typename disable_if<is_same<T2,Element>,Array<T2>>::type as() const {
     Array<typename remove_const<T2>::type> copy(m_,uninit);
-    for (int i=0;i<m_;i++) copy[i] = T2(data_[i]);
+    for (index_t i=0;i<m_;i++) copy[i] = T2(data_[i]);
     return copy;
   }
 };
@@ -561,8 +561,8 @@ template<class T,int d>   static inline const RawArray<T>       asarray(Vector<T
 template<class T,int d>   static inline const RawArray<const T> asarray(const Vector<T,d>& v)      { return RawArray<const T>(d,v.begin()); }
 template<class T>         static inline const RawArray<T>&      asarray(const RawArray<T>& v)      { return v; }
 template<class T>         static inline const RawArray<T>       asarray(const Array<T>& v)         { return v; }
-template<class T,class A> static inline const RawArray<T>       asarray(std::vector<T,A>& v)       { assert(v.size() <= std::numeric_limits<int>::max()); return RawArray<T>(int(v.size()),&v[0]); }
-template<class T,class A> static inline const RawArray<const T> asarray(const std::vector<T,A>& v) { assert(v.size() <= std::numeric_limits<int>::max()); return RawArray<const T>(int(v.size()),&v[0]); }
+template<class T,class A> static inline const RawArray<T>       asarray(std::vector<T,A>& v)       { assert(v.size() <= std::numeric_limits<index_t>::max()); return RawArray<T>(index_t(v.size()),&v[0]); }
+template<class T,class A> static inline const RawArray<const T> asarray(const std::vector<T,A>& v) { assert(v.size() <= std::numeric_limits<index_t>::max()); return RawArray<const T>(index_t(v.size()),&v[0]); }
 template<class T,class A> static inline const A&                asarray(const ArrayBase<T,A>& v)   { return v.derived(); }
 
 template<class T,int d>   static inline const RawArray<const T> asconstarray(T (&v)[d])                 { return RawArray<const T>(d,v); }
@@ -48,7 +48,7 @@ template<class TArray> struct SameArrayCanonical<TArray,TArray> { static bool sa
 template<class TA1,class TA2> struct SameArray : public SameArrayCanonical<typename CanonicalizeConstArray<TA1>::type,typename CanonicalizeConstArray<TA2>::type>{};
 
 // Throw IndexError with nice formatting.  Defined in Array.cpp
-GEODE_CORE_EXPORT void GEODE_NORETURN(out_of_bounds(const type_info& type, const int size, const int i)) GEODE_COLD;
+GEODE_CORE_EXPORT void GEODE_NORETURN(out_of_bounds(const type_info& type, const index_t size, const index_t i)) GEODE_COLD;
 
 template<class T_,class TArray>
 class ArrayBase {
@@ -61,8 +61,8 @@ public:
   typedef T value_type;
   typedef T_* iterator;
   typedef T_* const_iterator;
-  typedef int difference_type;
-  typedef int size_type;
+  typedef index_t difference_type;
+  typedef index_t size_type;
 
   typedef typename ScalarPolicy<T>::type Scalar;
 
@@ -91,11 +91,11 @@ public:
 protected:
   TArray& operator=(const ArrayBase& source) {
     TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     const TArray& source_ = source.derived();
     assert(m==source_.size());
     if (!TArray::same_array(self,source_))
-      for (int i=0;i<m;i++)
+      for (index_t i=0;i<m;i++)
         self[i] = source_[i];
     return self;
   }
@@ -103,10 +103,10 @@ protected:
   template<class TArray1> TArray& operator=(const TArray1& source) {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     assert(m==source.size());
     if (!TArray::same_array(self,source))
-      for (int i=0;i<m;i++)
+      for (index_t i=0;i<m;i++)
         self[i] = source[i];
     return self;
   }
@@ -141,9 +141,9 @@ public:
   template<class TArray1> bool operator==(const TArray1& v) const {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     if (m!=v.size()) return false;
-    for (int i=0;i<m;i++) if(self[i]!=v[i]) return false;
+    for (index_t i=0;i<m;i++) if(self[i]!=v[i]) return false;
     return true;
   }
 
@@ -154,65 +154,65 @@ public:
   template<class T1,class TArray1> const TArray& operator+=(const ArrayBase<T1,TArray1>& v) const {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     const TArray1& v_ = v.derived();
     assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] += v_[i];
+    for (index_t i=0;i<m;i++) self[i] += v_[i];
     return self;
   }
 
   const TArray& operator+=(const T& a) const { // This could be merged with the version below if windows wasn't broken
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) self[i] += a;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] += a;
     return self;
   }
 
   template<class T2> typename enable_if<IsScalar<T2>,const TArray&>::type operator+=(const T2& a) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) self[i] += a;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] += a;
     return self;
   }
 
   template<class T1,class TArray1> const TArray& operator-=(const ArrayBase<T1,TArray1>& v) const {
     STATIC_ASSERT_SAME(T,typename TArray1::Element);
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     const TArray1& v_ = v.derived();
     assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] -= v_[i];
+    for (index_t i=0;i<m;i++) self[i] -= v_[i];
     return self;
   }
 
   template<class T2> typename enable_if<mpl::or_<IsScalar<T2>,is_same<T,T2> >,const TArray&>::type operator-=(const T2& a) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) self[i] -= a;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] -= a;
     return self;
   }
 
   template<class T2,class TArrayT2> const TArray& operator*=(const ArrayBase<T2,TArrayT2>& v) const {
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     const TArrayT2& v_ = v.derived();
     assert(m==v_.size());
-    for (int i=0;i<m;i++) self[i] *= v_[i];
+    for (index_t i=0;i<m;i++) self[i] *= v_[i];
     return self;
   }
 
   template<class T2> typename enable_if<mpl::or_<IsScalar<T2>,is_same<T,T2> >,const TArray&>::type operator*=(const T2& a) const {
-    const TArray& self = derived();int m = self.size();
-    for (int i=0;i<m;i++) self[i] *= a;
+    const TArray& self = derived();index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] *= a;
     return self;
   }
 
   template<class T2,class TArrayT2> const TArray& operator/=(const ArrayBase<T2,TArrayT2>& a) const {
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     const TArrayT2& a_ = a.derived();
     assert(m==a_.size());
-    for (int i=0;i<m;i++) {
+    for (index_t i=0;i<m;i++) {
       assert(a_(i));
       self[i] /= a_[i];
     }
@@ -225,8 +225,8 @@ public:
 
   void negate() const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) self[i] = -self[i];
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] = -self[i];
   }
 
   T_& front() const {
@@ -238,55 +238,55 @@ public:
     return self[self.size()-1];
   }
 
-  int find(const T& element) const {
+  index_t find(const T& element) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) if (self[i]==element) return i;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) if (self[i]==element) return i;
     return -1;
   }
 
   bool contains(const T& element) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) if (self[i]==element) return true;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) if (self[i]==element) return true;
     return false;
   }
 
   bool contains_only(const T& element) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) if (self[i]!=element) return false;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) if (self[i]!=element) return false;
     return true;
   }
 
-  int count_matches(const T& value) const {
+  index_t count_matches(const T& value) const {
     const TArray& self = derived();
-    int m = self.size();
-    int count = 0;
-    for (int i=0;i<m;i++) if (self[i]==value) count++;
+    index_t m = self.size();
+    index_t count = 0;
+    for (index_t i=0;i<m;i++) if (self[i]==value) count++;
     return count;
   }
 
-  int count_true() const {
+  index_t count_true() const {
     const TArray& self = derived();
-    int m = self.size();
-    int count = 0;
-    for (int i=0;i<m;i++) if (self[i]) count++;
+    index_t m = self.size();
+    index_t count = 0;
+    for (index_t i=0;i<m;i++) if (self[i]) count++;
     return count;
   }
 
-  int count_false() const {
+  index_t count_false() const {
     const TArray& self = derived();
-    int m = self.size();
-    int count = 0;
-    for (int i=0;i<m;i++) if (!self[i]) count++;
+    index_t m = self.size();
+    index_t count = 0;
+    for (index_t i=0;i<m;i++) if (!self[i]) count++;
     return count;
   }
 
   void fill(const T& constant) const {
     const TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m;i++) self[i] = constant;
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) self[i] = constant;
   }
 
   Array<Element> copy() const {
@@ -322,86 +322,86 @@ public:
   T max() const {
     const TArray& self = derived();
     T result = self[0];
-    int m = self.size();
-    for (int i=1;i<m;i++) result = geode::max(result,self[i]);
+    index_t m = self.size();
+    for (index_t i=1;i<m;i++) result = geode::max(result,self[i]);
     return result;
   }
 
   T maxabs() const {
     const TArray& self = derived();
     T result = T();
-    int m = self.size();
-    for (int i=0;i<m;i++) result = geode::max(result,abs(self[i]));
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result = geode::max(result,abs(self[i]));
     return result;
   }
 
   T maxmag() const {
     const TArray& self = derived();
     T result = T();
-    int m = self.size();
-    for (int i=1;i<m;i++) result = geode::maxmag(result,self[i]);
+    index_t m = self.size();
+    for (index_t i=1;i<m;i++) result = geode::maxmag(result,self[i]);
     return result;
   }
 
-  int argmax() const {
+  index_t argmax() const {
     const TArray& self = derived();
-    int result = 0,
-        m = self.size();
-    for (int i=1;i<m;i++) if (self[i]>self[result]) result = i;
+    index_t result = 0,
+            m = self.size();
+    for (index_t i=1;i<m;i++) if (self[i]>self[result]) result = i;
     return result;
   }
 
   T min() const {
     const TArray& self = derived();
     T result = self[0];
-    int m = self.size();
-    for (int i=1;i<m;i++) result = geode::min(result,self[i]);
+    index_t m = self.size();
+    for (index_t i=1;i<m;i++) result = geode::min(result,self[i]);
     return result;
   }
 
   T minmag() const {
     const TArray& self = derived();
     T result = self[0];
-    int m = self.size();
-    for (int i=1;i<m;i++) result = geode::minmag(result,self[i]);
+    index_t m = self.size();
+    for (index_t i=1;i<m;i++) result = geode::minmag(result,self[i]);
     return result;
   }
 
-  int argmin() const {
+  index_t argmin() const {
     const TArray& self = derived();
-    int result = 0,
-        m = self.size();
-    for (int i=1;i<m;i++) if (self[i]<self[result]) result = i;
+    index_t result = 0,
+            m = self.size();
+    for (index_t i=1;i<m;i++) if (self[i]<self[result]) result = i;
     return result;
   }
 
   T sum() const {
     const TArray& self = derived();
     T result = T();
-    int m = self.size();
-    for (int i=0;i<m;i++) result += self[i];
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result += self[i];
     return result;
   }
 
   T product() const {
     const TArray& self = derived();
     T result = 1;
-    int m = self.size();
-    for (int i=0;i<m;i++) result *= self[i];
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result *= self[i];
     return result;
   }
 
   T mean() const {
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     return m?sum()/Scalar(m):T();
   }
 
   Scalar sqr_magnitude() const {
     const TArray& self = derived();
     Scalar result = 0;
-    int m = self.size();
-    for (int i=0;i<m;i++) result += geode::sqr_magnitude(self[i]);
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result += geode::sqr_magnitude(self[i]);
     return result;
   }
 
@@ -413,16 +413,16 @@ private:
   Scalar min_magnitude_helper(mpl::true_ is_scalar) const {
     const TArray& self = derived();
     T result = std::numeric_limits<T>::infinity();
-    int m = self.size();
-    for (int i=0;i<m;i++) result=geode::min(result,abs(self[i]));
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result=geode::min(result,abs(self[i]));
     return result;
   }
 
   Scalar max_magnitude_helper(mpl::true_ is_scalar) const {
     const TArray& self = derived();
     T result = 0;
-    int m = self.size();
-    for (int i=0;i<m;i++) result=geode::max(result,abs(self[i]));
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result=geode::max(result,abs(self[i]));
     return result;
   }
 
@@ -445,25 +445,25 @@ private:
   Scalar min_sqr_magnitude_helper(mpl::false_ is_scalar) const {
     const TArray& self = derived();
     Scalar result = std::numeric_limits<Scalar>::infinity();
-    int m = self.size();
-    for (int i=0;i<m;i++) result = geode::min(result,self[i].sqr_magnitude());
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result = geode::min(result,self[i].sqr_magnitude());
     return result;
   }
 
   Scalar max_sqr_magnitude_helper(mpl::false_ is_scalar) const {
     const TArray& self = derived();
     Scalar result = 0;
-    int m = self.size();
-    for (int i=0;i<m;i++) result = geode::max(result,self[i].sqr_magnitude());
+    index_t m = self.size();
+    for (index_t i=0;i<m;i++) result = geode::max(result,self[i].sqr_magnitude());
     return result;
   }
 
-  int argmax_magnitude_helper(mpl::true_ is_scalar) const {
+  index_t argmax_magnitude_helper(mpl::true_ is_scalar) const {
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     Scalar max = -1;
-    int argmax = -1;
-    for (int i=0;i<m;i++) {
+    index_t argmax = -1;
+    for (index_t i=0;i<m;i++) {
       Scalar current = abs(self[i]);
       if (max<current) {
         max = current;
@@ -473,12 +473,12 @@ private:
     return argmax;
   }
 
-  int argmax_magnitude_helper(mpl::false_ is_scalar) const {
+  index_t argmax_magnitude_helper(mpl::false_ is_scalar) const {
     const TArray& self = derived();
-    int m = self.size();
+    index_t m = self.size();
     Scalar max = -1;
-    int argmax = -1;
-    for (int i=0;i<m;i++) {
+    index_t argmax = -1;
+    for (index_t i=0;i<m;i++) {
       Scalar current = self[i].sqr_magnitude();
       if (max<current) {
         max = current;
@@ -505,23 +505,23 @@ public:
     return max_sqr_magnitude_helper(IsScalar<T>());
   }
 
-  int argmax_magnitude() const {
+  index_t argmax_magnitude() const {
     return argmax_magnitude_helper(IsScalar<T>());
   }
 
   template<class TArray1> void remove_sorted_indices(const TArray1& index) {
     STATIC_ASSERT_SAME(int,typename TArray1::Element);
     TArray& self = derived();
-    int m = self.size(),
-        index_m = index.size();
+    index_t m = self.size(),
+            index_m = index.size();
     if (!index_m) return;
     for (int kk=0;kk<index_m-1;kk++) {
-      assert(unsigned(index(kk))<unsigned(index(kk+1)));
-      for (int i=index(kk)-kk;i<index(kk+1)-kk-1;i++)
+      assert(uindex_t(index(kk))<uindex_t(index(kk+1)));
+      for (index_t i=index(kk)-kk;i<index(kk+1)-kk-1;i++)
         self[i] = self[i+kk];
     }
-    assert(unsigned(index(index_m-1))<unsigned(m));
-    for (int i=index(index_m)-index_m;i<m-index_m;i++)
+    assert(uindex_t(index(index_m-1))<uindex_t(m));
+    for (index_t i=index(index_m)-index_m;i<m-index_m;i++)
       self[i] = self[i+index_m];
     self.resize(m-index_m);
   }
@@ -538,8 +538,8 @@ public:
 
   void reverse() {
     TArray& self = derived();
-    int m = self.size();
-    for (int i=0;i<m/2;i++) swap(self[i],self[m-1-i]);
+    index_t m = self.size();
+    for (index_t i=0;i<m/2;i++) swap(self[i],self[m-1-i]);
   }
 
   T_* begin() const { // for stl
@@ -550,10 +550,10 @@ public:
     return derived().data()+derived().size();
   }
 
-  T& at(const int i) const {
+  T& at(const index_t i) const {
     const TArray& self = derived();
-    const int m = self.size();
-    if (unsigned(i) >= unsigned(m))
+    const index_t m = self.size();
+    if (uindex_t(i) >= uindex_t(m))
       out_of_bounds(typeid(T),m,i);
     return self[i];
   }
@@ -561,8 +561,8 @@ public:
 
 template<class T,class TArray> inline bool isnan(const ArrayBase<T,TArray>& a_) {
   const TArray& a = a_.derived();
-  int m = a.size();
-  for (int i=0;i<m;i++)
+  index_t m = a.size();
+  for (index_t i=0;i<m;i++)
     if (isnan(a[i])) return true;
   return false;
 }
@@ -585,8 +585,8 @@ template<class T,class TArray1,class TArray2> inline typename ScalarPolicy<T>::t
   const TArray2& a2 = a2_.derived();
   assert(a1.size()==a2.size());
   Scalar result = 0;
-  int m = a1.size();
-  for (int i=0;i<m;i++) result += geode::dot(a1[i],a2[i]);
+  index_t m = a1.size();
+  for (index_t i=0;i<m;i++) result += geode::dot(a1[i],a2[i]);
   return result;
 }
 
@@ -600,8 +600,8 @@ inner_product(const ArrayBase<TM,TArray1>& m_, const ArrayBase<T,TArray2>& a1_,
                 &a2 = a2_.derived();
   assert(a1.size()==a2.size());
   Scalar result=0;
-  int size = a1.size();
-  for (int i=0;i<size;i++) result += m[i]*geode::dot(a1[i],a2[i]);
+  index_t size = a1.size();
+  for (index_t i=0;i<size;i++) result += m[i]*geode::dot(a1[i],a2[i]);
   return result;
 }
 
@@ -612,17 +612,17 @@ inner_product(const ArrayBase<TM,TArray1>& m_,const ArrayBase<T,TArray2>& a1_,co
   const TArray2 &a1 = a1_.derived(),
                 &a2 = a2_.derived();
   Scalar result = 0;
-  int size = a1.size();
+  index_t size = a1.size();
   assert(m.size()==size && a2.size()==size);
-  for (int i=0;i<size;i++) result += m(i).inner_product(a1[i],a2[i]);
+  for (index_t i=0;i<size;i++) result += m(i).inner_product(a1[i],a2[i]);
   return result;
 }
 
 template<class T,class TArray> inline std::ostream& operator<<(std::ostream& output, const ArrayBase<T,TArray>& a) {
   const TArray& a_ = a.derived();
-  const int m = a_.size();
+  const index_t m = a_.size();
   output << '[';
-  for (int i=0;i<m;i++) {
+  for (index_t i=0;i<m;i++) {
     if (i)
       output << ',';
     output << a_[i];
@@ -642,8 +642,8 @@ template<class T0,class T1,class TA0,class TA1> Array<typename remove_const<T0>:
   STATIC_ASSERT_SAME(typename remove_const<T0>::type, typename remove_const<T1>::type);
   const auto& a0 = a0_.derived();
   const auto& a1 = a1_.derived();
-  const int m0 = a0.size(),
-            m1 = a1.size();
+  const index_t m0 = a0.size(),
+                m1 = a1.size();
   Array<typename remove_const<T0>::type> result(m0+m1,uninit);
   result.slice(0,m0) = a0;
   result.slice(m0,m0+m1) = a1;
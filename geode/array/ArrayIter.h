@@ -4,21 +4,22 @@
 #pragma once
 
 #include <geode/array/forward.h>
+#include <geode/utility/config.h>
 #include <geode/utility/type_traits.h>
 #include <iterator>
 namespace geode {
 
 template<class TArray> class ArrayIter {
   const TArray* array;
-  int index;
+  index_t index;
 public:
   typedef std::random_access_iterator_tag iterator_category;
   typedef decltype(declval<TArray>()[0]) reference;
   typedef typename remove_reference<reference>::type value_type;
-  typedef int difference_type;
+  typedef index_t difference_type;
   typedef value_type* pointer;
 
-  ArrayIter(const TArray& array, int index)
+  ArrayIter(const TArray& array, index_t index)
     : array(&array), index(index) {}
 
   ArrayIter& operator++() {
@@ -37,15 +38,15 @@ public:
     return ArrayIter(*array,index--);
   }
 
-  ArrayIter operator+(int n) const {
+  ArrayIter operator+(index_t n) const {
     return ArrayIter(*array,index+n);
   }
 
-  ArrayIter operator-(int n) const {
+  ArrayIter operator-(index_t n) const {
     return ArrayIter(*array,index-n);
   }
 
-  int operator-(ArrayIter other) const {
+  index_t operator-(ArrayIter other) const {
     return index-other.index; // Assume array==other.array
   }
 
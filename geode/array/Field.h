@@ -40,16 +40,16 @@ public:
   Field(typename mpl::if_c<is_const,const Field<Element,Id>&,Unusable>::type source)
     : flat(source.flat) {}
 
-  explicit Field(const int n)
+  explicit Field(const index_t n)
     : flat(n) {}
 
-  explicit Field(const int n, Uninit)
+  explicit Field(const index_t n, Uninit)
     : flat(n,uninit) {}
 
   explicit Field(const Array<T>& source)
     : flat(source) {}
 
-  Field(const Hashtable<Id,T>& source, const int size, const T def = T())
+  Field(const Hashtable<Id,T>& source, const index_t size, const T def = T())
     : flat(size,uninit) {
     flat.fill(def);
     for (const auto& p : source)
@@ -66,7 +66,7 @@ public:
     return *this;
   }
 
-  int size() const {
+  index_t size() const {
     return flat.size();
   }
 
@@ -112,11 +112,11 @@ public:
     flat.extend(append_array);
   }
 
-  void extend(const int n, Uninit) GEODE_ALWAYS_INLINE {
+  void extend(const index_t n, Uninit) GEODE_ALWAYS_INLINE {
     flat.extend(n,uninit);
   }
 
-  void preallocate(const int m_new) GEODE_ALWAYS_INLINE {
+  void preallocate(const index_t m_new) GEODE_ALWAYS_INLINE {
     flat.preallocate(m_new);
   }
 
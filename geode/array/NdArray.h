@@ -54,18 +54,15 @@ public:
     : shape(source.shape), flat(source.flat) {}
 
   NdArray(const Array<T>& array)
-    : flat(array) {
-    Array<int> shape_;
-    shape_.copy(array.sizes());
-    shape = shape_;
-  }
+    : shape(asarray(vec(int(array.size()))).copy())
+    , flat(array) {}
 
   template<int d> NdArray(const Array<T,d>& array)
     : shape(asarray(array.sizes()).copy())
     , flat(array.flat) {}
 
   template<int m> NdArray(const Array<Vector<T,m>>& array)
-    : shape(asarray(vec(array.size(),m)).copy())
+    : shape(asarray(vec(int(array.size()),m)).copy())
     , flat(m*array.size(),reinterpret_cast<T*>(array.data()),array.borrow_owner()) {}
 
   template<class TArray1> bool operator==(const TArray1& v) const {
@@ -6,10 +6,10 @@
 #include <geode/python/Class.h>
 namespace geode {
 
-Array<int> nested_array_offsets(RawArray<const int> lengths) {
-  Array<int> offsets(lengths.size()+1,uninit);
+Array<index_t> nested_array_offsets(RawArray<const int> lengths) {
+  Array<index_t> offsets(lengths.size()+1,uninit);
   offsets[0] = 0;
-  for (int i=0;i<lengths.size();i++) {
+  for (index_t i=0;i<lengths.size();i++) {
     GEODE_ASSERT(lengths[i]>=0);
     offsets[i+1] = offsets[i]+lengths[i];
   }
@@ -14,7 +14,7 @@ namespace geode {
 
 using std::ostream;
 GEODE_CORE_EXPORT bool is_nested_array(PyObject* object);
-GEODE_CORE_EXPORT Array<int> nested_array_offsets(RawArray<const int> lengths);
+GEODE_CORE_EXPORT Array<index_t> nested_array_offsets(RawArray<const int> lengths);
 
 template<class T,bool frozen> // frozen=true
 class Nested {
@@ -23,8 +23,9 @@ public:
   typedef typename Array<T>::Element Element;
   template<class S,bool f> struct Compatible { static const bool value = is_same<Element,typename remove_const<S>::type>::value && is_const<T>::value>=is_const<S>::value; };
 
-  // When growing an array incrementally via append or extend, set frozen=false to make offsets mutable.
-  typedef Array<typename mpl::if_c<frozen,const int,int>::type> Offsets;
+  // When growing an array incrementally via append or extend, set frozen=false to make offsets mutable.  Offsets
+  // use index_t, so the total size may exceed 2^31 in index=int64 builds, but each subarray's length is an int.
+  typedef Array<typename mpl::if_c<frozen,const index_t,index_t>::type> Offsets;
 
   Offsets offsets;
   Array<T> flat;
@@ -85,13 +86,13 @@ public:
   }
 
   template<class TA> static Nested copy(const TA& other) {
-    const int n = (int)other.size();
-    Array<int> offsets(n+1,uninit);
+    const index_t n = (index_t)other.size();
+    Array<index_t> offsets(n+1,uninit);
     offsets[0] = 0;
-    for (int i=0;i<n;i++)
-      offsets[i+1] = offsets[i]+(int)other[i].size();
+    for (index_t i=0;i<n;i++)
+      offsets[i+1] = offsets[i]+(index_t)other[i].size();
     Array<Element> flat(offsets[n],uninit);
-    for (int i=0;i<n;i++)
+    for (index_t i=0;i<n;i++)
       flat.slice(offsets[i],offsets[i+1]) = other[i];
     Nested self;
     self.offsets = offsets;
@@ -99,49 +100,52 @@ public:
     return self;
   }
 
-  int size() const {
+  index_t size() const {
     return offsets.size()-1;
   }
 
-  int size(int i) const {
-    return offsets[i+1]-offsets[i];
+  int size(index_t i) const {
+    return int(offsets[i+1]-offsets[i]);
   }
 
   bool empty() const {
     return !size();
   }
 
-  bool valid(int i) const {
-    return unsigned(i)<unsigned(size());
+  bool valid(index_t i) const {
+    return uindex_t(i)<uindex_t(size());
   }
 
-  bool valid(int i,int j) const {
+  bool valid(index_t i,int j) const {
     return valid(i) && unsigned(j)<unsigned(size(i));
   }
 
-  int total_size() const {
+  index_t total_size() const {
     return offsets.back();
   }
 
   Array<int> sizes() const {
-    return (offsets.slice(1,offsets.size())-offsets.slice(0,offsets.size()-1)).copy();
+    Array<int> sizes(size(),uninit);
+    for (index_t i=0;i<sizes.size();i++)
+      sizes[i] = int(offsets[i+1]-offsets[i]);
+    return sizes;
   }
 
-  Range<int> range(int i) const {
-    return Range<int>(offsets[i],offsets[i+1]);
+  Range<index_t> range(index_t i) const {
+    return Range<index_t>(offsets[i],offsets[i+1]);
   }
 
-  T& operator()(int i,int j) const {
-    int index = offsets[i]+j;
+  T& operator()(index_t i,int j) const {
+    const index_t index = offsets[i]+j;
     assert(0<=j && index<=offsets[i+1]);
     return flat[index];
   }
 
-  RawArray<T> operator[](int i) const {
+  RawArray<T> operator[](index_t i) const {
     return flat.slice(offsets[i],offsets[i+1]);
   }
 
-  Array<T> own(int i) const {
+  Array<T> own(index_t i) const {
     return flat.slice_own(offsets[i],offsets[i+1]);
   }
 
@@ -233,7 +237,7 @@ public:
 
 template<class T,bool f> inline ostream& operator<<(ostream& output, const Nested<T,f>& a) {
   output << '[';
-  for (int i=0;i<a.size();i++) {
+  for (index_t i=0;i<a.size();i++) {
     if (i)
       output << ',';
     output << a[i];
@@ -21,7 +21,7 @@ class NestedField {
   NestedField(Nested<T>&& _raw) : raw(_raw) {}
   NestedField(RawField<const int,Id> lengths) : raw(lengths.flat) {}
   NestedField(RawField<const int,Id> lengths, Uninit) : raw(lengths.flat, uninit) {}
-  NestedField(const Field<const int, Id> offsets, const Array<T>& flat) : raw(offsets.flat, flat) {}
+  NestedField(const Field<const index_t,Id> offsets, const Array<T>& flat) : raw(offsets.flat, flat) {}
 
   template<class S,class Id2> static NestedField empty_like(const NestedField<S,Id2>& other) {
     return NestedField(Nested<T>::empty_like(other.raw));
@@ -31,21 +31,21 @@ class NestedField {
     return NestedField(Nested<T>::empty_like(other));
   }
 
-  int size() const { return raw.size(); }
+  index_t size() const { return raw.size(); }
   int size(const Id i) const { return raw.size(i.idx()); }
   bool empty() const { return raw.empty(); }
   bool valid(const Id i) const { return raw.valid(i.idx()); }
-  int total_size() const { return raw.total_size(); }
+  index_t total_size() const { return raw.total_size(); }
   Field<int, Id> sizes() const { return Field<int,Id>{raw.sizes()}; }
   T& operator()(const Id i, const int j) const { return raw(i.idx(),j); }
   RawArray<T> operator[](const Id i) const { return raw[i.idx()]; }
 
   // return index into raw.flat for (*this)[i].front()
-  int front_offset(const Id i) const { return raw.offsets[i.idx()]; }
+  index_t front_offset(const Id i) const { return raw.offsets[i.idx()]; }
   // return index into raw.flat for (*this)[i].back()
-  int back_offset(const Id i) const { return raw.offsets[i.idx()+1]-1; }
+  index_t back_offset(const Id i) const { return raw.offsets[i.idx()+1]-1; }
   // return range of indices into raw.flat for (*this)[i]
-  Range<int> offset_range(const Id i) const { return raw.range(i.idx()); }
+  Range<index_t> offset_range(const Id i) const { return raw.range(i.idx()); }
 
   Range<IdIter<Id>> id_range() const { return range(IdIter<Id>(Id(0)),IdIter<Id>(Id(size()))); }
 };
@@ -44,7 +44,7 @@ private:
 
   T* const data_;
 public:
-  const int m;
+  const index_t m;
 
   RawArray()
     : data_(0), m(0) {}
@@ -70,9 +70,9 @@ public:
     : Base(), data_(source.data_), m(source.m) {}
 
   RawArray(typename CopyConst<std::vector<Element,std::allocator<Element> >,T>::type& source)
-    : Base(), data_(source.size()?&source[0]:0), m((int)source.size()) {}
+    : Base(), data_(source.size()?&source[0]:0), m((index_t)source.size()) {}
 
-  RawArray(const int m, T* data)
+  RawArray(const index_t m, T* data)
     : data_(data), m(m) {}
 
   const RawArray& operator=(const RawArray& source) const {
@@ -82,31 +82,31 @@ public:
   }
 
   template<class TArray> const RawArray& operator=(const TArray& source) const {
-    assert(size()==(int)source.size());
-    for (int i=0;i<m;i++) data_[i] = source[i];
+    assert(size()==(index_t)source.size());
+    for (index_t i=0;i<m;i++) data_[i] = source[i];
     return *this;
   }
 
-  int size() const {
+  index_t size() const {
     return m;
   }
 
-  Vector<int,1> sizes() const {
-    return Vector<int,1>(m);
+  Vector<index_t,1> sizes() const {
+    return Vector<index_t,1>(m);
   }
 
-  T& operator()(const int i) const {
-    assert(unsigned(i)<unsigned(m));
+  T& operator()(const index_t i) const {
+    assert(uindex_t(i)<uindex_t(m));
     return data_[i];
   }
 
-  T& operator[](const int i) const {
-    assert(unsigned(i)<unsigned(m));
+  T& operator[](const index_t i) const {
+    assert(uindex_t(i)<uindex_t(m));
     return data_[i];
   }
 
-  bool valid(const int i) const {
-    return unsigned(i)<unsigned(m);
+  bool valid(const index_t i) const {
+    return uindex_t(i)<uindex_t(m);
   }
 
   T* data() const {
@@ -122,8 +122,8 @@ public:
     return vec(i);
   }
 
-  RawArray slice(int lo, int hi) const {
-    assert(unsigned(lo)<=unsigned(hi) && unsigned(hi)<=unsigned(m));
+  RawArray slice(index_t lo, index_t hi) const {
+    assert(uindex_t(lo)<=uindex_t(hi) && uindex_t(hi)<=uindex_t(m));
     return RawArray(hi-lo,data_+lo);
   }
 
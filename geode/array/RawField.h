@@ -50,7 +50,7 @@ public:
   explicit RawField(RawArray<T> flat)
     : flat(flat) {}
 
-  int size() const {
+  index_t size() const {
     return flat.size();
   }
 
@@ -14,7 +14,7 @@ class Nested(object):
   """
 
   __slots__ = ['offsets','flat']
-  single_zero = zeros(1,dtype=int32)
+  single_zero = zeros(1,dtype=geode_wrap.index_dtype)
 
   def __init__(self,x,dtype=None):
     if isinstance(x,Nested):
@@ -22,13 +22,13 @@ class Nested(object):
       flat = x.flat
     elif isinstance(x,ndarray):
       assert x.ndim>=2
-      offsets = x.shape[1]*arange(x.shape[0]+1,dtype=int32)
+      offsets = x.shape[1]*arange(x.shape[0]+1,dtype=geode_wrap.index_dtype)
       flat = x.reshape(-1,*x.shape[2:])
     elif len(x) == 0:
       offsets = self.single_zero
       flat = []
     else:
-      offsets = hstack([self.single_zero,cumsum([len(y) for y in x],dtype=int32)])
+      offsets = hstack([self.single_zero,cumsum([len(y) for y in x],dtype=geode_wrap.index_dtype)])
       flat = concatenate(x)
     object.__setattr__(self,"offsets",offsets)
     object.__setattr__(self,"flat",ascontiguousarray(flat,dtype=dtype))
@@ -45,7 +45,7 @@ class Nested(object):
     lengths = asarray(lengths)
     assert all(lengths>=0)
     self = object.__new__(Nested)
-    object.__setattr__(self,'offsets',hstack([self.single_zero,cumsum(lengths,dtype=int32)]))
+    object.__setattr__(self,'offsets',hstack([self.single_zero,cumsum(lengths,dtype=geode_wrap.index_dtype)]))
     self.offsets.setflags(write=False)
     object.__setattr__(self,'flat',zeros(self.offsets[-1],dtype=dtype))
     return self
@@ -55,7 +55,7 @@ class Nested(object):
     lengths = asarray(lengths)
     assert all(lengths>=0)
     self = object.__new__(Nested)
-    object.__setattr__(self,'offsets',hstack([self.single_zero,cumsum(lengths,dtype=int32)]))
+    object.__setattr__(self,'offsets',hstack([self.single_zero,cumsum(lengths,dtype=geode_wrap.index_dtype)]))
     self.offsets.setflags(write=False)
     object.__setattr__(self,'flat',empty(self.offsets[-1],dtype=dtype))
     return self
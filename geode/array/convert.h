@@ -62,14 +62,16 @@ template<class T> Nested<T> FromPython<Nested<T>>::convert(PyObject* object) {
     // Already a Python Nested object, so conversion is easy
     const auto fields = nested_array_from_python_helper(object);
     Nested<T> self;
-    self.offsets = from_python<Array<const int>>(fields.x);
+    self.offsets = from_python<Array<const index_t>>(fields.x);
     self.flat = from_python<Array<T>>(fields.y);
     return self;
   } else if (is_numpy_array(object)) {
     // 2D numpy arrays can be handled more quickly than general sequences of sequences
     const auto data = from_python<Array<T,2>>(object);
-    const auto offsets = data.n*arange(data.m+1);
-    return Nested<T>(offsets.copy(),data.flat);
+    Array<index_t> offsets(data.m+1,uninit);
+    for (int i=0;i<=data.m;i++)
+      offsets[i] = index_t(data.n)*i;
+    return Nested<T>(offsets,data.flat);
   } else {
     // Convert via an array of arrays
     return Nested<T>::copy(from_python<vector<Array<T>>>(object));
@@ -5,6 +5,8 @@
 #include <geode/array/Nested.h>
 #include <geode/python/numpy.h>
 #include <geode/python/wrap.h>
+#include <geode/utility/time.h>
+#include <memory>
 using namespace geode;
 
 namespace {
@@ -68,6 +70,69 @@ Nested<const int> nested_convert_test(Nested<const int> a) {
   return a;
 }
 
+// Allocate many arrays inside an ArenaScope, letting one of them escape
+Array<int> arena_test(const int count) {
+  ArenaScope scope(4096);
+  Array<int> escaped;
+  for (int i=0;i<count;i++) {
+    Array<int> a(1+i%50,uninit);
+    a.fill(i);
+    if (i==count/2)
+      escaped = a;
+  }
+  return escaped;
+}
+
+// Allocate and free count arrays of the given positive size, optionally inside an ArenaScope
+int64_t allocation_test(const int count, const int size, const bool arena) {
+  GEODE_ASSERT(size>0);
+  std::unique_ptr<ArenaScope> scope(arena ? new ArenaScope : 0);
+  int64_t sum = 0;
+  for (int i=0;i<count;i++) {
+    Array<int> a(size,uninit);
+    a[size-1] = i;
+    sum += a[size-1];
+  }
+  return sum;
+}
+
+// Time the index_t heavy loops which index=int64 might slow down: appending count doubles, summing them, and writing
+// and reading a Nested with count/8 rows.  Returns seconds for each phase.
+Vector<real,4> index_test(const int count) {
+  GEODE_ASSERT(count>=0);
+  Vector<real,4> times;
+  double start = get_time();
+  Array<double> a;
+  for (int i=0;i<count;i++)
+    a.append(i);
+  times[0] = get_time()-start;
+  start = get_time();
+  double sum = 0;
+  for (const auto x : a)
+    sum += x;
+  times[1] = get_time()-start;
+  GEODE_ASSERT(sum==.5*count*(count-1.));
+  start = get_time();
+  Nested<int,false> nested;
+  int64_t expected = 0;
+  for (int i=0;i<count/8;i++) {
+    nested.append(Array<int>());
+    for (int j=0;j<i%16;j++) {
+      nested.append_to_back(j);
+      expected += j;
+    }
+  }
+  times[2] = get_time()-start;
+  start = get_time();
+  int64_t total = 0;
+  for (const auto row : nested)
+    for (const int x : row)
+      total += x;
+  times[3] = get_time()-start;
+  GEODE_ASSERT(nested.size()==count/8 && total==expected);
+  return times;
+}
+
 #ifdef GEODE_PYTHON
 
 ssize_t base_refcnt(PyObject* array) {
@@ -95,6 +160,9 @@ void wrap_array() {
   GEODE_FUNCTION(nested_test)
   GEODE_FUNCTION(nested_convert_test)
   GEODE_FUNCTION(const_array_test)
+  GEODE_FUNCTION(arena_test)
+  GEODE_FUNCTION(allocation_test)
+  GEODE_FUNCTION(index_test)
 #ifdef GEODE_PYTHON
   GEODE_FUNCTION(base_refcnt)
   GEODE_FUNCTION(array_write_test)
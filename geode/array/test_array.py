@@ -6,6 +6,7 @@ from numpy import *
 from geode import *
 import cPickle as pickle
 import sys
+import time
 import py
 
 def test_basic():
@@ -81,5 +82,67 @@ def test_nested():
   assert na==nested_convert_test(na)==nested_convert_test(n)
   assert a==pickle.loads(pickle.dumps(a))
 
+def test_index_dtype():
+  # Nested offsets use the C++ index type, which is int32 unless built with index=int64
+  assert index_dtype in (dtype(int32),dtype(int64))
+  a = Nested([[1,2],[3]],dtype=int32)
+  assert a.offsets.dtype==index_dtype
+  assert Nested.zeros([2,0,3]).offsets.dtype==index_dtype
+  b = nested_convert_test(a)
+  assert b.offsets.dtype==index_dtype and b==a
+
+def test_index(benchmark=False):
+  # index_test checks its own results; with -b, compare timings between index=int32 and index=int64 builds
+  index_test(1000)
+  if benchmark:
+    times = index_test(1<<24)
+    print 'index %s: append %.0f ms, sum %.0f ms, nested write %.0f ms, nested read %.0f ms'%((index_dtype,)+tuple(1000*times))
+
+def test_buffer_backends():
+  try:
+    for backend in 'malloc','pool':
+      for alignment in 16,32,64:
+        set_buffer_backend(backend,alignment)
+        assert buffer_alignment()==alignment
+        for n in 1,7,100,10000,1000000:
+          a = array_test(empty_array(),n)
+          assert len(a)==n
+          assert a.ctypes.data%alignment==0
+    py.test.raises(ValueError,set_buffer_backend,'pool',48)
+    py.test.raises(ValueError,set_buffer_backend,'unknown',16)
+  finally:
+    set_buffer_backend('malloc',16)
+
+def test_buffer_stats():
+  try:
+    set_buffer_backend('pool',16)
+    clear_buffer_stats()
+    assert allocation_test(100,10,False)==4950
+    s = buffer_stats()
+    assert s['calls']==s['frees']==100
+    assert s['bytes']==s['freed_bytes']==4000
+    assert s['pool_hits']>=99
+  finally:
+    set_buffer_backend('malloc',16)
+    trim_buffer_pool()
+
+def test_arena(benchmark=False):
+  clear_buffer_stats()
+  a = arena_test(1000)
+  assert len(a)==1+500%50 and all(a==500)
+  s = buffer_stats()
+  assert s['arena_calls']>=1000
+  assert s['mallocs']<100
+  if benchmark:
+    count,size = 1000000,20
+    for name,backend,arena in ('malloc','malloc',False),('pool','pool',False),('arena','malloc',True):
+      set_buffer_backend(backend,16)
+      start = time.time()
+      allocation_test(count,size,arena)
+      print '%s: %.1f ns per array'%(name,1e9*(time.time()-start)/count)
+    set_buffer_backend('malloc',16)
+
 if __name__=='__main__':
   test_write('array.npy')
+  test_arena(benchmark='-b' in sys.argv)
+  test_index(benchmark='-b' in sys.argv)
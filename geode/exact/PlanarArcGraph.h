@@ -295,7 +295,7 @@ template<Pb PS> class VertexSort {
   // Iterator that can walk around a circle
   IncidentCirculator circulator(const CircleId cid, const IncidentId iid) const {
     assert(circle_permutation.offset_range(cid).contains(incident_permutation[iid]));
-    return IncidentCirculator({circle_permutation[cid], incident_permutation[iid] - circle_permutation.front_offset(cid)});
+    return IncidentCirculator({circle_permutation[cid], int(incident_permutation[iid] - circle_permutation.front_offset(cid))});
   }
 
   // Can replace c.intersections_sorted(i0,i1) with (psudo_angle(iid0) < psudo_angle(iid1))
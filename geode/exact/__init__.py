@@ -14,8 +14,11 @@ else:
 if not has_exact():
   raise ImportError('geode/exact is unavailable since geode was compiled without gmp support')
 
-def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False):
-  return delaunay_points_py(X,edges,validate)
+# Must be kept in sync with PredicateStage in predicate_counters.h.  Use as labels for the predicate_counters() values.
+predicate_stages = ('filter','interval','exact','level 1','level 2','level 3','level 4+')
+
+def delaunay_points(X,edges=zeros((0,2),dtype=int32),validate=False,parallel=False):
+  return delaunay_points_py(X,edges,validate,parallel)
 
 def polygon_union(*polys):
   '''The union of possibly intersecting polygons, assuming consistent ordering'''
@@ -17,10 +17,13 @@
 #include <geode/geometry/BoxTree.h>
 #include <geode/geometry/polygon.h>
 #include <geode/geometry/traverse.h>
+#include <geode/python/ExceptionValue.h>
 #include <geode/python/stl.h>
 #include <geode/python/wrap.h>
 #include <geode/random/Random.h>
 #include <geode/structure/Hashtable.h>
+#include <geode/structure/UnionFind.h>
+#include <vector>
 namespace geode {
 
 Box<Vector<real,2>> approximate_bounding_box(const RawArray<const CircleArc> input) {
@@ -68,6 +71,109 @@ Nested<CircleArc> split_arcs_by_parity(Nested<const CircleArc> arcs) {
   return result;
 }
 
+Nested<CircleArc> parallel_split_circle_arcs(Nested<const CircleArc> arcs, const int depth, const int task_arcs) {
+  IntervalScope scope;
+  const auto PS = Pb::Implicit;
+  auto bounds = approximate_bounding_box(arcs);
+  if(bounds.empty()) bounds = Box<Vec2>::unit_box(); // As in quantize_circle_arcs
+  const auto quant = make_arc_quantizer(bounds);
+
+  // Pad the box of each contour by a generous multiple of the quantization error, which grows with |q|.
+  // Contours with disjoint padded boxes stay disjoint after quantization, so clusters of overlapping boxes are independent.
+  Array<int> contours;
+  Array<Box<Vec2>> boxes;
+  for (const int i : range(arcs.size())) {
+    if (arcs[i].empty())
+      continue;
+    real max_q = 0;
+    for (const auto& a : arcs[i])
+      max_q = max(max_q,abs(a.q));
+    contours.append(i);
+    boxes.append(approximate_bounding_box(arcs[i]).thickened(
+      16*(1+max_q)*constructed_arc_endpoint_error_bound()*quant.inverse.inv_scale));
+  }
+  const int n = contours.size();
+  if (!n)
+    return Nested<CircleArc>();
+  UnionFind union_find(n);
+  {
+    struct Overlaps {
+      const BoxTree<Vec2>& tree;
+      UnionFind& union_find;
+      bool cull(const int n) const { return false; }
+      bool cull(const int n0, const int n1) const { return false; }
+      void leaf(const int n) const { assert(tree.prims(n).size()==1); }
+      void leaf(const int n0, const int n1) {
+        assert(tree.prims(n0).size()==1 && tree.prims(n1).size()==1);
+        union_find.merge(tree.prims(n0)[0],tree.prims(n1)[0]);
+      }
+    };
+    const auto tree = new_<BoxTree<Vec2>>(boxes,1);
+    Overlaps overlaps({tree,union_find});
+    double_traverse(*tree,overlaps);
+  }
+
+  // Group contours by cluster, with clusters in order of their first contour
+  Array<int> cluster(n,uninit), counts;
+  Hashtable<int,int> root_to_cluster;
+  for (const int i : range(n)) {
+    const int root = union_find.find(i);
+    if (const int* c = root_to_cluster.get_pointer(root))
+      cluster[i] = *c;
+    else {
+      cluster[i] = counts.append(0);
+      root_to_cluster.set(root,cluster[i]);
+    }
+    counts[cluster[i]]++;
+  }
+  Nested<int> members(counts,uninit);
+  for (int i=n-1;i>=0;i--)
+    members(cluster[i],--counts[cluster[i]]) = contours[i];
+
+  // Batch consecutive clusters into tasks of at least task_arcs arcs
+  Array<int> tasks(1);
+  for (int c=0,size=0;c<members.size();c++) {
+    for (const int i : members[c])
+      size += arcs.size(i);
+    if (size>=task_arcs || c==members.size()-1) {
+      tasks.append(c+1);
+      size = 0;
+    }
+  }
+
+  // Split each task concurrently, keeping only one task's graph in memory per thread
+  std::vector<Nested<CircleArc>> results(tasks.size()-1);
+  std::vector<ExceptionValue> errors(results.size());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int t=0;t<int(results.size());t++) {
+    try {
+      GEODE_UNUSED const IntervalScope scope;
+      Nested<CircleArc,false> task;
+      for (const int i : members.flat.slice(members.offsets[tasks[t]],members.offsets[tasks[t+1]]))
+        task.append(arcs[i]);
+      const auto g = quantize_circle_arcs<PS>(quant,task.freeze());
+      const auto interior = faces_greater_than(*g, depth);
+      // For depth<0, the unbounded face of every task is interior, and the merged region is the intersection of the
+      // task regions.  Since clusters are disjoint, this is the concatenation of each task's inner boundaries, so no task
+      // may emit a contour around its own outer face.  For depth>=0 the unbounded face is exterior, and concatenation
+      // is the union of the task regions.
+      assert(!g->topology->n_faces() || interior[g->boundary_face()]==(depth<0));
+      const auto contour_edges = extract_region(g->topology, interior);
+      results[t] = g->unquantize_circle_arcs(quant, contour_edges);
+    } catch (const std::exception& e) {
+      errors[t] = ExceptionValue(e);
+    }
+  }
+  for (const auto& error : errors)
+    if (error)
+      error.throw_();
+
+  Nested<CircleArc,false> result;
+  for (const auto& r : results)
+    result.extend(r);
+  return result.freeze();
+}
+
 ostream& operator<<(ostream& output, const CircleArc& arc) {
   return output << format("CircleArc([%g,%g],%g)",arc.x.x,arc.x.y,arc.q);
 }
@@ -390,6 +496,7 @@ using namespace geode;
 void wrap_circle_csg() {
   GEODE_FUNCTION(split_circle_arcs)
   GEODE_FUNCTION(split_arcs_by_parity)
+  GEODE_FUNCTION(parallel_split_circle_arcs)
   GEODE_FUNCTION(canonicalize_circle_arcs)
   GEODE_FUNCTION_2(circle_arc_area,static_cast<real(*)(Nested<const CircleArc>)>(circle_arc_area))
   GEODE_FUNCTION(circle_arc_length)
@@ -36,6 +36,12 @@ struct CircleArc {
 GEODE_CORE_EXPORT Nested<CircleArc> split_circle_arcs(Nested<const CircleArc> arcs, const int depth);
 GEODE_CORE_EXPORT Nested<CircleArc> split_arcs_by_parity(Nested<const CircleArc> arcs);
 
+// As split_circle_arcs, but contours are grouped into clusters with overlapping padded bounding boxes, and batches of at
+// least task_arcs arcs are split concurrently.  Peak memory for the planar graphs scales with the largest batch rather
+// than the whole input.  The output contours match split_circle_arcs up to order.
+GEODE_CORE_EXPORT Nested<CircleArc> parallel_split_circle_arcs(Nested<const CircleArc> arcs, const int depth,
+                                                               const int task_arcs=1024);
+
 // The union of possibly intersecting circular arc polygons, assuming consistent ordering
 template<class... Arcs> static inline Nested<CircleArc> circle_arc_union(const Arcs&... arcs) {
   return split_circle_arcs(concatenate(arcs...),0);
@@ -414,8 +414,8 @@ template<Pb PS> static Vector<ApproxIntersection,2> circle_circle_approx_interse
     // const decltype(perturbed(circle0)) X[2] = {perturbed(circle0),perturbed(circle1)};
     const auto X = vec(perturbed(circle0), perturbed(circle1));
     exact::Vec2 fr,fs;
-    perturbed_ratio(asarray(fr),&FR::eval,3,asarray(X));
-    perturbed_ratio(asarray(fs),&FS::eval,6,asarray(X),true);
+    perturbed_ratio(asarray(fr),&FR::eval,3,asarray(X),false,PredicateCounter<FR>::id);
+    perturbed_ratio(asarray(fs),&FS::eval,6,asarray(X),true,PredicateCounter<FS>::id);
     fs = rotate_left_90(fs*exact::Vec2(axis_less<0>(X[0],X[1])?1:-1,
                                        axis_less<1>(X[0],X[1])?1:-1));
 #if CHECK
@@ -7,6 +7,7 @@
 #include <geode/array/amap.h>
 #include <geode/array/RawField.h>
 #include <geode/math/integer_log.h>
+#include <geode/python/ExceptionValue.h>
 #include <geode/python/wrap.h>
 #include <geode/random/permute.h>
 #include <geode/random/Random.h>
@@ -14,10 +15,13 @@
 #include <geode/utility/curry.h>
 #include <geode/utility/interrupts.h>
 #include <geode/utility/Log.h>
+#include <algorithm>
+#include <vector>
 namespace geode {
 
 using Log::cout;
 using std::endl;
+using std::vector;
 typedef Vector<real,2> TV;
 typedef Vector<Quantized,2> EV;
 using exact::Perturbed2;
@@ -764,9 +768,9 @@ static void spatial_sort(RawArray<Perturbed2> X, const int leaf_size, Random& ra
 }
 
 // Prepare a list of points for Delaunay triangulation: randomly assign into logarithmic bins, sort within bins, and add sentinels.
-// For details, see Amenta et al., Incremental Constructions con BRIO.
-static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
-  const int n = Xin.size();
+// For details, see Amenta et al., Incremental Constructions con BRIO.  Point i is point(i), and the sentinels get seeds
+// starting at sentinel, which must not collide with any point seed.
+template<class Point> static Array<Perturbed2> partially_sorted_shuffle(const int n, const Point& point, const int sentinel) {
   Array<Perturbed2> X(n+3,uninit);
 
   // Randomly assign input points into bins.  Bin k has 2**k = 1,2,4,8,... and starts at index 2**k-1 = 0,1,3,7,...
@@ -777,7 +781,7 @@ static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
     int j = (int)random_permute(n,key,i);
     const int bin = min(integer_log(j+1),bins-1);
     j = (1<<bin)-1+bin_counts[bin]++;
-    X[j] = Perturbed2(i,Xin[i]);
+    X[j] = point(i);
   }
 
   // Spatially sort each bin down to clusters of size 64.
@@ -790,37 +794,242 @@ static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
   }
 
   // Add 3 sentinel points at infinity
-  X[n+0] = Perturbed2(n+0,EV(-bound,-bound));
-  X[n+1] = Perturbed2(n+1,EV( bound, 0)    );
-  X[n+2] = Perturbed2(n+2,EV(-bound, bound));
+  X[n+0] = Perturbed2(sentinel+0,EV(-bound,-bound));
+  X[n+1] = Perturbed2(sentinel+1,EV( bound, 0)    );
+  X[n+2] = Perturbed2(sentinel+2,EV(-bound, bound));
 
   return X;
 }
 
+static Array<Perturbed2> partially_sorted_shuffle(RawArray<const EV> Xin) {
+  const int n = Xin.size();
+  return partially_sorted_shuffle(n,[=](const int i) { return Perturbed2(i,Xin[i]); },n);
+}
+
+// Triangulate a subset of points which already carry their seeds.  The vertices of the returned mesh are
+// indices into X, whose first X.size()-3 entries map them back to seeds.
+static Tuple<Ref<MutableTriangleTopology>,Array<Perturbed2>> subset_delaunay(RawArray<const Perturbed2> points,
+                                                                            const int sentinel) {
+  const auto X = partially_sorted_shuffle(points.size(),[=](const int i) { return points[i]; },sentinel);
+  return tuple(deterministic_exact_delaunay(Field<const Perturbed2,VertexId>(X),false),X);
+}
+
+// Partition X so that each slice offsets[k],offsets[k+1] precedes slice k+1 in exact axis order
+template<int axis> static void exact_split(RawArray<Perturbed2> X, RawArray<const int> offsets) {
+  const int parts = offsets.size()-1;
+  if (parts<2)
+    return;
+  const int mid = parts/2;
+  std::nth_element(X.begin()+offsets[0],X.begin()+offsets[mid],X.begin()+offsets[parts],
+                   [](const Perturbed2 a, const Perturbed2 b) { return a.seed()!=b.seed() && axis_less<axis>(a,b); });
+  exact_split<axis>(X,offsets.slice(0,mid+1));
+  exact_split<axis>(X,offsets.slice(mid,parts+1));
+}
+
+// Is the circumcircle of x0,x1,x2 safely inside an open box?  This is computed with floating point, but with a
+// generous error margin, so a true answer is always correct.  A false answer only means more stitching work.
+static bool circle_inside(const EV x0, const EV x1, const EV x2, const Box<TV>& box) {
+  const TV a(x1-x0),
+           b(x2-x0);
+  const real cross = a.x*b.y-a.y*b.x,
+             scale = abs(a.x*b.y)+abs(a.y*b.x);
+  if (!(abs(cross) > 1e-6*scale)) // Nearly degenerate triangles have huge circles anyways
+    return false;
+  const real A = sqr_magnitude(a),
+             B = sqr_magnitude(b);
+  const TV u = TV(b.y*A-a.y*B,a.x*B-b.x*A)/(2*cross),
+           c = TV(x0)+u;
+  const real r = magnitude(u),
+             error = 1e-6*(abs(a.x)*B+abs(a.y)*B+abs(b.x)*A+abs(b.y)*A)/abs(2*cross)
+                   + 1e-12*(maxabs(x0.x,x0.y)+r);
+  return box.min.x < c.x-r-error && c.x+r+error < box.max.x
+      && box.min.y < c.y-r-error && c.y+r+error < box.max.y;
+}
+
+namespace {
+struct DelaunayCell {
+  Box<TV> box; // Open box containing no points from other cells
+  Array<const Perturbed2> X;
+  Array<Vector<int,3>> faces; // Faces whose circumcircles lie safely inside box
+  Array<Vector<int,2>> boundary; // Directed edges with a safe face on the left and anything else on the right
+};
+}
+
+// Parallel Delaunay triangulation.  We split the points into g strips along x and each strip into g cells along y,
+// triangulate all cells concurrently, and keep the faces whose circumcircles lie safely inside their cell: no other
+// cell has points inside the box, so these faces are Delaunay for the whole point set.  The rest of the convex hull
+// is a seam along the cell boundaries.  Every Delaunay face in the seam has vertices on unsafe faces or cell hulls,
+// and is therefore a face of the Delaunay triangulation of those seam vertices.  We compute that triangulation with
+// the same kernel, and keep its faces outside the safe region, found by flood fill inwards from the safe boundary.
+// Since all points keep their seeds, the symbolic perturbation agrees everywhere, and the result is the same
+// triangulation the serial algorithm produces, with faces in a different order.
+GEODE_NEVER_INLINE static Ref<MutableTriangleTopology> parallel_exact_delaunay(RawArray<const EV> X, const int g,
+                                                                               const bool validate) {
+  const int n = X.size();
+  IntervalScope scope;
+  Array<Perturbed2> P(n,uninit);
+  for (const int i : range(n))
+    P[i] = Perturbed2(i,X[i]);
+
+  // Split into strips and cells using exact arithmetic, so that coincident points are handled consistently
+  Array<int> offsets(g*g+1,uninit);
+  for (const int s : range(g))
+    for (const int r : range(g))
+      offsets[g*s+r] = int(int64_t(n)*(g*s+r)/(g*g));
+  offsets.back() = n;
+  Array<int> strips(g+1,uninit);
+  for (const int s : range(g+1))
+    strips[s] = offsets[g*s];
+  exact_split<0>(P,strips);
+  #pragma omp parallel for
+  for (int s=0;s<g;s++) {
+    GEODE_UNUSED const IntervalScope scope;
+    exact_split<1>(P,offsets.slice(g*s,g*s+g+1));
+  }
+
+  // Each cell's box extends up to the nearest points of its neighbors
+  const auto range_of = [&](const int axis, const int lo, const int hi) {
+    Box<real> box;
+    for (const auto& p : P.slice(lo,hi))
+      box.enlarge(p.value()[axis]);
+    return box;
+  };
+  vector<DelaunayCell> cells(g*g);
+  for (const int s : range(g))
+    for (const int r : range(g)) {
+      const int c = g*s+r;
+      auto& cell = cells[c];
+      cell.X = P.slice_own(offsets[c],offsets[c+1]);
+      cell.box = Box<TV>(TV(s     ? range_of(0,strips[s-1],strips[s]).max   : -inf,
+                            r     ? range_of(1,offsets[c-1],offsets[c]).max : -inf),
+                         TV(s<g-1 ? range_of(0,strips[s+1],strips[s+2]).min :  inf,
+                            r<g-1 ? range_of(1,offsets[c+1],offsets[c+2]).min :  inf));
+    }
+
+  // Triangulate cells in parallel, marking vertices which belong in the seam
+  Array<bool> seam(n);
+  vector<ExceptionValue> errors(cells.size());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<int(cells.size());c++) {
+    try {
+      auto& cell = cells[c];
+      const auto dm = subset_delaunay(cell.X,n);
+      const auto& mesh = *dm.x;
+      const auto seeds = dm.y.slice(0,cell.X.size()).project<int,&Perturbed2::seed_>();
+      Field<bool,FaceId> safe(mesh.faces_.size());
+      for (const auto f : mesh.faces()) {
+        const auto v = mesh.vertices(f);
+        safe[f] = circle_inside(dm.y[v.x.id].value(),dm.y[v.y.id].value(),dm.y[v.z.id].value(),cell.box);
+      }
+      for (const auto f : mesh.faces()) {
+        const auto v = mesh.vertices(f);
+        if (safe[f]) {
+          cell.faces.append(vec(seeds[v.x.id],seeds[v.y.id],seeds[v.z.id]));
+          for (const auto e : mesh.halfedges(f)) {
+            const auto r = mesh.reverse(e);
+            if (mesh.is_boundary(r) || !safe[mesh.face(r)])
+              cell.boundary.append(vec(seeds[mesh.src(e).id],seeds[mesh.dst(e).id]));
+          }
+        } else
+          for (const auto u : v)
+            seam[seeds[u.id]] = true;
+      }
+      for (const auto e : mesh.boundary_edges())
+        seam[seeds[mesh.src(e).id]] = true;
+    } catch (const std::exception& e) {
+      errors[c] = ExceptionValue(e);
+    }
+  }
+  for (const auto& error : errors)
+    if (error)
+      error.throw_();
+
+  // Triangulate the seam
+  Array<Perturbed2> S;
+  for (const int i : range(n))
+    if (seam[i])
+      S.append(Perturbed2(i,X[i]));
+  const auto dm = subset_delaunay(S,n);
+  const auto& mesh = *dm.x;
+  const auto seeds = dm.y.slice(0,S.size()).project<int,&Perturbed2::seed_>();
+  const auto edge = [&](const HalfedgeId e) { return vec(seeds[mesh.src(e).id],seeds[mesh.dst(e).id]); };
+
+  // Every boundary edge of the safe region is a Delaunay edge between seam vertices, and thus also an edge of the seam
+  // triangulation.  Flood fill the seam faces on the safe side of these edges, and keep the rest.
+  Hashtable<Vector<int,2>> boundary;
+  for (const auto& cell : cells)
+    for (const auto& e : cell.boundary)
+      boundary.set(e);
+  Field<bool,FaceId> covered(mesh.faces_.size());
+  Array<FaceId> stack;
+  for (const auto e : mesh.interior_halfedges())
+    if (boundary.contains(edge(e))) {
+      const auto f = mesh.face(e);
+      if (!covered[f]) {
+        covered[f] = true;
+        stack.append(f);
+      }
+    }
+  while (stack.size()) {
+    const auto f = stack.pop();
+    for (const auto e : mesh.halfedges(f))
+      if (!boundary.contains(edge(e))) {
+        const auto r = mesh.reverse(e);
+        if (!mesh.is_boundary(r) && !covered[mesh.face(r)]) {
+          covered[mesh.face(r)] = true;
+          stack.append(mesh.face(r));
+        }
+      }
+  }
+
+  // Assemble the safe faces of each cell and the uncovered seam faces
+  Array<Vector<int,3>> faces;
+  for (const auto& cell : cells)
+    faces.extend(cell.faces);
+  for (const auto f : mesh.faces())
+    if (!covered[f]) {
+      const auto v = mesh.vertices(f);
+      faces.append(vec(seeds[v.x.id],seeds[v.y.id],seeds[v.z.id]));
+    }
+  const auto result = new_<MutableTriangleTopology>(faces);
+
+  // If desired, check that the final mesh is Delaunay
+  if (validate)
+    assert_delaunay("parallel delaunay validate: ",result,RawField<const EV,VertexId>(X));
+  return result;
+}
+
 Ref<TriangleTopology> exact_delaunay_points(RawArray<const EV> X, RawArray<const Vector<int,2>> edges,
-                                            const bool validate) {
+                                            const bool validate, const bool parallel) {
   const int n = X.size();
   GEODE_ASSERT(n>=3);
 
-  // Quantize all input points, reorder, and add sentinels
-  Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(X));
+  // In parallel mode, use a g by g grid of cells with at least 2**14 points each, or fall back to serial
+  const int g = parallel ? min(16,int(sqrt(double(n>>14)))) : 1;
+  Ptr<MutableTriangleTopology> mesh;
+  if (g>1) {
+    mesh = parallel_exact_delaunay(X,g,validate);
+  } else {
+    // Quantize all input points, reorder, and add sentinels
+    Field<const Perturbed2,VertexId> Xp(partially_sorted_shuffle(X));
 
-  // Compute Delaunay triangulation
-  const auto mesh = deterministic_exact_delaunay(Xp,validate);
+    // Compute Delaunay triangulation
+    mesh = deterministic_exact_delaunay(Xp,validate);
 
-  // Undo the vertex permutation
-  mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+    // Undo the vertex permutation
+    mesh->permute_vertices(Xp.flat.slice(0,n).project<int,&Perturbed2::seed_>().copy());
+  }
 
   // Insert constraint edges in random order
-  add_constraint_edges(mesh,RawField<const EV,VertexId>(X),edges,validate);
+  add_constraint_edges(*mesh,RawField<const EV,VertexId>(X),edges,validate);
 
   // All done!
-  return mesh;
+  return ref(*mesh);
 }
 
 Ref<TriangleTopology> delaunay_points(RawArray<const Vector<real,2>> X, RawArray<const Vector<int,2>> edges,
-                                      const bool validate) {
-  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate);
+                                      const bool validate, const bool parallel) {
+  return exact_delaunay_points(amap(quantizer(bounding_box(X)),X).copy(),edges,validate,parallel);
 }
 
 // Greedily compute a set of nonintersecting edges in a point cloud for testing purposes
@@ -7,14 +7,19 @@ namespace geode {
 
 // Approximately Delaunay triangulate a point set, by first quantizing and performing exact Delaunay.
 // Any edges are used as constraints in constrained Delaunay.  If two edges intersect, ValueError is thrown.
+// If parallel is true, large point sets are split into spatial cells which are triangulated concurrently and stitched
+// together.  The triangulation is the same, but faces are ordered differently.
 GEODE_CORE_EXPORT Ref<TriangleTopology> delaunay_points(RawArray<const Vector<real,2>> X,
                                                         RawArray<const Vector<int,2>> edges=Tuple<>(),
-                                                        const bool validate=false);
+                                                        const bool validate=false,
+                                                        const bool parallel=false);
 
 // Exactly Delaunay triangulate a quantized point set.
 // Any edges are used as constraints in constrained Delaunay.  If two edges intersect, ValueError is thrown.
+// See delaunay_points for parallel.
 GEODE_CORE_EXPORT Ref<TriangleTopology> exact_delaunay_points(RawArray<const Vector<Quantized,2>> X,
                                                               RawArray<const Vector<int,2>> edges=Tuple<>(),
-                                                              const bool validate=false);
+                                                              const bool validate=false,
+                                                              const bool parallel=false);
 
 }
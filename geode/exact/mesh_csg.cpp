@@ -18,6 +18,7 @@
 #include <geode/math/mean.h>
 #include <geode/math/optimal_sort.h>
 #include <geode/mesh/TriangleSoup.h>
+#include <geode/python/ExceptionValue.h>
 #include <geode/python/function.h>
 #include <geode/python/wrap.h>
 #include <geode/random/permute.h>
@@ -26,6 +27,7 @@
 #include <geode/structure/UnionFind.h>
 #include <geode/utility/Unique.h>
 #include <geode/vector/Matrix.h>
+#include <vector>
 namespace geode {
 
 // Algorithm explanation:
@@ -746,7 +748,7 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
     // Or perhaps I misunderstand something about lifetime of temporaries in this context?
     // Adding a seperate reference is a clean enough workaround
     const auto helper_edge_tree = new_<SimplexTree<EV, 1>>(edges, X, 1);
-    struct {
+    struct Helper {
       const Ref<const SimplexTree<EV,1>> edge_tree;
       const SimplexTree<EV,2>& face_tree;
       const RawArray<const EV> X;
@@ -768,16 +770,22 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
           }
         }
       }
-    } helper({helper_edge_tree,face_tree,X});
-    double_traverse(*helper.edge_tree,face_tree,helper);
+    };
+    // Each traversal task collects its own edge-face vertices.  Since each edge's vertices are sorted below,
+    // the result is identical to a serial traversal regardless of the number of threads.
+    const auto helpers = parallel_double_traverse<IntervalScope>(*helper_edge_tree,face_tree,[&]() {
+      return Helper({helper_edge_tree,face_tree,X});
+    });
 
     // Bucket edge face vertices by edge
     Array<int> counts(edges.elements.size());
-    for (const auto& ef : helper.ef_vertices)
-      counts[ef.edge]++;
+    for (const auto& helper : helpers)
+      for (const auto& ef : helper.ef_vertices)
+        counts[ef.edge]++;
     ef_vertices = Nested<EdgeFaceVertex>(counts,uninit);
-    for (const auto& ef : helper.ef_vertices)
-      ef_vertices(ef.edge,--counts[ef.edge]) = ef;
+    for (const auto& helper : helpers)
+      for (const auto& ef : helper.ef_vertices)
+        ef_vertices(ef.edge,--counts[ef.edge]) = ef;
   }
 
   // Sort ef_vertices along each edge
@@ -837,7 +845,7 @@ intersection_simplices(const SimplexTree<EV,2>& face_tree) {
             const auto f1n = faces.elements[f1];
             if (f1n.contains_all(e0)) {
               const bool flip = ef0.flip ^ flipped_in(e0,f1n);
-              ff_edges.append(FaceFaceEdge({flip?vec(f1,f0):vec(f0,f1),vec(v,X.size()+i0)}));
+              ff_edges.append(FaceFaceEdge({flip?vec(f1,f0):vec(f0,f1),vec(v,int(X.size()+i0))}));
             }
           }
     }
@@ -959,8 +967,19 @@ struct DepthUnionFind {
 };
 }
 
+namespace {
+// The output of retriangulating one face.  Faces are retriangulated independently, each with its own buffer of
+// face-face-face vertices, and the results are merged in face order afterwards.  Within a FaceResult, vertex nn+k
+// refers to fff[k] (where nn = X.size()+ef_vertices.flat.size()), and ~k in merges refers to the kth cut face.
+struct FaceResult {
+  Array<Vector<int,3>> faces;
+  Array<FaceFaceFaceVertex> fff; // In order of construction
+  Array<Vector<int,3>> merges; // Arguments to DepthUnionFind::merge, in order
+};
+}
+
 template<int up> static void
-retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &original_face_index, DepthUnionFind* const union_find,
+retriangulate_face(State& S, FaceResult& R, const bool depths,
                    const int face, Vector<int,3> e, RawArray<int> interior,
                    RawArray<const FaceFaceEdge> ff_edges, RawArray<const int> ffs) {
   // Sort vertices in upwards order, keeping track of permutation parity.
@@ -1056,18 +1075,16 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
                                 Line({ff.faces.sum()-face,ff.faces.x!=face?ffi:-ffi-1}));
   }
 
-  // Copy mesh into cut_faces
+  // Copy mesh into cut faces
   for (const auto f : mesh->faces()) {
     const auto v = mesh->vertices(f);
-    original_face_index.append(face);
-    cut_faces.append(vec(vertices[v.x],
-                         vertices[v.y],
-                         vertices[v.z]));
+    R.faces.append(vec(vertices[v.x],
+                       vertices[v.y],
+                       vertices[v.z]));
   }
 
-  if (union_find) {
+  if (depths) {
     // Absorb depth information at the start of all three original edges
-    const int base = union_find->extend(mesh->n_faces());
     const auto h = vec(mesh->halfedge(lo),
                        mesh->halfedge(vy),
                        mesh->halfedge(hi));
@@ -1075,7 +1092,7 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
     for (int i=0;i<3;i++) {
       const int j = (i+shift+3)%3,
                 k = (j+shift+3)%3;
-      union_find->merge(e[i],base+mesh->face(S.edges[e[i]].x==v[k] ? mesh->left(h[k]) : mesh->reverse(h[j])).id,0);
+      R.merges.append(vec(e[i],~mesh->face(S.edges[e[i]].x==v[k] ? mesh->left(h[k]) : mesh->reverse(h[j])).id,0));
     }
 
     // Absorb depth information in the interior of the cut triangle.
@@ -1093,12 +1110,12 @@ retriangulate_face(State& S, Array<Vector<int,3>>& cut_faces, Array<int> &origin
                       start = ff_edges[ff].nodes.x,
                       face2 = ff_edges[ff].faces.x == face ? ff_edges[ff].faces.y : ff_edges[ff].faces.x;
             const int ddepth = S.depth_weight[face2];
-            union_find->merge(base+f0.id,base+f1.id,flip?-ddepth:ddepth);
+            R.merges.append(vec(~f0.id,~f1.id,flip?-ddepth:ddepth));
             if (   start==P.vertices[mesh->src(e)]
                 || start==P.vertices[mesh->dst(e)])
-              union_find->merge(ff_base+ff,base+f0.id,flip?ddepth:0);
+              R.merges.append(vec(ff_base+ff,~f0.id,flip?ddepth:0));
           } else {
-            union_find->merge(base+f0.id,base+f1.id,0);
+            R.merges.append(vec(~f0.id,~f1.id,0));
           }
         }
       }
@@ -1172,25 +1189,70 @@ retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_we
     union_find->extend(edges.elements.size()+ff_edges.size());
   }
 
-  // Retriangulate each face
-  Array<FaceFaceFaceVertex> fff_vertices;
-  Hashtable<Vector<int,3>,int> faces_to_fff;
-  State S(X,ef_vertices,fff_vertices,faces_to_fff,faces.elements,edges.elements,depth_weight);
+  // Find the three edges bounding each face, ordered so that e[3-i-j] connects v[i] and v[j]
+  const auto bounding_edges = [&](const int f) {
+    const auto fe = face_edges[f]; // v01,v12,v20
+    return Vector<int,3>(fe.y,fe.z,fe.x);
+  };
+
+  // Collect faces which are cut.  If a face isn't cut, there's very little to do.
+  Array<int> cut;
   for (const int f : range(faces.elements.size())) {
-    const auto v = faces.elements[f];
+    const auto e = bounding_edges(f);
+    if (   face_to_ef.size(f) || ef_vertices.size(e.x)
+        || ef_vertices.size(e.y) || ef_vertices.size(e.z))
+      cut.append(f);
+  }
 
-    // Find the three edges bounding this face
-    const auto fe = face_edges[f]; // v01,v12,v20
-    Vector<int,3> e(fe.y,fe.z,fe.x); // e[3-i-j] connects v[i] and v[j]
+  // Retriangulate cut faces in parallel.  Each face gets a fresh fff vertex buffer, so a vertex shared by several
+  // faces is constructed once per face, but the results are independent of the number of threads.
+  std::vector<FaceResult> results(cut.size());
+  std::vector<ExceptionValue> errors(cut.size());
+  #pragma omp parallel if(cut.size()>1)
+  {
+    GEODE_UNUSED const IntervalScope scope;
+    Hashtable<Vector<int,3>,int> local_faces_to_fff;
+    #pragma omp for schedule(dynamic,16)
+    for (int i=0;i<cut.size();i++) {
+      try {
+        const int f = cut[i];
+        auto& R = results[i];
+        local_faces_to_fff.clear();
+        State S(X,ef_vertices,R.fff,local_faces_to_fff,faces.elements,edges.elements,depth_weight);
+
+        // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
+        // since it does not affect correctness.
+        const auto v = faces.elements[f];
+        const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
+        const auto e = bounding_edges(f);
+        const auto interior = face_to_ef[f];
+        const auto ffs = face_to_ff[f];
+        const bool depths = union_find!=0;
+        if (up==0)      retriangulate_face<0>(S,R,depths,f,e,interior,ff_edges,ffs);
+        else if (up==1) retriangulate_face<1>(S,R,depths,f,e,interior,ff_edges,ffs);
+        else            retriangulate_face<2>(S,R,depths,f,e,interior,ff_edges,ffs);
+      } catch (const std::exception& e) {
+        errors[i] = ExceptionValue(e);
+      }
+    }
+  }
+  for (const auto& error : errors)
+    if (error)
+      error.throw_();
 
-    // If the face isn't cut, there's very little to do
-    const auto interior = face_to_ef[f];
-    if (!interior.size() && !ef_vertices.size(e.x)
-                         && !ef_vertices.size(e.y)
-                         && !ef_vertices.size(e.z)) {
+  // Merge the results in face order.  Shared fff vertices are identified by their sorted faces, and numbered in
+  // order of first appearance, which matches the numbering we'd get by retriangulating the faces serially.
+  Array<FaceFaceFaceVertex> fff_vertices;
+  Hashtable<Vector<int,3>,int> faces_to_fff;
+  const int nn = X.size()+ef_vertices.flat.size();
+  Array<int> fff_map;
+  int next = 0;
+  for (const int f : range(faces.elements.size())) {
+    if (next==cut.size() || cut[next]!=f) {
       original_face_index.append(f);
-      cut_faces.append(v);
+      cut_faces.append(faces.elements[f]);
       if (union_find) {
+        const auto e = bounding_edges(f);
         const int i = union_find->append();
         union_find->merge(i,e.x,0);
         union_find->merge(i,e.y,0);
@@ -1198,14 +1260,31 @@ retriangulate_soup(const SimplexTree<EV,2>& face_tree, Array<const int> depth_we
       }
       continue;
     }
+    const auto& R = results[next++];
+
+    // Map local fff vertices to global ones
+    fff_map.resize(R.fff.size(),uninit);
+    for (const int k : range(R.fff.size())) {
+      const int n = faces_to_fff.size();
+      const int i = faces_to_fff.get_or_insert(R.fff[k].faces.sorted(),n);
+      if (i == n)
+        fff_vertices.append(R.fff[k]);
+      fff_map[k] = nn+i;
+    }
+    for (const auto& c : R.faces) {
+      original_face_index.append(f);
+      cut_faces.append(vec(c.x<nn ? c.x : fff_map[c.x-nn],
+                           c.y<nn ? c.y : fff_map[c.y-nn],
+                           c.z<nn ? c.z : fff_map[c.z-nn]));
+    }
 
-    // Let the longest axis be the upwards sweep axis.  This choice can be made using inexact arithmetic,
-    // since it does not affect correctness.
-    const int up = bounding_box(X[v.x],X[v.y],X[v.z]).sizes().dominant_axis();
-    const auto ffs = face_to_ff[f];
-    if (up==0)      retriangulate_face<0>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else if (up==1) retriangulate_face<1>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
-    else            retriangulate_face<2>(S,cut_faces,original_face_index,union_find,f,e,interior,ff_edges,ffs);
+    // Absorb depth information
+    if (union_find) {
+      const int base = union_find->extend(R.faces.size());
+      for (const auto& m : R.merges)
+        union_find->merge(m.x<0 ? base+~m.x : m.x,
+                          m.y<0 ? base+~m.y : m.y,m.z);
+    }
   }
 
   // Add one union-find node at infinity, and fire rays until everything is connected to it
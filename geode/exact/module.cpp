@@ -8,6 +8,7 @@ void wrap_exact() {
   GEODE_WRAP(interval)
   GEODE_WRAP(exact_exact)
   GEODE_WRAP(perturb)
+  GEODE_WRAP(predicate_counters)
   GEODE_WRAP(predicates)
   GEODE_WRAP(constructions)
   GEODE_WRAP(delaunay)
@@ -121,7 +121,7 @@ assert_last_nonzero(void(*const polynomial)(R,RawArray<const Vector<Exact<1>,Per
 }
 
 template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-                                                      const int degree, RawArray<const PerturbedT> X) {
+                                                      const int degree, RawArray<const PerturbedT> X, const int counter) {
   const int m = PerturbedT::m;
   typedef Vector<Exact<1>,m> EV;
   if (check)
@@ -139,8 +139,10 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
       Z[i] = EV(to_exact(X[i].value()));
     const auto R = GEODE_RAW_ALLOCA(precision,mp_limb_t);
     predicate(R,Z);
-    if (const int sign = mpz_sign(R))
+    if (const int sign = mpz_sign(R)) {
+      count_perturbation_level(counter,0);
       return sign>0;
+    }
   }
 
   // Check the first perturbation level with specialized code
@@ -171,8 +173,10 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
 
     // Compute sign
     for (int j=0;j<degree;j++)
-      if (const int sign = mpz_sign(values[j]))
+      if (const int sign = mpz_sign(values[j])) {
+        count_perturbation_level(counter,1);
         return sign>0;
+      }
   }
 
   {
@@ -215,8 +219,10 @@ template<class PerturbedT> bool perturbed_sign(void(*const predicate)(RawArray<m
         }
 
       // If we find a nonzero sign, we're done!
-      if (sign)
+      if (sign) {
+        count_perturbation_level(counter,d);
         return sign>0;
+      }
 
       // If we get through two levels without fixing the degeneracy, run a fast, strict identity test to make sure we weren't handed an impossible problem.
       if (d==2)
@@ -321,7 +327,7 @@ void snap_divs(RawArray<Quantized> result, RawArray<mp_limb_t,2> values, const b
   throw OverflowError("perturbed_ratio: overflow in l'Hopital expansion");
 }
 
-template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void(*const ratio)(RawArray<mp_limb_t,2>,RawArray<const Vector<Exact<1>,PerturbedT::m>>), const int degree, RawArray<const PerturbedT> X, const bool take_sqrt) {
+template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void(*const ratio)(RawArray<mp_limb_t,2>,RawArray<const Vector<Exact<1>,PerturbedT::m>>), const int degree, RawArray<const PerturbedT> X, const bool take_sqrt, const int counter) {
   const int m = PerturbedT::m;
   typedef Vector<Exact<1>,m> EV;
   const int n = X.size();
@@ -340,6 +346,7 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
     ratio(R,Z);
     if (const int sign = mpz_sign(R[r])) {
       snap_divs(result,R,take_sqrt);
+      count_perturbation_level(counter,0);
       return sign>0;
     }
   }
@@ -375,6 +382,7 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
     for (int j=0;j<degree;j++) {
       if (const int sign = mpz_sign(values(j,r))) { // We found a nonzero, now compute the rounded ratio
         snap_divs(result,values[j],take_sqrt);
+        count_perturbation_level(counter,1);
         return sign>0;
       } else
         for (int k=0;k<r;k++)
@@ -431,6 +439,7 @@ template<class PerturbedT> bool perturbed_ratio(RawArray<Quantized> result, void
       // If we found a nonzero, compute the result
       if (nonzero >= 0) {
         snap_divs(result,values[nonzero],take_sqrt);
+        count_perturbation_level(counter,d);
         return sign>0;
       }
 
@@ -573,21 +582,21 @@ static void perturbed_ratio_test() {
   template Vector<ExactInt,m> perturbation(const int, const int); \
   template Vector<ExactInt,m> packed_perturbation(const int, const Vector<Quantized,m>); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::Perturbed<m>>); \
+                                            const int, RawArray<const exact::Perturbed<m>>, const int); \
   template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,m>>), \
-                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>); \
+                                            const int, RawArray<const exact::ImplicitlyPerturbed<m>>, const int); \
   template bool perturbed_ratio(RawArray<Quantized>,void(*const)(RawArray<mp_limb_t,2>, \
                                 RawArray<const Vector<Exact<1>,m>>), const int, \
-                                RawArray<const exact::Perturbed<m>>, bool); \
+                                RawArray<const exact::Perturbed<m>>, bool, const int); \
   template bool perturbed_ratio(RawArray<Quantized>,void(*const)(RawArray<mp_limb_t,2>, \
                                 RawArray<const Vector<Exact<1>,m>>), const int, \
-                                RawArray<const exact::ImplicitlyPerturbed<m>>, bool);
+                                RawArray<const exact::ImplicitlyPerturbed<m>>, bool, const int);
 INSTANTIATE(1)
 INSTANTIATE(2)
 INSTANTIATE(3)
 
 template bool perturbed_sign(void(*const)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,2>>), const int,
-                             RawArray<const exact::ImplicitlyPerturbedCenter>);
+                             RawArray<const exact::ImplicitlyPerturbedCenter>, const int);
 }
 using namespace geode;
 
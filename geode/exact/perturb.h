@@ -6,6 +6,7 @@
 #include <geode/exact/Exact.h>
 #include <geode/exact/Interval.h>
 #include <geode/exact/irreducible.h>
+#include <geode/exact/predicate_counters.h>
 #include <geode/structure/Tuple.h>
 #include <geode/utility/IRange.h>
 #include <geode/vector/Vector.h>
@@ -21,9 +22,10 @@ namespace geode {
 //
 // Identically zero polynomials are zero regardless of perturbation; these are detected and an exception is thrown.
 // predicate should compute a quantity of type Exact<degree>, then copy it into result with mpz_set.
+// The perturbation level reached is recorded in the given predicate counter (see predicate_counters.h).
 template<class PerturbedT> GEODE_CORE_EXPORT GEODE_COLD bool
 perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-               const int degree, RawArray<const PerturbedT> X);
+               const int degree, RawArray<const PerturbedT> X, const int counter=0);
 
 // Given polynomial numerator and denominator functions, evaluate numerator(X+epsilon)/denominator(X+epsilon) rounded
 // to int for the same infinitesimal perturbation epsilon as in perturbed_sign.  The numerator and denominator must be
@@ -40,10 +42,11 @@ perturbed_sign(void(*const predicate)(RawArray<mp_limb_t>,RawArray<const Vector<
 // If take_sqrt is true, an exactly rounded square root is computed.
 // The r+1 numbers (r numerators and one denominator) should be copied into the result array via r+1 calls to mpz_set.
 // The perturbed sign of the denominator (before any square root) is returned.
+// As in perturbed_sign, the perturbation level reached is recorded in the given predicate counter.
 template<class PerturbedT> GEODE_CORE_EXPORT GEODE_COLD bool
 perturbed_ratio(RawArray<Quantized> result,
                 void(*const ratio)(RawArray<mp_limb_t,2>,RawArray<const Vector<Exact<1>,PerturbedT::m>>),
-                const int degree, RawArray<const PerturbedT> X, const bool take_sqrt=false);
+                const int degree, RawArray<const PerturbedT> X, const bool take_sqrt=false, const int counter=0);
 
 // The levelth perturbation of point i in R^m.  This is exposed for occasional special purpose use only, or as a
 // convenient pseudorandom generator; normally this routine is called internally by perturbed_sign.  perturbation<m+1>
@@ -85,12 +88,26 @@ template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool perturbed
     inexact_assert_irreducible(f,degree,sizeof...(Args),typeid(F).name());
 
   // Evaluate with conservative interval arithmetic, hoping for a clear nonzero
-  if (const int s = weak_sign(F::eval(Vector<Interval,d>(args.value())...)))
+  const int counter = PredicateCounter<F>::id;
+  if (const int s = weak_sign(F::eval(Vector<Interval,d>(args.value())...))) {
+    count_predicate(counter,interval_stage);
     return s>0;
+  }
 
   // Fall back to exact integer evaluation with symbolic perturbation
   const PerturbedT X[sizeof...(Args)] = {args...};
-  return perturbed_sign(f,degree,asarray(X));
+  return perturbed_sign(f,degree,asarray(X),counter);
+}
+
+// Same as perturbed_predicate, but first try F::filter, a plain floating point evaluation of F which returns its sign
+// if that sign is certified by a static error bound over the quantized input range, and zero otherwise.  Filters
+// are cheap enough that the interval stage is skipped for most nondegenerate inputs.  For examples, see predicates.cpp.
+template<class F,class... Args> GEODE_ALWAYS_INLINE static inline bool filtered_predicate(const Args... args) {
+  if (const int s = F::filter(args.value()...)) {
+    count_predicate(PredicateCounter<F>::id,filter_stage);
+    return s>0;
+  }
+  return perturbed_predicate<F>(args...);
 }
 
 template<class F,class... Args> struct PerturbedConstruct {
@@ -128,8 +145,10 @@ perturbed_construct(const int tolerance, const Args... args) {
 #if CHECK
       check = tuple(r,s);
 #else
-      if (small(r,tolerance))
+      if (small(r,tolerance)) {
+        count_predicate(PredicateCounter<F>::id,interval_stage);
         return tuple(snap(r),s>0);
+      }
 #endif
     }
   }
@@ -137,7 +156,7 @@ perturbed_construct(const int tolerance, const Args... args) {
   // If intervals fail, evaluate and round using symbolic perturbation
   const typename First<Args...>::type X[sizeof...(Args)] = {args...};
   Vector<Quantized,I::k> q;
-  const bool s = perturbed_ratio(asarray(q),f,I::degree,asarray(X));
+  const bool s = perturbed_ratio(asarray(q),f,I::degree,asarray(X),false,PredicateCounter<F>::id);
 #if CHECK
   GEODE_ASSERT(!check.y || (check.y>0)==s);
   for (int i=0;i<I::k;i++)
@@ -12,11 +12,15 @@
 #include <geode/geometry/BoxTree.h>
 #include <geode/geometry/polygon.h>
 #include <geode/geometry/traverse.h>
+#include <geode/python/Class.h>
+#include <geode/python/exceptions.h>
 #include <geode/python/wrap.h>
 #include <geode/structure/Hashtable.h>
 #include <geode/utility/Log.h>
 #include <geode/utility/str.h>
 #include <geode/utility/time.h>
+#include <geode/vector/Frame.h>
+#include <limits>
 
 namespace geode {
 
@@ -52,6 +56,199 @@ static inline bool local_outwards_x_axis(const Perturbed2 x0, const Perturbed2 x
   return out0==out1 ? out0 : triangle_oriented(x0,x1,x2);
 }
 
+namespace {
+// Compute all nontrivial intersections between segments in two trees (possibly the same).  Segments are indexed by
+// the index of their first point in X, which is offset plus the tree's prim.
+struct Pairs {
+  const BoxTree<EV>& tree0;
+  const BoxTree<EV>& tree1;
+  const int offset0, offset1;
+  RawArray<const int> next;
+  RawArray<const EV> X;
+  Array<Vector<int,2>> pairs;
+
+  Pairs(const BoxTree<EV>& tree0, const BoxTree<EV>& tree1, const int offset0, const int offset1,
+        RawArray<const int> next, RawArray<const EV> X)
+    : tree0(tree0), tree1(tree1), offset0(offset0), offset1(offset1), next(next), X(X) {}
+
+  bool cull(const int n) const { return false; }
+  bool cull(const int n0, const int box1) const { return false; }
+  void leaf(const int n) const { assert(tree0.prims(n).size()==1); }
+
+  void leaf(const int n0, const int n1) {
+    assert(tree0.prims(n0).size()==1 && tree1.prims(n1).size()==1);
+    const int i0 = offset0+tree0.prims(n0)[0], i1 = next[i0],
+              j0 = offset1+tree1.prims(n1)[0], j1 = next[j0];
+    if (!(i0==j0 || i0==j1 || i1==j0 || i1==j1)) {
+      const auto a0 = Perturbed2(i0,X[i0]), a1 = Perturbed2(i1,X[i1]),
+                 b0 = Perturbed2(j0,X[j0]), b1 = Perturbed2(j1,X[j1]);
+      if (segments_intersect(a0,a1,b0,b1))
+        pairs.append(vec(i0,j0));
+    }
+  }
+};
+
+// Order intersections along a segment
+struct PairOrder {
+  RawArray<const int> next;
+  RawArray<const EV> X;
+  const Vector<Perturbed2,2> segment;
+
+  PairOrder(RawArray<const int> next, RawArray<const EV> X, const Vector<Perturbed2,2>& segment)
+    : next(next), X(X), segment(segment) {}
+
+  bool operator()(const int j, const int k) const {
+    if (j==k)
+      return false;
+    const int jn = next[j],
+              kn = next[k];
+    return segment_intersections_ordered(segment.x,segment.y,
+                                         Perturbed2(j,X[j]),Perturbed2(jn,X[jn]),
+                                         Perturbed2(k,X[k]),Perturbed2(kn,X[kn]));
+  }
+};
+
+// Compute the external depth at a point by firing a ray along the positive x axis.  The ray may be traversed through
+// several trees in turn by changing tree and offset.
+struct Depth {
+  const BoxTree<EV>* tree;
+  int offset;
+  RawArray<const int> next;
+  RawArray<const EV> X;
+  const Perturbed2 start;
+  int depth;
+
+  Depth(RawArray<const int> next, RawArray<const EV> X, const int prev, const int i)
+    : tree(0), offset(0), next(next), X(X)
+    , start(i,X[i])
+    // If we intersect no other segments, the depth depends on the orientation of direction = (1,0) relative to segments prev and i
+    , depth(-!local_outwards_x_axis(Perturbed2(prev,X[prev]),start,Perturbed2(next[i],X[next[i]]))) {}
+
+  bool cull(const Box<EV>& box) const {
+    return box.max.x<start.value().x || box.max.y<start.value().y || box.min.y>start.value().y;
+  }
+
+  bool cull(const int n) const {
+    return cull(tree->boxes(n));
+  }
+
+  void leaf(const int n) {
+    assert(tree->prims(n).size()==1);
+    const int i0 = offset+tree->prims(n)[0], i1 = next[i0];
+    if (start.seed()!=i0 && start.seed()!=i1) {
+      const auto a0 = Perturbed2(i0,X[i0]),
+                 a1 = Perturbed2(i1,X[i1]);
+      const bool above0 = upwards(start,a0),
+                 above1 = upwards(start,a1);
+      if (above0!=above1 && above1==triangle_oriented(a0,a1,start))
+        depth += above1 ? 1 : -1;
+    }
+  }
+};
+
+// Find the first segment hit by a ray along the positive x axis, ignoring segments touching the start.  Once a hit is
+// found, boxes entirely to the right of it are culled.
+struct FirstHit {
+  const BoxTree<EV>& tree;
+  RawArray<const int> next;
+  RawArray<const EV> X;
+  const Perturbed2 start;
+  int hit; // First segment hit, or -1 for none
+  Quantized bound; // The hit lies left of bound
+
+  FirstHit(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X, const int i)
+    : tree(tree), next(next), X(X), start(i,X[i]), hit(-1), bound(0) {}
+
+  bool cull(const int n) const {
+    const auto& box = tree.boxes(n);
+    return box.max.x<start.value().x || box.max.y<start.value().y || box.min.y>start.value().y
+        || (hit>=0 && box.min.x>bound);
+  }
+
+  void leaf(const int n) {
+    assert(tree.prims(n).size()==1);
+    const int i0 = tree.prims(n)[0], i1 = next[i0];
+    if (start.seed()!=i0 && start.seed()!=i1) {
+      const auto a0 = Perturbed2(i0,X[i0]),
+                 a1 = Perturbed2(i1,X[i1]);
+      const bool above0 = upwards(start,a0),
+                 above1 = upwards(start,a1);
+      if (   above0!=above1 && above1==triangle_oriented(a0,a1,start)
+          && (hit<0 || ray_intersections_rightwards(a0,a1,Perturbed2(hit,X[hit]),Perturbed2(next[hit],X[next[hit]]),start))) {
+        hit = i0;
+        bound = max(a0.value().x,a1.value().x);
+      }
+    }
+  }
+};
+}
+
+// Sort the intersections along the segments of one polygon, and compute the external depth just before and after each
+// intersection relative to the start of the polygon.  Depth starts at 0 at infinity, and changes by 1 at each crossing.
+// The segments crossing segment i are others[offsets[i-poly.lo]:offsets[i-poly.lo+1]], and crossings is indexed likewise.
+static void sort_crossings(RawArray<const int> next, RawArray<const EV> X, const Range<int> poly,
+                           RawArray<const index_t> offsets, RawArray<int> others, RawArray<Vector<int,2>> crossings) {
+  int delta = 0;
+  for (const int i : poly) {
+    const int j = next[i];
+    const Vector<Perturbed2,2> segment(Perturbed2(i,X[i]),Perturbed2(j,X[j]));
+    const auto other = others.slice(offsets[i-poly.lo],offsets[i-poly.lo+1]);
+    if (other.size() > 1)
+      sort(other,PairOrder(next,X,segment));
+    for (const int t : range(offsets[i-poly.lo],offsets[i-poly.lo+1])) {
+      const int o = others[t],
+                on = next[o];
+      crossings[t].x = delta;
+      delta += segment_directions_oriented(segment.x,segment.y,Perturbed2(o,X[o]),Perturbed2(on,X[on])) ? -1 : 1;
+      crossings[t].y = delta;
+    }
+  }
+}
+
+// Walk around one polygon, recording all subsegments at the desired depth.  delta is the external depth at the start
+// of the polygon minus the desired depth, and the other arguments are as for sort_crossings.
+static void walk_polygon(Hashtable<Vector<int,2>,int>& graph, RawArray<const int> next, const Range<int> poly,
+                         const int delta0, RawArray<const index_t> offsets, RawArray<const int> others,
+                         RawArray<const Vector<int,2>> crossings) {
+  int delta = delta0;
+  int prev = poly.back();
+  for (const int i : poly) {
+    // Walk through each intersection of this segment, remembering the subsegment if it has the right depth
+    for (const int t : range(offsets[i-poly.lo],offsets[i-poly.lo+1])) {
+      const int o = others[t];
+      if (!delta)
+        graph.set(vec(prev,i),o);
+      delta = delta0+crossings[t].y;
+      prev = o;
+    }
+    if (!delta)
+      graph.set(vec(prev,i),next[i]);
+    // Advance to the next segment
+    prev = i;
+  }
+}
+
+// Walk the graph to produce output polygons
+static Nested<EV> extract_contours(const Hashtable<Vector<int,2>,int>& graph, RawArray<const int> next,
+                                   RawArray<const EV> X) {
+  Hashtable<Vector<int,2>> seen;
+  Nested<EV,false> output;
+  for (const auto& start : graph)
+    if (seen.set(start.x)) {
+      auto ij = start.x;
+      for (;;) {
+        const int i = ij.x, j = ij.y, in = next[i], jn = next[j];
+        output.flat.append(j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn])));
+        ij = vec(j,graph.get(ij));
+        if (ij == start.x)
+          break;
+        seen.set(ij);
+      }
+      output.offsets.append(output.flat.size());
+    }
+  return output;
+}
+
 Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
   IntervalScope scope;
   RawArray<const EV> X = polys.flat;
@@ -64,33 +261,8 @@ Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
   }
 
   // Compute all nontrivial intersections between segments
-  struct Pairs {
-    const BoxTree<EV>& tree;
-    RawArray<const int> next;
-    RawArray<const EV> X;
-    Array<Vector<int,2>> pairs;
-
-    Pairs(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X)
-      : tree(tree), next(next), X(X) {}
-
-    bool cull(const int n) const { return false; }
-    bool cull(const int n0, const int box1) const { return false; }
-    void leaf(const int n) const { assert(tree.prims(n).size()==1); }
-
-    void leaf(const int n0, const int n1) {
-      assert(tree.prims(n0).size()==1 && tree.prims(n1).size()==1);
-      const int i0 = tree.prims(n0)[0], i1 = next[i0],
-                j0 = tree.prims(n1)[0], j1 = next[j0];
-      if (!(i0==j0 || i0==j1 || i1==j0 || i1==j1)) {
-        const auto a0 = Perturbed2(i0,X[i0]), a1 = Perturbed2(i1,X[i1]),
-                   b0 = Perturbed2(j0,X[j0]), b1 = Perturbed2(j1,X[j1]);
-        if (segments_intersect(a0,a1,b0,b1))
-          pairs.append(vec(i0,j0));
-      }
-    }
-  };
   const auto tree = new_<BoxTree<EV>>(segment_boxes(next,X),1);
-  Pairs pairs(tree,next,X);
+  Pairs pairs(tree,tree,0,0,next,X);
   double_traverse(*tree,pairs);
 
   // Group intersections by segment.  Each pair is added twice: once for each order.
@@ -107,106 +279,119 @@ Nested<EV> exact_split_polygons(Nested<const EV> polys, const int depth) {
   pairs.pairs.clean_memory();
   counts.clean_memory();
 
-  // Walk all original polygons, recording which subsegments occur in the final result
-  Hashtable<Vector<int,2>,int> graph; // If (i,j) -> k, the output contains the portion of segment j from ij to jk
+  // Sort intersections along each segment, and compute relative depths
+  Array<Vector<int,2>> crossings(others.flat.size(),uninit); // Relative depth before and after each intersection
   for (const int p : range(polys.size())) {
-    const auto poly = range(polys.offsets[p],polys.offsets[p+1]);
-    // Compute the depth of the first point in the polygon by firing a ray along the positive x axis.
-    struct Depth {
-      const BoxTree<EV>& tree;
-      RawArray<const int> next;
-      RawArray<const EV> X;
-      const Perturbed2 start;
-      int depth;
-
-      Depth(const BoxTree<EV>& tree, RawArray<const int> next, RawArray<const EV> X, const int prev, const int i)
-        : tree(tree), next(next), X(X)
-        , start(i,X[i])
-        // If we intersect no other segments, the depth depends on the orientation of direction = (1,0) relative to segments prev and i
-        , depth(-!local_outwards_x_axis(Perturbed2(prev,X[prev]),start,Perturbed2(next[i],X[next[i]]))) {}
-
-      bool cull(const int n) const {
-        const auto box = tree.boxes(n);
-        return box.max.x<start.value().x || box.max.y<start.value().y || box.min.y>start.value().y;
-      }
+    const Range<int> poly(polys.offsets[p],polys.offsets[p+1]);
+    sort_crossings(next,X,poly,others.offsets.slice(poly.lo,poly.hi+1),others.flat,crossings);
+  }
+  Hashtable<Vector<int,2>,int> mirror; // (i,o) -> index of o in others.flat
+  for (const int i : range(X.size()))
+    for (const int t : range(others.offsets[i],others.offsets[i+1]))
+      mirror.set(vec(i,others.flat[t]),t);
 
-      void leaf(const int n) {
-        assert(tree.prims(n).size()==1);
-        const int i0 = tree.prims(n)[0], i1 = next[i0];
-        if (start.seed()!=i0 && start.seed()!=i1) {
-          const auto a0 = Perturbed2(i0,X[i0]),
-                     a1 = Perturbed2(i1,X[i1]);
-          const bool above0 = upwards(start,a0),
-                     above1 = upwards(start,a1);
-          if (above0!=above1 && above1==triangle_oriented(a0,a1,start))
-            depth += above1 ? 1 : -1;
-        }
-      }
-    };
-    Depth ray(tree,next,X,poly.back(),poly[0]);
-    single_traverse(*tree,ray);
+  // Compute the external depth just before each vertex, relative to the start of its polygon
+  Array<int> vertex_delta(X.size(),uninit);
+  for (const int p : range(polys.size())) {
+    int delta = 0;
+    for (const int i : polys.range(p)) {
+      vertex_delta[i] = delta;
+      if (others.size(i))
+        delta = crossings[others.offsets[i+1]-1].y;
+    }
+  }
 
-    // Walk around the polygon, recording all subsegments at the desired depth
-    int delta = ray.depth-depth;
-    int prev = poly.back();
-    for (const int i : poly) {
-      const int j = next[i];
-      const Vector<Perturbed2,2> segment(Perturbed2(i,X[i]),Perturbed2(j,X[j]));
-      const auto other = others[i];
-      // Sort intersections along this segment
-      if (other.size() > 1) {
-        struct PairOrder {
-          RawArray<const int> next;
-          RawArray<const EV> X;
-          const Vector<Perturbed2,2> segment;
-
-          PairOrder(RawArray<const int> next, RawArray<const EV> X, const Vector<Perturbed2,2>& segment)
-            : next(next), X(X), segment(segment) {}
-
-          bool operator()(const int j, const int k) const {
-            if (j==k)
-              return false;
-            const int jn = next[j],
-                      kn = next[k];
-            return segment_intersections_ordered(segment.x,segment.y,
-                                                 Perturbed2(j,X[j]),Perturbed2(jn,X[jn]),
-                                                 Perturbed2(k,X[k]),Perturbed2(kn,X[kn]));
+  // Group polygons into connected clusters of intersecting polygons.  Where two polygons cross, the depth along one
+  // after the crossing equals the depth along the other before it, so depth propagates across intersections by flood
+  // fill, giving start depths relative to the cluster.  We also find the rightmost vertex of each cluster.
+  Array<int> polygon(X.size(),uninit);
+  for (const int p : range(polys.size()))
+    polygon.slice(polys.offsets[p],polys.offsets[p+1]).fill(p);
+  Array<int> cluster(polys.size());
+  cluster.fill(-1);
+  Array<int> relative_depth(polys.size(),uninit);
+  Array<int> rightmost; // Rightmost vertex of each cluster
+  Array<int> stack;
+  for (const int root : range(polys.size())) {
+    if (cluster[root]>=0)
+      continue;
+    const int c = rightmost.append(polys.offsets[root]);
+    cluster[root] = c;
+    relative_depth[root] = 0;
+    stack.append(root);
+    while (stack.size()) {
+      const int p = stack.pop();
+      for (const int i : polys.range(p)) {
+        if (i!=rightmost[c] && rightwards(Perturbed2(rightmost[c],X[rightmost[c]]),Perturbed2(i,X[i])))
+          rightmost[c] = i;
+        for (const int t : range(others.offsets[i],others.offsets[i+1])) {
+          const int o = others.flat[t],
+                    q = polygon[o];
+          if (cluster[q]<0) {
+            relative_depth[q] = relative_depth[p]+crossings[t].y-crossings[mirror.get(vec(o,i))].x;
+            cluster[q] = c;
+            stack.append(q);
           }
-        };
-        sort(other,PairOrder(next,X,segment));
-      }
-      // Walk through each intersection of this segment, updating delta as we go and remembering the subsegment if it has the right depth
-      for (const int o : other) {
-        if (!delta)
-          graph.set(vec(prev,i),o);
-        const int on = next[o];
-        delta += segment_directions_oriented(segment.x,segment.y,Perturbed2(o,X[o]),Perturbed2(on,X[on])) ? -1 : 1;
-        prev = o;
+          assert(relative_depth[q]+crossings[mirror.get(vec(o,i))].x==relative_depth[p]+crossings[t].y);
+        }
       }
-      if (!delta)
-        graph.set(vec(prev,i),next[i]);
-      // Advance to the next segment
-      prev = i;
     }
   }
 
-  // Walk the graph to produce output polygons
-  Hashtable<Vector<int,2>> seen;
-  Nested<EV,false> output;
-  for (const auto& start : graph)
-    if (seen.set(start.x)) {
-      auto ij = start.x;
-      for (;;) {
-        const int i = ij.x, j = ij.y, in = next[i], jn = next[j];
-        output.flat.append(j==next[i] ? X[j] : segment_segment_intersection(Perturbed2(i,X[i]),Perturbed2(in,X[in]),Perturbed2(j,X[j]),Perturbed2(jn,X[jn])));
-        ij = vec(j,graph.get(ij));
-        if (ij == start.x)
-          break;
-        seen.set(ij);
+  // Clusters do not cross, so a ray from the rightmost vertex of a cluster crosses none of its own segments, and the
+  // first segment it hits belongs to a cluster with a vertex further right.  Sweeping clusters from right to left, the
+  // depth of each cluster follows from the depth along the first segment its ray hits, so each cluster needs only a
+  // single nearest hit query rather than a full ray count.
+  Array<int> order = arange(rightmost.size()).copy();
+  sort(order,[&](const int c0, const int c1) {
+    return c0!=c1 && rightwards(Perturbed2(rightmost[c1],X[rightmost[c1]]),Perturbed2(rightmost[c0],X[rightmost[c0]]));
+  });
+  Array<int> start_depth(polys.size(),uninit);
+  Array<int> cluster_depth(rightmost.size(),uninit);
+  for (const int c : order) {
+    const int v = rightmost[c],
+              p = polygon[v];
+    // If we hit no segments, the depth at v depends on the direction (1,0) relative to the segments touching v
+    const int prev = v==polys.offsets[p] ? polys.offsets[p+1]-1 : v-1;
+    const Perturbed2 start(v,X[v]);
+    int depth_v = -!local_outwards_x_axis(Perturbed2(prev,X[prev]),start,Perturbed2(next[v],X[next[v]]));
+    FirstHit ray(*tree,next,X,v);
+    single_traverse(*tree,ray);
+    if (ray.hit>=0) {
+      // The depth along the hit segment is the depth on its outer side, which is one less than its inner side.
+      // Crossings are sorted along the segment, and the segment is monotone in y, so we find the crossings
+      // before the hit by comparing their heights against the ray.
+      const int i0 = ray.hit, i1 = next[i0];
+      const auto a0 = Perturbed2(i0,X[i0]),
+                 a1 = Perturbed2(i1,X[i1]);
+      const bool up = upwards(start,a1);
+      int lo = others.offsets[i0], hi = others.offsets[i0+1];
+      while (lo<hi) {
+        const int mid = (lo+hi)/2,
+                  o = others.flat[mid];
+        if (segment_intersection_above_point(a0,a1,Perturbed2(o,X[o]),Perturbed2(next[o],X[next[o]]),start)!=up)
+          lo = mid+1;
+        else
+          hi = mid;
       }
-      output.offsets.append(output.flat.size());
+      const int q = polygon[i0];
+      assert(cluster[q]!=c);
+      depth_v += cluster_depth[cluster[q]]+relative_depth[q]
+               + (lo>others.offsets[i0] ? crossings[lo-1].y : vertex_delta[i0])
+               + triangle_oriented(a0,a1,start);
     }
-  return output;
+    cluster_depth[c] = depth_v-vertex_delta[v]-relative_depth[p];
+  }
+  for (const int p : range(polys.size()))
+    start_depth[p] = cluster_depth[cluster[p]]+relative_depth[p];
+
+  // Walk all original polygons, recording which subsegments occur in the final result
+  Hashtable<Vector<int,2>,int> graph; // If (i,j) -> k, the output contains the portion of segment j from ij to jk
+  for (const int p : range(polys.size())) {
+    const Range<int> poly(polys.offsets[p],polys.offsets[p+1]);
+    walk_polygon(graph,next,poly,start_depth[p]-depth,others.offsets.slice(poly.lo,poly.hi+1),others.flat,crossings);
+  }
+  return extract_contours(graph,next,X);
 }
 
 static inline bool include_face(const int delta, const FillRule rule) {
@@ -223,6 +408,296 @@ Nested<Vec2> split_polygons(Nested<const Vec2> polys, const int depth) {
   return amap(quant.inverse,exact_split_polygons(amap(quant,polys),depth));
 }
 
+GEODE_DEFINE_TYPE(PolygonCSG)
+
+static const int invalid_ray = std::numeric_limits<int>::min();
+
+PolygonCSG::PolygonCSG(const Box<Vec2> bounds)
+  : bounds(bounds)
+  , quant(quantizer(bounds)) {}
+
+PolygonCSG::~PolygonCSG() {}
+
+int PolygonCSG::add(RawArray<const Vec2> poly) {
+  polys.emplace_back();
+  const int id = size()-1;
+  polys.back().ray = invalid_ray;
+  assign(id,poly);
+  return id;
+}
+
+void PolygonCSG::remove(const int id) {
+  GEODE_ASSERT(unsigned(id)<unsigned(size()));
+  auto& P = polys[id];
+  if (P.seeds.size()) {
+    invalidate(id);
+    changed.append(P.box);
+    P = Polygon();
+    P.ray = invalid_ray;
+  }
+}
+
+void PolygonCSG::set(const int id, RawArray<const Vec2> poly) {
+  GEODE_ASSERT(unsigned(id)<unsigned(size()));
+  if (!polys[id].seeds.size())
+    throw ValueError(format("PolygonCSG: polygon %d has been removed",id));
+  assign(id,poly);
+}
+
+void PolygonCSG::assign(const int id, RawArray<const Vec2> poly) {
+  GEODE_ASSERT(poly.size()>=3,"Degenerate polygons are not allowed");
+  if (!bounds.contains(bounding_box(poly)))
+    throw ValueError(format("PolygonCSG: polygon %d lies outside the session bounds",id));
+  auto& P = polys[id];
+  if (P.seeds.size()) {
+    invalidate(id);
+    changed.append(P.box);
+  }
+
+  // Reuse seeds if the size is unchanged, otherwise allocate new ones
+  if (P.seeds.size()!=poly.size()) {
+    P.seeds = range(int(X.size()),int(X.size()+poly.size()));
+    X.resize(P.seeds.hi,uninit);
+    next.resize(P.seeds.hi,uninit);
+  }
+  P.points = poly.copy();
+  Array<int> local_next(poly.size(),uninit);
+  for (const int k : range(poly.size())) {
+    local_next[k] = (k+1)%poly.size();
+    X[P.seeds.lo+k] = quant(poly[k]);
+    next[P.seeds.lo+k] = P.seeds.lo+local_next[k];
+  }
+  const auto PX = X.slice(P.seeds.lo,P.seeds.hi);
+  P.tree = new_<BoxTree<EV>>(segment_boxes(local_next,PX),1);
+  P.box = bounding_box(PX);
+  P.dirty = P.stale = true;
+  P.ray = invalid_ray;
+  changed.append(P.box);
+}
+
+void PolygonCSG::transform(const int id, const Frame<Vec2>& frame) {
+  GEODE_ASSERT(unsigned(id)<unsigned(size()));
+  const auto points = polys[id].points; // Empty if removed, in which case set throws
+  Array<Vec2> moved(points.size(),uninit);
+  for (const int k : range(points.size()))
+    moved[k] = frame*points[k];
+  set(id,moved);
+}
+
+Array<const Vec2> PolygonCSG::polygon(const int id) const {
+  GEODE_ASSERT(unsigned(id)<unsigned(size()));
+  return polys[id].points;
+}
+
+// Forget all intersections involving a polygon, marking the polygons it touched as stale
+void PolygonCSG::invalidate(const int id) {
+  auto& P = polys[id];
+  for (const int q : P.neighbors) {
+    pairs.erase(vec(min(id,q),max(id,q)));
+    polys[q].neighbors.erase(id);
+    polys[q].stale = true;
+  }
+  pairs.erase(vec(id,id));
+  P.neighbors.clear();
+  P.dirty = P.stale = true;
+}
+
+// Seeds of removed or resized polygons are abandoned.  Once abandoned seeds outnumber live ones, pack the live seeds
+// to the front.  Seeds determine symbolic perturbation, so every cached intersection and ray is recomputed afterwards.
+void PolygonCSG::compact() {
+  int live = 0;
+  for (const auto& P : polys)
+    live += P.seeds.size();
+  if (X.size()<=2*live)
+    return;
+  Array<EV> new_X(live,uninit);
+  Array<int> new_next(live,uninit);
+  int lo = 0;
+  for (auto& P : polys)
+    if (P.seeds.size()) {
+      for (const int i : P.seeds) {
+        new_X[lo+i-P.seeds.lo] = X[i];
+        new_next[lo+i-P.seeds.lo] = lo+next[i]-P.seeds.lo;
+      }
+      P.seeds = range(lo,lo+P.seeds.size());
+      lo = P.seeds.hi;
+      P.neighbors.clear();
+      P.dirty = P.stale = true;
+      P.ray = invalid_ray;
+    }
+  X = new_X;
+  next = new_next;
+  pairs.clear();
+}
+
+void PolygonCSG::update() {
+  if (!changed.size())
+    return;
+  compact();
+
+  // Rebuild the tree of polygon boxes
+  Array<Box<EV>> boxes;
+  tree_polys.clear();
+  for (const int p : range(size()))
+    if (polys[p].seeds.size()) {
+      boxes.append(polys[p].box);
+      tree_polys.append(p);
+    }
+  tree.clear();
+  if (tree_polys.size())
+    tree = new_<BoxTree<EV>>(boxes,1);
+
+  // Recompute intersections for changed polygons against all polygons with overlapping boxes
+  struct Overlapping {
+    const BoxTree<EV>& tree;
+    const Box<EV> box;
+    Array<int> prims;
+    bool cull(const int n) const { return !box.intersects(tree.boxes(n)); }
+    void leaf(const int n) { prims.extend(tree.prims(n)); }
+  };
+  for (const int p : range(size())) {
+    auto& P = polys[p];
+    if (!P.seeds.size() || !P.dirty)
+      continue;
+    Overlapping overlapping({*tree,P.box});
+    single_traverse(*tree,overlapping);
+    for (const int prim : overlapping.prims) {
+      const int q = tree_polys[prim];
+      auto& Q = polys[q];
+      if (q!=p && Q.dirty && q<p)
+        continue; // Already computed from q's side
+      Pairs found(*P.tree,*Q.tree,P.seeds.lo,Q.seeds.lo,next,X);
+      if (q==p)
+        double_traverse(*P.tree,found);
+      else
+        double_traverse(*P.tree,*Q.tree,found);
+      if (found.pairs.size()) {
+        if (q<p)
+          for (auto& pair : found.pairs)
+            swap(pair.x,pair.y);
+        pairs.set(vec(min(p,q),max(p,q)),found.pairs);
+        if (q!=p) {
+          P.neighbors.set(q);
+          Q.neighbors.set(p);
+          Q.stale = true;
+        }
+      }
+    }
+  }
+  for (auto& P : polys)
+    P.dirty = false;
+
+  // Recompute sorted crossings for stale polygons
+  for (const int p : range(size())) {
+    auto& P = polys[p];
+    if (!P.seeds.size() || !P.stale)
+      continue;
+    P.stale = false;
+    const int lo = P.seeds.lo;
+    // Gather intersections as (segment of p, other segment).  Self intersections are added in both orders.
+    Array<Vector<int,2>> incident;
+    if (const auto* self = pairs.get_pointer(vec(p,p)))
+      for (const auto& pair : *self) {
+        incident.append(pair);
+        incident.append(vec(pair.y,pair.x));
+      }
+    for (const int q : P.neighbors)
+      for (const auto& pair : pairs.get(vec(min(p,q),max(p,q))))
+        incident.append(p<q ? pair : vec(pair.y,pair.x));
+    Array<int> counts(P.seeds.size());
+    for (const auto& pair : incident)
+      counts[pair.x-lo]++;
+    P.offsets.resize(P.seeds.size()+1,uninit);
+    P.offsets[0] = 0;
+    for (const int k : range(P.seeds.size()))
+      P.offsets[k+1] = P.offsets[k]+counts[k];
+    P.others.resize(P.offsets.back(),uninit);
+    for (const auto& pair : incident)
+      P.others[P.offsets[pair.x-lo]+--counts[pair.x-lo]] = pair.y;
+    P.crossings.resize(P.others.size(),uninit);
+    sort_crossings(next,X,P.seeds,P.offsets,P.others,P.crossings);
+    P.index.clear();
+    for (const int i : P.seeds)
+      for (const int t : range(P.offsets[i-lo],P.offsets[i-lo+1]))
+        P.index.set(vec(i,P.others[t]),t);
+  }
+
+  // Invalidate cached rays which might cross a changed box
+  for (auto& P : polys)
+    if (P.ray!=invalid_ray) {
+      const auto start = X[P.seeds.lo];
+      for (const auto& box : changed)
+        if (!(box.max.x<start.x || box.max.y<start.y || box.min.y>start.y)) { // As in Depth::cull
+          P.ray = invalid_ray;
+          break;
+        }
+    }
+  changed.clear();
+}
+
+Nested<Vec2> PolygonCSG::split(const int depth) {
+  IntervalScope scope;
+  update();
+
+  // Compute start depths by flood fill, casting rays only from uncached cluster roots
+  const int n = size();
+  Array<int> start_depth(n,uninit);
+  Array<bool> known(n);
+  Array<int> owner(X.size(),uninit);
+  for (const int p : range(n))
+    owner.slice(polys[p].seeds.lo,polys[p].seeds.hi).fill(p);
+  Array<int> stack;
+  for (const int root : range(n)) {
+    auto& R = polys[root];
+    if (known[root] || !R.seeds.size())
+      continue;
+    if (R.ray==invalid_ray) {
+      struct Ray {
+        const PolygonCSG& self;
+        Depth depth;
+        bool cull(const int n) const { return depth.cull(self.tree->boxes(n)); }
+        void leaf(const int n) {
+          for (const int prim : self.tree->prims(n)) {
+            const auto& P = self.polys[self.tree_polys[prim]];
+            depth.tree = &*P.tree;
+            depth.offset = P.seeds.lo;
+            single_traverse(*P.tree,depth);
+          }
+        }
+      };
+      Ray ray({*this,Depth(next,X,R.seeds.hi-1,R.seeds.lo)});
+      single_traverse(*tree,ray);
+      R.ray = ray.depth.depth;
+    }
+    start_depth[root] = R.ray;
+    known[root] = true;
+    stack.append(root);
+    while (stack.size()) {
+      const int p = stack.pop();
+      const auto& P = polys[p];
+      for (const int i : P.seeds)
+        for (const int t : range(P.offsets[i-P.seeds.lo],P.offsets[i-P.seeds.lo+1])) {
+          const int o = P.others[t],
+                    q = owner[o];
+          if (!known[q]) {
+            start_depth[q] = start_depth[p]+P.crossings[t].y-polys[q].crossings[polys[q].index.get(vec(o,i))].x;
+            known[q] = true;
+            stack.append(q);
+          }
+        }
+    }
+  }
+
+  // Walk all polygons, and extract contours
+  Hashtable<Vector<int,2>,int> graph;
+  for (const int p : range(n)) {
+    const auto& P = polys[p];
+    if (P.seeds.size())
+      walk_polygon(graph,next,P.seeds,start_depth[p]-depth,P.offsets,P.others,P.crossings);
+  }
+  return amap(quant.inverse,extract_contours(graph,next,X));
+}
+
 // Remove any polygons with fewer than three edges
 // Ideally ExactSegmentGraph would handle these, but for now we filter them out here
 static Nested<const Vec2> filter_degenerate_polys(Nested<const Vec2> polys) {
@@ -318,4 +793,17 @@ void wrap_polygon_csg() {
   GEODE_FUNCTION(split_polygons_parity)
   GEODE_FUNCTION(split_polygons_neq)
   GEODE_FUNCTION(compare_splitting_algorithms)
+
+  typedef PolygonCSG Self;
+  Class<Self>("PolygonCSG")
+    .GEODE_INIT(Box<Vec2>)
+    .GEODE_FIELD(bounds)
+    .GEODE_METHOD(size)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(remove)
+    .GEODE_METHOD(set)
+    .GEODE_METHOD(transform)
+    .GEODE_METHOD(polygon)
+    .GEODE_METHOD(split)
+    ;
 }
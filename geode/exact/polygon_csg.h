@@ -7,10 +7,19 @@
 // calling polygon_union multiple times may add more and more points.
 //
 // Warning: The worst case complexity of these algorithms is quadratic, since O(n) arbitrary line segments may
-// have up to O(n^2) intersections, and contour depth is computed in a worst case O(n^2) fashion.
+// have up to O(n^2) intersections.  Given k intersections, exact_split_polygons computes contour depth in O((n+k) log n)
+// time by propagating depth across intersections, plus one pruned nearest hit query per cluster of intersecting polygons.
 
 #include <geode/exact/config.h>
+#include <geode/exact/quantize.h>
 #include <geode/array/Nested.h>
+#include <geode/geometry/forward.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ptr.h>
+#include <geode/structure/Hashtable.h>
+#include <geode/utility/range.h>
+#include <geode/vector/forward.h>
+#include <vector>
 namespace geode {
 
 // Resolve all intersections between polygons, and extract the contour with given *external* depth.
@@ -29,6 +38,79 @@ template<class... Polys> static inline Nested<Vec2> polygon_intersection(const P
   return split_polygons(concatenate(polys...),sizeof...(Polys)-1);
 }
 
+// A persistent CSG session for editing a few polygons at a time among many.  The session caches quantized segments,
+// a segment tree per polygon, the intersections between each pair of polygons, and the sorted crossings along each
+// polygon.  Changing a polygon recomputes only its own intersections and the crossings of polygons it touched or now
+// touches.  Start depths are cached per polygon, and are recomputed only if a change could affect their ray cast.
+//
+// The quantizer is fixed by the bounds given at construction, and all polygons must stay inside them.  Removing a
+// polygon or changing its number of points abandons its seeds for symbolic perturbation.  When abandoned seeds outnumber
+// live ones, the next split packs the live seeds together and recomputes all cached intersections.
+class PolygonCSG : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const Box<Vec2> bounds;
+  const Quantizer<real,2> quant;
+
+private:
+  struct Polygon {
+    Range<int> seeds; // Indices into X, or empty if removed
+    Array<const Vec2> points;
+    Ptr<BoxTree<exact::Vec2>> tree; // Segment tree, with prims offset by seeds.lo
+    Box<exact::Vec2> box;
+    Hashtable<int> neighbors; // Other polygons with intersections
+    bool dirty; // Intersections need recomputing
+    bool stale; // Crossings need recomputing
+    Array<index_t> offsets; // Offsets into others, as for Nested
+    Array<int> others; // Segments crossing each segment, sorted along it
+    Array<Vector<int,2>> crossings; // Relative depth before and after each crossing
+    Hashtable<Vector<int,2>,int> index; // (i,o) -> index of o in others
+    int ray; // Cached ray depth at the first point, or invalid_ray
+  };
+
+  Array<exact::Vec2> X; // Quantized points, indexed by seed
+  Array<int> next; // Next point in each polygon, indexed by seed
+  std::vector<Polygon> polys;
+  Hashtable<Vector<int,2>,Array<const Vector<int,2>>> pairs; // (p,q) for p<=q -> intersecting segments of p and q
+  Array<Box<exact::Vec2>> changed; // Old and new boxes of polygons changed since the last split
+  Ptr<BoxTree<exact::Vec2>> tree; // Tree of polygon boxes, rebuilt when polygons change
+  Array<int> tree_polys; // Polygon for each prim of tree
+
+protected:
+  GEODE_CORE_EXPORT PolygonCSG(const Box<Vec2> bounds);
+public:
+  ~PolygonCSG();
+
+  // Number of polygon ids, including removed ones
+  int size() const { return int(polys.size()); }
+
+  // Add a polygon, returning its id
+  GEODE_CORE_EXPORT int add(RawArray<const Vec2> poly);
+
+  // Remove a polygon.  Its id is not reused.
+  GEODE_CORE_EXPORT void remove(const int id);
+
+  // Replace the points of a polygon, which must not have been removed
+  GEODE_CORE_EXPORT void set(const int id, RawArray<const Vec2> poly);
+
+  // Apply a rigid transform to the original points of a polygon
+  GEODE_CORE_EXPORT void transform(const int id, const Frame<Vec2>& frame);
+
+  // The current points of a polygon
+  GEODE_CORE_EXPORT Array<const Vec2> polygon(const int id) const;
+
+  // Resolve all intersections and extract the contour with given external depth, as in split_polygons
+  GEODE_CORE_EXPORT Nested<Vec2> split(const int depth);
+
+private:
+  void assign(const int id, RawArray<const Vec2> poly);
+  void invalidate(const int id);
+  void compact();
+  void update();
+};
+
 enum class FillRule { Greater, Parity, NotEqual };
 GEODE_CORE_EXPORT std::string str(const FillRule rule);
 GEODE_CORE_EXPORT Nested<Vec2> split_polygons_with_rule(Nested<const Vec2> polys, const int depth, const FillRule rule);
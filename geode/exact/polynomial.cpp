@@ -195,7 +195,7 @@ void scaled_univariate_in_place_interpolating_polynomial(Subarray<mp_limb_t,2> A
 
 static ExactInt evaluate(RawArray<const uint8_t,2> lambda, RawArray<const ExactInt> coefs,
                          RawArray<const uint8_t> inputs) {
-  GEODE_ASSERT(lambda.sizes()==vec(coefs.size(),inputs.size()));
+  GEODE_ASSERT(lambda.sizes()==vec(int(coefs.size()),int(inputs.size())));
   ExactInt sum = 0;
   for (int k=0;k<lambda.m;k++) {
     auto v = coefs[k];
@@ -0,0 +1,108 @@
+// Per-predicate counts of which evaluation stage decides each perturbed predicate or construction
+
+#include <geode/exact/predicate_counters.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/range.h>
+#include <mutex>
+#include <vector>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+namespace geode {
+
+using std::vector;
+
+GEODE_THREAD_LOCAL PredicateCounters* thread_predicate_counters = 0;
+
+namespace {
+// Registered names and per-thread counter blocks.  Function local statics avoid initialization order problems,
+// since predicate counters are registered during static initialization of other translation units.
+struct Registry {
+  std::mutex mutex;
+  vector<string> names;
+  std::map<string,int> ids;
+  vector<PredicateCounters*> threads;
+
+  Registry()
+    : names(1,"unknown") {
+    ids[names[0]] = 0;
+  }
+};
+static Registry& registry() {
+  static Registry registry;
+  return registry;
+}
+}
+
+// Turn a typeid name into something readable, dropping the namespace noise common to all predicates
+static string predicate_name(const char* name) {
+  string s = name;
+#ifdef __GNUC__
+  int status;
+  if (char* demangled = abi::__cxa_demangle(name,0,0,&status)) {
+    s = demangled;
+    free(demangled);
+  }
+#endif
+  for (const char* noise : {"geode::","(anonymous namespace)::"})
+    for (size_t i;(i=s.find(noise))!=string::npos;)
+      s.erase(i,strlen(noise));
+  return s;
+}
+
+int predicate_counter(const char* name) {
+  const auto s = predicate_name(name);
+  auto& R = registry();
+  std::lock_guard<std::mutex> lock(R.mutex);
+  const auto it = R.ids.find(s);
+  if (it != R.ids.end())
+    return it->second;
+  if (int(R.names.size()) == max_predicate_counters)
+    return 0;
+  const int id = R.names.size();
+  R.names.push_back(s);
+  R.ids[s] = id;
+  return id;
+}
+
+PredicateCounters* new_thread_predicate_counters() {
+  auto counters = new PredicateCounters();
+  auto& R = registry();
+  {
+    std::lock_guard<std::mutex> lock(R.mutex);
+    R.threads.push_back(counters);
+  }
+  return thread_predicate_counters = counters;
+}
+
+std::map<string,PredicateStageCounts> predicate_counters() {
+  auto& R = registry();
+  std::lock_guard<std::mutex> lock(R.mutex);
+  std::map<string,PredicateStageCounts> totals;
+  for (const int id : range(int(R.names.size()))) {
+    PredicateStageCounts total;
+    for (const auto counters : R.threads)
+      total += counters->counts[id];
+    if (total.sum())
+      totals[R.names[id]] = total;
+  }
+  return totals;
+}
+
+void clear_predicate_counters() {
+  auto& R = registry();
+  std::lock_guard<std::mutex> lock(R.mutex);
+  for (const auto counters : R.threads)
+    *counters = PredicateCounters();
+}
+
+}
+using namespace geode;
+
+void wrap_predicate_counters() {
+  GEODE_FUNCTION(predicate_counters)
+  GEODE_FUNCTION(clear_predicate_counters)
+}
@@ -0,0 +1,62 @@
+// Per-predicate counts of which evaluation stage decides each perturbed predicate or construction
+#pragma once
+
+// Every call to perturbed_predicate, filtered_predicate, perturbed_construct, perturbed_sign, or perturbed_ratio is
+// attributed to the stage which settled it: a static floating point filter, conservative interval arithmetic, exact
+// integer arithmetic without perturbation, or the lowest symbolic perturbation level which breaks the degeneracy.
+// Counters are kept separately for each predicate type F, and in separate blocks for each thread, so counting is a
+// thread local increment with no synchronization.  Use predicate_counters() to see where time goes.
+
+#include <geode/utility/config.h>
+#include <geode/vector/Vector.h>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <stdint.h>
+namespace geode {
+
+using std::string;
+
+// Counter stages.  Perturbation level k is counted in stage perturbation_stage+k-1, with deep levels lumped together.
+enum PredicateStage { filter_stage, interval_stage, exact_stage, perturbation_stage };
+const int predicate_stages = perturbation_stage+4;
+const int max_predicate_counters = 512;
+
+typedef Vector<uint64_t,predicate_stages> PredicateStageCounts;
+
+struct PredicateCounters {
+  PredicateStageCounts counts[max_predicate_counters];
+};
+
+// Each thread's counters are allocated on first use, and never freed so that counts survive thread exit
+GEODE_CORE_EXPORT extern GEODE_THREAD_LOCAL PredicateCounters* thread_predicate_counters;
+GEODE_CORE_EXPORT PredicateCounters* new_thread_predicate_counters();
+
+// Register a predicate name, returning its counter.  Counter 0 collects unnamed calls, and calls made during static
+// initialization.  If max_predicate_counters is exceeded, further predicates share counter 0 as well.
+GEODE_CORE_EXPORT int predicate_counter(const char* name);
+
+// The counter for predicate F, registered at load time so that lookups are free
+template<class F> struct PredicateCounter { static const int id; };
+template<class F> const int PredicateCounter<F>::id = predicate_counter(typeid(F).name());
+
+static inline void count_predicate(const int counter, const int stage) {
+  auto counters = thread_predicate_counters;
+  if (!counters)
+    counters = new_thread_predicate_counters();
+  counters->counts[counter][stage < predicate_stages ? stage : predicate_stages-1]++;
+}
+
+// Record a perturbed_sign or perturbed_ratio result settled at the given perturbation level (0 for exact arithmetic)
+static inline void count_perturbation_level(const int counter, const int level) {
+  count_predicate(counter,exact_stage+level);
+}
+
+// Sum counters over all threads, omitting predicates which have never been evaluated.  Counters of running threads
+// are read without synchronization, so call this when predicates aren't being evaluated for exact totals.
+GEODE_CORE_EXPORT std::map<string,PredicateStageCounts> predicate_counters();
+
+// Zero all counters, including those of other threads.  Not safe to call while predicates are being evaluated.
+GEODE_CORE_EXPORT void clear_predicate_counters();
+
+}
@@ -6,8 +6,14 @@
 #include <geode/exact/perturb.h>
 #include <geode/exact/scope.h>
 #include <geode/array/RawArray.h>
+#include <geode/math/cube.h>
+#include <geode/math/sqr.h>
 #include <geode/python/wrap.h>
 #include <geode/random/Random.h>
+#include <geode/utility/IRange.h>
+#include <geode/utility/Log.h>
+#include <geode/utility/time.h>
+#include <limits>
 namespace geode {
 
 using exact::Perturbed;
@@ -22,7 +28,7 @@ template<int axis, class Perturbed> bool axis_less_degenerate(const Perturbed a,
     mpz_set(result,X[1][axis]-X[0][axis]);
   }};
   const Perturbed X[2] = {a,b};
-  return perturbed_sign(F::eval,1,asarray(X));
+  return perturbed_sign(F::eval,1,asarray(X),PredicateCounter<F>::id);
 }
 
 #define IAL(d,axis) \
@@ -35,15 +41,41 @@ IAL(3,0) IAL(3,1) IAL(3,2)
 template bool axis_less_degenerate<0,exact::ImplicitlyPerturbedCenter>(const exact::ImplicitlyPerturbedCenter,const exact::ImplicitlyPerturbedCenter);
 template bool axis_less_degenerate<1,exact::ImplicitlyPerturbedCenter>(const exact::ImplicitlyPerturbedCenter,const exact::ImplicitlyPerturbedCenter);
 
+// Static floating point filters for the most common low degree predicates.  Coordinate differences of quantized inputs
+// are bounded by filter_range, so Shewchuk's first stage error bounds for orient2d, orient3d, and incircle (Shewchuk 1997,
+// "Adaptive precision floating-point arithmetic and fast robust geometric predicates") can be evaluated once for the
+// entire input range.  Predicates usually run inside an IntervalScope, so we charge each operation the full machine
+// epsilon instead of half an ulp, which makes the bounds valid in any rounding mode.
+
+namespace {
+const double filter_epsilon = std::numeric_limits<double>::epsilon(),
+             filter_range = 2*double(exact::bound),
+             filter_slack = 1+16*filter_epsilon; // Absorbs rounding in the permanents and in the bounds themselves
+const double triangle_oriented_bound = (3+16*filter_epsilon)*filter_epsilon*filter_slack*2*filter_range*filter_range,
+             incircle_bound = (10+96*filter_epsilon)*filter_epsilon*filter_slack*12*sqr(sqr(filter_range)),
+             tetrahedron_oriented_bound = (7+56*filter_epsilon)*filter_epsilon*filter_slack*6*cube(filter_range);
+
+static inline int filter_sign(const double value, const double bound) {
+  return value>bound ? 1 : value<-bound ? -1 : 0;
+}
+}
+
 // Polynomial predicates
 
 
 namespace {
-struct TriangleOriented { template<class TV> static inline PredicateType<2,TV> eval(const TV p0, const TV p1, const TV p2) {
-  return edet(p1-p0,p2-p0);
-}};}
+struct TriangleOriented {
+  template<class TV> static inline PredicateType<2,TV> eval(const TV p0, const TV p1, const TV p2) {
+    return edet(p1-p0,p2-p0);
+  }
+  static inline int filter(const Vector<Quantized,2> p0, const Vector<Quantized,2> p1, const Vector<Quantized,2> p2) {
+    const auto a = p1-p0,
+               b = p2-p0;
+    return filter_sign(a.x*b.y-a.y*b.x,triangle_oriented_bound);
+  }
+};}
 bool triangle_oriented(const P2 p0, const P2 p1, const P2 p2) {
-  return perturbed_predicate<TriangleOriented>(p0,p1,p2);
+  return filtered_predicate<TriangleOriented>(p0,p1,p2);
 }
 
 namespace {
@@ -119,14 +151,26 @@ bool ray_intersections_rightwards(const P2 a0, const P2 a1, const P2 b0, const P
 #define ROW(d) tuple(esqr_magnitude(d),d.x,d.y) // Put the quadratic entry first so that subexpressions are lower order
 
 namespace {
-struct Incircle { template<class TV> static inline PredicateType<4,TV> eval(const TV p0, const TV p1, const TV p2, const TV p3) {
-  const auto d0 = p0-p3,
-             d1 = p1-p3,
-             d2 = p2-p3;
-  return edet(ROW(d0),ROW(d1),ROW(d2));
-}};}
+struct Incircle {
+  template<class TV> static inline PredicateType<4,TV> eval(const TV p0, const TV p1, const TV p2, const TV p3) {
+    const auto d0 = p0-p3,
+               d1 = p1-p3,
+               d2 = p2-p3;
+    return edet(ROW(d0),ROW(d1),ROW(d2));
+  }
+  static inline int filter(const Vector<Quantized,2> p0, const Vector<Quantized,2> p1, const Vector<Quantized,2> p2,
+                           const Vector<Quantized,2> p3) {
+    const auto a = p0-p3,
+               b = p1-p3,
+               c = p2-p3;
+    // Expand along the quadratic column, in the same order as Shewchuk's incircle
+    return filter_sign(  a.sqr_magnitude()*(b.x*c.y-c.x*b.y)
+                       + b.sqr_magnitude()*(c.x*a.y-a.x*c.y)
+                       + c.sqr_magnitude()*(a.x*b.y-b.x*a.y),incircle_bound);
+  }
+};}
 bool incircle(const P2 p0, const P2 p1, const P2 p2, const P2 p3) {
-  return perturbed_predicate<Incircle>(p0,p1,p2,p3);
+  return filtered_predicate<Incircle>(p0,p1,p2,p3);
 }
 
 bool segments_intersect(const P2 a0, const P2 a1, const P2 b0, const P2 b1) {
@@ -139,9 +183,18 @@ struct TetrahedronOriented {
   template<class TV> static inline PredicateType<3,TV> eval(const TV p0, const TV p1, const TV p2, const TV p3) {
     return edet(p1-p0,p2-p0,p3-p0);
   }
+  static inline int filter(const Vector<Quantized,3> p0, const Vector<Quantized,3> p1, const Vector<Quantized,3> p2,
+                           const Vector<Quantized,3> p3) {
+    const auto a = p1-p0,
+               b = p2-p0,
+               c = p3-p0;
+    return filter_sign(  a.z*(b.x*c.y-c.x*b.y)
+                       + b.z*(c.x*a.y-a.x*c.y)
+                       + c.z*(a.x*b.y-b.x*a.y),tetrahedron_oriented_bound);
+  }
 };}
 bool tetrahedron_oriented(const P3 p0, const P3 p1, const P3 p2, const P3 p3) {
-  return perturbed_predicate<TetrahedronOriented>(p0,p1,p2,p3);
+  return filtered_predicate<TetrahedronOriented>(p0,p1,p2,p3);
 }
 
 namespace {
@@ -199,6 +252,14 @@ bool triangles_oriented(const P3 a0, const P3 a1, const P3 a2,
   return perturbed_predicate<TrianglesOriented>(a0,a1,a2,b0,b1,b2,c0,c1,c2);
 }
 
+// Verify that F::filter never disagrees with the unfiltered predicate.  Returns true if the filter decided.
+template<class F,class... Args> static bool check_filter(const Args... args) {
+  const int s = F::filter(args.value()...);
+  if (s)
+    GEODE_ASSERT((s>0)==perturbed_predicate<F>(args...));
+  return s!=0;
+}
+
 // Unit tests.  Warning: These do not check the geometric correctness of the predicates, only properties of exact computation and perturbation.
 
 static void predicate_tests() {
@@ -236,6 +297,162 @@ static void predicate_tests() {
     GEODE_ASSERT(!incircle(p0,p1,p2,p3));
     GEODE_ASSERT( incircle(p0,p1,p3,p2));
   }
+
+  // Check that the static filters never disagree with the unfiltered predicates, including at the extremes of the
+  // quantized range and on nearly degenerate inputs where the filters should give up.
+  typedef Vector<Quantized,3> QV3;
+  int decided = 0;
+  for (int step=0;step<1000;step++) {
+    const ExactInt b = step&1 ? exact::bound : ExactInt(1)<<random->uniform<int>(1,exact::log_bound);
+    #define RANDOM(i) \
+      const auto q##i = P2(i,QV2(random->uniform<Vector<ExactInt,2>>(-b,b))); \
+      const auto r##i = P3(i,QV3(random->uniform<Vector<ExactInt,3>>(-b,b)));
+    RANDOM(0) RANDOM(1) RANDOM(2) RANDOM(3)
+    #undef RANDOM
+    const auto corner = P2(4,QV2(b,-b)),
+               mid2 = P2(5,QV2(floor(q0.value()/2+q1.value()/2))),
+               circle = P2(6,QV2(-q0.value().y,q0.value().x));
+    const auto mid3 = P3(4,QV3(floor(r0.value()/3+r1.value()/3+r2.value()/3)));
+    const int full = step&1;
+    decided += full & check_filter<TriangleOriented>(q0,q1,q2);
+    decided += full & check_filter<Incircle>(q0,q1,q2,q3);
+    decided += full & check_filter<TetrahedronOriented>(r0,r1,r2,r3);
+    check_filter<TriangleOriented>(q0,corner,q1);
+    check_filter<TriangleOriented>(q0,q1,mid2);
+    check_filter<Incircle>(q0,corner,q1,q2);
+    check_filter<Incircle>(q0,P2(7,-q0.value()),circle,P2(8,-circle.value()));
+    check_filter<TetrahedronOriented>(r0,r1,r2,mid3);
+  }
+  // Nearly all random inputs at full scale should be decided by the filters
+  GEODE_ASSERT(decided>1450);
+}
+
+namespace {
+// Predicates which can be benchmarked with predicate_benchmark, and generators for random, nearly degenerate, and
+// exactly degenerate inputs.  Each generator takes the scale b of the inputs and the degeneracy level.
+struct TriangleOrientedBenchmark {
+  typedef TriangleOriented F;
+  typedef Vector<P2,3> Input;
+  static const char* name() { return "triangle_oriented"; }
+  static Input generate(Random& random, const ExactInt b, const int level) {
+    typedef Vector<Quantized,2> QV;
+    const QV x0(random.uniform<Vector<ExactInt,2>>(-b,b)),
+             x1(random.uniform<Vector<ExactInt,2>>(-b,b));
+    if (level==2) { // Reflect x0 through an integer point to get exactly collinear points
+      const QV mid = floor(x0/2+x1/2);
+      return Input(P2(0,x0),P2(1,mid),P2(2,2*mid-x0));
+    }
+    const QV x2 = level==0 ? QV(random.uniform<Vector<ExactInt,2>>(-b,b))
+                           : floor(x0+random.uniform<real>(0,1)*(x1-x0));
+    return Input(P2(0,x0),P2(1,x1),P2(2,x2));
+  }
+};
+
+struct IncircleBenchmark {
+  typedef Incircle F;
+  typedef Vector<P2,4> Input;
+  static const char* name() { return "incircle"; }
+  static Input generate(Random& random, const ExactInt b, const int level) {
+    typedef Vector<Quantized,2> QV;
+    Input X;
+    if (level==0)
+      for (int i=0;i<4;i++)
+        X[i] = P2(i,QV(random.uniform<Vector<ExactInt,2>>(-b,b)));
+    else if (level==1) // Round points on a circle to the integer grid
+      for (int i=0;i<4;i++)
+        X[i] = P2(i,floor(b*polar(random.uniform<real>(0,2*pi))));
+    else { // Rectangle corners are exactly cocircular
+      const QV x(random.uniform<Vector<ExactInt,2>>(0,b));
+      X = Input(P2(0,x),P2(1,QV(-x.x,x.y)),P2(2,-x),P2(3,QV(x.x,-x.y)));
+    }
+    return X;
+  }
+};
+
+struct TetrahedronOrientedBenchmark {
+  typedef TetrahedronOriented F;
+  typedef Vector<P3,4> Input;
+  static const char* name() { return "tetrahedron_oriented"; }
+  static Input generate(Random& random, const ExactInt b, const int level) {
+    typedef Vector<Quantized,3> QV;
+    const QV x0(random.uniform<Vector<ExactInt,3>>(-b,b)),
+             x1(random.uniform<Vector<ExactInt,3>>(-b,b)),
+             x2(random.uniform<Vector<ExactInt,3>>(-b,b));
+    const auto w = random.uniform<Vector<real,2>>(0,1);
+    const QV x3 = level==0 ? QV(random.uniform<Vector<ExactInt,3>>(-b,b))
+                : level==1 ? floor(x0+w.x*(x1-x0)+w.y*(x2-x0))
+                           : x1+x2-x0; // Exactly coplanar
+    return Input(P3(0,x0),P3(1,x1),P3(2,x2),P3(3,x3));
+  }
+};
+
+// Which stage decides the predicate: 0 for the static filter, 1 for intervals, 2 for exact arithmetic
+template<class F,class Input,class... entries> static inline int
+predicate_stage(const Input& X, Types<entries...>) {
+  typedef Vector<Interval,Input::value_type::m> IV;
+  return F::filter(X[entries::value].value()...)                 ? 0
+       : weak_sign(F::eval(IV(X[entries::value].value())...))    ? 1
+                                                                 : 2;
+}
+
+template<class F,class Input,class... entries> static inline bool
+filtered(const Input& X, Types<entries...>) {
+  return filtered_predicate<F>(X[entries::value]...);
+}
+
+template<class F,class Input,class... entries> static inline bool
+unfiltered(const Input& X, Types<entries...>) {
+  return perturbed_predicate<F>(X[entries::value]...);
+}
+}
+
+template<class B> static void benchmark_predicate(Random& random, const int n) {
+  typedef typename B::F F;
+  typedef typename B::Input Input;
+  const IRange<Input::m> entries;
+  Log::Scope scope(B::name());
+  const char* levels[3] = {"random","nearly degenerate","degenerate"};
+  for (const int level : range(3)) {
+    Log::Scope scope(levels[level]);
+    // Use the full quantized range, as produced by quantize.h
+    const ExactInt b = level==2 ? exact::bound/4 : exact::bound; // Leave room for exact degenerate constructions
+    Array<Input> X(n,uninit);
+    for (auto& x : X)
+      x = B::generate(random,b,level);
+
+    // Count how often each stage is reached
+    Vector<int,3> stages;
+    for (const auto& x : X)
+      stages[predicate_stage<F>(x,entries)]++;
+    Log::stat("filter",stages[0]);
+    Log::stat("interval",stages[1]);
+    Log::stat("exact",stages[2]);
+
+    // Time with and without the filter.  Results are accumulated to keep the optimizer honest.
+    int count = 0;
+    auto start = get_time();
+    for (const auto& x : X)
+      count += filtered<F>(x,entries);
+    const double filtered_time = get_time()-start;
+    start = get_time();
+    for (const auto& x : X)
+      count -= unfiltered<F>(x,entries);
+    const double unfiltered_time = get_time()-start;
+    GEODE_ASSERT(!count);
+    Log::stat("filtered predicates per second",n/filtered_time);
+    Log::stat("unfiltered predicates per second",n/unfiltered_time);
+  }
+}
+
+// Measure throughput of the filtered predicates, and how often each stage is reached, on random, nearly degenerate,
+// and exactly degenerate inputs.
+static void predicate_benchmark(const int n) {
+  IntervalScope scope;
+  const auto random = new_<Random>(1823131);
+  Log::Scope log("predicate benchmark");
+  benchmark_predicate<TriangleOrientedBenchmark>(random,n);
+  benchmark_predicate<IncircleBenchmark>(random,n);
+  benchmark_predicate<TetrahedronOrientedBenchmark>(random,n);
 }
 
 }
@@ -243,4 +460,5 @@ using namespace geode;
 
 void wrap_predicates() {
   GEODE_FUNCTION(predicate_tests)
+  GEODE_FUNCTION(predicate_benchmark)
 }
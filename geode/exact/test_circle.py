@@ -182,6 +182,26 @@ def test_circles():
         assert allclose(area,circle_arc_area(circle_arc_union(arcs1,arcs1)))
         assert allclose(area,circle_arc_area(circle_arc_intersection(arcs1,arcs1)))
 
+def test_parallel_circles():
+  random.seed(81731)
+  k = 3
+  for depth in -2,-1,0,1:
+    # Clusters of random contours spread over a grid, so that most clusters are independent
+    arcs = empty((64,10,k),dtype=CircleArc).view(recarray)
+    arcs.x = 6*indices((8,8)).reshape(2,-1).T.reshape(-1,1,1,2)+random.randn(64,10,1,2)+.5*random.randn(64,10,k,2)
+    arcs.q = random.uniform(-1.5,1.5,size=(64,10,k))
+    arcs = Nested(arcs.reshape(-1,k))
+    serial = split_circle_arcs(arcs,depth)
+    for task_arcs in 1,100,1<<20:
+      parallel = parallel_split_circle_arcs(arcs,depth,task_arcs)
+      assert len(parallel)==len(serial)
+      assert allclose(circle_arc_area(parallel),circle_arc_area(serial))
+      # Contours should match up to order and roundoff in constructed vertices.  For depth<0 the unbounded face is
+      # inside the result, so this checks that no task contributes a contour around its own outer face.
+      p,s = canonicalize_circle_arcs(parallel),canonicalize_circle_arcs(serial)
+      assert all(p.offsets==s.offsets)
+      assert allclose(p.flat['x'],s.flat['x']) and allclose(p.flat['q'],s.flat['q'])
+
 def test_single_circle(show_results=False):
   seed = 151193
   max_count = 10
@@ -13,6 +13,16 @@ def test_interval():
 def test_predicates():
   predicate_tests()
 
+def test_predicate_counters():
+  clear_predicate_counters()
+  predicate_tests()
+  counts = predicate_counters()
+  for name in 'TriangleOriented','Incircle','TetrahedronOriented':
+    assert len(counts[name])==len(predicate_stages)
+    assert counts[name][0]>0 # Random inputs are decided by the static filter
+  clear_predicate_counters()
+  assert not predicate_counters()
+
 def test_constructions():
   construction_tests()
 
@@ -56,6 +66,22 @@ def test_delaunay(benchmark=False,cgal=False,origin=True,circle=False,constrain=
             if n>0 and mesh.n_faces!=nf:
               Log.write('expected %d faces, got %d'%(mesh.n_faces,nf))
 
+def test_delaunay_parallel():
+  def edges(mesh):
+    # Sorted directed edges, which determine the oriented faces of a triangulation
+    tris = mesh.elements()
+    edges = concatenate([tris[:,:2],tris[:,1:],tris[:,::-2]])
+    return edges[lexsort(edges.T[::-1])]
+  random.seed(7)
+  grid = indices((256,256)).reshape(2,-1).T.astype(real) # Highly degenerate: all grid cells are cocircular
+  for name,X in ('gaussian',random.randn(1<<16,2)),('grid',grid):
+    with Log.scope('parallel delaunay %s %d'%(name,len(X))):
+      serial = delaunay_points(X)
+      mesh = delaunay_points(X,validate=True,parallel=True)
+      mesh.assert_consistent(True)
+      assert mesh.n_vertices==len(X)
+      assert all(edges(mesh)==edges(serial))
+
 def draw_polygons(polys):
   import pylab
   for p,points in enumerate(polys):
@@ -101,6 +127,64 @@ def test_polygon():
       print 'error = %g'%error
       assert False
 
+def test_polygon_clusters():
+  # Many small clusters of overlapping quads, nested inside two large squares.  Depth propagates within each cluster,
+  # and each cluster takes its depth from the first segment hit by a ray, so compare against the graph based algorithm
+  # at several depths.
+  random.seed(1731)
+  k,n = 4,8
+  centers = 3*indices((n,n)).reshape(2,-1).T.astype(real)
+  quads = centers.reshape(-1,1,1,2)+random.randn(len(centers),3,1,2)/3 \
+        + polar(sort(random.uniform(2*pi,size=(len(centers),3,k)),axis=-1))*abs(random.randn(len(centers),3,k,1))/2
+  square = asarray([[-2,-2],[3*n+1,-2],[3*n+1,3*n+1],[-2,3*n+1]],dtype=real)
+  polys = Nested.concatenate(Nested(quads.reshape(-1,k,2)),Nested([square]),Nested([square+[3*n,0]]))
+  for depth in 0,1,2:
+    compare_splitting_algorithms(polys,depth)
+
+def test_polygon_session():
+  random.seed(8123)
+  k,n = 4,30
+  def random_polygon(k):
+    return random.randn(1,2)+polar(sort(random.uniform(2*pi,size=k)))*abs(random.randn(k,1))/2
+  session = PolygonCSG(Box((-10,-10),(10,10)))
+  ids = [session.add(random_polygon(k)) for _ in xrange(n)]
+  def check():
+    # Compare contours against a session built from scratch from the current polygons, and against split_polygons.
+    # split_polygons quantizes to the bounding box of its input rather than the session bounds, so constructed vertices
+    # agree only up to roundoff.
+    current = [session.polygon(i) for i in ids if len(session.polygon(i))]
+    fresh = PolygonCSG(session.bounds)
+    for p in current:
+      fresh.add(p)
+    for depth in 0,1:
+      result = canonicalize_polygons(session.split(depth))
+      for expected in fresh.split(depth),split_polygons(Nested(current),depth):
+        expected = canonicalize_polygons(expected)
+        assert all(result.offsets==expected.offsets)
+        assert allclose(result.flat,expected.flat)
+  check()
+  # Move, replace, remove and add single polygons, checking against a full recomputation each time.  Enough polygons
+  # are removed or resized that abandoned seeds are compacted along the way.
+  for step in xrange(80):
+    i = ids[random.randint(len(ids))]
+    if not len(session.polygon(i)):
+      continue
+    if step%4==0:
+      session.transform(i,Frames(random.randn(2)/2,Rotation.from_angle(random.uniform(2*pi))))
+    elif step%4==1:
+      session.set(i,random_polygon(k+1+step%3))
+    elif step%4==2:
+      session.remove(i)
+      # Removed ids are not reused, so they can't be set again
+      try:
+        session.set(i,random_polygon(k))
+        assert False
+      except ValueError:
+        pass
+    else:
+      ids.append(session.add(random_polygon(k)))
+    check()
+
 if __name__=='__main__':
   Log.configure('exact tests',0,0,100)
   if '-i' in sys.argv:
@@ -112,6 +196,8 @@ if __name__=='__main__':
     test_delaunay(Mesh=Mesh,benchmark=True,origin=False,cgal=cgal,circle=circle,constrain=False)
   elif '-p' in sys.argv:
     test_polygon()
+  elif '-f' in sys.argv:
+    predicate_benchmark(1<<20)
   else:
     test_fast_exact()
     test_predicates()
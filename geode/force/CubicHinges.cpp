@@ -1,6 +1,7 @@
 // Cubic hinges based on Garg et al. 2007
 
 #include <geode/force/CubicHinges.h>
+#include <geode/force/coloring.h>
 #include <geode/array/view.h>
 #include <geode/math/copysign.h>
 #include <geode/geometry/Triangle3d.h>
@@ -180,6 +181,7 @@ template<class TV> CubicHinges<TV>::CubicHinges(Array<const Vector<int,d+2>> ben
   , stiffness(0)
   , damping(0)
   , simple_hessian(false)
+  , parallel(false)
   , nodes_(bends.size()?scalar_view(bends).max()+1:0)
   , info(bends.size()) {
   GEODE_ASSERT(bends.size()==angles.size());
@@ -189,6 +191,10 @@ template<class TV> CubicHinges<TV>::CubicHinges(Array<const Vector<int,d+2>> ben
 
 template<class TV> CubicHinges<TV>::~CubicHinges() {}
 
+template<class TV> Nested<const int> CubicHinges<TV>::colors() const {
+  return lazy_colors(parallel,colors_,bends,nodes_);
+}
+
 template<class TV> int CubicHinges<TV>::nodes() const {
   return nodes_;
 }
@@ -246,9 +252,9 @@ template<class TV> T CubicHinges<TV>::damping_energy(RawArray<const TV> V) const
   return damping?damping*energy_helper<true>(bends,info,V):0;
 }
 
-template<bool simple> static void add_force_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const T scale, RawArray<TV2> F, RawArray<const TV2> X) {
+template<bool simple> static void add_force_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const Nested<const int>& colors, const T scale, RawArray<TV2> F, RawArray<const TV2> X) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
+  colored_for(colors,bends.size(),[&](const int b) {
     const auto& I = info[b];
     int i0,i1,i2;bends[b].get(i0,i1,i2);
     const TV2 x0 = X[i0], x1 = X[i1], x2 = X[i2],
@@ -262,12 +268,12 @@ template<bool simple> static void add_force_helper(RawArray<const Vector<int,3>>
     F[i0] -= f0;
     F[i1] += f0+f2;
     F[i2] -= f2;
-  }
+  });
 }
 
-template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const T scale, RawArray<TV3> F, RawArray<const TV3> X) {
+template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const Nested<const int>& colors, const T scale, RawArray<TV3> F, RawArray<const TV3> X) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
+  colored_for(colors,bends.size(),[&](const int b) {
     const auto& I = info[b];
     int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
     const TV3 x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3],
@@ -291,38 +297,38 @@ template<bool simple> static void add_force_helper(RawArray<const Vector<int,4>>
       F[i2] -= I.c[2]*stress+cross12;
       F[i3] -= I.c[3]*stress+cross20;
     }
-  }
+  });
 }
 
 template<class TV> void CubicHinges<TV>::add_elastic_force(RawArray<TV> F) const {
   GEODE_ASSERT(F.size()>=nodes_);
-  add_force_helper<false>(bends,info,stiffness,F,X);
+  add_force_helper<false>(bends,info,colors(),stiffness,F,X);
 }
 
 template<class TV> void CubicHinges<TV>::add_damping_force(RawArray<TV> F, RawArray<const TV> V) const {
   GEODE_ASSERT(F.size()>=nodes_ && V.size()>=nodes_);
-  add_force_helper<true>(bends,info,damping,F,V);
+  add_force_helper<true>(bends,info,colors(),damping,F,V);
 }
 
 template<> void CubicHinges<TV2>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   // 2D forces are unconditionally linear, so we can always reuse force computation
   GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
   if (simple_hessian)
-    add_force_helper<true>(bends,info,stiffness,dF,dX);
+    add_force_helper<true>(bends,info,colors(),stiffness,dF,dX);
   else
-    add_force_helper<false>(bends,info,stiffness,dF,dX);
+    add_force_helper<false>(bends,info,colors(),stiffness,dF,dX);
 }
 
 template<> void CubicHinges<TV3>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
   if (simple_hessian) // In the simple case, the force is linear and the differential is easy
-    add_force_helper<true>(bends,info,stiffness,dF,dX);
+    add_force_helper<true>(bends,info,colors(),stiffness,dF,dX);
   else { // Otherwise, we need custom code
     GEODE_ASSERT(dF.size()>=nodes_ && dX.size()>=nodes_);
     const T scale = stiffness;
     if (!scale) return;
     RawArray<const TV> X = this->X;
-    for (int b=0;b<bends.size();b++) {
+    colored_for(colors(),bends.size(),[&](const int b) {
       const auto& I = info[b];
       int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
       const TV x0 = X[i0], x1 = X[i1], x2 = X[i2], x3 = X[i3];
@@ -342,7 +348,7 @@ template<> void CubicHinges<TV3>::add_elastic_differential(RawArray<TV> dF, RawA
       dF[i1] -= I.c[1]*dstress-dcross01-dcross12-dcross20;
       dF[i2] -= I.c[2]*dstress+dcross12;
       dF[i3] -= I.c[3]*dstress+dcross20;
-    }
+    });
   }
 }
 
@@ -354,9 +360,9 @@ structure(SolidMatrixStructure& structure) const {
         structure.add_entry(bend[i],bend[j]);
 }
 
-template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const T scale, RawArray<const TV2> X, SolidMatrix<TV2>& matrix) {
+template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,3>> bends, RawArray<const CubicHinges<TV2>::Info> info, const Nested<const int>& colors, const T scale, RawArray<const TV2> X, SolidMatrix<TV2>& matrix) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
+  colored_for(colors,bends.size(),[&](const int b) {
     const auto& I = info[b];
     int i0,i1,i2;bends[b].get(i0,i1,i2);
     const T quad = -scale*I.dot;
@@ -374,12 +380,12 @@ template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,
       matrix.add_entry(i0,i2,quad*I.c[0]*I.c[2]+anti);
       matrix.add_entry(i1,i2,quad*I.c[1]*I.c[2]-anti);
     }
-  }
+  });
 }
 
-template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const T scale, RawArray<const TV3> X, SolidMatrix<TV3>& matrix) {
+template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,4>> bends, RawArray<const CubicHinges<TV3>::Info> info, const Nested<const int>& colors, const T scale, RawArray<const TV3> X, SolidMatrix<TV3>& matrix) {
   if (!scale) return;
-  for (int b=0;b<bends.size();b++) {
+  colored_for(colors,bends.size(),[&](const int b) {
     const auto& I = info[b];
     int i0,i1,i2,i3;bends[b].get(i0,i1,i2,i3);
     const T quad = -scale*I.dot;
@@ -404,35 +410,35 @@ template<bool simple> static void add_gradient_helper(RawArray<const Vector<int,
       matrix.add_entry(i1,i3,quad*I.c[1]*I.c[3]+cross_product_matrix(x0-x2)); //  e4
       matrix.add_entry(i2,i3,quad*I.c[2]*I.c[3]+cross_product_matrix(x1-x0)); // -e2
     }
-  }
+  });
 }
 
 template<class TV> void CubicHinges<TV>::
 add_elastic_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()>=nodes_);
   if (simple_hessian)
-    add_gradient_helper<true>(bends,info,stiffness,X,matrix);
+    add_gradient_helper<true>(bends,info,colors(),stiffness,X,matrix);
   else
-    add_gradient_helper<false>(bends,info,stiffness,X,matrix);
+    add_gradient_helper<false>(bends,info,colors(),stiffness,X,matrix);
 }
 
 template<class TV> void CubicHinges<TV>::
 add_damping_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()>=nodes_);
-  add_gradient_helper<true>(bends,info,damping,X,matrix);
+  add_gradient_helper<true>(bends,info,colors(),damping,X,matrix);
 }
 
 template<class TV> void CubicHinges<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,d+1>> dFdX) const {
   GEODE_ASSERT(dFdX.size()>=nodes_);
   if (!stiffness) return;
   const T scale = stiffness;
-  for (int b=0;b<bends.size();b++) {
+  colored_for(colors(),bends.size(),[&](const int b) {
     const auto bend = bends[b];
     const auto& I = info[b];
     const T quad = scale*I.dot;
     for (int i=0;i<bend.size();i++)
       dFdX[bend[i]] -= quad*sqr(I.c[i]);
-  }
+  });
 }
 
 template class CubicHinges<TV2>;
@@ -450,6 +456,7 @@ template<int d> static void wrap_helper() {
     .GEODE_FIELD(stiffness)
     .GEODE_FIELD(damping)
     .GEODE_FIELD(simple_hessian)
+    .GEODE_FIELD(parallel)
     ;
 }
 
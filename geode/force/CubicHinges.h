@@ -2,6 +2,7 @@
 #pragma once
 
 #include <geode/force/Force.h>
+#include <geode/array/Nested.h>
 #include <geode/mesh/forward.h>
 #include <geode/vector/forward.h>
 namespace geode {
@@ -30,10 +31,12 @@ public:
   const Array<const Vector<int,d+2>> bends;
   T stiffness, damping;
   bool simple_hessian;
+  bool parallel; // Assemble forces and gradients in parallel over a coloring of the bends
 private:
   const int nodes_;
   const Array<Info> info;
   Array<const TV> X;
+  mutable Nested<const int> colors_; // Computed on first parallel use
 
 protected:
   CubicHinges(Array<const Vector<int,d+2>> bends, RawArray<const T> angles, RawArray<const TV> X);
@@ -59,6 +62,8 @@ public:
 
   // For testing purposes: equal to elastic_energy only for isometric deformations and nice rest triangles
   T slow_elastic_energy(RawArray<const T> angles, RawArray<const TV> restX, RawArray<const TV> X) const;
+private:
+  Nested<const int> colors() const;
 };
 
 }
@@ -1,5 +1,6 @@
 //#####################################################################
 #include <geode/force/FiniteVolume.h>
+#include <geode/force/coloring.h>
 #include <geode/force/AnisotropicConstitutiveModel.h>
 #include <geode/force/IsotropicConstitutiveModel.h>
 #include <geode/force/DiagonalizedStressDerivative.h>
@@ -30,6 +31,7 @@ template<class TV,int d> FiniteVolume<TV,d>::FiniteVolume(StrainMeasure<T,d>& st
   , density(density)
   , model(ref(model))
   , plasticity(plasticity)
+  , parallel(false)
   , Be_scales(strain.elements.size(),uninit)
   , stress_derivatives_valid(false)
   , definite(false) {
@@ -41,6 +43,10 @@ template<class TV,int d> FiniteVolume<TV,d>::FiniteVolume(StrainMeasure<T,d>& st
 
 template<class TV,int d> FiniteVolume<TV,d>::~FiniteVolume() {}
 
+template<class TV,int d> Nested<const int> FiniteVolume<TV,d>::colors() const {
+  return lazy_colors(parallel,colors_,strain->elements,strain->nodes);
+}
+
 template<class TV,int d> int FiniteVolume<TV,d>::nodes() const {
   return strain->nodes;
 }
@@ -109,15 +115,15 @@ template<class TV,int d> typename TV::Scalar FiniteVolume<TV,d>::elastic_energy(
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_force(RawArray<TV> F) const {
   if (anisotropic)
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
       Matrix<T,m,d> forces = in_plane<d>(U[t])*anisotropic->P_From_Strain(Fe_hat[t],V[t],Be_scales[t],t).times_transpose(De_inverse_hat[t]);
       strain->distribute_force(F,t,forces);
-    }
+    });
   else
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
       Matrix<T,m,d> forces = in_plane<d>(U[t])*isotropic->P_From_Strain(Fe_hat[t],Be_scales[t],t).times_transpose(De_inverse_hat[t]);
       strain->distribute_force(F,t,forces);
-    }
+    });
 }
 
 template<int m,int d> static inline typename enable_if_c<m==d,const DiagonalizedIsotropicStressDerivative<T,m>&>::type
@@ -159,18 +165,18 @@ template<class TV,int d> void FiniteVolume<TV,d>::update_stress_derivatives() co
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   update_stress_derivatives();
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative())
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
       Matrix<T,m,d> dDs = strain->Ds(dX,t),
                     Up = in_plane<d>(U[t]),
                     dG = Up*(Be_scales[t]*dP_dFe[t].differential(Up.transpose_times(dDs)*De_inverse_hat[t]).times_transpose(De_inverse_hat[t]));
       strain->distribute_force(dF,t,dG);
-    }
+    });
   else
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
       Matrix<T,m,d> dDs = strain->Ds(dX,t),
                     dG = U[t]*(Be_scales[t]*dPi_dFe[t].differential(U[t].transpose_times(dDs)*De_inverse_hat[t]).times_transpose(De_inverse_hat[t]));
       strain->distribute_force(dF,t,dG);
-    }
+    });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const {
@@ -178,8 +184,8 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient_block_dia
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative())
     GEODE_NOT_IMPLEMENTED();
   else {
-    Matrix<T,m> dGdD[d][d];
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
+      Matrix<T,m> dGdD[d][d];
       for (int i=0;i<d;i++)
         for(int j=0;j<m;j++) {
           Matrix<T,m,d> dDs;
@@ -196,7 +202,7 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient_block_dia
         for (int j=0;j<d;j++)
           sum += assume_symmetric(dGdD[i][j]);
       dFdX[nodes[0]] += sum;
-    }
+    });
   }
 }
 
@@ -205,8 +211,8 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient(SolidMatr
   if (anisotropic && !anisotropic->use_isotropic_stress_derivative())
     GEODE_NOT_IMPLEMENTED();
   else {
-    Matrix<T,m> dGdD[d+1][d+1];
-    for (int t=0;t<strain->elements.size();t++) {
+    colored_for(colors(),strain->elements.size(),[&](const int t) {
+      Matrix<T,m> dGdD[d+1][d+1];
       for (int i=0;i<d;i++)
         for (int j=0;j<m;j++) {
           Matrix<T,m,d> dDs;
@@ -228,7 +234,7 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_elastic_gradient(SolidMatr
       for (int j=0;j<d+1;j++)
         for (int i=j;i<d+1;i++)
           matrix.add_entry(nodes[i],nodes[j],dGdD[i][j]);
-    }
+    });
   }
 }
 
@@ -242,17 +248,17 @@ template<class TV,int d> typename TV::Scalar FiniteVolume<TV,d>::damping_energy(
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_damping_force(RawArray<TV> F,RawArray<const TV> V) const {
-  for (int t=0;t<strain->elements.size();t++) {
+  colored_for(colors(),strain->elements.size(),[&](const int t) {
     Matrix<T,m,d> Up = in_plane<d>(U[t]);
     Matrix<T,d> Fe_dot_hat = Up.transpose_times(strain->Ds(V,t))*De_inverse_hat[t];
     Matrix<T,m,d> forces = Up*model->P_From_Strain_Rate(Fe_hat[t],Fe_dot_hat,Be_scales[t],t).times_transpose(De_inverse_hat[t]);
     strain->distribute_force(F,t,forces);
-  }
+  });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_damping_gradient(SolidMatrix<TV>& matrix) const {
-  Matrix<T,m> dGdD[d+1][d+1];
-  for (int t=0;t<strain->elements.size();t++) {
+  colored_for(colors(),strain->elements.size(),[&](const int t) {
+    Matrix<T,m> dGdD[d+1][d+1];
     Matrix<T,m,d> Up = in_plane<d>(U[t]);
     for (int i=0;i<d;i++)
       for (int j=0;j<m;j++) {
@@ -276,7 +282,7 @@ template<class TV,int d> void FiniteVolume<TV,d>::add_damping_gradient(SolidMatr
     for (int j=0;j<d+1;j++)
       for (int i=j;i<d+1;i++)
         matrix.add_entry(nodes[i],nodes[j],dGdD[i][j]);
-  }
+  });
 }
 
 template<class TV,int d> void FiniteVolume<TV,d>::add_frequency_squared(RawArray<T> frequency_squared) const {
@@ -311,6 +317,7 @@ template<int m,int d> static void wrap_helper() {
   static const string name = format("FiniteVolume%s",d==3?"3d":m==3?"S3d":"2d");
   Class<Self>(name.c_str())
     .GEODE_INIT(StrainMeasure<T,d>&,T,ConstitutiveModel<T,d>&,Ptr<PlasticityModel<T,d>>)
+    .GEODE_FIELD(parallel)
     ;
 }
 
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <geode/force/Force.h>
+#include <geode/array/Nested.h>
 #include <geode/python/Ptr.h>
 #include <geode/vector/Matrix.h>
 #include <geode/force/StrainMeasure.h>
@@ -23,6 +24,7 @@ public:
   const T density;
   Ref<ConstitutiveModel<T,d>> model;
   Ptr<PlasticityModel<T,d>> plasticity;
+  bool parallel; // Assemble forces and gradients in parallel over a coloring of the elements
 protected:
   Array<T> Be_scales;
   Array<Matrix<T,m>> U;
@@ -34,6 +36,7 @@ protected:
   mutable bool stress_derivatives_valid,definite;
   mutable Array<DiagonalizedIsotropicStressDerivative<T,m,d>> dPi_dFe;
   mutable Array<DiagonalizedStressDerivative<T,d>> dP_dFe;
+  mutable Nested<const int> colors_; // Computed on first parallel use
 public:
 
 protected:
@@ -57,6 +60,7 @@ public:
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
 private:
   void update_stress_derivatives() const;
+  Nested<const int> colors() const;
 };
 
 }
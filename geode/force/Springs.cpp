@@ -2,6 +2,7 @@
 // Class Springs
 //#####################################################################
 #include <geode/force/Springs.h>
+#include <geode/force/coloring.h>
 #include <geode/array/NdArray.h>
 #include <geode/array/ProjectedArray.h>
 #include <geode/array/view.h>
@@ -20,6 +21,7 @@ template<class TV> Springs<TV>::Springs(Array<const Vector<int,2>> springs, Arra
   : springs(springs)
   , resist_compression(true)
   , off_axis_damping(0)
+  , parallel(false)
   , nodes_(X.size())
   , mass(mass)
   , info(springs.size(),uninit) {
@@ -46,6 +48,10 @@ template<class TV> Array<T> Springs<TV>::restlengths() const {
   return info.template project<T,&SpringInfo<TV>::restlength>().copy();
 }
 
+template<class TV> Nested<const int> Springs<TV>::colors() const {
+  return lazy_colors(parallel,colors_,springs,nodes_);
+}
+
 template<class TV> int Springs<TV>::nodes() const {
   return nodes_;
 }
@@ -111,49 +117,49 @@ template<class TV> T Springs<TV>::elastic_energy() const {
 
 template<class TV> void Springs<TV>::add_elastic_force(RawArray<TV> F) const {
   GEODE_ASSERT(F.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors(),springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I=info[s];
     TV f = I.stiffness*(I.length-I.restlength)*I.direction;
     F[i] += f;
     F[j] -= f;
-  }
+  });
 }
 
 template<class TV> void Springs<TV>::add_elastic_differential(RawArray<TV> dF, RawArray<const TV> dX) const {
   GEODE_ASSERT(dF.size()==nodes_);
   GEODE_ASSERT(dX.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors(),springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j); 
     const SpringInfo<TV>& I=info[s];
     TV dx = dX[j]-dX[i];
     TV f = I.alpha*dx+I.beta*dot(dx,I.direction)*I.direction;
     dF[i] += f;
     dF[j] -= f;
-  }
+  });
 }
 
 template<class TV> void Springs<TV>::add_elastic_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors(),springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j);
     const SpringInfo<TV>& I=info[s];
     SymmetricMatrix<T,3> A = scaled_outer_product(I.beta,I.direction)+I.alpha;
     matrix.add_entry(i,-A);
     matrix.add_entry(i,j,A);
     matrix.add_entry(j,-A);
-  }
+  });
 }
 
 template<class TV> void Springs<TV>::add_elastic_gradient_block_diagonal(RawArray<SymmetricMatrix<T,m>> dFdX) const {
   GEODE_ASSERT(dFdX.size()==nodes_);
-  for (int s=0;s<springs.size();s++) {
+  colored_for(colors(),springs.size(),[&](const int s) {
     int i,j;springs[s].get(i,j); 
     const SpringInfo<TV>& I = info[s];
     SymmetricMatrix<T,m> A = scaled_outer_product(I.beta,I.direction)+I.alpha;
     dFdX[i] -= A;
     dFdX[j] -= A;
-  }
+  });
 }
 
 template<class TV> T Springs<TV>::damping_energy(RawArray<const TV> V) const {
@@ -182,41 +188,41 @@ template<class TV> void Springs<TV>::add_damping_force(RawArray<TV> force,RawArr
   GEODE_ASSERT(V.size()==nodes_);
   GEODE_ASSERT(force.size()==nodes_);
   if (!off_axis_damping)
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors(),springs.size(),[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       TV f = I.damping*dot(V[j]-V[i],I.direction)*I.direction;
       force[i]+=f;force[j]-=f;
-    }
+    });
   else {
     const T alpha = off_axis_damping,
             beta = 1-off_axis_damping;
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors(),springs.size(),[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       TV dv = V[j]-V[i];
       TV f = alpha*I.damping*dv+beta*I.damping*dot(dv,I.direction)*I.direction;
       force[i] += f;
       force[j] -= f;
-    }
+    });
   }
 }
 
 template<class TV> void Springs<TV>::add_damping_gradient(SolidMatrix<TV>& matrix) const {
   GEODE_ASSERT(matrix.size()==nodes_);
   if (!off_axis_damping)
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors(),springs.size(),[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       SymmetricMatrix<T,3> A = scaled_outer_product(I.damping,I.direction);
       matrix.add_entry(i,-A);
       matrix.add_entry(i,j,A);
       matrix.add_entry(j,-A);
-    }
+    });
   else {
     const T alpha = off_axis_damping,
             beta = 1-off_axis_damping;
-    for (int s=0;s<springs.size();s++) {
+    colored_for(colors(),springs.size(),[&](const int s) {
       int i,j;springs[s].get(i,j);
       const SpringInfo<TV>& I=info[s];
       SymmetricMatrix<T,3> A = scaled_outer_product(beta*I.damping,I.direction);
@@ -224,7 +230,7 @@ template<class TV> void Springs<TV>::add_damping_gradient(SolidMatrix<TV>& matri
       matrix.add_entry(i,-A);
       matrix.add_entry(i,j,A);
       matrix.add_entry(j,-A);
-    }
+    });
   }
 }
 
@@ -278,6 +284,7 @@ void wrap_springs() {
     .GEODE_FIELD(resist_compression)
     .GEODE_FIELD(strain_range)
     .GEODE_FIELD(off_axis_damping)
+    .GEODE_FIELD(parallel)
     .GEODE_METHOD(limit_strain)
     ;
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <geode/array/Array.h>
+#include <geode/array/Nested.h>
 #include <geode/force/Force.h>
 #include <geode/vector/Vector.h>
 #include <geode/geometry/Box.h>
@@ -32,11 +33,13 @@ public:
   bool resist_compression;
   Box<T> strain_range;
   T off_axis_damping; // between 0 and 1
+  bool parallel; // Assemble forces and gradients in parallel over a coloring of the springs
 private:
   const int nodes_;
   Array<const T> mass;
   Array<const TV> X;
   const Array<SpringInfo<TV>> info;
+  mutable Nested<const int> colors_; // Computed on first parallel use
 protected:
   Springs(Array<const Vector<int,2>> springs, Array<const T> mass, Array<const TV> X, NdArray<const T> stiffness, NdArray<const T> damping_ratio);
 public:
@@ -60,6 +63,8 @@ public:
   void structure(SolidMatrixStructure& structure) const;
   void add_elastic_gradient(SolidMatrix<TV>& matrix) const;
   void add_damping_gradient(SolidMatrix<TV>& matrix) const;
+private:
+  Nested<const int> colors() const;
 };
 
 }
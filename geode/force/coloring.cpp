@@ -0,0 +1,61 @@
+// Element coloring for parallel force assembly
+
+#include <geode/force/coloring.h>
+#include <geode/utility/range.h>
+#include <stdint.h>
+namespace geode {
+
+template<int k> Nested<const int> color_elements(RawArray<const Vector<int,k>> elements, const int nodes) {
+  // Assign colors in rounds of 64, tracking the colors used at each node as a bit mask.  Elements which find all
+  // 64 colors of a round taken at one of their nodes wait for the next round.
+  const int n = elements.size();
+  Array<int> color(n,uninit);
+  Array<uint64_t> used(nodes,uninit);
+  Array<int> remaining(n,uninit), next;
+  for (const int e : range(n))
+    remaining[e] = e;
+  int colors = 0;
+  for (int base=0;remaining.size();base+=64) {
+    used.zero();
+    next.clear();
+    for (const int e : remaining) {
+      uint64_t mask = 0;
+      for (const int i : elements[e]) {
+        GEODE_ASSERT(unsigned(i)<unsigned(nodes));
+        mask |= used[i];
+      }
+      if (!~mask) {
+        next.append(e);
+        continue;
+      }
+      int c = 0;
+      while (mask>>c&1)
+        c++;
+      for (const int i : elements[e])
+        used[i] |= uint64_t(1)<<c;
+      color[e] = base+c;
+      colors = max(colors,base+c+1);
+    }
+    remaining.swap(next);
+  }
+
+  // Group elements by color, preserving order within each color
+  Array<int> counts(colors);
+  for (const int c : color)
+    counts[c]++;
+  Nested<int> result(counts,uninit);
+  counts.zero();
+  for (const int e : range(n)) {
+    const int c = color[e];
+    result(c,counts[c]++) = e;
+  }
+  return result;
+}
+
+#define INSTANTIATE(k) \
+  template GEODE_CORE_EXPORT Nested<const int> color_elements(RawArray<const Vector<int,k>>,const int);
+INSTANTIATE(2)
+INSTANTIATE(3)
+INSTANTIATE(4)
+
+}
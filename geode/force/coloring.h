@@ -0,0 +1,42 @@
+// Element coloring for parallel force assembly
+#pragma once
+
+#include <geode/array/Nested.h>
+#include <geode/vector/Vector.h>
+namespace geode {
+
+// Greedily color elements so that no two elements of the same color share a node, returning the elements of each
+// color in increasing order.  Elements are colored in order, so the result is deterministic.
+template<int k> GEODE_CORE_EXPORT Nested<const int> color_elements(RawArray<const Vector<int,k>> elements,
+                                                                   const int nodes);
+
+// The coloring to pass to colored_for: empty if parallel is false, and otherwise the coloring of elements, computed
+// into cache on first use.  The elements must not change between calls.
+template<int k> static inline Nested<const int> lazy_colors(const bool parallel, Nested<const int>& cache,
+                                                            const Array<const Vector<int,k>>& elements, const int nodes) {
+  if (!parallel)
+    return Nested<const int>();
+  if (cache.flat.size() != elements.size())
+    cache = color_elements<k>(elements,nodes);
+  return cache;
+}
+
+// Call body(e) for each of n elements.  With empty colors, elements are visited serially in order.  Otherwise the
+// elements of each color are visited in parallel, one color at a time, so bodies which scatter into per node arrays
+// or SolidMatrix rows never touch the same node concurrently.
+template<class Body> static inline void colored_for(const Nested<const int>& colors, const int n, const Body& body) {
+  if (colors.empty()) {
+    for (int e=0;e<n;e++)
+      body(e);
+  } else {
+    assert(colors.flat.size()==n);
+    for (int c=0;c<colors.size();c++) {
+      const auto elements = colors[c];
+      #pragma omp parallel for
+      for (int i=0;i<elements.size();i++)
+        body(elements[i]);
+    }
+  }
+}
+
+}
@@ -2,8 +2,9 @@
 
 from __future__ import absolute_import
 
+import sys
 from numpy import *
-from geode import real
+from geode import real,Log,SolidMatrix,SolidMatrixStructure,relative_error
 from geode.force import *
 from geode.force.force_test import *
 from geode.geometry.platonic import *
@@ -193,5 +194,48 @@ def test_particle_binding_springs():
   springs = particle_binding_springs([[1,2]],mass,7,1.2)
   force_test(springs,X,verbose=1)
 
+def test_parallel_assembly(benchmark=False):
+  # Colored parallel assembly matches serial assembly up to rounding
+  random.seed(81721)
+  n = 1000 if benchmark else 30
+  mesh = grid_topology(n,n)
+  X0 = zeros((n+1,n+1,3))
+  X0[:,:,:2] = transpose(indices((n+1,n+1)),(1,2,0))/n
+  X0 = X0.reshape(-1,3)
+  X = X0+.1/n*random.randn(*X0.shape)
+  dX = random.randn(*X.shape)
+  mass = ones(len(X))
+  shell = finite_volume(mesh,1000,X0,neo_hookean(),verbose=False)
+  forces = [('springs',edge_springs(mesh,mass,X0,7,1.2)),
+            ('hinges',cubic_hinges(mesh,X0,7,3)),
+            ('shell',shell)]
+  for name,force in forces:
+    structure = SolidMatrixStructure(len(X))
+    force.structure(structure)
+    matrix = SolidMatrix[3](structure)
+    def assemble():
+      force.update_position(X,False)
+      F = zeros_like(X)
+      force.add_elastic_force(F)
+      dF = zeros_like(X)
+      force.add_elastic_differential(dF,dX)
+      matrix.zero()
+      force.add_elastic_gradient(matrix)
+      force.add_damping_gradient(matrix)
+      KdX = empty_like(X)
+      matrix.multiply(dX,KdX)
+      return F,dF,KdX,force.elastic_gradient_block_diagonal_times(dX)
+    results = []
+    for parallel in False,True:
+      force.parallel = parallel
+      with Log.scope('%s %s assembly'%(name,'parallel' if parallel else 'serial')):
+        for i in xrange(10 if benchmark else 1):
+          results.append(assemble())
+    for a,b in zip(results[0],results[-1]):
+      assert relative_error(a,b)<1e-10
+
 if __name__=='__main__':
-  test_simple_shell()
+  if '-b' in sys.argv:
+    test_parallel_assembly(benchmark=True)
+  else:
+    test_simple_shell()
@@ -8,8 +8,12 @@
 #include <geode/geometry/Box.h>
 #include <geode/geometry/Sphere.h>
 #include <geode/geometry/traverse.h>
+#include <geode/math/clamp.h>
+#include <geode/math/constants.h>
 #include <geode/math/integer_log.h>
 #include <geode/python/Class.h>
+#include <geode/python/wrap.h>
+#include <queue>
 namespace geode {
 using std::cout;
 using std::endl;
@@ -17,6 +21,21 @@ using std::endl;
 template<> GEODE_DEFINE_TYPE(BoxTree<Vector<real,2>>)
 template<> GEODE_DEFINE_TYPE(BoxTree<Vector<real,3>>)
 
+#ifdef GEODE_PYTHON
+PyObject* to_python(const BoxTreeSplit split) {
+  return to_python(split==BoxTreeSplit::SAH ? "sah" : "median");
+}
+
+template<> BoxTreeSplit FromPython<BoxTreeSplit>::convert(PyObject* object) {
+  const string split = from_python<string>(object);
+  if (split=="median")
+    return BoxTreeSplit::Median;
+  else if (split=="sah")
+    return BoxTreeSplit::SAH;
+  throw ValueError(format("BoxTree: unknown split rule '%s', expected 'median' or 'sah'",split));
+}
+#endif
+
 namespace {
 
 struct CenterCompare {
@@ -52,29 +71,122 @@ Array<const Range<int>> ranges(int prims, int leaf_size) {
   return ranges;
 }
 
-template<class Geo,class TV> void
-build(BoxTree<TV>& self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo, int node) {
+// Primitives are either points or boxes
+template<class TV> static inline const TV& center(const TV& x) { return x; }
+template<class TV> static inline TV center(const Box<TV>& box) { return box.center(); }
+template<class TV> static inline Box<TV> bounds(const TV& x) { return Box<TV>(x); }
+template<class TV> static inline const Box<TV>& bounds(const Box<TV>& box) { return box; }
+
+// Half the surface measure of a box, which is all the surface area heuristic needs
+template<class T> static inline T half_area(const Box<Vector<T,2>>& box) {
+  return box.sizes().sum();
+}
+template<class T> static inline T half_area(const Box<Vector<T,3>>& box) {
+  const auto s = box.sizes();
+  return s.x*(s.y+s.z)+s.y*s.z;
+}
+
+// Surface area heuristic contribution of a node
+template<class TV> static inline typename TV::Scalar node_sah_area(const BoxTree<TV>& self, const int node, const Box<TV>& box) {
+  return (self.is_leaf(node) ? self.ranges[node].size() : 1)*half_area(box);
+}
+
+// Subtrees with at least this many primitives are built as separate tasks
+const int parallel_prims = 1<<12;
+
+// Choose a split axis using the binned surface area heuristic.  The packed layout fixes the split count,
+// so for each axis we bin primitive centers, find the bin containing the split, and estimate the child
+// boxes from the bins on either side.  A partially filled split bin is counted on both sides.
+template<class Geo,class TV> static int sah_axis(RawArray<const Geo> geo, RawArray<const int> p, const int split) {
+  typedef typename TV::Scalar T;
+  const int bins = 16;
+  Box<TV> centers;
+  for (const int i : p)
+    centers.enlarge(center(geo[i]));
+  const TV sizes = centers.sizes();
+
+  int best_axis = sizes.argmax();
+  T best_cost = inf;
+  for (int axis=0;axis<TV::m;axis++) {
+    if (!sizes[axis])
+      continue;
+    const T scale = bins/sizes[axis];
+    int counts[bins] = {0};
+    Box<TV> boxes[bins];
+    for (const int i : p) {
+      const int b = clamp(int(scale*(center(geo[i])[axis]-centers.min[axis])),0,bins-1);
+      counts[b]++;
+      boxes[b].enlarge(bounds(geo[i]));
+    }
+    // Find the bin containing the split
+    int b = 0, below = 0;
+    while (below+counts[b]<split)
+      below += counts[b++];
+    Box<TV> left, right;
+    for (int j=0;j<b;j++)
+      left.enlarge(boxes[j]);
+    for (int j=b+1;j<bins;j++)
+      right.enlarge(boxes[j]);
+    if (below+counts[b]>split) {
+      left.enlarge(boxes[b]);
+      right.enlarge(boxes[b]);
+    } else
+      left.enlarge(boxes[b]);
+    const T cost = split*half_area(left)+(p.size()-split)*half_area(right);
+    if (best_cost>cost) {
+      best_cost = cost;
+      best_axis = axis;
+    }
+  }
+  return best_axis;
+}
+
+template<class Geo,class TV> static void
+build(BoxTree<TV>* self, RawArray<const Range<int>> ranges, RawArray<const Geo> geo, const BoxTreeSplit split, int node) {
   // Compute box
   const auto r = ranges[node];
-  Box<TV>& box = self.boxes[node];
-  box = Box<TV>(geo[self.p[r.lo]]);
+  Box<TV>& box = self->boxes[node];
+  box = Box<TV>(geo[self->p[r.lo]]);
   for (int i=r.lo+1;i<r.hi;i++)
-    box.enlarge_nonempty(geo[self.p[i]]);
+    box.enlarge_nonempty(geo[self->p[i]]);
 
-  // Recursively split along largest axis if necessary
-  if (self.is_leaf(node))
-    sort(self.p.slice(r.lo,r.hi).const_cast_());
+  // Recursively split if necessary
+  if (self->is_leaf(node))
+    sort(self->p.slice(r.lo,r.hi).const_cast_());
   else {
-    const int axis = box.sizes().argmax();
-    int* pp = const_cast<int*>(self.p.data());
+    const int mid = ranges[2*node+1].hi;
+    const int axis = split==BoxTreeSplit::SAH ? sah_axis<Geo,TV>(geo,self->p.slice(r.lo,r.hi),mid-r.lo)
+                                              : box.sizes().argmax();
+    int* pp = const_cast<int*>(self->p.data());
     std::nth_element(pp+r.lo,
-                     pp+ranges[2*node+1].hi,
+                     pp+mid,
                      pp+r.hi,indirect_comparison(geo,CenterCompare(axis)));
-    build(self,ranges,geo,2*node+1);
-    build(self,ranges,geo,2*node+2);
+    // Children touch disjoint parts of p and boxes, so large ones can be built concurrently
+    if (r.size()>=parallel_prims) {
+      #pragma omp task
+      build(self,ranges,geo,split,2*node+1);
+    } else
+      build(self,ranges,geo,split,2*node+1);
+    build(self,ranges,geo,split,2*node+2);
   }
 }
 
+template<class Geo,class TV> static void build(BoxTree<TV>& self, RawArray<const Geo> geo, const BoxTreeSplit split) {
+  if (!self.leaves.size())
+    return;
+  const RawArray<const Range<int>> ranges = self.ranges;
+  #pragma omp parallel if(geo.size()>=2*parallel_prims)
+  #pragma omp single
+  build(&self,ranges,geo,split,0);
+}
+
+template<class TV> static typename TV::Scalar total_sah_area(const BoxTree<TV>& self) {
+  typename TV::Scalar sum = 0;
+  for (const int n : range(self.nodes()))
+    sum += node_sah_area(self,n,self.boxes[n]);
+  return sum;
+}
+
 }
 
 static int check_leaf_size(int leaf_size) {
@@ -97,44 +209,95 @@ static inline Range<int> leaf_range(int prims, int leaf_size) {
   return range(leaves-1,2*leaves-1);
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const TV> geo, const int leaf_size, const BoxTreeSplit split)
   : leaf_size(check_leaf_size(leaf_size))
   , leaves(leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
   , p(arange(geo.size()).copy())
   , ranges(geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
+  , split(split)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  build(*this,geo,split);
+  sah_area = total_sah_area(*this);
+  built_sah_cost = sah_cost();
 }
 
-template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size)
+template<class TV> BoxTree<TV>::BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const BoxTreeSplit split)
   : leaf_size(check_leaf_size(leaf_size))
   , leaves(leaf_range(geo.size(),leaf_size))
   , depth(geode::depth(leaves.size()))
   , p(arange(geo.size()).copy())
   , ranges(geode::ranges(geo.size(),leaf_size))
   , boxes(max(0,leaves.hi),uninit)
+  , split(split)
 {
-  if (leaves.size())
-    build(*this,ranges,geo,0);
+  build(*this,geo,split);
+  sah_area = total_sah_area(*this);
+  built_sah_cost = sah_cost();
 }
 
 template<class TV> BoxTree<TV>::BoxTree(const BoxTree<TV>& other)
   : leaf_size(other.leaf_size)
   , leaves(other.leaves)
   , depth(other.depth)
-  , p(other.p)
+  , p(other.p.copy()) // Not shared, since rebuild changes it
   , ranges(other.ranges)
   , boxes(other.boxes.copy()) // Don't share ownership with geometry
+  , split(other.split)
+  , sah_area(other.sah_area)
+  , built_sah_cost(other.built_sah_cost)
 {}
 
 template<class TV> BoxTree<TV>::~BoxTree() {}
 
+template<class TV> void BoxTree<TV>::rebuild(RawArray<const Box<TV>> geo) {
+  GEODE_ASSERT(geo.size()==p.size());
+  build(*this,geo,split);
+  sah_area = total_sah_area(*this);
+  built_sah_cost = sah_cost();
+}
+
 template<class TV> void BoxTree<TV>::update_nonleaf_boxes() {
   for(int n=leaves.lo-1;n>=0;n--)
     boxes[n] = Box<TV>::combine(boxes[2*n+1],boxes[2*n+2]);
+  sah_area = total_sah_area(*this);
+}
+
+template<class TV> void BoxTree<TV>::
+update_leaf_boxes(RawArray<const int> leaves, RawArray<const Box<TV>> leaf_boxes) {
+  GEODE_ASSERT(leaves.size()==leaf_boxes.size());
+  // Parents have smaller indices than their children, so popping the largest dirty node first
+  // recomputes each node after all of its dirty descendants.
+  std::priority_queue<int> dirty;
+  for (const int i : range(leaves.size())) {
+    const int n = leaves[i];
+    assert(is_leaf(n));
+    sah_area += node_sah_area(*this,n,leaf_boxes[i])-node_sah_area(*this,n,boxes[n]);
+    boxes[n] = leaf_boxes[i];
+    if (n)
+      dirty.push(parent(n));
+  }
+  int last = -1;
+  while (!dirty.empty()) {
+    const int n = dirty.top();
+    dirty.pop();
+    if (n == last)
+      continue;
+    last = n;
+    const auto box = Box<TV>::combine(boxes[2*n+1],boxes[2*n+2]);
+    if (box == boxes[n])
+      continue;
+    sah_area += half_area(box)-half_area(boxes[n]);
+    boxes[n] = box;
+    if (n)
+      dirty.push(parent(n));
+  }
+}
+
+template<class TV> typename TV::Scalar BoxTree<TV>::sah_cost() const {
+  const T root = nodes() ? half_area(boxes[0]) : 0;
+  return root ? sah_area/root : 0;
 }
 
 namespace {
@@ -199,16 +362,20 @@ void wrap_box_tree() {
   {typedef Vector<real,2> TV;
   typedef BoxTree<TV> Self;
   Class<Self>("BoxTree2d")
-    .GEODE_INIT(RawArray<const TV>,int)
+    .GEODE_INIT(RawArray<const TV>,int,BoxTreeSplit)
     .GEODE_FIELD(p)
+    .GEODE_FIELD(split)
     .GEODE_METHOD(check)
+    .GEODE_METHOD(sah_cost)
     ;}
 
   {typedef Vector<real,3> TV;
   typedef BoxTree<TV> Self;
   Class<Self>("BoxTree3d")
-    .GEODE_INIT(RawArray<const TV>,int)
+    .GEODE_INIT(RawArray<const TV>,int,BoxTreeSplit)
     .GEODE_FIELD(p)
+    .GEODE_FIELD(split)
     .GEODE_METHOD(check)
+    .GEODE_METHOD(sah_cost)
     ;}
 }
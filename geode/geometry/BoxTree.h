@@ -10,6 +10,18 @@
 //
 // For templatized visitor-based traversal, include traversal.h.
 //
+// Since the packed layout fixes the number of primitives on each side of
+// every split, construction only chooses the split axis.  BoxTreeSplit::Median
+// splits along the longest axis of each node; BoxTreeSplit::SAH picks the axis
+// minimizing a binned surface area heuristic, which gives better culling on
+// uneven geometry at a modest build cost.  Large subtrees are built as
+// parallel OpenMP tasks in either mode, and the result is independent of the
+// thread count.
+//
+// When only a few primitives move, update_leaf_boxes refits just the changed
+// leaves and their ancestors.  sah_cost() tracks tree quality through refits
+// so that callers can rebuild once refitting has degraded the tree too far.
+//
 //#####################################################################
 #pragma once
 
@@ -20,6 +32,14 @@
 #include <geode/utility/range.h>
 namespace geode {
 
+enum class BoxTreeSplit { Median, SAH };
+
+#ifdef GEODE_PYTHON
+// In python, split rules are the strings 'median' and 'sah'
+GEODE_CORE_EXPORT PyObject* to_python(const BoxTreeSplit split);
+template<> GEODE_CORE_EXPORT BoxTreeSplit FromPython<BoxTreeSplit>::convert(PyObject* object);
+#endif
+
 template<class TV> class BoxTree : public Object
 {
   typedef typename TV::Scalar T;
@@ -33,11 +53,18 @@ public:
   const Array<const int> p; // index permutation
   const Array<const Range<int>> ranges;
   const Array<Box<TV>> boxes;
+  const BoxTreeSplit split; // Split rule used to build the tree
 
 protected:
-  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size);
-  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size);
-  GEODE_CORE_EXPORT BoxTree(const BoxTree<TV>& other); // Shares ownership with everything except boxes
+  T sah_area; // Sum of node surface areas, with leaves weighted by primitive count
+  T built_sah_cost; // sah_cost() immediately after the last build
+
+  GEODE_CORE_EXPORT BoxTree(RawArray<const TV> geo, const int leaf_size, const BoxTreeSplit split=BoxTreeSplit::Median);
+  GEODE_CORE_EXPORT BoxTree(RawArray<const Box<TV>> geo, const int leaf_size, const BoxTreeSplit split=BoxTreeSplit::Median);
+  GEODE_CORE_EXPORT BoxTree(const BoxTree<TV>& other); // Shares ownership with everything except p and boxes
+
+  // Rebuild the tree for new primitive geometry in place, keeping the same leaf ranges
+  GEODE_CORE_EXPORT void rebuild(RawArray<const Box<TV>> geo);
 public:
   ~BoxTree();
 
@@ -74,6 +101,18 @@ public:
   }
 
   GEODE_CORE_EXPORT void update_nonleaf_boxes();
+
+  // Set the boxes of the given leaves and refit their ancestors, leaving all other nodes untouched
+  GEODE_CORE_EXPORT void update_leaf_boxes(RawArray<const int> leaves, RawArray<const Box<TV>> leaf_boxes);
+
+  // Surface area heuristic cost relative to the root box (lower is better), maintained incrementally
+  GEODE_CORE_EXPORT T sah_cost() const;
+
+  // Ratio of the current sah_cost() to its value after the last build
+  T sah_degradation() const {
+    return built_sah_cost ? sah_cost()/built_sah_cost : 1;
+  }
+
   void check(RawArray<const TV> x) const;
 
   // Warning: Doesn't know about structure without each tree leaf
@@ -16,8 +16,8 @@ template<> GEODE_DEFINE_TYPE(ParticleTree<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(ParticleTree<Vector<T,3>>)
 
 template<class TV> ParticleTree<TV>::
-ParticleTree(Array<const TV> X,int leaf_size)
-  : Base(X.raw(),leaf_size), X(X) {}
+ParticleTree(Array<const TV> X, int leaf_size, BoxTreeSplit split)
+  : Base(X.raw(),leaf_size,split), X(X) {}
 
 template<class TV> ParticleTree<TV>::
 ~ParticleTree() {}
@@ -32,11 +32,11 @@ update() {
 namespace {
 template<class TV> struct DuplicatesVisitor {
   const ParticleTree<TV>& tree;
-  UnionFind components;
   T tolerance;
+  Array<Vector<int,2>> pairs;
 
   DuplicatesVisitor(const ParticleTree<TV>& tree, T tolerance)
-    : tree(tree), components(tree.X.size()), tolerance(tolerance) {}
+    : tree(tree), tolerance(tolerance) {}
 
   bool cull(int n) const { return false; }
   bool cull(int n0, int n1) const { return false; }
@@ -45,28 +45,31 @@ template<class TV> struct DuplicatesVisitor {
     auto prims = tree.prims(n);
     for (int i=0;i<prims.size();i++) for (int j=i+1;j<prims.size();j++)
       if((tree.X[prims[i]]-tree.X[prims[j]]).sqr_magnitude()<=sqr(tolerance))
-        components.merge(prims[i],prims[j]);
+        pairs.append(vec(prims[i],prims[j]));
   }
 
   void leaf(int n0, int n1) {
     for (int i : tree.prims(n0)) for (int j : tree.prims(n1))
       if ((tree.X[i]-tree.X[j]).sqr_magnitude()<=sqr(tolerance))
-        components.merge(i,j);
+        pairs.append(vec(i,j));
   }
 };
 }
 
 template<class TV> Array<int> ParticleTree<TV>::
 remove_duplicates(T tolerance) const {
-  DuplicatesVisitor<TV> visitor(*this,tolerance);
-  double_traverse(*this,visitor,tolerance);
+  const auto visitors = parallel_double_traverse(*this,[=](){ return DuplicatesVisitor<TV>(*this,tolerance); },tolerance);
+  UnionFind components(X.size());
+  for (const auto& visitor : visitors)
+    for (const auto& p : visitor.pairs)
+      components.merge(p.x,p.y);
   Array<int> map(X.size(),uninit);
   int count=0;
   for(int i=0;i<X.size();i++)
-    if(visitor.components.is_root(i))
+    if(components.is_root(i))
       map[i] = count++;
   for(int i=0;i<X.size();i++)
-    map[i] = map[visitor.components.find(i)];
+    map[i] = map[components.find(i)];
   return map;
 }
 
@@ -148,7 +151,7 @@ template<int d> static void wrap_helper() {
   typedef Vector<T,d> TV;
   typedef ParticleTree<TV> Self;
   Class<Self>(d==2?"ParticleTree2d":"ParticleTree3d")
-    .GEODE_INIT(Array<const TV>,int)
+    .GEODE_INIT(Array<const TV>,int,BoxTreeSplit)
     .GEODE_FIELD(X)
     .GEODE_METHOD(update)
     .GEODE_METHOD(remove_duplicates)
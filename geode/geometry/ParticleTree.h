@@ -21,7 +21,7 @@ public:
   const Array<const TV> X;
 
 protected:
-  GEODE_CORE_EXPORT ParticleTree(Array<const TV> X, int leaf_size);
+  GEODE_CORE_EXPORT ParticleTree(Array<const TV> X, int leaf_size, BoxTreeSplit split=BoxTreeSplit::Median);
 public:
   ~ParticleTree();
 
@@ -0,0 +1,56 @@
+// SIMD ray-box intersection tests for packets of four rays
+#pragma once
+
+#include <geode/geometry/Box.h>
+#include <geode/geometry/RayIntersection.h>
+#include <geode/math/constants.h>
+#include <geode/math/Lanes4.h>
+namespace geode {
+
+// Up to four 3D rays in SoA form, tested against boxes together.  Unlike FastRay, the rays in a packet may lie in different
+// octants, so we take the min and max of the two slab distances instead of templatizing over signs.  If a ray starts exactly
+// on a slab boundary and is parallel to it, 0*inf produces nan, and the SSE min/max semantics drop that slab: the box test
+// is conservative in this case, which is fine since it is only used for culling.
+template<class T> struct RayPacket {
+  typedef Vector<T,3> TV;
+  static const int width = 4;
+
+  Lanes4<T> start[3], inv_dx[3];
+  T t_max[width]; // Kept as a plain array so that single lanes can be shortened after scalar simplex hits
+  int live; // Mask of lanes containing actual rays
+
+  RayPacket(const RayIntersection<TV>* rays, const int n)
+    : live((1<<n)-1) {
+    assert(0<n && n<=width);
+    T s[3][width], inv[3][width];
+    for (int i=0;i<width;i++) {
+      const auto& ray = rays[i<n?i:0]; // Pad with copies of the first ray
+      const TV inv_i = 1/ray.direction;
+      for (int a=0;a<3;a++) {
+        s[a][i] = ray.start[a];
+        inv[a][i] = inv_i[a];
+      }
+      t_max[i] = ray.t_max;
+    }
+    for (int a=0;a<3;a++) {
+      start[a] = Lanes4<T>::load(s[a]);
+      inv_dx[a] = Lanes4<T>::load(inv[a]);
+    }
+  }
+
+  // Returns the mask of live rays which hit the enlarged box before their t_max, and their entry distances in t_min
+  int intersects(const Box<TV>& box, const T box_enlargement, Lanes4<T>& t_min) const {
+    auto lo = Lanes4<T>::splat(-inf),
+         hi = Lanes4<T>::splat(inf);
+    for (int a=0;a<3;a++) {
+      const auto t0 = inv_dx[a]*(Lanes4<T>::splat(box.min[a]-box_enlargement)-start[a]),
+                 t1 = inv_dx[a]*(Lanes4<T>::splat(box.max[a]+box_enlargement)-start[a]);
+      lo = max(min(t0,t1),lo);
+      hi = min(max(t0,t1),hi);
+    }
+    t_min = lo;
+    return live & movemask(lo<=hi) & movemask(Lanes4<T>::splat(0)<=hi) & movemask(lo<=Lanes4<T>::load(t_max));
+  }
+};
+
+}
@@ -3,6 +3,7 @@
 //#####################################################################
 #include <geode/geometry/SimplexTree.h>
 #include <geode/geometry/FastRay.h>
+#include <geode/geometry/RayPacket.h>
 #include <geode/geometry/Sphere.h>
 #include <geode/geometry/Segment.h>
 #include <geode/geometry/traverse.h>
@@ -10,6 +11,7 @@
 #include <geode/geometry/Triangle3d.h>
 #include <geode/array/IndirectArray.h>
 #include <geode/python/Class.h>
+#include <geode/python/ExceptionValue.h>
 #include <geode/random/Random.h>
 
 // Windows silliness
@@ -26,19 +28,23 @@ template<class TV,int d_> const int SimplexTree<TV,d_>::d;
 template<class Mesh,class TV> static Array<Box<TV>> boxes(const Mesh& mesh, Array<const TV> X) {
   GEODE_ASSERT(mesh.nodes()<=X.size());
   Array<Box<TV>> boxes(mesh.elements.size(),uninit);
+  #pragma omp parallel for
   for(int t=0;t<mesh.elements.size();t++)
     boxes[t] = bounding_box(X.subset(mesh.elements[t]));
   return boxes;
 }
 
-template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size)
-  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit) {
+template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, BoxTreeSplit split)
+  : Base(RawArray<const Box<TV>>(geode::boxes(mesh,X)),leaf_size,split), mesh(ref(mesh)), X(X), simplices(mesh.elements.size(),uninit)
+  , rebuild_ratio(inf), refits(0), rebuilds(0) {
+  #pragma omp parallel for
   for (int t=0;t<mesh.elements.size();t++)
     simplices[t] = Simplex(X.subset(mesh.elements[t]));
 }
 
 template<class TV,int d> SimplexTree<TV,d>::SimplexTree(const SimplexTree& other, Array<const TV> X)
-  : Base(other), mesh(other.mesh), X(X), simplices(mesh->elements.size(),uninit) {
+  : Base(other), mesh(other.mesh), X(X), simplices(mesh->elements.size(),uninit)
+  , rebuild_ratio(other.rebuild_ratio), refits(0), rebuilds(0) {
   GEODE_ASSERT(mesh->nodes()<=X.size());
   update();
 }
@@ -58,6 +64,50 @@ template<class TV,int d> void SimplexTree<TV,d>::update() {
   update_nonleaf_boxes();
 }
 
+template<class TV,int d> void SimplexTree<TV,d>::update(RawArray<const int> moved) {
+  RawArray<const Vector<int,d+1>> elements = mesh->elements;
+  if (prim_leaf.size() != elements.size()) {
+    prim_leaf.resize(elements.size(),uninit);
+    for (const int n : leaves)
+      for (const int t : prims(n))
+        prim_leaf[t] = n;
+  }
+
+  // Recompute simplices touching moved vertices
+  const auto incident = mesh->incident_elements();
+  Array<int> changed;
+  for (const int v : moved)
+    if (incident.valid(v))
+      changed.extend(incident[v]);
+  std::sort(changed.begin(),changed.end());
+  changed.resize(int(std::unique(changed.begin(),changed.end())-changed.begin()));
+  Array<int> dirty;
+  for (const int t : changed) {
+    simplices[t] = Simplex(X.subset(elements[t]));
+    dirty.append(prim_leaf[t]);
+  }
+
+  // Refit only the affected leaves and their ancestors
+  std::sort(dirty.begin(),dirty.end());
+  dirty.resize(int(std::unique(dirty.begin(),dirty.end())-dirty.begin()));
+  Array<Box<TV>> dirty_boxes(dirty.size(),uninit);
+  for (const int i : range(dirty.size())) {
+    Box<TV> box;
+    for (const int s : prims(dirty[i]))
+      box.enlarge(geode::bounding_box(X.subset(elements[s])));
+    dirty_boxes[i] = box;
+  }
+  Base::update_leaf_boxes(dirty,dirty_boxes);
+
+  // Rebuild if refitting has degraded the tree too far
+  if (sah_degradation() > rebuild_ratio) {
+    Base::rebuild(geode::boxes(*mesh,X));
+    prim_leaf.clear();
+    rebuilds++;
+  } else
+    refits++;
+}
+
 namespace {
 template<class T> struct PlaneVisitor {
   const SimplexTree<Vector<T,3>,2>& self;
@@ -170,6 +220,125 @@ template<class TV,int d> bool SimplexTree<TV,d>::intersection(RayIntersection<TV
   return true;
 }
 
+// Packet version of intersection_helper: trace up to four rays through the tree together.  Each stack entry carries the mask
+// of rays still alive in that subtree.  Box tests are done for the whole packet at once, and simplex tests one ray at a time.
+static void packet_intersection_helper(const SimplexTree<Vector<real,3>,2>& self, RayIntersection<Vector<real,3>>* rays,
+                                       const int n, const real half_thickness) {
+  const int width = RayPacket<real>::width;
+  RayPacket<real> packet(rays,n);
+  Lanes4<real> t_min;
+  const int root = packet.intersects(self.boxes[0],half_thickness,t_min);
+  if (!root)
+    return;
+  struct Entry {
+    int node, mask;
+    real t_min[width];
+    Entry(const int node, const int mask, const Lanes4<real> t_min) : node(node), mask(mask) { t_min.store(this->t_min); }
+  };
+  const int internal = self.leaves.lo;
+  RawStack<Entry> stack(GEODE_RAW_ALLOCA(self.depth,Entry));
+  stack.push(Entry(0,root,t_min));
+  while (stack.size()) {
+    const auto entry = stack.pop();
+    // Check t_min again since the packet's t_max may have changed
+    const int mask = entry.mask & movemask(Lanes4<real>::load(entry.t_min)<=Lanes4<real>::load(packet.t_max));
+    if (!mask)
+      continue;
+    const int node = entry.node;
+    if (node < internal) {
+      int child0 = 2*node+1,
+          child1 = 2*node+2;
+      Lanes4<real> range0, range1;
+      int mask0 = mask & packet.intersects(self.boxes[child0],half_thickness,range0),
+          mask1 = mask & packet.intersects(self.boxes[child1],half_thickness,range1);
+      // Sort children by t_min of the first ray hitting either of them
+      int lead = 0;
+      while (!((mask0|mask1)>>lead&1) && lead<width)
+        lead++;
+      if (lead==width)
+        continue;
+      real t0[width], t1[width];
+      range0.store(t0);
+      range1.store(t1);
+      if ((mask0>>lead&1 ? t0[lead] : inf) > (mask1>>lead&1 ? t1[lead] : inf)) {
+        swap(child0,child1);
+        swap(mask0,mask1);
+        swap(range0,range1);
+      }
+      // Push child with larger t_min onto the stack first, so that we check smaller t_min first
+      if (mask1)
+        stack.push(Entry(child1,mask1,range1));
+      if (mask0)
+        stack.push(Entry(child0,mask0,range0));
+    } else {
+      // Test all simplices in this leaf against each live ray
+      for (const int t : self.prims(node))
+        for (int i=0;i<n;i++)
+          if (mask>>i&1 && self.simplices[t].intersection(rays[i],half_thickness)) {
+            packet.t_max[i] = rays[i].t_max;
+            rays[i].aggregate_id = t;
+          }
+    }
+  }
+}
+
+// Packets are only implemented for 3D triangles, so other trees trace rays one at a time.  Some trees don't support
+// ray queries at all, so errors are caught inside the parallel loop and rethrown after it.
+template<class TV,int d> void SimplexTree<TV,d>::intersection(RawArray<const TV> starts, RawArray<const TV> directions,
+                                                              RawArray<T> t_max, RawArray<int> hits, const T half_thickness) const {
+  const int n = starts.size();
+  GEODE_ASSERT(directions.size()==n && t_max.size()==n && hits.size()==n);
+  ExceptionValue error;
+  #pragma omp parallel for schedule(dynamic,64)
+  for (int i=0;i<n;i++) {
+    try {
+      RayIntersection<TV> ray(starts[i],directions[i]);
+      ray.t_max = t_max[i];
+      if (intersection(ray,half_thickness)) {
+        t_max[i] = ray.t_max;
+        hits[i] = ray.aggregate_id;
+      } else
+        hits[i] = -1;
+    } catch (const std::exception& e) {
+      #pragma omp critical
+      {
+        if (!error)
+          error = ExceptionValue(e);
+      }
+    }
+  }
+  if (error)
+    error.throw_();
+}
+
+template<> void SimplexTree<Vector<real,3>,2>::intersection(RawArray<const Vector<real,3>> starts, RawArray<const Vector<real,3>> directions,
+                                                            RawArray<real> t_max, RawArray<int> hits, const real half_thickness) const {
+  typedef Vector<real,3> TV;
+  const int n = starts.size(),
+            width = RayPacket<real>::width;
+  GEODE_ASSERT(directions.size()==n && t_max.size()==n && hits.size()==n);
+  hits.fill(-1);
+  if (boxes.size() == 0)
+    return; // No intersections possible for empty trees
+  const int packets = (n+width-1)/width;
+  #pragma omp parallel for schedule(dynamic,16)
+  for (int p=0;p<packets;p++) {
+    const int lo = width*p,
+              count = min(width,n-lo);
+    RayIntersection<TV> rays[width];
+    for (int i=0;i<count;i++) {
+      rays[i].initialize(starts[lo+i],directions[lo+i]);
+      rays[i].t_max = t_max[lo+i];
+    }
+    packet_intersection_helper(*this,rays,count,half_thickness);
+    for (int i=0;i<count;i++)
+      if (rays[i].aggregate_id >= 0) {
+        t_max[lo+i] = rays[i].t_max;
+        hits[lo+i] = rays[i].aggregate_id;
+      }
+  }
+}
+
 namespace {
 template<class TV,int d> struct SphereVisitor {
   const SimplexTree<TV,d>& self;
@@ -389,6 +558,39 @@ template<class T, int d> static int ray_traversal_test(const SimplexTree<Vector<
   return hits;
 }
 
+// Trace a coherent res x res grid of rays from a viewpoint outside the tree, one at a time or in packets.
+// Returns the hit distance and simplex for each ray, with -1 for rays which miss.
+static Tuple<Array<real>,Array<int>> ray_grid_test(const SimplexTree<Vector<real,3>,2>& tree, const int res,
+                                                   const real half_thickness, const bool packet) {
+  typedef Vector<real,3> TV;
+  GEODE_ASSERT(res>0);
+  const auto box = tree.bounding_box();
+  const TV eye = box.center()+TV(.3,.2,2)*box.sizes().max(),
+           corner = box.min-eye;
+  const TV du(box.sizes().x/res,0,0),
+           dv(0,box.sizes().y/res,0);
+  const int n = sqr(res);
+  Array<TV> starts(n,uninit), directions(n,uninit);
+  for (int i=0;i<res;i++)
+    for (int j=0;j<res;j++) {
+      starts[res*i+j] = eye;
+      directions[res*i+j] = corner+(i+.5)*du+(j+.5)*dv;
+    }
+  Array<real> t(n);
+  t.fill(4*box.sizes().max());
+  Array<int> hits(n,uninit);
+  if (packet)
+    tree.intersection(starts,directions,t,hits,half_thickness);
+  else
+    for (int i=0;i<n;i++) {
+      RayIntersection<TV> ray(starts[i],directions[i]);
+      ray.t_max = t[i];
+      hits[i] = tree.intersection(ray,half_thickness) ? ray.aggregate_id : -1;
+      t[i] = ray.t_max;
+    }
+  return tuple(t,hits);
+}
+
 }
 using namespace geode;
 
@@ -396,11 +598,15 @@ template<class TV,int d> static void wrap_helper() {
   typedef SimplexTree<TV,d> Self;
   static const string name = format("%sTree%dd",(d==1?"Segment":"Triangle"),TV::m);
   Class<Self>(name.c_str())
-    .GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int)
+    .GEODE_INIT(const typename Self::Mesh&,Array<const TV>,int,BoxTreeSplit)
     .GEODE_FIELD(mesh)
     .GEODE_FIELD(X)
     .GEODE_FIELD(d)
-    .GEODE_METHOD(update)
+    .GEODE_FIELD(rebuild_ratio)
+    .GEODE_FIELD(refits)
+    .GEODE_FIELD(rebuilds)
+    .GEODE_OVERLOADED_METHOD(void(Self::*)(),update)
+    .GEODE_OVERLOADED_METHOD_2(void(Self::*)(RawArray<const int>),"update_moved",update)
     .GEODE_METHOD(closest_point)
     .GEODE_METHOD(distance)
     ;
@@ -412,4 +618,5 @@ void wrap_simplex_tree() {
   wrap_helper<Vector<real,3>,1>();
   wrap_helper<Vector<real,3>,2>();
   GEODE_FUNCTION_2(ray_traversal_test,ray_traversal_test<real,3>)
+  GEODE_FUNCTION(ray_grid_test)
 }
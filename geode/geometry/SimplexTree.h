@@ -21,21 +21,32 @@ public:
   typedef typename mpl::if_c<d==1,Segment<TV>,Triangle<TV>>::type Simplex;
   typedef typename mpl::if_c<d==1,T,Vector<T,3>>::type Weights;
   using Base::leaves;using Base::prims;using Base::boxes;using Base::update_nonleaf_boxes;
-  using Base::bounding_box;using Base::nodes;
+  using Base::bounding_box;using Base::nodes;using Base::sah_degradation;
 
   const Ref<const Mesh> mesh;
   const Array<const TV> X;
   const Array<Simplex> simplices;
+  T rebuild_ratio; // update(moved) rebuilds the tree once sah_degradation() exceeds this (inf to always refit)
+  int refits, rebuilds; // Number of update(moved) calls that refit or rebuilt the tree, respectively
+private:
+  Array<int> prim_leaf; // Leaf containing each simplex, computed lazily by update(moved)
 
 protected:
-  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size);
+  GEODE_CORE_EXPORT SimplexTree(const Mesh& mesh, Array<const TV> X, int leaf_size, BoxTreeSplit split=BoxTreeSplit::Median);
   GEODE_CORE_EXPORT SimplexTree(const SimplexTree& other, Array<const TV> X); // Shares ownership for topology (mesh, tree structure, etc.) but not geometry (X,boxes,simplices)
 public:
   ~SimplexTree();
 
   GEODE_CORE_EXPORT void update(); // Call whenever X changes
+  GEODE_CORE_EXPORT void update(RawArray<const int> moved); // Call if only the given vertices of X have changed
   GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two) const;
   GEODE_CORE_EXPORT Array<RayIntersection<TV> > intersections(const RayIntersection<TV>& ray, const T thickness_over_two) const;
+
+  // Trace many rays at once.  3D triangle trees trace packets of four sharing SIMD box tests, so adjacent rays should be coherent
+  // for speed; other trees trace rays one at a time.  On input, t_max holds the maximum distance along each ray (directions need not be normalized).  On output, hits
+  // holds the first simplex hit by each ray or -1, and t_max is shortened to the hit distance for rays which hit.
+  GEODE_CORE_EXPORT void intersection(RawArray<const TV> starts, RawArray<const TV> directions, RawArray<T> t_max,
+                                      RawArray<int> hits, const T thickness_over_two) const;
   GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits) const;
   GEODE_CORE_EXPORT void intersections(const Plane<T>& plane, Array<Segment<TV>>& result) const;
   GEODE_CORE_EXPORT bool inside(TV point) const;
@@ -0,0 +1,513 @@
+//#####################################################################
+// Class WideBoxTree
+//#####################################################################
+#include <geode/geometry/WideBoxTree.h>
+#include <geode/geometry/RayIntersection.h>
+#include <geode/geometry/Segment.h>
+#include <geode/geometry/Sphere.h>
+#include <geode/geometry/Triangle2d.h>
+#include <geode/geometry/Triangle3d.h>
+#include <geode/array/alloca.h>
+#include <geode/array/RawStack.h>
+#include <geode/array/sort.h>
+#include <geode/math/Lanes4.h>
+#include <geode/python/Class.h>
+#include <geode/random/Random.h>
+namespace geode {
+
+typedef real T;
+
+template<class TV> const int WideBoxTree<TV>::m;
+template<class TV> const int WideBoxTree<TV>::width;
+template<class TV,int d_> const int WideSimplexTree<TV,d_>::d;
+
+template<class TV> static int build(const BoxTree<TV>& tree, Array<typename WideBoxTree<TV>::Node>& nodes, const int binary) {
+  const int width = WideBoxTree<TV>::width;
+  // Repeatedly open the binary descendant with the most primitives until we have width children.  For the balanced
+  // binary tree, this collapses pairs of levels into one.
+  int source[width];
+  int count = 0;
+  if (tree.is_leaf(binary))
+    source[count++] = binary;
+  else {
+    source[count++] = 2*binary+1;
+    source[count++] = 2*binary+2;
+    while (count<width) {
+      int best = -1;
+      for (int c=0;c<count;c++)
+        if (   !tree.is_leaf(source[c])
+            && (best<0 || tree.ranges[source[c]].size()>tree.ranges[source[best]].size()))
+          best = c;
+      if (best<0)
+        break;
+      const int open = source[best];
+      source[best] = 2*open+1;
+      source[count++] = 2*open+2;
+    }
+  }
+
+  // Allocate this node before recursing so that the root ends up first
+  const int index = nodes.append(uninit);
+  int child[width];
+  for (int c=0;c<count;c++)
+    child[c] = tree.is_leaf(source[c]) ? ~source[c] : build(tree,nodes,source[c]);
+  auto& node = nodes[index];
+  node.count = count;
+  for (int c=0;c<width;c++) {
+    node.child[c] = c<count ? child[c] : 0;
+    node.source[c] = c<count ? source[c] : -1;
+  }
+  return index;
+}
+
+template<class TV> static Array<typename WideBoxTree<TV>::Node> build(const BoxTree<TV>& tree) {
+  Array<typename WideBoxTree<TV>::Node> nodes;
+  if (tree.nodes())
+    build(tree,nodes,0);
+  return nodes;
+}
+
+template<class TV> WideBoxTree<TV>::WideBoxTree(const BoxTree<TV>& tree)
+  : tree(ref(tree))
+  , nodes(build(tree))
+  , depth(tree.depth) {
+  update();
+}
+
+template<class TV> WideBoxTree<TV>::~WideBoxTree() {}
+
+template<class TV> void WideBoxTree<TV>::update() {
+  const auto boxes = tree->boxes;
+  for (auto& node : nodes)
+    for (int c=0;c<width;c++) {
+      const auto box = c<node.count ? boxes[node.source[c]] : Box<TV>::empty_box();
+      for (int a=0;a<m;a++) {
+        node.min[a][c] = box.min[a];
+        node.max[a][c] = box.max[a];
+      }
+    }
+}
+
+namespace {
+template<class TV> struct Wide {
+  typedef typename WideBoxTree<TV>::Node Node;
+  static const int width = WideBoxTree<TV>::width;
+
+  // Mask of the children which are actually present
+  static int present(const Node& node) {
+    return (1<<node.count)-1;
+  }
+
+  // Squared distance bounds from a point to all children at once.  Absent children are infinitely far away.
+  static Lanes4<T> sqr_distances(const Node& node, const TV& X) {
+    const auto zero = Lanes4<T>::splat(0);
+    auto sqr_d = zero;
+    for (int a=0;a<TV::m;a++) {
+      const auto x = Lanes4<T>::splat(X[a]);
+      const auto dx = max(max(Lanes4<T>::load(node.min[a])-x,x-Lanes4<T>::load(node.max[a])),zero);
+      sqr_d = sqr_d+dx*dx;
+    }
+    return sqr_d;
+  }
+
+  // Mask of the children whose enlarged boxes intersect the ray, with entry distances in t_min.  See RayPacket.h
+  // for the slab test, and why nans are harmless.
+  static int ray_ranges(const Node& node, const TV& start, const TV& inv_dx, const T box_enlargement, const T t_max, Lanes4<T>& t_min) {
+    const auto e = Lanes4<T>::splat(box_enlargement);
+    auto lo = Lanes4<T>::splat(-inf),
+         hi = Lanes4<T>::splat(inf);
+    for (int a=0;a<TV::m;a++) {
+      const auto s = Lanes4<T>::splat(start[a]),
+                 inv = Lanes4<T>::splat(inv_dx[a]);
+      const auto t0 = inv*(Lanes4<T>::load(node.min[a])-e-s),
+                 t1 = inv*(Lanes4<T>::load(node.max[a])+e-s);
+      lo = max(min(t0,t1),lo);
+      hi = min(max(t0,t1),hi);
+    }
+    t_min = lo;
+    return present(node) & movemask(lo<=hi) & movemask(Lanes4<T>::splat(0)<=hi) & movemask(lo<=Lanes4<T>::splat(t_max));
+  }
+
+  // Sort the children in mask by key, returning their count
+  static int order_children(const int mask, const T* key, int* order) {
+    int n = 0;
+    for (int c=0;c<width;c++)
+      if (mask>>c&1) {
+        int i = n++;
+        for (;i>0 && key[order[i-1]]>key[c];i--)
+          order[i] = order[i-1];
+        order[i] = c;
+      }
+    return n;
+  }
+
+  // Call leaf(leaf) on every leaf whose ancestors all pass test(node), which returns a mask of children
+  template<class Test,class Leaf> static void traverse(const WideBoxTree<TV>& self, const int n, const Test& test, const Leaf& leaf) {
+    const auto& node = self.nodes[n];
+    const int mask = test(node);
+    for (int c=0;c<node.count;c++)
+      if (mask>>c&1) {
+        const int child = node.child[c];
+        if (child>=0)
+          traverse(self,child,test,leaf);
+        else
+          leaf(~child);
+      }
+  }
+
+  // Find the closest primitive to a point, visiting children in order of distance bound.
+  // leaf(leaf,sqr_distance) should scan the primitives in the leaf and shrink sqr_distance as needed.
+  template<class Leaf> static void closest(const WideBoxTree<TV>& self, const int n, const TV& X, T& sqr_distance, const Leaf& leaf) {
+    const auto& node = self.nodes[n];
+    T bounds[width];
+    sqr_distances(node,X).store(bounds);
+    int order[width];
+    const int count = order_children(present(node),bounds,order);
+    for (int i=0;i<count;i++) {
+      const int c = order[i];
+      if (bounds[c]<sqr_distance) {
+        const int child = node.child[c];
+        if (child>=0)
+          closest(self,child,X,sqr_distance,leaf);
+        else
+          leaf(~child,sqr_distance);
+      }
+    }
+  }
+
+  // Visit leaves hit by the ray in roughly front to back order.  leaf(leaf) may shorten ray.t_max.
+  template<class Leaf> static void trace(const WideBoxTree<TV>& self, const RayIntersection<TV>& ray, const T box_enlargement, const Leaf& leaf) {
+    const TV inv_dx = 1/ray.direction;
+    // Each entry is (child,t_min), where child is encoded as in Node
+    RawStack<Tuple<int,T>> stack(GEODE_RAW_ALLOCA((width-1)*self.depth+1,Tuple<int,T>));
+    stack.push(tuple(0,-T(inf)));
+    while (stack.size()) {
+      const auto entry = stack.pop();
+      if (entry.y>ray.t_max) // Check t_min again since ray.t_max may have changed
+        continue;
+      const int n = entry.x;
+      if (n<0) {
+        leaf(~n);
+        continue;
+      }
+      const auto& node = self.nodes[n];
+      Lanes4<T> ranges;
+      const int mask = ray_ranges(node,ray.start,inv_dx,box_enlargement,ray.t_max,ranges);
+      T t_min[width];
+      ranges.store(t_min);
+      int order[width];
+      const int count = order_children(mask,t_min,order);
+      // Push children with larger t_min first, so that we check smaller t_min first
+      for (int i=count-1;i>=0;i--)
+        stack.push(tuple(node.child[order[i]],t_min[order[i]]));
+    }
+  }
+};
+}
+
+template<class TV,int d> WideSimplexTree<TV,d>::WideSimplexTree(const Tree& tree)
+  : Base(tree)
+  , simplex_tree(ref(tree)) {}
+
+template<class TV,int d> WideSimplexTree<TV,d>::~WideSimplexTree() {}
+
+template<class TV,int d> bool WideSimplexTree<TV,d>::intersection(RayIntersection<TV>& ray, const T half_thickness) const {
+  if (!nodes.size())
+    return false; // No intersections possible for empty trees
+  const int aggregate_save = ray.aggregate_id;
+  ray.aggregate_id = -1;
+  const auto& simplices = simplex_tree->simplices;
+  Wide<TV>::trace(*this,ray,half_thickness,[&](const int leaf) {
+    for (const int t : prims(leaf))
+      if (simplices[t].intersection(ray,half_thickness))
+        ray.aggregate_id = t;
+  });
+  if (ray.aggregate_id<0) {
+    ray.aggregate_id = aggregate_save;
+    return false;
+  }
+  return true;
+}
+
+// Ray intersection is only available for the same simplex types as in SimplexTree
+template<> bool WideSimplexTree<Vector<real,2>,2>::intersection(RayIntersection<Vector<real,2>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
+template<> bool WideSimplexTree<Vector<real,3>,1>::intersection(RayIntersection<Vector<real,3>>& ray, const real half_thickness) const { GEODE_NOT_IMPLEMENTED(); }
+
+template<class TV,int d> void WideSimplexTree<TV,d>::intersection(const Sphere<TV>& sphere, Array<int>& hits) const {
+  hits.clear();
+  if (!nodes.size())
+    return;
+  const auto sqr_radius = Lanes4<T>::splat(sqr(sphere.radius));
+  const auto& simplices = simplex_tree->simplices;
+  Wide<TV>::traverse(*this,0,[&](const typename Base::Node& node) {
+    return movemask(Wide<TV>::sqr_distances(node,sphere.center)<=sqr_radius);
+  }, [&](const int leaf) {
+    for (const int t : prims(leaf))
+      if (simplices[t].distance(sphere.center)<=sphere.radius)
+        hits.append(t);
+  });
+}
+
+template<class TV,int d> Tuple<TV,int,typename WideSimplexTree<TV,d>::Weights> WideSimplexTree<TV,d>::closest_point(const TV point, const T max_distance) const {
+  int simplex = -1;
+  const auto& simplices = simplex_tree->simplices;
+  if (nodes.size()) {
+    T sqr_distance = sqr(max_distance);
+    Wide<TV>::closest(*this,0,point,sqr_distance,[&](const int leaf, T& sqr_distance) {
+      for (const int t : prims(leaf)) {
+        const T sqr_d = sqr_magnitude(point-simplices[t].closest_point(point).x);
+        if (sqr_distance>sqr_d) {
+          sqr_distance = sqr_d;
+          simplex = t;
+        }
+      }
+    });
+  }
+  if (simplex == -1) {
+    TV x;
+    x.fill(inf);
+    return tuple(x,-1,Weights());
+  } else {
+    const auto r = simplices[simplex].closest_point(point);
+    return tuple(r.x,simplex,r.y);
+  }
+}
+
+template<class TV,int d> typename WideSimplexTree<TV,d>::T WideSimplexTree<TV,d>::distance(const TV point, const T max_distance) const {
+  return magnitude(point-closest_point(point,max_distance).x);
+}
+
+template<class TV> WideParticleTree<TV>::WideParticleTree(const ParticleTree<TV>& tree)
+  : Base(tree)
+  , particle_tree(ref(tree)) {}
+
+template<class TV> WideParticleTree<TV>::~WideParticleTree() {}
+
+template<class TV> bool WideParticleTree<TV>::intersection(RayIntersection<TV>& ray, const T radius) const {
+  if (!nodes.size())
+    return false;
+  const int aggregate_save = ray.aggregate_id;
+  ray.aggregate_id = -1;
+  const auto& X = particle_tree->X;
+  const T sqr_radius = sqr(radius);
+  Wide<TV>::trace(*this,ray,radius,[&](const int leaf) {
+    for (const int i : prims(leaf)) {
+      // Intersect the ray with the ball of the given radius around X[i]
+      const TV v = X[i]-ray.start;
+      const T s = dot(v,ray.direction),
+              sqr_perp = sqr_magnitude(v)-sqr(s);
+      if (sqr_perp>sqr_radius)
+        continue;
+      const T half_chord = sqrt(sqr_radius-sqr_perp);
+      if (s+half_chord<0)
+        continue;
+      const T t = max(T(0),s-half_chord);
+      if (t<ray.t_max) {
+        ray.t_max = t;
+        ray.aggregate_id = i;
+      }
+    }
+  });
+  if (ray.aggregate_id<0) {
+    ray.aggregate_id = aggregate_save;
+    return false;
+  }
+  return true;
+}
+
+template<class TV> void WideParticleTree<TV>::intersection(const Sphere<TV>& sphere, Array<int>& hits) const {
+  hits.clear();
+  if (!nodes.size())
+    return;
+  const auto sqr_radius = Lanes4<T>::splat(sqr(sphere.radius));
+  const auto& X = particle_tree->X;
+  Wide<TV>::traverse(*this,0,[&](const typename Base::Node& node) {
+    return movemask(Wide<TV>::sqr_distances(node,sphere.center)<=sqr_radius);
+  }, [&](const int leaf) {
+    for (const int i : prims(leaf))
+      if (sphere.lazy_inside(X[i]))
+        hits.append(i);
+  });
+}
+
+template<class TV> void WideParticleTree<TV>::intersection(const Box<TV>& box, Array<int>& hits) const {
+  hits.clear();
+  if (!nodes.size())
+    return;
+  const auto& X = particle_tree->X;
+  Wide<TV>::traverse(*this,0,[&](const typename Base::Node& node) {
+    int mask = Wide<TV>::present(node);
+    for (int a=0;a<TV::m;a++)
+      mask &= movemask(Lanes4<T>::load(node.min[a])<=Lanes4<T>::splat(box.max[a]))
+            & movemask(Lanes4<T>::splat(box.min[a])<=Lanes4<T>::load(node.max[a]));
+    return mask;
+  }, [&](const int leaf) {
+    for (const int i : prims(leaf))
+      if (box.lazy_inside(X[i]))
+        hits.append(i);
+  });
+}
+
+template<class TV> TV WideParticleTree<TV>::closest_point(TV point, int& index, T max_distance, int ignore) const {
+  index = -1;
+  const auto& X = particle_tree->X;
+  if (nodes.size()) {
+    T sqr_distance = sqr(max_distance);
+    Wide<TV>::closest(*this,0,point,sqr_distance,[&](const int leaf, T& sqr_distance) {
+      for (const int i : prims(leaf)) {
+        const T sqr_d = sqr_magnitude(point-X[i]);
+        if (sqr_distance>sqr_d && i != ignore) {
+          sqr_distance = sqr_d;
+          index = i;
+        }
+      }
+    });
+  }
+  if (index == -1) {
+    TV x;
+    x.fill(inf);
+    return x;
+  } else
+    return X[index];
+}
+
+template<class TV> TV WideParticleTree<TV>::closest_point(TV point, T max_distance) const {
+  int index;
+  return closest_point(point,index,max_distance);
+}
+
+template<class TV> Tuple<TV,int> WideParticleTree<TV>::closest_point_py(TV point, T max_distance) const {
+  int index = -1;
+  const TV p = closest_point(point,index,max_distance);
+  return tuple(p,index);
+}
+
+#define INSTANTIATE(m) \
+  template<> GEODE_DEFINE_TYPE(WideBoxTree<Vector<real,m>>) \
+  template<> GEODE_DEFINE_TYPE(WideParticleTree<Vector<real,m>>) \
+  template class WideBoxTree<Vector<real,m>>; \
+  template class WideParticleTree<Vector<real,m>>;
+#define INSTANTIATE_SIMPLEX(m,d) \
+  template<> GEODE_DEFINE_TYPE(WideSimplexTree<Vector<real,m>,d>) \
+  template class WideSimplexTree<Vector<real,m>,d>;
+INSTANTIATE(2)
+INSTANTIATE(3)
+INSTANTIATE_SIMPLEX(2,1)
+INSTANTIATE_SIMPLEX(2,2)
+INSTANTIATE_SIMPLEX(3,1)
+INSTANTIATE_SIMPLEX(3,2)
+
+// Check wide tree queries against the binary tree for random rays, spheres, and points.  Returns the number of ray hits.
+static int wide_simplex_tree_test(const SimplexTree<Vector<real,3>,2>& tree, const int queries, const real half_thickness) {
+  typedef Vector<real,3> TV;
+  const auto wide = new_<WideSimplexTree<TV,2>>(tree);
+  const auto box = tree.bounding_box();
+  const auto random = new_<Random>(819371111);
+  int hits = 0;
+  Array<int> wide_hits, binary_hits;
+  for (int i=0;i<queries;i++) {
+    const TV start = random->uniform(box);
+    RayIntersection<TV> ray(start,random->direction<TV>());
+    ray.t_max = 2;
+    auto copy = ray;
+    const bool hit = wide->intersection(ray,half_thickness);
+    GEODE_ASSERT(hit==tree.intersection(copy,half_thickness));
+    GEODE_ASSERT(!hit || abs(ray.t_max-copy.t_max)<1e-10);
+    hits += hit;
+
+    const Sphere<TV> sphere(start,random->uniform<real>(0,.5));
+    wide->intersection(sphere,wide_hits);
+    tree.intersection(sphere,binary_hits);
+    sort(wide_hits);
+    sort(binary_hits);
+    GEODE_ASSERT(wide_hits==binary_hits);
+
+    const TV point = 2*random->uniform(box);
+    GEODE_ASSERT(abs(wide->distance(point)-tree.distance(point))<1e-10);
+  }
+  return hits;
+}
+
+// Same as wide_simplex_tree_test for particles, checking rays against brute force since ParticleTree has no ray queries
+static int wide_particle_tree_test(const ParticleTree<Vector<real,3>>& tree, const int queries, const real radius) {
+  typedef Vector<real,3> TV;
+  const auto wide = new_<WideParticleTree<TV>>(tree);
+  const auto box = tree.bounding_box();
+  const auto random = new_<Random>(819371111);
+  int hits = 0;
+  Array<int> wide_hits, binary_hits;
+  for (int i=0;i<queries;i++) {
+    const TV start = random->uniform(box);
+    RayIntersection<TV> ray(start,random->direction<TV>());
+    ray.t_max = 2;
+    const bool hit = wide->intersection(ray,radius);
+    bool slow_hit = false;
+    for (const auto& x : tree.X) {
+      const TV v = x-start;
+      const real s = clamp(dot(v,ray.direction),real(0),real(2));
+      slow_hit |= sqr_magnitude(v-s*ray.direction)<=sqr(radius);
+    }
+    GEODE_ASSERT(hit==slow_hit);
+    hits += hit;
+
+    const Sphere<TV> sphere(start,random->uniform<real>(0,.5));
+    wide->intersection(sphere,wide_hits);
+    tree.intersection(sphere,binary_hits);
+    sort(wide_hits);
+    sort(binary_hits);
+    GEODE_ASSERT(wide_hits==binary_hits);
+
+    const Box<TV> query(start,start+random->uniform<TV>(0,.5));
+    wide->intersection(query,wide_hits);
+    tree.intersection(query,binary_hits);
+    sort(wide_hits);
+    sort(binary_hits);
+    GEODE_ASSERT(wide_hits==binary_hits);
+
+    const TV point = 2*random->uniform(box);
+    int wide_index, binary_index;
+    wide->closest_point(point,wide_index);
+    tree.closest_point(point,binary_index);
+    GEODE_ASSERT(wide_index==binary_index);
+  }
+  return hits;
+}
+
+}
+using namespace geode;
+
+template<class TV,int d> static void wrap_simplex_helper() {
+  typedef WideSimplexTree<TV,d> Self;
+  static const string name = format("Wide%sTree%dd",(d==1?"Segment":"Triangle"),TV::m);
+  Class<Self>(name.c_str())
+    .GEODE_INIT(const typename Self::Tree&)
+    .GEODE_FIELD(simplex_tree)
+    .GEODE_FIELD(d)
+    .GEODE_FIELD(depth)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD(closest_point)
+    .GEODE_METHOD(distance)
+    ;
+}
+
+template<int m> static void wrap_particle_helper() {
+  typedef WideParticleTree<Vector<real,m>> Self;
+  Class<Self>(m==2?"WideParticleTree2d":"WideParticleTree3d")
+    .GEODE_INIT(const ParticleTree<Vector<real,m>>&)
+    .GEODE_FIELD(particle_tree)
+    .GEODE_FIELD(depth)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD_2("closest_point",closest_point_py)
+    ;
+}
+
+void wrap_wide_box_tree() {
+  wrap_simplex_helper<Vector<real,2>,1>();
+  wrap_simplex_helper<Vector<real,2>,2>();
+  wrap_simplex_helper<Vector<real,3>,1>();
+  wrap_simplex_helper<Vector<real,3>,2>();
+  wrap_particle_helper<2>();
+  wrap_particle_helper<3>();
+  GEODE_FUNCTION(wide_simplex_tree_test)
+  GEODE_FUNCTION(wide_particle_tree_test)
+}
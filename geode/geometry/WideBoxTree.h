@@ -0,0 +1,109 @@
+//#####################################################################
+// Class WideBoxTree
+//#####################################################################
+//
+// WideBoxTree collapses a binary BoxTree into a bounding box hierarchy with
+// up to four children per node.  The child boxes of each node are stored in
+// SoA form, so that one SIMD test (see math/Lanes4.h) culls all children at
+// once, and traversals visit far fewer nodes.
+//
+// The wide tree keeps the leaves of the binary tree, and shares its primitive
+// permutation.  Whenever the binary tree's boxes change (e.g., after
+// SimplexTree::update), call update() to refresh the wide bounds.
+//
+// WideSimplexTree and WideParticleTree provide the queries of SimplexTree and
+// ParticleTree on top of the wide layout.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/geometry/forward.h>
+#include <geode/geometry/ParticleTree.h>
+#include <geode/geometry/SimplexTree.h>
+#include <geode/math/constants.h>
+namespace geode {
+
+template<class TV> class WideBoxTree : public Object {
+  typedef typename TV::Scalar T;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+  static const int m = TV::m;
+  static const int width = 4;
+
+  // Child c of a node is wide node child[c] if child[c]>=0, binary tree leaf ~child[c] if child[c]<0, and absent if c>=count.
+  // Absent children have empty bounds.
+  struct Node {
+    T min[m][width], max[m][width];
+    int child[width];
+    int source[width]; // Binary tree node corresponding to each child
+    int count;
+  };
+
+  const Ref<const BoxTree<TV>> tree;
+  const Array<Node> nodes;
+  const int depth; // Bound on the number of wide nodes on a path from the root to a leaf
+
+protected:
+  GEODE_CORE_EXPORT WideBoxTree(const BoxTree<TV>& tree);
+public:
+  ~WideBoxTree();
+
+  GEODE_CORE_EXPORT void update(); // Call whenever the binary tree's boxes change
+
+  RawArray<const int> prims(const int leaf) const {
+    return tree->prims(leaf);
+  }
+};
+
+template<class TV,int d_> class WideSimplexTree : public WideBoxTree<TV> {
+  typedef typename TV::Scalar T;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef WideBoxTree<TV> Base;
+  typedef SimplexTree<TV,d_> Tree;
+  static const int d = d_;
+  typedef typename Tree::Weights Weights;
+  using Base::nodes;using Base::prims;
+
+  const Ref<const Tree> simplex_tree;
+
+protected:
+  GEODE_CORE_EXPORT WideSimplexTree(const Tree& tree);
+public:
+  ~WideSimplexTree();
+
+  GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two) const;
+  GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits) const;
+  GEODE_CORE_EXPORT T distance(TV point, T max_distance=inf) const; // return value is infinity if nothing is found
+
+  // Returns closest_point,simplex,weights.  If nothing is found, simplex = -1 and closet_point = inf.
+  GEODE_CORE_EXPORT Tuple<TV,int,Weights> closest_point(const TV point, const T max_distance=inf) const;
+};
+
+template<class TV> class WideParticleTree : public WideBoxTree<TV> {
+  typedef typename TV::Scalar T;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef WideBoxTree<TV> Base;
+  using Base::nodes;using Base::prims;
+
+  const Ref<const ParticleTree<TV>> particle_tree;
+
+protected:
+  GEODE_CORE_EXPORT WideParticleTree(const ParticleTree<TV>& tree);
+public:
+  ~WideParticleTree();
+
+  // Find the first particle within thickness_over_two of the ray, setting ray.t_max to the distance at which the ray enters its ball
+  GEODE_CORE_EXPORT bool intersection(RayIntersection<TV>& ray, const T thickness_over_two) const;
+
+  GEODE_CORE_EXPORT void intersection(const Sphere<TV>& sphere, Array<int>& hits) const;
+  GEODE_CORE_EXPORT void intersection(const Box<TV>& box, Array<int>& hits) const;
+
+  GEODE_CORE_EXPORT TV closest_point(TV point, int& index, T max_distance=inf, int ignore=-1) const; // index=-1 if nothing is found
+  GEODE_CORE_EXPORT TV closest_point(TV point, T max_distance=inf) const; // return value is infinity if nothing is found
+  GEODE_CORE_EXPORT Tuple<TV,int> closest_point_py(TV point, T max_distance=inf) const;
+};
+
+}
@@ -6,19 +6,27 @@ from geode import *
 from numpy import asarray
 
 BoxTrees = {2:BoxTree2d,3:BoxTree3d}
-def BoxTree(X,leaf_size):
+def BoxTree(X,leaf_size,split='median'):
   X = asarray(X)
-  return BoxTrees[X.shape[1]](X,leaf_size)
+  return BoxTrees[X.shape[1]](X,leaf_size,split)
 
 ParticleTrees = {2:ParticleTree2d,3:ParticleTree3d}
-def ParticleTree(X,leaf_size=1):
+def ParticleTree(X,leaf_size=1,split='median'):
   X = asarray(X)
-  return ParticleTrees[X.shape[1]](X,leaf_size)
+  return ParticleTrees[X.shape[1]](X,leaf_size,split)
 
 SimplexTrees = {(2,1):SegmentTree2d,(3,1):SegmentTree3d,(2,2):TriangleTree2d,(3,2):TriangleTree3d}
-def SimplexTree(mesh,X,leaf_size=1):
+def SimplexTree(mesh,X,leaf_size=1,split='median'):
   X = asarray(X)
-  return SimplexTrees[X.shape[1],mesh.d](mesh,X,leaf_size)
+  return SimplexTrees[X.shape[1],mesh.d](mesh,X,leaf_size,split)
+
+WideSimplexTrees = {(2,1):WideSegmentTree2d,(3,1):WideSegmentTree3d,(2,2):WideTriangleTree2d,(3,2):WideTriangleTree3d}
+def WideSimplexTree(tree):
+  return WideSimplexTrees[tree.X.shape[1],tree.d](tree)
+
+WideParticleTrees = {2:WideParticleTree2d,3:WideParticleTree3d}
+def WideParticleTree(tree):
+  return WideParticleTrees[tree.X.shape[1]](tree)
 
 Boxes = {1:Box1d,2:Box2d,3:Box3d}
 def Box(min,max):
@@ -50,5 +58,5 @@ def FrameImplicit(frame,object):
   return FrameImplicits[object.d](frame,object)
 
 surface_levelsets = {1:surface_levelset_c3d,2:surface_levelset_s3d}
-def surface_levelset(particles,surface,max_distance=inf,compute_signs=True):
-  return surface_levelsets[surface.d](particles,surface,max_distance,compute_signs)
+def surface_levelset(particles,surface,max_distance=inf,compute_signs=True,parallel=False):
+  return surface_levelsets[surface.d](particles,surface,max_distance,compute_signs,parallel)
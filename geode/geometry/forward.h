@@ -15,9 +15,13 @@ template<class TV> class RayIntersection;
 template<class TV> class Sphere;
 class Cylinder;
 
+enum class BoxTreeSplit;
 template<class TV> class BoxTree;
 template<class TV> class ParticleTree;
 template<class TV,int d> class SimplexTree;
+template<class TV> class WideBoxTree;
+template<class TV> class WideParticleTree;
+template<class TV,int d> class WideSimplexTree;
 
 template<class TV> class Implicit;
 
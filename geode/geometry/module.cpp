@@ -13,6 +13,7 @@ void wrap_geometry() {
   GEODE_WRAP(box_tree)
   GEODE_WRAP(particle_tree)
   GEODE_WRAP(simplex_tree)
+  GEODE_WRAP(wide_box_tree)
   GEODE_WRAP(platonic)
   GEODE_WRAP(thick_shell)
   GEODE_WRAP(bezier)
@@ -489,7 +489,7 @@ Tuple<Array<Vec2>,Array<int>> offset_polygon_with_correspondence(RawArray<const
   return tuple(new_opoly,new_corr);
 }
 
-Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const int> offsets, bool open) {
+Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const index_t> offsets, bool open) {
   GEODE_ASSERT(offsets.size() && !offsets[0]); // Not a complete check, but may catch a few bugs
 
   // empty?
@@ -585,7 +585,7 @@ Nested<Vec2> canonicalize_polygons(Nested<const Vec2> polys) {
   return new_polys;
 }
 
-Array<int> closed_contours_next_from_offsets(RawArray<const int> offsets) {
+Array<int> closed_contours_next_from_offsets(RawArray<const index_t> offsets) {
   const int n = offsets.back();
   if(n == 0) // Catch empty arrays to avoid trying to iterate over an inverted range
     return Array<int>();
@@ -40,7 +40,7 @@ GEODE_CORE_EXPORT Vec2 point_inside_polygon_component(RawArray<const Vec2> poly,
 GEODE_CORE_EXPORT Tuple<Array<Vec2>,Array<int>> offset_polygon_with_correspondence(RawArray<const Vec2> poly, real offset, real maxangle_deg = 20., real minangle_deg = 10.);
 
 // Turn an array of polygons into a SegmentSoup.
-GEODE_CORE_EXPORT Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const int> offsets, bool open);
+GEODE_CORE_EXPORT Ref<SegmentSoup> nested_array_offsets_to_segment_soup(RawArray<const index_t> offsets, bool open);
 template<class TV> static inline Tuple<Ref<SegmentSoup>,Array<TV>> to_segment_soup(const Nested<TV>& polys, bool open) {
   return tuple(nested_array_offsets_to_segment_soup(polys.offsets,open),polys.flat);
 }
@@ -52,7 +52,7 @@ GEODE_CORE_EXPORT Nested<const Vec2> polygons_from_python(PyObject* object);
 GEODE_CORE_EXPORT Nested<Vec2> canonicalize_polygons(Nested<const Vec2> polys);
 
 // Helper routine for closed_contours_next
-GEODE_CORE_EXPORT Array<int> closed_contours_next_from_offsets(RawArray<const int> offsets);
+GEODE_CORE_EXPORT Array<int> closed_contours_next_from_offsets(RawArray<const index_t> offsets);
 
 // nested.flat[i] connects to nested.flat[closed_contour_next[i]]
 // This allows traversing closed contours as a graph instead of with special cases or messy modular arithmetic
@@ -10,7 +10,9 @@
 #include <geode/array/ConstantMap.h>
 #include <geode/python/wrap.h>
 #include <geode/utility/Log.h>
+#include <geode/utility/time.h>
 #include <limits>
+#include <memory>
 namespace geode {
 
 typedef real T;
@@ -22,6 +24,7 @@ using std::numeric_limits;
 namespace {
 
 static const bool profile = false;
+static const int subtree_size = 1024; // Particles per task in parallel mode
 GEODE_UNUSED static uint64_t evaluation_count;
 
 static inline T lower_bound_sqr_phi(const TV& n1, const Box<TV>& n2) {
@@ -79,7 +82,45 @@ template<int d> struct Helper {
       }
     }
   }
+
+  // Evaluate a particle leaf against the whole surface.  Each particle is first checked against previous, the closest
+  // simplex to the previously evaluated particle, so that coherent particles start the traversal with a tight bound.
+  void eval_leaf(const int pn, int& previous) const {
+    const auto prims = particles.prims(pn);
+    if (previous >= 0) {
+      sqr_phi_node[pn] = 0;
+      for (const int p : prims) {
+        const auto close = surface.simplices[previous].closest_point(particles.X[p]);
+        const TV delta = particles.X[p] - close.x;
+        const T sd = sqr_magnitude(delta);
+        if (info[p].phi > sd)
+          info[p] = CloseInfo<d>({sd,delta,previous,close.y});
+        sqr_phi_node[pn] = max(sqr_phi_node[pn],info[p].phi);
+      }
+    }
+    eval(pn,0);
+    if (prims.size() && info[prims.back()].simplex >= 0)
+      previous = info[prims.back()].simplex;
+  }
+
+  // Evaluate all leaves of a particle subtree in order
+  void eval_subtree(const int pn, int& previous) const {
+    if (particles.is_leaf(pn))
+      eval_leaf(pn,previous);
+    else
+      for (const int c : particles.children(pn))
+        eval_subtree(c,previous);
+  }
 };
+
+// Collect subtrees with at most size particles, each of which will be a separate task
+static void subtrees(const ParticleTree<TV>& particles, const int node, const int size, Array<int>& roots) {
+  if (particles.is_leaf(node) || particles.ranges[node].size() <= size)
+    roots.append(node);
+  else
+    for (const int c : particles.children(node))
+      subtrees(particles,c,size,roots);
+}
 }
 
 static TV normal_flip(const Segment<TV>& seg, const TV u) {
@@ -102,7 +143,7 @@ static TV normal_noflip(const Triangle<TV>& tri) { return tri.n; }
 
 template<int d> void surface_levelset(const ParticleTree<TV>& particles, const SimplexTree<TV,d>& surface,
                                       RawArray<typename Hide<CloseInfo<d>>::type> info,
-                                      const T max_distance, const bool compute_signs) {
+                                      const T max_distance, const bool compute_signs, const bool parallel) {
   GEODE_ASSERT(particles.X.size()==info.size());
   const T sqr_max_distance = sqr(max_distance);
   for (auto& I : info) {
@@ -112,8 +153,31 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
   if (profile)
     evaluation_count = 0;
   const auto sqr_phi_node = constant_map(particles.nodes(),sqr_max_distance).copy();
-  if (particles.X.size() && surface.simplices.size())
-    Helper<d>({particles,surface,sqr_phi_node,info}).eval(0,0);
+  // Timing is only logged for parallel or profiled calls, since small serial queries are frequent
+  const bool timed = parallel || profile;
+  std::unique_ptr<Log::Scope> scope(timed ? new Log::Scope("surface levelset") : 0);
+  if (timed)
+    Log::time("closest points");
+  const double start = get_time();
+  if (particles.X.size() && surface.simplices.size()) {
+    const Helper<d> helper({particles,surface,sqr_phi_node,info});
+    if (!parallel)
+      helper.eval(0,0);
+    else {
+      // The subtrees depend only on the particle tree, so results are independent of the number of threads
+      Array<int> roots;
+      subtrees(particles,0,subtree_size,roots);
+      #pragma omp parallel for schedule(dynamic,1)
+      for (int r=0;r<roots.size();r++) {
+        int previous = -1;
+        helper.eval_subtree(roots[r],previous);
+      }
+    }
+  }
+  if (timed) {
+    Log::stat("closest points per second",particles.X.size()/max(get_time()-start,1e-9));
+    Log::time("normals and signs");
+  }
   if (profile) {
     long slow_count = (long)particles.X.size()*surface.simplices.size();
     cout << "particles = "<<particles.X.size()<<", per particle "<<evaluation_count/particles.X.size()<<endl;
@@ -122,15 +186,18 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
   }
   const T epsilon = sqrt(numeric_limits<T>::epsilon())*max(particles.bounding_box().sizes().max(),
                                                              surface.bounding_box().sizes().max());
-  if (d<TV::m-1 || !compute_signs)
-    for (auto& I : info) {
+  if (d<TV::m-1 || !compute_signs) {
+    #pragma omp parallel for if(parallel)
+    for (int i=0;i<info.size();i++) {
+      auto& I = info[i];
       I.phi = sqrt(I.phi);
       I.normal = ((I.simplex) < 0)   ? TV()  // Parenthesis around I.simplex avoid parse error in MinGW-W64 version 4.9.2 of g++
                : (I.phi > epsilon) ? I.normal / I.phi
                                    : normal_flip(surface.simplices[I.simplex],I.normal);
     }
-  else // compute_signs
-    for (const int i : range(info.size())) {
+  } else { // compute_signs
+    #pragma omp parallel for if(parallel)
+    for (int i=0;i<info.size();i++) {
       auto& I = info[i];
       I.phi = sqrt(I.phi);
       if ((I.simplex) < 0) // Parentheses needed for parse error in gcc 4.9
@@ -150,13 +217,16 @@ template<int d> void surface_levelset(const ParticleTree<TV>& particles, const S
         }
       }
     }
+  }
+  if (timed)
+    Log::stat("points per second",particles.X.size()/max(get_time()-start,1e-9));
 }
 
 template<int d> Tuple<Array<T>,Array<TV>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>>
 surface_levelset(const ParticleTree<TV>& particles, const SimplexTree<TV,d>& surface,
-                 const T max_distance, const bool compute_signs) {
+                 const T max_distance, const bool compute_signs, const bool parallel) {
   Array<CloseInfo<d>> info(particles.X.size(),uninit);
-  surface_levelset<d>(particles,surface,info,max_distance,compute_signs);
+  surface_levelset<d>(particles,surface,info,max_distance,compute_signs,parallel);
   return tuple(info.template project<T,&CloseInfo<d>::phi>().copy(),
                info.template project<TV,&CloseInfo<d>::normal>().copy(),
                info.template project<int,&CloseInfo<d>::simplex>().copy(),
@@ -164,9 +234,9 @@ surface_levelset(const ParticleTree<TV>& particles, const SimplexTree<TV,d>& sur
 }
 
 #define INSTANTIATE(d) \
-  template void surface_levelset(const ParticleTree<TV>&,const SimplexTree<TV,d>&,RawArray<CloseInfo<d>>,T,bool); \
+  template void surface_levelset(const ParticleTree<TV>&,const SimplexTree<TV,d>&,RawArray<CloseInfo<d>>,T,bool,bool); \
   template Tuple<Array<T>,Array<TV>,Array<int>,Array<typename SimplexTree<TV,d>::Weights>> \
-    surface_levelset(const ParticleTree<TV>&,const SimplexTree<TV,d>&,const T,const bool);
+    surface_levelset(const ParticleTree<TV>&,const SimplexTree<TV,d>&,const T,const bool,const bool);
 INSTANTIATE(1)
 INSTANTIATE(2)
 
@@ -202,8 +272,8 @@ using namespace geode;
 
 void wrap_surface_levelset() {
   GEODE_FUNCTION_2(surface_levelset_c3d,static_cast<Tuple<Array<T>,Array<TV>,Array<int>,Array<T>>(*)(
-    const ParticleTree<TV>&,const SimplexTree<TV,1>&,T,bool)>(surface_levelset))
+    const ParticleTree<TV>&,const SimplexTree<TV,1>&,T,bool,bool)>(surface_levelset))
   GEODE_FUNCTION_2(surface_levelset_s3d,static_cast<Tuple<Array<T>,Array<TV>,Array<int>,Array<TV>>(*)(
-    const ParticleTree<TV>&,const SimplexTree<TV,2>&,T,bool)>(surface_levelset))
+    const ParticleTree<TV>&,const SimplexTree<TV,2>&,T,bool,bool)>(surface_levelset))
   GEODE_FUNCTION(slow_surface_levelset)
 }
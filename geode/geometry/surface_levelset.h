@@ -20,15 +20,19 @@ template<int d> struct CloseInfo {
   typename SimplexTree<TV,d>::Weights weights;
 };
 
+// If parallel is true, the particle tree is split into subtrees which are evaluated as separate OpenMP tasks.  Within each
+// subtree, particles are first checked against the closest simplex of the previous particle, which gives a tight culling
+// bound for coherent point clouds.  Throughput is reported via Log::time and Log::stat.
 template<int d> GEODE_CORE_EXPORT void surface_levelset(const ParticleTree<Vector<real,3>>& particles,
                                                         const SimplexTree<Vector<real,3>,d>& surface,
                                                         RawArray<typename Hide<CloseInfo<d>>::type> info,
-                                                        const real max_distance=inf, const bool compute_signs=true);
+                                                        const real max_distance=inf, const bool compute_signs=true,
+                                                        const bool parallel=false);
 
 // Functional-style version: returns distance, normals, closest simplex, and barycentric weights per point.
 template<int d> GEODE_CORE_EXPORT Tuple<Array<real>,Array<Vector<real,3>>,
                                         Array<int>,Array<typename SimplexTree<Vector<real,3>,d>::Weights>>
 surface_levelset(const ParticleTree<Vector<real,3>>& particles, const SimplexTree<Vector<real,3>,d>& surface,
-                 const real max_distance=inf, const bool compute_signs=true);
+                 const real max_distance=inf, const bool compute_signs=true, const bool parallel=false);
 
 }
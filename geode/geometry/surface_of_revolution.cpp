@@ -89,7 +89,7 @@ template<class T> static Tuple<Array<Vec3i>,Array<Vector<T,3>>> surface_of_revol
   }
   const RawArray<const TV2> body_profile = profile_rz.slice(profile_revolve_start, profile_revolve_end);
 
-  const CylinderTopology topology = {body_profile.size(), sides, true, true};
+  const CylinderTopology topology = {int(body_profile.size()), sides, true, true};
 
   Array<TV3> X;
   X.preallocate(topology.num_vertices());
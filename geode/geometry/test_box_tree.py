@@ -3,6 +3,8 @@
 from __future__ import division
 from geode import *
 from geode.geometry.platonic import *
+import time
+import sys
 
 def test_box_tree():
   random.seed(10098331)
@@ -12,6 +14,22 @@ def test_box_tree():
     tree = BoxTree(x,10)
     tree.check(x)
 
+def test_box_tree_split():
+  random.seed(10098332)
+  for n in 0,1,35,99,100,101,199,200,201,20000:
+    x = random.randn(n,3).astype(real)
+    x[:,0] *= 100
+    for split in 'median','sah':
+      tree = BoxTree(x,10,split)
+      assert tree.split==split
+      tree.check(x)
+  mesh,X = sphere_mesh(3)
+  X[:,0] *= 10
+  for split in 'median','sah':
+    tree = SimplexTree(mesh,X,4,split)
+    assert tree.split==split
+    assert allclose(tree.distance((20,0,0)),SimplexTree(mesh,X,4).distance((20,0,0)))
+
 def test_particle_tree():
   random.seed(10098331)
   for n in 0,1,35,99,100,101,199,200,201:
@@ -23,6 +41,14 @@ def test_particle_tree():
     tree.update()
     tree.check(X)
 
+def test_remove_duplicates():
+  random.seed(10098333)
+  for n in 0,1,35,200,2000:
+    X = random.randint(0,10,size=(n,3)).astype(real)
+    map = ParticleTree(X,2).remove_duplicates(.5)
+    for i in xrange(0,n,7):
+      assert all((map==map[i])==all(X==X[i],axis=1))
+
 def test_simplex_tree():
   mesh,X = sphere_mesh(4)
   tree = SimplexTree(mesh,X,4)
@@ -31,5 +57,69 @@ def test_simplex_tree():
   print 'rays = %d, hits = %d'%(rays,hits)
   assert hits==642
 
+def test_simplex_tree_packet(benchmark=False):
+  mesh,X = sphere_mesh(6 if benchmark else 4)
+  tree = SimplexTree(mesh,X,4)
+  res = 512 if benchmark else 64
+  start = time.time()
+  scalar_t,scalar_hits = ray_grid_test(tree,res,1e-6,False)
+  scalar_time = time.time()-start
+  start = time.time()
+  packet_t,packet_hits = ray_grid_test(tree,res,1e-6,True)
+  packet_time = time.time()-start
+  # Simplices can tie along shared edges, so compare distances rather than ids
+  assert all((scalar_hits>=0)==(packet_hits>=0))
+  assert allclose(scalar_t,packet_t,rtol=0,atol=1e-10*scalar_t.max())
+  if benchmark:
+    print 'rays = %d, hits = %d, scalar time = %g, packet time = %g, speedup = %g'%(
+      res*res,(packet_hits>=0).sum(),scalar_time,packet_time,scalar_time/packet_time)
+  else:
+    assert (packet_hits>=0).sum()==3915
+
+def test_simplex_tree_refit():
+  random.seed(10098334)
+  mesh,X = sphere_mesh(3)
+  refit = SimplexTree(mesh,X,4)
+  rebuild = SimplexTree(mesh,X,4)
+  rebuild.rebuild_ratio = 0 # Always rebuild
+  queries = random.randn(100,3)
+  for step in xrange(10):
+    moved = random.choice(len(X),size=5,replace=False).astype(int32)
+    X[moved] += (step+1)*random.randn(5,3)
+    refit.update_moved(moved)
+    rebuild.update_moved(moved)
+    fresh = SimplexTree(mesh,X,4)
+    for q in queries:
+      d = fresh.distance(q)
+      assert allclose(refit.distance(q),d)
+      assert allclose(rebuild.distance(q),d)
+  assert (refit.refits,refit.rebuilds)==(10,0)
+  assert (rebuild.refits,rebuild.rebuilds)==(0,10)
+
+def test_wide_simplex_tree():
+  mesh,X = sphere_mesh(4)
+  tree = SimplexTree(mesh,X,4)
+  hits = wide_simplex_tree_test(tree,1000,1e-6)
+  assert hits==648
+  # Wide trees follow refits of the binary tree
+  random.seed(10098335)
+  wide = WideSimplexTree(tree)
+  X[:] += .1*random.randn(*X.shape)
+  tree.update()
+  wide.update()
+  for q in random.randn(100,3):
+    assert allclose(wide.distance(q),tree.distance(q))
+
+def test_wide_particle_tree():
+  random.seed(10098336)
+  for n in 1,35,200,2000:
+    X = random.randn(n,3).astype(real)
+    tree = ParticleTree(X,2)
+    wide_particle_tree_test(tree,200,.05)
+    wide = WideParticleTree(tree)
+    for q in random.randn(20,3):
+      assert wide.closest_point(q)[1]==tree.closest_point(q)[1]
+
 if __name__=='__main__':
   test_simplex_tree()
+  test_simplex_tree_packet(benchmark='-b' in sys.argv)
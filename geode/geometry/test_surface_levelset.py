@@ -39,3 +39,16 @@ def test_surface_levelset():
     print 'i %d, phi %g, phi2 %g'%(i,phi[i],phi2[i])
   assert relative_error(abs(phi),phi2) < 1e-7
   assert all(magnitudes(cross(normal,normal2))<1e-7)
+
+def test_surface_levelset_parallel():
+  random.seed(127131)
+  mesh,X = sphere_mesh(4)
+  surface = SimplexTree(mesh,X,10)
+  particles = ParticleTree(random.randn(5000,3),10)
+  for signs in False,True:
+    phi,normal,_,_ = surface_levelset(particles,surface,10,signs)
+    phi2,normal2,_,_ = surface_levelset(particles,surface,10,signs,parallel=True)
+    # Subtrees visit simplices in a different order than the serial traversal, so ties between simplices
+    # may be broken differently.  Don't depend on the traversal order.
+    assert relative_error(phi,phi2) < 1e-7
+    assert relative_error(normal,normal2) < 1e-7
@@ -7,6 +7,10 @@
 #include <geode/array/RawStack.h>
 #include <geode/array/view.h>
 #include <geode/geometry/BoxTree.h>
+#include <geode/python/ExceptionValue.h>
+#include <geode/structure/Tuple.h>
+#include <geode/utility/openmp.h>
+#include <vector>
 namespace geode {
 
 // Traverse one box tree.  There is no automatic culling: the visitor is responsible for everything.
@@ -72,14 +76,14 @@ double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visit
   double_traverse_helper(tree0,tree1,visitor,stack,0,0,thickness);
 }
 
-// Helper function traversing a hierarchy against itself starting at the roots.
+// Helper function traversing a hierarchy against itself starting at the given node.
 template<class Visitor,class Thickness,class TV> static void
-double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness) {
+double_traverse_helper(const BoxTree<TV>& tree, Visitor&& visitor, Thickness thickness, const int start=0) {
   if (!tree.nodes())
     return;
   const int internal = tree.leaves.lo;
   RawStack<int> stack(GEODE_RAW_ALLOCA(6*tree.depth,int));
-  stack.push(0);
+  stack.push(start);
   while (stack.size()) {
     const int n = stack.pop();
     if (visitor.cull(n))
@@ -123,4 +127,122 @@ template<class Visitor,class TV> static void double_traverse(const BoxTree<TV>&
   double_traverse_helper(tree,visitor,Zero());
 }
 
+// Expansion and traversal of a single frontier entry (n,n) during self traversal; never called for distinct trees.
+template<class Visitor,class TV> static inline bool
+expand_self_entry(const BoxTree<TV>& tree, Visitor&& visitor, const int n, Array<Vector<int,2>>& next, mpl::true_) {
+  if (visitor.cull(n))
+    return false;
+  if (tree.is_leaf(n)) {
+    next.append(vec(n,n));
+    return false;
+  }
+  next.append(vec(2*n+1,2*n+1));
+  next.append(vec(2*n+2,2*n+2));
+  next.append(vec(2*n+1,2*n+2));
+  return true;
+}
+template<class Visitor,class TV> static inline bool
+expand_self_entry(const BoxTree<TV>& tree, Visitor&& visitor, const int n, Array<Vector<int,2>>& next, mpl::false_) {
+  GEODE_UNREACHABLE();
+}
+template<class Visitor,class Thickness,class TV> static inline void
+traverse_self_entry(const BoxTree<TV>& tree, Visitor&& visitor, const Thickness thickness, const int n, mpl::true_) {
+  double_traverse_helper(tree,visitor,thickness,n);
+}
+template<class Visitor,class Thickness,class TV> static inline void
+traverse_self_entry(const BoxTree<TV>& tree, Visitor&& visitor, const Thickness thickness, const int n, mpl::false_) {
+  GEODE_UNREACHABLE();
+}
+
+// Expand the node pair frontier of a double traversal breadth first until it has at least the given number of
+// entries or consists entirely of leaf pairs.  For self traversal, an entry (n,n) stands for the traversal of
+// node n against itself.  The frontier depends only on the trees and culling, never on the thread count.
+template<bool self,class Visitor,class Thickness,class TV> static Array<Vector<int,2>>
+traverse_frontier(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, Visitor&& visitor,
+                  const Thickness thickness, const int size) {
+  const int internal0 = tree0.leaves.lo,
+            internal1 = tree1.leaves.lo;
+  Array<Vector<int,2>> frontier, next;
+  if (tree0.nodes() && tree1.nodes())
+    frontier.append(vec(0,0));
+  for (bool split=true;split && frontier.size()<size;) {
+    split = false;
+    next.clear();
+    for (const auto n : frontier) {
+      if (self && n.x==n.y)
+        split |= expand_self_entry(tree0,visitor,n.x,next,mpl::bool_<self>());
+      else if (!visitor.cull(n.x,n.y) && tree0.boxes[n.x].intersects(tree1.boxes[n.y],thickness)) {
+        const bool split0 = n.x < internal0,
+                   split1 = n.y < internal1;
+        for (const int c0 : range(split0?2:1))
+          for (const int c1 : range(split1?2:1))
+            next.append(vec(split0?2*n.x+1+c0:n.x,
+                            split1?2*n.y+1+c1:n.y));
+        split |= split0 || split1;
+      }
+    }
+    swap(frontier,next);
+  }
+  return frontier;
+}
+
+// Run one traversal task per frontier entry in parallel, giving each task its own visitor.  One ThreadScope is
+// constructed on each thread before any visitor runs (e.g., IntervalScope, since rounding modes are per thread).
+// Exceptions thrown by visitors are rethrown on the calling thread, choosing the first task in frontier order.
+template<bool self,class ThreadScope,class MakeVisitor,class Thickness,class TV> static auto
+parallel_double_traverse_helper(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, const MakeVisitor& make_visitor,
+                                const Thickness thickness) -> std::vector<decltype(make_visitor())> {
+  typedef decltype(make_visitor()) Visitor;
+  const int tasks = 256; // Fixed so that the split into tasks is independent of the number of threads
+  const auto frontier = traverse_frontier<self>(tree0,tree1,make_visitor(),thickness,tasks);
+  std::vector<Visitor> visitors;
+  visitors.reserve(frontier.size());
+  for (int i=0;i<frontier.size();i++)
+    visitors.push_back(make_visitor());
+  std::vector<ExceptionValue> errors(frontier.size());
+  const int buffer_size = 3*max(tree0.depth,tree1.depth);
+  #pragma omp parallel if(frontier.size()>1)
+  {
+    GEODE_UNUSED const ThreadScope scope{};
+    #pragma omp for schedule(dynamic,1)
+    for (int i=0;i<frontier.size();i++) {
+      try {
+        const auto n = frontier[i];
+        if (self && n.x==n.y)
+          traverse_self_entry(tree0,visitors[i],thickness,n.x,mpl::bool_<self>());
+        else {
+          RawStack<Vector<int,2>> stack(GEODE_RAW_ALLOCA(buffer_size,Vector<int,2>));
+          double_traverse_helper(tree0,tree1,visitors[i],stack,n.x,n.y,thickness);
+        }
+      } catch (const std::exception& e) {
+        errors[i] = ExceptionValue(e);
+      }
+    }
+  }
+  for (const auto& error : errors)
+    if (error)
+      error.throw_();
+  return visitors;
+}
+
+// Parallel version of double_traverse for two distinct hierarchies.  The node pair frontier near the roots is split
+// into independent tasks which are load balanced across OpenMP threads, and make_visitor() is called to construct a
+// fresh visitor for each task.  The visitors are returned in frontier order, which does not depend on the number of
+// threads, so merging their results in order gives the same answer as a serial traversal up to ordering.
+template<class ThreadScope=Tuple<>,class MakeVisitor,class TV> static auto
+parallel_double_traverse(const BoxTree<TV>& tree0, const BoxTree<TV>& tree1, const MakeVisitor& make_visitor,
+                         const typename TV::Scalar thickness=0) -> std::vector<decltype(make_visitor())> {
+  GEODE_ASSERT(&tree0 != &tree1,"Identical trees should use the dedicated routine below");
+  return thickness ? parallel_double_traverse_helper<false,ThreadScope>(tree0,tree1,make_visitor,thickness)
+                   : parallel_double_traverse_helper<false,ThreadScope>(tree0,tree1,make_visitor,Zero());
+}
+
+// Parallel version of double_traverse for a hierarchy against itself.  Visitors need both cull(n) and cull(n0,n1).
+template<class ThreadScope=Tuple<>,class MakeVisitor,class TV> static auto
+parallel_double_traverse(const BoxTree<TV>& tree, const MakeVisitor& make_visitor,
+                         const typename TV::Scalar thickness=0) -> std::vector<decltype(make_visitor())> {
+  return thickness ? parallel_double_traverse_helper<true,ThreadScope>(tree,tree,make_visitor,thickness)
+                   : parallel_double_traverse_helper<true,ThreadScope>(tree,tree,make_visitor,Zero());
+}
+
 }
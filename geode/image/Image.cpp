@@ -18,9 +18,12 @@ namespace geode {
 
 using std::pow;
 using std::nth_element;
+using std::sort;
 
 template<> GEODE_DEFINE_TYPE(Image<float>)
 template<> GEODE_DEFINE_TYPE(Image<double>)
+template<> GEODE_DEFINE_TYPE(MedianStack<float>)
+template<> GEODE_DEFINE_TYPE(MedianStack<double>)
 
 template<class T> Array<Vector<T,3>,2> Image<T>::read(const string& filename)
 {
@@ -70,11 +73,14 @@ write_png_to_memory(RawArray<const Vector<T,4>,2> image) {
 template<class T> Array<Vector<T,3>,2> Image<T>::
 gamma_compress(Array<const Vector<T,3>,2> image,const real gamma)
 {
-    T one_over_gamma = T(1/gamma);
-    Array<Vector<T,3>,2> result(image.sizes());
-    for(int t=0;t<result.flat.size();t++)
-      for (int i = 0; i < 3; ++i)
-        result.flat[t][i] = pow(image.flat(t)[i],one_over_gamma);
+    const T one_over_gamma = T(1/gamma);
+    Array<Vector<T,3>,2> result(image.sizes(),uninit);
+    const RawArray<const T> src = scalar_view(image.flat);
+    const RawArray<T> dst = scalar_view(result.flat);
+    const int n = src.size();
+    #pragma omp parallel for
+    for(int t=0;t<n;t++)
+      dst[t] = pow(src[t],one_over_gamma);
     return result;
 }
 
@@ -83,19 +89,59 @@ dither(Array<const Vector<T,3>,2> image)
 {
     Ref<Random> random=new_<Random>(324032); // want uniform seed so noise perturbation pattern is temporally coherent
 
-    Array<Vector<T,3>,2> result(image.sizes());
-    for(int t=0;t<result.flat.size();t++){
-        result.flat(t)=image.flat(t);
-        Vector<T,3> pixel_values((T)255*result.flat(t));
-        Vector<int,3> floored_values((int)pixel_values[0],(int)pixel_values[1],(int)pixel_values[2]);
-        Vector<real,3> random_stuff=random->uniform<Vector<real,3> >(0,1);
-        Vector<T,3> normalized_values=pixel_values-Vector<T,3>(floored_values);
-        for(int k=0;k<3;k++)
-            if(random_stuff[k]>normalized_values[k]) result.flat(t)[k]=(floored_values[k]+(T).5001)/255; // use normal quantized floor
-            else result.flat(t)[k]=(floored_values[k]+(T)1.5001)/255;} // jump to next value
+    // Noise is drawn in chunks with counter based bulk sampling, so the pattern is independent of thread count
+    const int chunk = 1<<16;
+    Array<real> noise(3*chunk,uninit);
+    Array<Vector<T,3>,2> result(image.sizes(),uninit);
+    const int n = result.flat.size();
+    for(int lo=0;lo<n;lo+=chunk){
+        const int hi = min(n,lo+chunk);
+        const RawArray<real> random_stuff = noise.slice(0,3*(hi-lo));
+        random->bulk_uniform(random_stuff,0,1);
+        #pragma omp parallel for
+        for(int t=lo;t<hi;t++){
+            const Vector<T,3> pixel_values((T)255*image.flat[t]);
+            for(int k=0;k<3;k++){
+                const int floored_value = (int)pixel_values[k];
+                if(random_stuff[3*(t-lo)+k]>pixel_values[k]-floored_value) result.flat[t][k]=(floored_value+(T).5001)/255; // use normal quantized floor
+                else result.flat[t][k]=(floored_value+(T)1.5001)/255;}}} // jump to next value
     return result;
 }
 
+// Per pixel selection over a list of frames, in parallel over tiles of pixels.  Each tile transposes its samples into
+// a per thread buffer, so that frames are read sequentially and select runs over contiguous memory.
+static const int median_tile = 64;
+
+template<class T,class Select> static void
+median_tiles(const vector<RawArray<const Vector<T,3>>>& frames,RawArray<Vector<T,3>> result,const Select& select)
+{
+    const int n = (int)frames.size(),
+              pixels = result.size(),
+              tiles = (pixels+median_tile-1)/median_tile;
+    #pragma omp parallel
+    {
+        Array<T,2> samples(3*median_tile,n,uninit);
+        #pragma omp for schedule(static)
+        for(int b=0;b<tiles;b++){
+            const int lo = b*median_tile,
+                      hi = min(pixels,lo+median_tile);
+            for(int k=0;k<n;k++){
+                const RawArray<const T> frame = scalar_view(frames[k].slice(lo,hi));
+                for(int i=0;i<frame.size();i++)
+                    samples(i,k) = frame[i];}
+            const RawArray<T> tile = scalar_view(result.slice(lo,hi));
+            for(int i=0;i<tile.size();i++)
+                tile[i] = select(samples[i]);}
+    }
+}
+
+template<class T> static T median_select(RawArray<T> samples)
+{
+    const int n = samples.size();
+    nth_element(samples.begin(),samples.begin()+n/2,samples.end());
+    return samples[n/2];
+}
+
 template<class T>
 Array<Vector<T,3>,2> Image<T>::median(const vector<Array<const Vector<T,3>,2> >& images) {
   GEODE_ASSERT(images.size());
@@ -103,17 +149,89 @@ Array<Vector<T,3>,2> Image<T>::median(const vector<Array<const Vector<T,3>,2> >&
   for (int k=1;k<n;k++)
     GEODE_ASSERT(images[0].sizes()==images[k].sizes());
 
-  Array<T,2> pixel(3,n);
-  Array<Vector<T,3>,2> result(images[0].sizes());
-  for(int t=0; t<result.flat.size(); t++){
-    for (int k=0;k<n;k++)
-      images[k].flat[t].get(pixel(0,k),pixel(1,k),pixel(2,k));
-    for (int a=0;a<3;a++) {
-      RawArray<T> samples = pixel[a];
-      nth_element(&samples[0],&samples[n/2],&samples[n-1]);
-      result.flat[t][a] = samples[n/2];
+  vector<RawArray<const Vector<T,3>>> frames;
+  for (const auto& image : images)
+    frames.push_back(image.flat);
+  Array<Vector<T,3>,2> result(images[0].sizes(),uninit);
+  median_tiles<T>(frames,result.flat,median_select<T>);
+  return result;
+}
+
+template<class T> MedianStack<T>::MedianStack(const Vector<int,2> sizes,const int base)
+  : sizes(sizes)
+  , base(base)
+  , frames_(0) {
+  if (!(sizes.min()>=0))
+    throw ValueError(format("MedianStack: expected nonnegative sizes, got %d %d",sizes.x,sizes.y));
+  if (base < 2)
+    throw ValueError(format("MedianStack: expected base at least 2, got %d",base));
+}
+
+template<class T> MedianStack<T>::~MedianStack() {}
+
+template<class T> void MedianStack<T>::add(RawArray<const Vector<T,3>,2> frame) {
+  if (frame.sizes() != sizes)
+    throw ValueError(format("MedianStack::add: expected frame of size %d %d, got %d %d",
+                            sizes.x,sizes.y,frame.m,frame.n));
+  if (levels.empty()) {
+    levels.push_back(Array<Vector<T,3>,2>(base,sizes.product(),uninit));
+    counts.push_back(0);
+  }
+  levels[0][counts[0]++] = frame.flat;
+  frames_++;
+
+  // Push the median of each full buffer up a level
+  for (int l=0;counts[l]==base;l++) {
+    if (l+1 == (int)levels.size()) {
+      levels.push_back(Array<Vector<T,3>,2>(base,sizes.product(),uninit));
+      counts.push_back(0);
     }
+    vector<RawArray<const Vector<T,3>>> full;
+    for (int s=0;s<base;s++)
+      full.push_back(levels[l][s]);
+    median_tiles<T>(full,levels[l+1][counts[l+1]++],median_select<T>);
+    counts[l] = 0;
+  }
+}
+
+template<class T> Array<Vector<T,3>,2> MedianStack<T>::median() const {
+  if (!frames_)
+    throw RuntimeError("MedianStack::median: no frames added");
+
+  // Each level's slots are sorted separately, then merged until the cumulative weight passes the middle frame
+  vector<RawArray<const Vector<T,3>>> slots;
+  vector<int> offsets(1,0);
+  for (int l=0;l<(int)levels.size();l++) {
+    for (int s=0;s<counts[l];s++)
+      slots.push_back(levels[l][s]);
+    offsets.push_back(offsets.back()+counts[l]);
   }
+  const int L = (int)levels.size(),
+            middle = frames_/2;
+  GEODE_ASSERT(L<=32);
+  vector<int64_t> weights(1,1);
+  for (int l=1;l<L;l++)
+    weights.push_back(base*weights.back());
+  const auto select = [&offsets,&weights,L,middle](RawArray<T> samples) {
+    int next[32]; // Merge position per level
+    for (int l=0;l<L;l++) {
+      sort(samples.begin()+offsets[l],samples.begin()+offsets[l+1]);
+      next[l] = offsets[l];
+    }
+    int64_t weight = 0;
+    for (;;) {
+      int best = -1;
+      for (int l=0;l<L;l++)
+        if (next[l]<offsets[l+1] && (best<0 || samples[next[l]]<samples[next[best]]))
+          best = l;
+      weight += weights[best];
+      const T value = samples[next[best]++];
+      if (weight > middle)
+        return value;
+    }
+  };
+  Array<Vector<T,3>,2> result(sizes,uninit);
+  median_tiles<T>(slots,result.flat,select);
   return result;
 }
 
@@ -132,6 +250,8 @@ template<> uint8_t component_to_byte_color(const uint8_t color_in) { return colo
 
 template class Image<float>;
 template class Image<double>;
+template class MedianStack<float>;
+template class MedianStack<double>;
 template Array<Vector<uint8_t,3>,2> Image<uint8_t>::read(const string&);
 template Array<Vector<uint8_t,4>,2> Image<uint8_t>::read_alpha(const string&);
 template void Image<uint8_t>::write(const string&,RawArray<const Vector<uint8_t,3>,2>);
@@ -149,13 +269,27 @@ void wrap_Image()
   using namespace python;
   typedef real T;
 
-  typedef Image<T> Self;
+  {typedef Image<T> Self;
   Class<Self>("Image")
     .GEODE_METHOD(read)
     .GEODE_METHOD(write)
     .GEODE_METHOD(gamma_compress)
     .GEODE_METHOD(dither)
     .GEODE_METHOD(median)
+    .GEODE_METHOD(flip_x)
+    .GEODE_METHOD(flip_y)
+    .GEODE_METHOD(invert)
+    .GEODE_METHOD(threshold)
     .GEODE_METHOD(is_supported)
-    ;
+    ;}
+
+  {typedef MedianStack<T> Self;
+  Class<Self>("MedianStack")
+    .GEODE_INIT(Vector<int,2>,int)
+    .GEODE_FIELD(sizes)
+    .GEODE_FIELD(base)
+    .GEODE_GET(frames)
+    .GEODE_METHOD(add)
+    .GEODE_METHOD(median)
+    ;}
 }
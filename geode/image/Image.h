@@ -52,17 +52,27 @@ public:
     template<int C> static Vector<uint8_t,C> to_byte_color(const Vector<T,C> color_in)
     {return geode::to_byte_color<T,C>(color_in); }
 
-    static void flip_x(Array<Vector<T,3>,2>& image)
-    {for(int i=0;i<image.m/2;i++)for(int j=0;j<image.n;j++) swap(image(i,j),image(image.m-1-i,j));}
+    // The in place kernels below run in parallel over rows, with contiguous inner loops
+    static void flip_x(RawArray<Vector<T,3>,2> image)
+    {const int m=image.m,n=image.n;
+    #pragma omp parallel for
+    for(int i=0;i<m/2;i++){const RawArray<Vector<T,3>> a=image[i],b=image[m-1-i];for(int j=0;j<n;j++) swap(a[j],b[j]);}}
 
-    static void flip_y(Array<Vector<T,3>,2>& image)
-    {for(int j=0;j<image.n/2;j++)for(int i=0;i<image.m;i++) swap(image(i,j),image(i,image.n-1-j));}
+    static void flip_y(RawArray<Vector<T,3>,2> image)
+    {const int m=image.m,n=image.n;
+    #pragma omp parallel for
+    for(int i=0;i<m;i++){const RawArray<Vector<T,3>> a=image[i];for(int j=0;j<n/2;j++) swap(a[j],a[n-1-j]);}}
 
-    static void invert(Array<Vector<T,3>,2>& image)
-    {for(int i=0;i<image.m;i++) for(int j=0;j<image.n;j++) image(i,j)=Vector<T,3>::ones()-image(i,j);}
+    static void invert(RawArray<Vector<T,3>,2> image)
+    {const int m=image.m,n=image.n;
+    #pragma omp parallel for
+    for(int i=0;i<m;i++){const RawArray<Vector<T,3>> a=image[i];for(int j=0;j<n;j++) a[j]=Vector<T,3>::ones()-a[j];}}
 
-    static void threshold(Array<Vector<T,3>,2>& image,const T threshold,const Vector<T,3>& low_color,const Vector<T,3>& high_color)
-    {for(int i=0;i<image.m;i++) for(int j=0;j<image.n;j++) image(i,j)=image(i,j).magnitude()<threshold?low_color:high_color;}
+    // Compares squared magnitudes to avoid a square root per pixel
+    static void threshold(RawArray<Vector<T,3>,2> image,const T threshold,const Vector<T,3>& low_color,const Vector<T,3>& high_color)
+    {const int m=image.m,n=image.n;const T sqr_threshold=threshold>0?sqr(threshold):0;
+    #pragma omp parallel for
+    for(int i=0;i<m;i++){const RawArray<Vector<T,3>> a=image[i];for(int j=0;j<n;j++) a[j]=a[j].sqr_magnitude()<sqr_threshold?low_color:high_color;}}
 
     //#####################################################################
     GEODE_CORE_EXPORT static Array<Vector<T,3>,2> read(const string& filename);
@@ -74,7 +84,36 @@ public:
     GEODE_CORE_EXPORT static Array<Vector<T,3>,2> gamma_compress(Array<const Vector<T,3>,2> image,const real gamma);
     GEODE_CORE_EXPORT static Array<Vector<T,3>,2> dither(Array<const Vector<T,3>,2> image);
     GEODE_CORE_EXPORT static bool is_supported(const string& filename);
-    GEODE_CORE_EXPORT static Array<Vector<T,3>,2> median(const vector<Array<const Vector<T,3>,2> >& images);
+    GEODE_CORE_EXPORT static Array<Vector<T,3>,2> median(const vector<Array<const Vector<T,3>,2> >& images); // Exact, all frames resident
     //#####################################################################
 };
+
+// Streaming per pixel median of a sequence of equally sized frames, using the remedian of Rousseeuw and Bassett (1990).
+// Frames are copied into a buffer of base slots, and whenever a buffer fills its per pixel median is pushed into a slot
+// one level up, so memory is base*log_base(frames) samples per pixel rather than one per frame.  The result is exact for
+// up to base frames; beyond that it is the weighted median of the buffered values, a robust approximation.
+template<class T>
+class MedianStack : public Object
+{
+public:
+    GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+    typedef Object Base;
+
+    const Vector<int,2> sizes;
+    const int base;
+private:
+    int frames_;
+    vector<Array<Vector<T,3>,2> > levels; // levels[l] has shape (base,pixels), and each slot stands for base^l frames
+    vector<int> counts; // Occupied slots per level
+protected:
+    GEODE_CORE_EXPORT MedianStack(const Vector<int,2> sizes,const int base);
+public:
+    ~MedianStack();
+
+    int frames() const
+    {return frames_;}
+
+    GEODE_CORE_EXPORT void add(RawArray<const Vector<T,3>,2> frame);
+    GEODE_CORE_EXPORT Array<Vector<T,3>,2> median() const;
+};
 }
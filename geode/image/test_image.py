@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from numpy import *
+from geode import *
+import time
+import sys
+
+def frames(count,m,n,outliers=.3):
+  # A static background with small noise, where a fraction of each frame is replaced by foreground clutter
+  random.seed(7)
+  background = random.uniform(0,1,(m,n,3))
+  images = []
+  for _ in xrange(count):
+    frame = background+.02*random.uniform(-.5,.5,(m,n,3))
+    mask = random.uniform(0,1,(m,n))<outliers
+    frame[mask] = random.uniform(0,1,(mask.sum(),3))
+    images.append(frame)
+  return background,images
+
+def test_median():
+  for count in 1,2,7,16:
+    _,images = frames(count,10,13)
+    assert all(Image.median(images)==sort(images,axis=0)[count//2])
+
+def test_median_stack():
+  for count in 1,2,7,15:
+    _,images = frames(count,10,13)
+    stack = MedianStack((10,13),15)
+    for f in images:
+      stack.add(f)
+    assert stack.frames==count
+    assert all(stack.median()==Image.median(images))
+  # Beyond base frames the remedian is approximate, but still rejects the clutter
+  background,images = frames(300,10,13)
+  stack = MedianStack((10,13),15)
+  for f in images:
+    stack.add(f)
+  assert abs(stack.median()-background).max()<.05
+
+def test_kernels():
+  random.seed(3)
+  image = random.uniform(0,1,(10,13,3))
+  assert allclose(Image.gamma_compress(image,2),sqrt(image))
+  dithered = Image.dither(image)
+  assert all(dithered==Image.dither(image))
+  assert abs(dithered-image).max()<1.51/255
+
+def test_flips():
+  random.seed(5)
+  for m,n in (9,13),(10,12):
+    image = random.uniform(0,1,(m,n,3))
+    for kernel,expected in (Image.flip_x,image[::-1]),(Image.flip_y,image[:,::-1]),(Image.invert,1-image):
+      result = image.copy()
+      kernel(result)
+      assert all(result==expected)
+
+def test_threshold():
+  random.seed(6)
+  image = random.uniform(0,1,(10,13,3))
+  magnitude = sqrt((image**2).sum(axis=-1))
+  low,high = (0,0,.5),(1,1,.25)
+  for threshold in -1,0,.8,1.2:
+    result = image.copy()
+    Image.threshold(result,threshold,low,high)
+    assert all(result==where((magnitude<threshold)[...,None],low,high))
+
+def benchmark_median():
+  m,n = 480,640
+  for count in 100,300:
+    _,images = frames(count,m,n)
+    start = time.time()
+    exact = Image.median(images)
+    exact_time = time.time()-start
+    start = time.time()
+    stack = MedianStack((m,n),15)
+    for f in images:
+      stack.add(f)
+    approx = stack.median()
+    stack_time = time.time()-start
+    print '%d frames: exact %.2f s, stack %.2f s, max difference %g'%(count,exact_time,stack_time,abs(exact-approx).max())
+
+if __name__=='__main__':
+  if '-b' in sys.argv:
+    benchmark_median()
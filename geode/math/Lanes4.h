@@ -0,0 +1,85 @@
+// SIMD vectors of four floats or doubles
+#pragma once
+
+#include <geode/math/sse.h>
+namespace geode {
+
+// Four scalars processed in lockstep.  Lanes4<double> is a single __m256d with AVX, a pair of __m128d with SSE2, and
+// Lanes4<float> is a __m128 with SSE; everything else is a plain array.  Comparisons produce lane masks in the same
+// representation, which movemask collapses to one bit per lane.
+template<class T> struct Lanes4 {
+  T x[4];
+
+  static Lanes4 splat(const T s) { return {{s,s,s,s}}; }
+  static Lanes4 load(const T* p) { return {{p[0],p[1],p[2],p[3]}}; }
+  void store(T* p) const { for (int i=0;i<4;i++) p[i] = x[i]; }
+
+  // min and max follow SSE semantics: if either argument is nan, the second is returned
+  friend Lanes4 operator+(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]+b.x[i]; return r; }
+  friend Lanes4 operator-(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]-b.x[i]; return r; }
+  friend Lanes4 operator*(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]*b.x[i]; return r; }
+  friend Lanes4 min(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]<b.x[i] ? a.x[i] : b.x[i]; return r; }
+  friend Lanes4 max(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]>b.x[i] ? a.x[i] : b.x[i]; return r; }
+  friend Lanes4 operator<=(const Lanes4 a, const Lanes4 b) { Lanes4 r; for (int i=0;i<4;i++) r.x[i] = a.x[i]<=b.x[i]; return r; }
+  friend int movemask(const Lanes4 a) { int m = 0; for (int i=0;i<4;i++) m |= (a.x[i]!=0)<<i; return m; }
+};
+
+#if defined(GEODE_SSE) && defined(__AVX__)
+
+template<> struct Lanes4<double> {
+  __m256d x;
+
+  static Lanes4 splat(const double s) { return {_mm256_set1_pd(s)}; }
+  static Lanes4 load(const double* p) { return {_mm256_loadu_pd(p)}; }
+  void store(double* p) const { _mm256_storeu_pd(p,x); }
+
+  friend Lanes4 operator+(const Lanes4 a, const Lanes4 b) { return {_mm256_add_pd(a.x,b.x)}; }
+  friend Lanes4 operator-(const Lanes4 a, const Lanes4 b) { return {_mm256_sub_pd(a.x,b.x)}; }
+  friend Lanes4 operator*(const Lanes4 a, const Lanes4 b) { return {_mm256_mul_pd(a.x,b.x)}; }
+  friend Lanes4 min(const Lanes4 a, const Lanes4 b) { return {_mm256_min_pd(a.x,b.x)}; }
+  friend Lanes4 max(const Lanes4 a, const Lanes4 b) { return {_mm256_max_pd(a.x,b.x)}; }
+  friend Lanes4 operator<=(const Lanes4 a, const Lanes4 b) { return {_mm256_cmp_pd(a.x,b.x,_CMP_LE_OQ)}; }
+  friend int movemask(const Lanes4 a) { return _mm256_movemask_pd(a.x); }
+};
+
+#elif defined(GEODE_SSE)
+
+template<> struct Lanes4<double> {
+  __m128d lo, hi;
+
+  static Lanes4 splat(const double s) { const auto v = _mm_set1_pd(s); return {v,v}; }
+  static Lanes4 load(const double* p) { return {_mm_loadu_pd(p),_mm_loadu_pd(p+2)}; }
+  void store(double* p) const { _mm_storeu_pd(p,lo); _mm_storeu_pd(p+2,hi); }
+
+  friend Lanes4 operator+(const Lanes4 a, const Lanes4 b) { return {_mm_add_pd(a.lo,b.lo),_mm_add_pd(a.hi,b.hi)}; }
+  friend Lanes4 operator-(const Lanes4 a, const Lanes4 b) { return {_mm_sub_pd(a.lo,b.lo),_mm_sub_pd(a.hi,b.hi)}; }
+  friend Lanes4 operator*(const Lanes4 a, const Lanes4 b) { return {_mm_mul_pd(a.lo,b.lo),_mm_mul_pd(a.hi,b.hi)}; }
+  friend Lanes4 min(const Lanes4 a, const Lanes4 b) { return {_mm_min_pd(a.lo,b.lo),_mm_min_pd(a.hi,b.hi)}; }
+  friend Lanes4 max(const Lanes4 a, const Lanes4 b) { return {_mm_max_pd(a.lo,b.lo),_mm_max_pd(a.hi,b.hi)}; }
+  friend Lanes4 operator<=(const Lanes4 a, const Lanes4 b) { return {_mm_cmple_pd(a.lo,b.lo),_mm_cmple_pd(a.hi,b.hi)}; }
+  friend int movemask(const Lanes4 a) { return _mm_movemask_pd(a.lo)|_mm_movemask_pd(a.hi)<<2; }
+};
+
+#endif
+
+#ifdef GEODE_SSE
+
+template<> struct Lanes4<float> {
+  __m128 x;
+
+  static Lanes4 splat(const float s) { return {_mm_set1_ps(s)}; }
+  static Lanes4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+  void store(float* p) const { _mm_storeu_ps(p,x); }
+
+  friend Lanes4 operator+(const Lanes4 a, const Lanes4 b) { return {_mm_add_ps(a.x,b.x)}; }
+  friend Lanes4 operator-(const Lanes4 a, const Lanes4 b) { return {_mm_sub_ps(a.x,b.x)}; }
+  friend Lanes4 operator*(const Lanes4 a, const Lanes4 b) { return {_mm_mul_ps(a.x,b.x)}; }
+  friend Lanes4 min(const Lanes4 a, const Lanes4 b) { return {_mm_min_ps(a.x,b.x)}; }
+  friend Lanes4 max(const Lanes4 a, const Lanes4 b) { return {_mm_max_ps(a.x,b.x)}; }
+  friend Lanes4 operator<=(const Lanes4 a, const Lanes4 b) { return {_mm_cmple_ps(a.x,b.x)}; }
+  friend int movemask(const Lanes4 a) { return _mm_movemask_ps(a.x); }
+};
+
+#endif
+
+}
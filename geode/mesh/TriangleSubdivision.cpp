@@ -181,7 +181,7 @@ Ref<SparseMatrix> TriangleSubdivision::loop_matrix() const {
     }
   }
   // Finalize construction
-  loop_matrix_ = new_<SparseMatrix>(A,vec(offset+segments.size(),offset));
+  loop_matrix_ = new_<SparseMatrix>(A,vec(offset+int(segments.size()),offset));
   return ref(loop_matrix_);
 }
 
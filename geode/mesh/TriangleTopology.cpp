@@ -1148,7 +1148,19 @@ bool MutableTriangleTopology::is_collapse_safe(HalfedgeId h) const {
     return false;
 
   // One-rings of v0 and v1 cannot intersect, otherwise we'll collapse a
-  // triangle-shaped tunnel
+  // triangle-shaped tunnel.  Valences are usually small, so search directly
+  // unless that would be quadratically expensive.
+  if (valence(v0)*valence(v1) <= 256) {
+    for (auto oh1: outgoing(v1)) {
+      auto v = dst(oh1);
+      if (v == vl || v == vr)
+        continue;
+      for (auto oh0: outgoing(v0))
+        if (dst(oh0) == v)
+          return false;
+    }
+    return true;
+  }
   Hashtable<VertexId> covered;
   for (auto oh: outgoing(v0)) {
     auto v = dst(oh);
@@ -181,5 +181,20 @@ def mesh_lower_hull(mesh, up, offset, draft_angle = 0., division_angle = 30./180
 def mesh_offset(mesh, offset):
   return meshify(*rough_offset_mesh(mesh, mesh.vertex_field(vertex_position_id), offset))
 
-def decimate(mesh,X,distance,max_angle=pi/2,min_vertices=-1,boundary_distance=0):
-  return geode_wrap.decimate(mesh,X,distance,max_angle,min_vertices,boundary_distance)
+def decimate(mesh,X,distance,max_angle=pi/2,min_vertices=-1,boundary_distance=0,parallel=False):
+  return geode_wrap.decimate(mesh,X,distance,max_angle,min_vertices,boundary_distance,parallel)
+
+def improve_mesh(mesh,min_quality,max_distance,max_silhouette_distance,min_normal_dot=.8,max_iter=20,
+                 min_relevant_area=1e-12,min_quality_improvement=1e-6,parallel=False):
+  return geode_wrap.improve_mesh(mesh,min_quality,max_distance,max_silhouette_distance,min_normal_dot,max_iter,
+                                 min_relevant_area,min_quality_improvement,parallel)
+
+def stream_mesh(filename,batch_size=1<<16,weld=0):
+  '''Iterate over (X,tris) batches of a large .stl, .obj, or .ply file.  X holds the vertices new to each batch, and
+  tris use global vertex ids.  See MeshReader in io.h for details.'''
+  reader = mesh_reader(filename,batch_size,weld)
+  while 1:
+    X,tris = reader.read()
+    if not len(X) and not len(tris):
+      break
+    yield X,tris
@@ -4,6 +4,8 @@
 #include <geode/python/wrap.h>
 #include <geode/structure/Heap.h>
 #include <geode/mesh/quadric.h>
+#include <geode/utility/range.h>
+#include <algorithm>
 
 namespace geode {
 
@@ -73,42 +75,180 @@ struct Heap : public HeapBase<Heap>, public Noncopyable {
 };
 }
 
+// Finds the best edge to collapse v along.  Returns (q(e),dst(e)).
+static Tuple<T,VertexId> best_collapse(const TriangleTopology& mesh, RawField<TV,VertexId> X, const VertexId v) {
+  Quadric q = compute_quadric(mesh,X,v);
+
+  // Find the best edge, ignoring normal constraints
+  T min_q = inf;
+  HalfedgeId min_e;
+  for (const auto e : mesh.outgoing(v)) {
+    const T qx = q(X[mesh.dst(e)]);
+    if (min_q > qx) {
+      min_q = qx;
+      min_e = e;
+    }
+  }
+  return tuple(min_q,mesh.dst(min_e));
+}
+
+// Is collapsing e allowed by topology, the boundary distance limit, and the normal limit?
+// Reads only the one-rings of src(e) and dst(e).
+static bool collapse_allowed(const MutableTriangleTopology& mesh, RawField<const TV,VertexId> X, const HalfedgeId e,
+                             const T sign_sqr_min_cos, const T boundary_distance) {
+  if (!e.valid() || !mesh.is_collapse_safe(e))
+    return false;
+  const auto vs = mesh.src(e),
+             vd = mesh.dst(e);
+  const auto xs = X[vs],
+             xd = X[vd];
+
+  // Are we moving a boundary vertex too far from its two boundary lines?
+  {
+    const auto b = mesh.halfedge(vs);
+    if (mesh.is_boundary(b)) {
+      const auto x0 = X[mesh.dst(b)],
+                 x1 = X[mesh.src(mesh.prev(b))];
+      if (   line_point_distance(simplex(xs,x0),xd) > boundary_distance
+          || line_point_distance(simplex(xs,x1),xd) > boundary_distance)
+        return false;
+    }
+  }
+
+  // Do the normals change too much?
+  if (sign_sqr_min_cos > -1)
+    for (const auto ee : mesh.outgoing(vs))
+      if (e!=ee && !mesh.is_boundary(ee)) {
+        const auto v2 = mesh.opposite(ee);
+        if (v2 != vd) {
+          const auto x1 = X[mesh.dst(ee)],
+                     x2 = X[v2];
+          const auto n0 = cross(x2-x1,xs-x1),
+                     n1 = cross(x2-x1,xd-x1);
+          if (sign_sqr(dot(n0,n1)) < sign_sqr_min_cos*sqr_magnitude(n0)*sqr_magnitude(n1))
+            return false;
+        }
+      }
+  return true;
+}
+
+// Decimate in rounds.  Each round recomputes the priorities of vertices whose neighborhoods changed, greedily
+// picks the cheapest collapses whose closed one-rings are disjoint, checks them concurrently, and applies the
+// survivors.  Disjoint one-rings mean that no collapse in a round can affect the checks of another.
+static void parallel_decimate_inplace(MutableTriangleTopology& mesh, RawField<TV,VertexId> X, const T area,
+                                      const T sign_sqr_min_cos, const int min_vertices, const T boundary_distance) {
+  const int nv = mesh.allocated_vertices();
+  Field<T,VertexId> cost(nv,uninit);
+  Field<VertexId,VertexId> target(nv,uninit);
+  Field<int,VertexId> stamp(nv); // Round in which a vertex was last claimed by a collapse
+  Field<bool,VertexId> dirty(nv);
+  Array<VertexId> update;
+  for (const auto v : mesh.vertices())
+    update.append(v);
+  Array<Tuple<T,VertexId>> candidates;
+  Array<HalfedgeId> batch;
+  Array<bool> allowed;
+  const auto mark = [&](const VertexId v) {
+    if (!dirty[v]) {
+      dirty[v] = true;
+      update.append(v);
+    }
+  };
+  for (int round=1;;round++) {
+    // Recompute priorities of changed vertices
+    #pragma omp parallel for
+    for (int i=0;i<update.size();i++) {
+      const auto v = update[i];
+      const auto qe = best_collapse(mesh,X,v);
+      cost[v] = qe.x;
+      target[v] = qe.y;
+    }
+    for (const auto v : update)
+      dirty[v] = false;
+    update.clear();
+
+    // Greedily pick cheap collapses with disjoint closed one-rings
+    candidates.clear();
+    for (const auto v : mesh.vertices())
+      if (cost[v] <= area)
+        candidates.append(tuple(cost[v],v));
+    if (!candidates.size())
+      break;
+    std::sort(candidates.begin(),candidates.end());
+    batch.clear();
+    for (const auto& c : candidates) {
+      const auto vs = c.y,
+                 vd = target[vs];
+      if (stamp[vs]==round || stamp[vd]==round)
+        continue;
+      const auto e = mesh.halfedge(vs,vd);
+      if (!e.valid()) {
+        cost[vs] = inf;
+        continue;
+      }
+      for (const auto h : mesh.outgoing(vs))
+        if (stamp[mesh.dst(h)]==round)
+          goto claimed;
+      for (const auto h : mesh.outgoing(vd))
+        if (stamp[mesh.dst(h)]==round)
+          goto claimed;
+      stamp[vs] = stamp[vd] = round;
+      for (const auto h : mesh.outgoing(vs))
+        stamp[mesh.dst(h)] = round;
+      for (const auto h : mesh.outgoing(vd))
+        stamp[mesh.dst(h)] = round;
+      batch.append(e);
+      claimed:;
+    }
+
+    // Check collapses concurrently
+    allowed.resize(batch.size(),uninit);
+    #pragma omp parallel for
+    for (int i=0;i<batch.size();i++)
+      allowed[i] = collapse_allowed(mesh,X,batch[i],sign_sqr_min_cos,boundary_distance);
+
+    // Apply allowed collapses.  Rejected vertices drop out until their neighborhood changes, as in the serial heap.
+    for (const int i : range(batch.size())) {
+      const auto e = batch[i];
+      if (!allowed[i]) {
+        cost[mesh.src(e)] = inf;
+        continue;
+      }
+      const auto vd = mesh.dst(e);
+      mesh.unsafe_collapse(e);
+      if (mesh.n_vertices() <= min_vertices)
+        return;
+      mark(vd);
+      for (const auto h : mesh.outgoing(vd))
+        mark(mesh.dst(h));
+    }
+  }
+}
+
 void decimate_inplace(MutableTriangleTopology& mesh, RawField<TV,VertexId> X,
-                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance) {
+                      const T distance, const T max_angle, const int min_vertices, const T boundary_distance,
+                      const bool parallel) {
   if (mesh.n_vertices() <= min_vertices)
     return;
   const T area = sqr(distance);
   const T sign_sqr_min_cos = sign_sqr(max_angle > .99*pi ? -1 : cos(max_angle));
-
-  // Finds the best edge to collapse v along.  Returns (q(e),dst(e)).
-  const auto best_collapse = [&mesh,X](const VertexId v) {
-    Quadric q = compute_quadric(mesh,X,v);
-
-    // Find the best edge, ignoring normal constraints
-    T min_q = inf;
-    HalfedgeId min_e;
-    for (const auto e : mesh.outgoing(v)) {
-      const T qx = q(X[mesh.dst(e)]);
-      if (min_q > qx) {
-        min_q = qx;
-        min_e = e;
-      }
-    }
-    return tuple(min_q,mesh.dst(min_e));
-  };
+  if (parallel) {
+    parallel_decimate_inplace(mesh,X,area,sign_sqr_min_cos,min_vertices,boundary_distance);
+    return;
+  }
 
   // Initialize quadrics and heap
-  Heap heap(mesh.n_vertices_);
+  Heap heap(mesh.allocated_vertices());
   for (const auto v : mesh.vertices()) {
-    const auto qe = best_collapse(v);
+    const auto qe = best_collapse(mesh,X,v);
     if (qe.x <= area)
       heap.inv_heap[v] = heap.heap.append(tuple(v,qe.x,qe.y));
   }
   heap.make();
 
   // Update the quadric information for a vertex
-  const auto update = [&heap,best_collapse,area](const VertexId v) {
-    const auto qe = best_collapse(v);
+  const auto update = [&heap,&mesh,X,area](const VertexId v) {
+    const auto qe = best_collapse(mesh,X,v);
     if (qe.x <= area)
       heap.set(v,qe.x,qe.y);
     else
@@ -123,41 +263,9 @@ void decimate_inplace(MutableTriangleTopology& mesh, RawField<TV,VertexId> X,
     if (mesh.valid(v.x) && mesh.valid(v.y)) {
       const auto e = mesh.halfedge(v.x,v.y);
 
-      // Is the collapse invalid?
-      if (e.valid() && mesh.is_collapse_safe(e)) {
-        const auto vs = mesh.src(e),
-                   vd = mesh.dst(e);
-        const auto xs = X[vs],
-                   xd = X[vd];
-
-        // Are we moving a boundary vertex too far from its two boundary lines?
-        {
-          const auto b = mesh.halfedge(vs);
-          if (mesh.is_boundary(b)) {
-            const auto x0 = X[mesh.dst(b)],
-                       x1 = X[mesh.src(mesh.prev(b))];
-            if (   line_point_distance(simplex(xs,x0),xd) > boundary_distance
-                || line_point_distance(simplex(xs,x1),xd) > boundary_distance)
-              goto bad;
-          }
-        }
-
-        // Do the normals change too much?
-        if (sign_sqr_min_cos > -1)
-          for (const auto ee : mesh.outgoing(vs))
-            if (e!=ee && !mesh.is_boundary(ee)) {
-              const auto v2 = mesh.opposite(ee);
-              if (v2 != vd) {
-                const auto x1 = X[mesh.dst(ee)],
-                           x2 = X[v2];
-                const auto n0 = cross(x2-x1,xs-x1),
-                           n1 = cross(x2-x1,xd-x1);
-                if (sign_sqr(dot(n0,n1)) < sign_sqr_min_cos*sqr_magnitude(n0)*sqr_magnitude(n1))
-                  goto bad;
-              }
-            }
-
-        // Collapse vs onto vd, then update the heap
+      // Collapse vs onto vd, then update the heap
+      if (collapse_allowed(mesh,X,e,sign_sqr_min_cos,boundary_distance)) {
+        const auto vd = mesh.dst(e);
         mesh.unsafe_collapse(e);
         if (mesh.n_vertices() <= min_vertices)
           break;
@@ -166,16 +274,16 @@ void decimate_inplace(MutableTriangleTopology& mesh, RawField<TV,VertexId> X,
           update(mesh.dst(e));
       }
     }
-    bad:;
   }
 }
 
 Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>
 decimate(const TriangleTopology& mesh, RawField<const TV,VertexId> X,
-         const T distance, const T max_angle, const int min_vertices, const T boundary_distance) {
+         const T distance, const T max_angle, const int min_vertices, const T boundary_distance,
+         const bool parallel) {
   const auto rmesh = mesh.mutate();
   const auto rX = X.copy();
-  decimate_inplace(rmesh,rX,distance,max_angle,min_vertices,boundary_distance);
+  decimate_inplace(rmesh,rX,distance,max_angle,min_vertices,boundary_distance,parallel);
   return Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>(rmesh,rX);
 }
 
@@ -10,7 +10,8 @@ decimate(const TriangleTopology& mesh,
          const real distance,             // (Very) approximate distance between original and decimation
          const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
          const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
-         const real boundary_distance=0); // How far we're allowed to move the boundary
+         const real boundary_distance=0,  // How far we're allowed to move the boundary
+         const bool parallel=false);      // Collapse in batches of independent edges using multiple threads
 
 GEODE_CORE_EXPORT void
 decimate_inplace(MutableTriangleTopology& mesh,
@@ -18,6 +19,7 @@ decimate_inplace(MutableTriangleTopology& mesh,
                  const real distance,             // (Very) approximate distance between original and decimation
                  const real max_angle=pi/2,       // Max normal angle change in radians for one decimation step
                  const int min_vertices=-1,       // Stop if we decimate down to this many vertices (-1 for no limit)
-                 const real boundary_distance=0); // How far we're allowed to move the boundary
+                 const real boundary_distance=0,  // How far we're allowed to move the boundary
+                 const bool parallel=false);      // Collapse in batches of independent edges using multiple threads
 
 }
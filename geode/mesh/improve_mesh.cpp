@@ -1,22 +1,29 @@
 #include <geode/mesh/improve_mesh.h>
+#include <geode/utility/format.h>
+#include <geode/utility/Log.h>
 
 namespace geode {
 
 bool improve_mesh_inplace(MutableTriangleTopology &mesh,
                           Field<Vector<real,3>, VertexId> const &pos,
-                          ImproveOptions const &o) {
+                          ImproveOptions const &o,
+                          ImproveStats *stats) {
   auto Q = [](Triangle<Vector<real,3>> const &t) { return t.quality(); };
   auto EL = [](VertexId, VertexId) { return false; };
   auto VL = [](VertexId) { return false; };
 
-  return improve_mesh_inplace(mesh, pos, o, EL, VL, Q);
+  return improve_mesh_inplace(mesh, pos, o, EL, VL, Q, stats);
 }
 
 // positions are assumed to be at default location
-Ref<MutableTriangleTopology> improve_mesh(MutableTriangleTopology const &mesh, real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot, int max_iter, real min_relevant_area, real min_quality_improvement) {
+Ref<MutableTriangleTopology> improve_mesh(MutableTriangleTopology const &mesh, real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot, int max_iter, real min_relevant_area, real min_quality_improvement, bool parallel) {
   FieldId<Vector<real,3>,VertexId> posid(vertex_position_id);
   Ref<MutableTriangleTopology> copy = mesh.copy();
-  improve_mesh_inplace(copy, copy->field(posid), ImproveOptions(min_quality, max_distance, max_silhouette_distance, min_normal_dot, max_iter, min_relevant_area, min_quality_improvement));
+  ImproveStats stats;
+  improve_mesh_inplace(copy, copy->field(posid), ImproveOptions(min_quality, max_distance, max_silhouette_distance, min_normal_dot, max_iter, min_relevant_area, min_quality_improvement, parallel), &stats);
+  Log::cout << format("improve_mesh: %d flips, %d collapses, %d moves, %d checks in %d batches, %g s, %g operations/s",
+                      stats.flips, stats.collapses, stats.moves, stats.checks, stats.batches, stats.time,
+                      stats.operations_per_second()) << std::endl;
   return copy;
 }
 
@@ -4,12 +4,14 @@
 #include <geode/mesh/quadric.h>
 #include <geode/math/lerp.h>
 #include <geode/solver/brent.h>
+#include <geode/utility/time.h>
+#include <vector>
 
 namespace geode {
 
 struct ImproveOptions {
 
-  ImproveOptions(real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot = .8, real max_iter = 30, real min_relevant_area = 1e-12, real min_quality_improvement = 1e-6)
+  ImproveOptions(real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot = .8, real max_iter = 30, real min_relevant_area = 1e-12, real min_quality_improvement = 1e-6, bool parallel = false)
   : min_quality(min_quality)
   , max_distance(max_distance)
   , max_silhouette_distance(max_silhouette_distance)
@@ -17,6 +19,7 @@ struct ImproveOptions {
   , max_iter(max_iter)
   , min_relevant_area(min_relevant_area)
   , min_quality_improvement(min_quality_improvement)
+  , parallel(parallel)
   {}
 
   real min_quality;
@@ -26,6 +29,30 @@ struct ImproveOptions {
   int max_iter;
   real min_relevant_area;
   real min_quality_improvement;
+
+  // Evaluate candidate operations for independent faces on multiple threads.  Faces are independent if the
+  // vertices within two edges of them are disjoint, since an operation reads at most that region and writes at most
+  // its inner one ring.  Quality, EdgeLocked and VertexLocked must then be safe to call concurrently.
+  bool parallel;
+};
+
+// Counts of the work done by improve_mesh_inplace
+struct ImproveStats {
+  int flips, collapses, moves; // Operations performed
+  int checks; // Candidate operations evaluated
+  int batches; // Rounds of independent faces (one per face if not parallel)
+  double time; // Wall clock seconds
+
+  ImproveStats()
+    : flips(0), collapses(0), moves(0), checks(0), batches(0), time(0) {}
+
+  int operations() const {
+    return flips+collapses+moves;
+  }
+
+  double operations_per_second() const {
+    return time ? operations()/time : 0;
+  }
 };
 
 Quadric compute_silhouette_quadric(TriangleTopology const &mesh, Field<Vector<real,3>, VertexId> const &pos, VertexId v, real min_relevant_area) {
@@ -172,6 +199,22 @@ inline real mesh_quality(MutableTriangleTopology const &mesh) {
 // For boundary edges, we apply the same criterion to implicitly defined planes perpendicular to
 // the incident face.
 
+// The best operation found for one face.  The arrays are scratch space that keeps its capacity, so once warmed up
+// evaluating candidates does not allocate.
+struct ImproveCandidate {
+  FaceId face;
+  real cost;
+  HalfedgeId flip_edge, collapse_edge;
+  VertexId move_vertex;
+  Vector<real,3> move_to;
+  int checks;
+  Array<Tuple<FaceId,real>> changed; // Faces changed by the best operation, and their new qualities
+  Array<Tuple<FaceId,real>> trial; // Same for the operation being checked
+  Array<FaceId> faces; // Used by check_move
+  Array<real> areas;
+  Array<Vector<real,3>> normals;
+};
+
 template<class Quality, class EdgeLocked, class VertexLocked>
 struct Allowed {
   MutableTriangleTopology const &mesh;
@@ -235,20 +278,21 @@ struct Allowed {
   // - finite costs for operations are the maximum normal and quadric cost of any changed
   //   vertex/face
   // - cannot violate locked edges/vertices
-  // These functions return a tuple with
-  // - a cost (if this cost is infinity, the other return fields may be empty)
-  // - an array of (face ID, new_quality) tuples of all faces that will be changed
-  //   by this operation, and their qualities after the operation (all vertices
-  //   incident to any of these faces should have their quadrics recomputed)
+  // These functions return a cost, and fill changed with (face ID, new_quality) tuples
+  // of all faces that will be changed by this operation, and their qualities after the
+  // operation (all vertices incident to any of these faces should have their quadrics
+  // recomputed).  changed is cleared first, and may be incomplete if the cost is infinite.
   // The cost is +inf if the operation is not allowed, and a finite cost otherwise.
+  // None of them modify anything but their arguments, so they may run concurrently.
 
-  Tuple<real,Array<Tuple<FaceId,real>>> check_flip(HalfedgeId h) {
+  real check_flip(HalfedgeId h, Array<Tuple<FaceId,real>> &changed) {
+    changed.clear();
 
     if (EL(mesh.src(h), mesh.dst(h)))
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
 
     if (!mesh.is_flip_safe(h))
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
 
     // old faces
     HalfedgeId r = mesh.reverse(h);
@@ -267,7 +311,7 @@ struct Allowed {
 
     if (o.min_quality_improvement+min(old_q1, old_q2) >= min(new_q1, new_q2)) {
       //GEODE_DEBUG_ONLY(std::cout << "    illegal flip for " << mesh.src(h) << " - " << mesh.dst(h) << ", q " << min(old_q1, old_q2) << " -> " << min(new_q1, new_q2) << ", improvement " << min(new_q1, new_q2)-min(old_q1, old_q2) << std::endl);
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
     }
 
     real old_a1 = old_t1.area();
@@ -292,16 +336,16 @@ struct Allowed {
     if (old_a2 > o.min_relevant_area && new_a2 > o.min_relevant_area)
       min_dot = min(min_dot, dot(old_n2, new_n2));
 
-    Array<Tuple<FaceId,real>> changed;
     changed.append(tuple(f1, new_q1));
     changed.append(tuple(f2, new_q2));
 
     GEODE_DEBUG_ONLY(std::cout << "    checking flip for " << mesh.src(h) << " - " << mesh.dst(h) << ", dot: " << min_dot << " (areas " << old_a1 << ", " << old_a2 << " -> " << new_a1 << ", " << new_a2 << "), q " << min(old_q1, old_q2) << " -> " << min(new_q1, new_q2) << ", improvement " << min(new_q1, new_q2)-min(old_q1, old_q2) << std::endl);
 
-    return tuple(normal_cost(min_dot)+area_cost(old_a1+old_a2, new_a1+new_a2), changed);
+    return normal_cost(min_dot)+area_cost(old_a1+old_a2, new_a1+new_a2);
   }
 
-  Tuple<real,Array<Tuple<FaceId,real>>> check_collapse(HalfedgeId h) {
+  real check_collapse(HalfedgeId h, Array<Tuple<FaceId,real>> &new_faces) {
+    new_faces.clear();
     VertexId v0 = mesh.src(h);
     VertexId v1 = mesh.dst(h);
 
@@ -311,36 +355,38 @@ struct Allowed {
     }
 
     if (edge_locked || VL(v0))
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
 
     if (!mesh.is_collapse_safe(h))
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
 
     // compute quadric cost
     real quadric_cost = this->quadric_cost(quadrics[v0](pos[v1]));
     if (quadric_cost == numeric_limits<real>::infinity()) {
       //GEODE_DEBUG_ONLY(std::cout << "    illegal collapse " << mesh.src(h) << " -> " << mesh.dst(h) << ", bad quadric: " << quadrics[v0](pos[v1]) << std::endl);
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
     }
 
     // compute silhouette cost
     real silhouette_cost = this->silhouette_cost(silhouette_quadrics[v0](pos[v1]));
     if (silhouette_cost == numeric_limits<real>::infinity()) {
       //GEODE_DEBUG_ONLY(std::cout << "    illegal collapse " << mesh.src(h) << " -> " << mesh.dst(h) << ", bad silhouette quadric: " << silhouette_quadrics[v0](pos[v1]) << std::endl);
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+      return numeric_limits<real>::infinity();
     }
 
     // compute minimum quality before
     real minq_before = 1;
-    for (auto f : mesh.incident_faces(v0)) {
-      minq_before = min(minq_before, quality[f]);
+    for (auto e : mesh.outgoing(v0)) {
+      FaceId f = mesh.face(e);
+      if (f.valid())
+        minq_before = min(minq_before, quality[f]);
     }
 
-    Array<Tuple<FaceId,real>> new_faces;
     real max_normal_cost = 0;
     real old_area = 0, new_area = 0;
-    for (auto f : mesh.incident_faces(v0)) {
-      if (mesh.vertices(f).contains(v1))
+    for (auto e : mesh.outgoing(v0)) {
+      FaceId f = mesh.face(e);
+      if (!f.valid() || mesh.vertices(f).contains(v1))
         continue;
 
       // get current normal
@@ -364,7 +410,7 @@ struct Allowed {
       // compute whether quality allows this operation
       if (new_q < minq_before && minq_before > o.min_quality_improvement) { // if both are terrible, removing the triangle is better than not removing it
         //GEODE_DEBUG_ONLY(std::cout << "    illegal collapse " << mesh.src(h) << " -> " << mesh.dst(h) << ", quadric: " << quadrics[v0](pos[v1]) << ", quality decreases by at least " << - new_q + minq_before << " (from " << minq_before << " > " << o.min_quality_improvement << ")" << std::endl);
-        return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+        return numeric_limits<real>::infinity();
       }
 
       // compute normal cost
@@ -375,7 +421,7 @@ struct Allowed {
 
         if (max_normal_cost == numeric_limits<real>::infinity()) {
           //GEODE_DEBUG_ONLY(std::cout << "    illegal collapse " << mesh.src(h) << " -> " << mesh.dst(h) << ", quadric: " << quadrics[v0](pos[v1]) << ", bad normal dot " << dot(old_n, new_n) << ", areas " << old_a << ", " << new_a << std::endl);
-          return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>());
+          return numeric_limits<real>::infinity();
         }
       }
 
@@ -385,18 +431,20 @@ struct Allowed {
 
     GEODE_DEBUG_ONLY(std::cout << "    checking collapse " << mesh.src(h) << " -> " << mesh.dst(h) << ", quadric: " << quadrics[v0](pos[v1]) << ", silhouette quadric: " << silhouette_quadrics[v0](pos[v1]) << ", normal_cost " << max_normal_cost << ", area cost " << area_cost(old_area, new_area) << " (" << old_area << " -> " << new_area << ")" << std::endl);
 
-    return tuple(silhouette_cost + quadric_cost + max_normal_cost + area_cost(old_area, new_area), new_faces);
+    return silhouette_cost + quadric_cost + max_normal_cost + area_cost(old_area, new_area);
   }
 
-  // this function additionally returns the optimal (while still allowed) position to move to
-  Tuple<real,Array<Tuple<FaceId,real>>, Vector<real,3>> check_move(VertexId v) {
+  // this function additionally returns the optimal (while still allowed) position to move to,
+  // and uses the faces, areas and normals of c as scratch space
+  Tuple<real,Vector<real,3>> check_move(VertexId v, Array<Tuple<FaceId,real>> &new_faces, ImproveCandidate &c) {
+    new_faces.clear();
     bool edge_locked = false;
     for (auto h : mesh.outgoing(v)) {
       edge_locked = edge_locked || EL(mesh.src(h), mesh.dst(h)) || EL(mesh.dst(h), mesh.src(h));
     }
 
     if (edge_locked || VL(v))
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>(), Vector<real,3>());
+      return tuple(numeric_limits<real>::infinity(), Vector<real,3>());
 
     // TODO: we should actually put a proper optimization here: optimize the minimum
     // incident triangle quality, subject quadric constraints on the vertex and
@@ -407,17 +455,25 @@ struct Allowed {
     // brent to optimize only along that line
     int nvertices = 0;
     Vector<real,3> target;
-    for (auto v2 : mesh.vertex_one_ring(v)) {
-      target += pos[v2];
+    for (auto h : mesh.outgoing(v)) {
+      target += pos[mesh.dst(h)];
       nvertices++;
     }
     target /= nvertices;
     target = target.projected_orthogonal_to_unit_direction(mesh.normal(pos, v));
 
-    auto faces = mesh.incident_faces(v);
+    auto &faces = c.faces;
+    auto &areas = c.areas;
+    auto &normals = c.normals;
+    faces.clear();
+    areas.clear();
+    normals.clear();
+    for (auto h : mesh.outgoing(v)) {
+      FaceId f = mesh.face(h);
+      if (f.valid())
+        faces.append(f);
+    }
     real before_min_q = 1;
-    Array<real> areas;
-    Array<Vector<real,3>> normals;
     for (auto f : faces) {
       before_min_q = min(before_min_q, quality[f]);
       auto t = mesh.triangle(pos,f);
@@ -471,10 +527,9 @@ struct Allowed {
 
     if (qafter < before_min_q+o.min_quality_improvement) { // illegal or no (tangible) improvement?
       //GEODE_DEBUG_ONLY(std::cout << "    illegal move: p-x " << p-pos[v] << ", q " << before_min_q << " -> " << qafter << ", improvement " << qafter-before_min_q << std::endl);
-      return tuple(numeric_limits<real>::infinity(), Array<Tuple<FaceId,real>>(), Vector<real,3>());
+      return tuple(numeric_limits<real>::infinity(), Vector<real,3>());
     }
 
-    Array<Tuple<FaceId,real>> new_faces;
     real min_dot = 1;
     real old_area = 0, new_area = 0;
     GEODE_DEBUG_ONLY(real minq = 1);
@@ -507,16 +562,81 @@ struct Allowed {
     GEODE_DEBUG_ONLY(GEODE_ASSERT(fabs(minq - qafter) < 1e-12));
     GEODE_DEBUG_ONLY(std::cout << "    checking move: p-x " << p-pos[v] << ", cost " << quadric_cost(quadrics[v](p)) + silhouette_cost(silhouette_quadrics[v](p)) + normal_cost(min_dot) + area_cost(old_area, new_area) << ", q " << before_min_q << " -> " << minq << ", improvement " << minq-before_min_q << std::endl);
 
-    return tuple(quadric_cost(quadrics[v](p)) + silhouette_cost(silhouette_quadrics[v](p)) + normal_cost(min_dot) + area_cost(old_area, new_area), new_faces, p);
+    return tuple(quadric_cost(quadrics[v](p)) + silhouette_cost(silhouette_quadrics[v](p)) + normal_cost(min_dot) + area_cost(old_area, new_area), p);
+  }
+
+  // find best operation to perform on this triangle we can:
+  //   - flip an edge
+  //   - collapse an edge (any halfedge outgoing from any triangle vertex)
+  //   - move a vertex
+  // prioritize the operation which
+  //   - improves the quality of the mesh the most (enough)
+  //   - has the lowest impact on normals and quadrics
+  //   - changes the fewest triangles
+  // Priority:
+  //   - if there are any operations with finite cost that improve our triangle
+  //     above min_quality without pulling any other triangle below, only consider those
+  //   - if there are any operations with finite cost that improve our triangle
+  //     above min_quality without worsening other triangles, only consider those
+  //   - from the leftover operations, pick the one with lowest cost
+  void best_operation(FaceId f, ImproveCandidate &c) {
+    c.face = f;
+    c.cost = numeric_limits<real>::infinity();
+    c.flip_edge = c.collapse_edge = HalfedgeId();
+    c.move_vertex = VertexId();
+    c.checks = 0;
+    c.changed.clear();
+
+    // check flips
+    for (auto he : mesh.halfedges(f)) {
+      c.checks++;
+      real cost = check_flip(he, c.trial);
+      if (cost < c.cost) {
+        c.cost = cost;
+        c.flip_edge = he;
+        c.changed.swap(c.trial);
+      }
+    }
+
+    // check collapses
+    for (auto v : mesh.vertices(f)) {
+      for (auto he : mesh.outgoing(v)) {
+        c.checks++;
+        real cost = check_collapse(he, c.trial);
+        if (cost < c.cost) {
+          c.flip_edge = HalfedgeId();
+          c.cost = cost;
+          c.collapse_edge = he;
+          c.changed.swap(c.trial);
+        }
+      }
+    }
+
+    // check vertex moves only if nothing else works (they're expensive)
+    if (!c.flip_edge.valid() && !c.collapse_edge.valid()) {
+      for (auto v : mesh.vertices(f)) {
+        c.checks++;
+        auto r = check_move(v, c.trial, c);
+        if (r.x < c.cost) {
+          c.collapse_edge = c.flip_edge = HalfedgeId();
+          c.cost = r.x;
+          c.move_vertex = v;
+          c.move_to = r.y;
+          c.changed.swap(c.trial);
+        }
+      }
+    }
   }
 };
 
 template<class Quality, class EdgeLocked, class VertexLocked>
 bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, VertexId> const &pos,
                           ImproveOptions const &o,
-                          EdgeLocked &EL, VertexLocked &VL, Quality &Q) {
+                          EdgeLocked &EL, VertexLocked &VL, Quality &Q,
+                          ImproveStats *stats = 0) {
 
   GEODE_DEBUG_ONLY(std::cout.precision(18));
+  const double start_time = get_time();
 
   // cache face qualities
   Field<real,FaceId> quality = mesh.create_compatible_face_field<real>();
@@ -540,6 +660,17 @@ bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, V
 
   Allowed<Quality, EdgeLocked, VertexLocked> allowed(mesh, pos, quality, quadrics, silhouette_quadrics, Q, EL, VL, o);
 
+  // Buffers reused across batches and iterations.  claimed and updated hold the stamp of the
+  // last batch that claimed a vertex's neighborhood or recomputed its quadrics.
+  ImproveStats local_stats;
+  ImproveStats &st = stats ? *stats : local_stats;
+  std::vector<ImproveCandidate> candidates;
+  Array<FaceId> pending, deferred, batch;
+  Array<VertexId> update_vertices;
+  Field<int,VertexId> claimed = mesh.create_compatible_vertex_field<int>(),
+                      updated = mesh.create_compatible_vertex_field<int>();
+  int stamp = 0;
+
   bool improved_something = !needs_improvement.empty();
   int iter = 0;
   while (improved_something && iter < o.max_iter) {
@@ -548,144 +679,143 @@ bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, V
 
     improved_something = false;
     Hashtable<FaceId> still_needs_improvement;
-
-    for (auto f : needs_improvement) {
-      // check if this face has been deleted by another operation
-      if (mesh.erased(f))
-        continue;
-
-      // check if the quality has been changed by another operation, and if it's
-      // still in need of improvement
-      real q = quality[f];
-      if (q >= o.min_quality)
-        continue;
-
-      // find best operation to perform on this triangle we can:
-      //   - flip an edge
-      //   - collapse an edge (any halfedge outgoing from any triangle vertex)
-      //   - move a vertex
-      // prioritize the operation which
-      //   - improves the quality of the mesh the most (enough)
-      //   - has the lowest impact on normals and quadrics
-      //   - changes the fewest triangles
-      // Priority:
-      //   - if there are any operations with finite cost that improve our triangle
-      //     above min_quality without pulling any other triangle below, only consider those
-      //   - if there are any operations with finite cost that improve our triangle
-      //     above min_quality without worsening other triangles, only consider those
-      //   - from the leftover operations, pick the one with lowest cost
-
-      Array<Tuple<FaceId,real>> changed_faces;
-      real best_cost = numeric_limits<real>::infinity();
-
-      GEODE_DEBUG_ONLY(std::cout << "  face " << f << " quality " << q << std::endl);
-
-      // check flips
-      HalfedgeId flip_edge;
-      for (auto he : mesh.halfedges(f)) {
-        auto r = allowed.check_flip(he);
-        if (r.x < best_cost) {
-          best_cost = r.x;
-          flip_edge = he;
-          changed_faces = r.y;
+    pending.clear();
+    for (auto f : needs_improvement)
+      pending.append(f);
+
+    int next = 0;
+    while (next < pending.size()) {
+      // choose a batch of faces whose neighborhoods are disjoint.  Serially, this is
+      // just the next face.
+      stamp++;
+      batch.clear();
+      deferred.clear();
+      for (; next < pending.size(); next++) {
+        FaceId f = pending[next];
+
+        // check if this face has been deleted by another operation, or if the quality has
+        // been changed by another operation and it's no longer in need of improvement
+        if (mesh.erased(f) || quality[f] >= o.min_quality)
+          continue;
+
+        if (!o.parallel) {
+          batch.append(f);
+          next++;
+          break;
         }
-      }
 
-      // check collapses
-      HalfedgeId collapse_edge;
-      for (auto v : mesh.vertices(f)) {
-        for (auto he : mesh.outgoing(v)) {
-          auto r = allowed.check_collapse(he);
-          if (r.x < best_cost) {
-            flip_edge = HalfedgeId();
-            best_cost = r.x;
-            collapse_edge = he;
-            changed_faces = r.y;
-          }
+        bool free = true;
+        for (auto v : mesh.vertices(f))
+          for (auto h : mesh.outgoing(v))
+            for (auto h2 : mesh.outgoing(mesh.dst(h)))
+              free = free && claimed[mesh.dst(h2)] != stamp;
+        if (!free) {
+          deferred.append(f);
+          continue;
         }
+        for (auto v : mesh.vertices(f))
+          for (auto h : mesh.outgoing(v))
+            for (auto h2 : mesh.outgoing(mesh.dst(h)))
+              claimed[mesh.dst(h2)] = stamp;
+        batch.append(f);
       }
-
-      // check vertex moves only if nothing else works (they're expensive)
-      VertexId move_vertex;
-      Vector<real,3> move_to;
-      if (!flip_edge.valid() && !collapse_edge.valid()) {
-        for (auto v : mesh.vertices(f)) {
-          auto r = allowed.check_move(v);
-          if (r.x < best_cost) {
-            collapse_edge = flip_edge = HalfedgeId();
-            best_cost = r.x;
-            move_vertex = v;
-            move_to = r.z;
-            changed_faces = r.y;
-          }
-        }
+      if (o.parallel) {
+        // retry the faces that conflicted with this batch once it has been applied
+        pending.swap(deferred);
+        next = 0;
       }
+      if (!batch.size())
+        continue;
+      st.batches++;
+
+      // evaluate candidates against the unchanged mesh
+      if (candidates.size() < size_t(batch.size()))
+        candidates.resize(batch.size());
+      #pragma omp parallel for if(o.parallel)
+      for (int i = 0; i < batch.size(); i++)
+        allowed.best_operation(batch[i], candidates[i]);
+
+      // apply operations one at a time, since topology changes aren't thread safe
+      update_vertices.clear();
+      for (int i = 0; i < batch.size(); i++) {
+        const ImproveCandidate &c = candidates[i];
+        FaceId f = c.face;
+        st.checks += c.checks;
+
+        GEODE_DEBUG_ONLY(std::cout << "  face " << f << " quality " << quality[f] << std::endl);
+        GEODE_DEBUG_ONLY(real minq_before = 1);
+
+        // do it and update qualities and quadrics
+        if (c.flip_edge.valid()) {
+          GEODE_DEBUG_ONLY(
+            for (auto bf: mesh.faces(c.flip_edge)) {
+              minq_before = min(minq_before, quality[bf]);
+            }
+            std::cout << "    flip " << c.flip_edge << ", cost " << c.cost << std::endl;
+          )
+
+          const auto flipped GEODE_UNUSED = mesh.flip_edge(c.flip_edge);
+          st.flips++;
+        } else if (c.collapse_edge.valid()) {
+          GEODE_DEBUG_ONLY(
+            for (auto bf: mesh.incident_faces(mesh.src(c.collapse_edge))) {
+              minq_before = min(minq_before, quality[bf]);
+            }
+            std::cout << "    collapse " << c.collapse_edge << ": " << mesh.src(c.collapse_edge) << " -> " << mesh.dst(c.collapse_edge) << ", cost " << c.cost << std::endl;
+          )
+
+          mesh.collapse(c.collapse_edge);
+          st.collapses++;
+        } else if (c.move_vertex.valid()) {
+          GEODE_DEBUG_ONLY(
+            for (auto bf: mesh.incident_faces(c.move_vertex)) {
+              minq_before = min(minq_before, quality[bf]);
+            }
+            std::cout << "    move " << c.move_vertex << ", cost " << c.cost << std::endl;
+          )
+
+          pos[c.move_vertex] = c.move_to;
+          st.moves++;
+        } else {
+          // can't remove this triangle, it's still there!
+          still_needs_improvement.set(f);
+          continue;
+        }
 
-      GEODE_DEBUG_ONLY(real minq_before = 1);
-
-      // do it and update qualities and quadrics
-      if (flip_edge.valid()) {
         GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.faces(flip_edge)) {
-            minq_before = min(minq_before, quality[bf]);
+          real minq_after = 1;
+          for (auto nf: c.changed) {
+            minq_after = min(minq_after, nf.y);
           }
-          std::cout << "    flip " << flip_edge << ", cost " << best_cost << std::endl;
+          std::cout << "    min quality " << minq_before << " -> " << minq_after << ", improvement " << minq_after - minq_before << std::endl;
         )
 
-        flip_edge = mesh.flip_edge(flip_edge);
-      } else if (collapse_edge.valid()) {
-        GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.incident_faces(mesh.src(collapse_edge))) {
-            minq_before = min(minq_before, quality[bf]);
-          }
-          std::cout << "    collapse " << collapse_edge << ": " << mesh.src(collapse_edge) << " -> " << mesh.dst(collapse_edge) << ", cost " << best_cost << std::endl;
-        )
+        for (auto nf : c.changed) {
+          // update quality
+          quality[nf.x] = nf.y;
 
-        mesh.collapse(collapse_edge);
-      } else if (move_vertex.valid()) {
-        GEODE_DEBUG_ONLY(
-          for (auto bf: mesh.incident_faces(move_vertex)) {
-            minq_before = min(minq_before, quality[bf]);
+          // remember vertices to update quadrics for
+          for (auto v : mesh.vertices(nf.x)) {
+            if (updated[v] != stamp) {
+              updated[v] = stamp;
+              update_vertices.append(v);
+            }
           }
-          std::cout << "    move " << move_vertex << ", cost " << best_cost << std::endl;
-        )
 
-        pos[move_vertex] = move_to;
-      } else {
-        // can't remove this triangle, it's still there!
-        still_needs_improvement.set(f);
-        continue;
-      }
-
-      GEODE_DEBUG_ONLY(
-        real minq_after = 1;
-        for (auto nf: changed_faces) {
-          minq_after = min(minq_after, nf.y);
+          if (nf.y < o.min_quality)
+            still_needs_improvement.set(nf.x);
         }
-        std::cout << "    min quality " << minq_before << " -> " << minq_after << ", improvement " << minq_after - minq_before << std::endl;
-      )
 
-      Hashtable<VertexId> update_vertices;
-      for (auto nf : changed_faces) {
-        // update quality
-        quality[nf.x] = nf.y;
-
-        // remember vertices to update quadrics for
-        for (auto v : mesh.vertices(nf.x)) {
-          update_vertices.set(v);
-        }
-
-        if (nf.y < o.min_quality)
-          still_needs_improvement.set(nf.x);
+        improved_something = true;
       }
 
       // update quadrics on update_vertices
-      for (auto uv : update_vertices) {
+      #pragma omp parallel for if(o.parallel)
+      for (int i = 0; i < update_vertices.size(); i++) {
+        VertexId uv = update_vertices[i];
         quadrics[uv] = compute_quadric(mesh, pos, uv);
         silhouette_quadrics[uv] = compute_silhouette_quadric(mesh, pos, uv, o.min_relevant_area);
       }
-
-      improved_something = true;
     }
 
     GEODE_DEBUG_ONLY(real quality_after = mesh_quality(mesh, pos, Q));
@@ -695,6 +825,7 @@ bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, V
     iter++;
   }
 
+  st.time += get_time()-start_time;
   return mesh_quality(mesh, pos, Q) >= o.min_quality;
 }
 
@@ -719,9 +850,11 @@ bool improve_mesh_inplace(MutableTriangleTopology &mesh, Field<Vector<real,3>, V
 
 bool improve_mesh_inplace(MutableTriangleTopology &mesh,
                           Field<Vector<real,3>, VertexId> const &pos,
-                          ImproveOptions const &o);
+                          ImproveOptions const &o,
+                          ImproveStats *stats = 0);
 
 // positions are assumed to be in the default location and of the correct type.
-Ref<MutableTriangleTopology> improve_mesh(MutableTriangleTopology const &mesh, real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot = .8, int max_iter = 20, real min_relevant_area = 1e-12, real min_quality_improvement = 1e-6);
+// Logs the number of operations performed and operations per second.
+Ref<MutableTriangleTopology> improve_mesh(MutableTriangleTopology const &mesh, real min_quality, real max_distance, real max_silhouette_distance, real min_normal_dot = .8, int max_iter = 20, real min_relevant_area = 1e-12, real min_quality_improvement = 1e-6, bool parallel = false);
 
 }
@@ -5,10 +5,16 @@
 #include <geode/array/view.h>
 #include <geode/geometry/Triangle3d.h>
 #include <geode/python/cast.h>
+#include <geode/python/ExceptionValue.h>
+#include <geode/python/Class.h>
 #include <geode/python/wrap.h>
+#include <geode/utility/const_cast.h>
 #include <geode/utility/endian.h>
 #include <geode/utility/function.h>
+#include <geode/utility/Log.h>
+#include <geode/utility/MappedFile.h>
 #include <geode/utility/path.h>
+#include <algorithm>
 #include <errno.h>
 namespace geode {
 
@@ -30,6 +36,13 @@ struct File {
         strerror(errno)));
   }
 
+  // Open an anonymous temporary file, deleted when closed
+  File()
+    : f(tmpfile()) {
+    if (!f)
+      throw IOError(format("can't open temporary file: %s",strerror(errno)));
+  }
+
   File(const File&) = delete;
   void operator=(const File&) = delete;
 
@@ -71,11 +84,70 @@ struct StlTri {
 };
 static_assert(sizeof(StlTri)==12*4+2,"");
 
-// See http://en.wikipedia.org/wiki/STL_file for details
-static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
-  if (is_binary(filename)) {
-    File f(filename,"rb");
+GEODE_DEFINE_TYPE(MeshReader)
+GEODE_DEFINE_TYPE(MeshWriter)
+
+MeshReader::MeshReader(const string& filename, const int batch_size)
+  : filename(filename)
+  , batch_size(batch_size)
+  , vertices_(0) {
+  if (batch_size < 1)
+    throw ValueError(format("MeshReader: expected positive batch size, got %d",batch_size));
+}
+
+MeshReader::~MeshReader() {}
+
+bool MeshReader::read(MeshBatch& batch) {
+  batch.vertex_offset = vertices_;
+  batch.X.clear();
+  batch.tris.clear();
+  fill(batch);
+  vertices_ += batch.X.size();
+  return batch.X.size() || batch.tris.size();
+}
+
+Tuple<Array<TV>,Array<Vector<int,3>>> MeshReader::read_py() {
+  MeshBatch batch;
+  read(batch);
+  return tuple(batch.X,batch.tris);
+}
+
+namespace {
+// Welds vertices for formats which store positions per triangle.  Positions are merged if they are identical,
+// or if weld > 0, if they round to the same point of a grid with spacing weld.  Nearby positions on opposite
+// sides of a grid cell boundary are not merged.
+struct Welder {
+  const real weld;
+  Hashtable<Vector<double,3>,int> ids;
+
+  Welder(const real weld)
+    : weld(weld) {}
+
+  int operator()(const TV x, MeshBatch& batch) {
+    const auto key = weld ? Vector<double,3>(rint(x.x/weld),rint(x.y/weld),rint(x.z/weld))
+                          : Vector<double,3>(x);
+    const int next = batch.vertex_offset+batch.X.size();
+    const int i = ids.get_or_insert(key,next);
+    if (i == next) {
+      if (next==numeric_limits<int>::max())
+        throw IOError("stl file has too many vertices, our limit is 2^31-1");
+      batch.X.append(x);
+    }
+    return i;
+  }
+};
 
+struct StlBinaryReader : public MeshReader {
+  GEODE_NEW_FRIEND
+  File f;
+  Welder weld;
+  uint32_t remaining;
+  Array<StlTri> data;
+protected:
+  StlBinaryReader(const string& filename, const int batch_size, const real weld)
+    : MeshReader(filename,batch_size)
+    , f(filename,"rb")
+    , weld(weld) {
     // Skip header
     char header[80];
     const auto nh = fread(header,1,sizeof(header),f);
@@ -90,110 +162,135 @@ static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
       throw IOError(format("invalid binary stl '%s': failed to read count",filename));
     if (count > (1u<<31)/3-1)
       throw IOError(format("binary stl has too many triangles: %u > 2^31/3-1",count));
+    remaining = count;
+  }
 
-    // Read triangles
-    Array<StlTri> data(count,uninit);
-    const auto nt = fread(data.data(),sizeof(StlTri),count,f);
-    if (nt < count)
+  void fill(MeshBatch& batch) {
+    // Each triangle adds at most three vertices
+    const int n = int(min(remaining,uint32_t(max(1,batch_size/4))));
+    data.resize(n,uninit);
+    const auto nt = fread(data.data(),sizeof(StlTri),n,f);
+    if (nt < size_t(n))
       throw IOError(format("invalid binary stl '%s': failed to read triangles",filename));
-
-    // Deduplicate
-    Hashtable<Vector<float,3>,int> id;
-    Array<Vector<int,3>> tris;
-    Array<TV> X;
-    for (auto& t : data) {
+    remaining -= n;
+    batch.tris.preallocate(n);
+    for (const auto& t : data) {
       StlTriData d;
       memcpy(&d,t.d,sizeof(d));
       Vector<int,3> tri;
-      for (int a=0;a<3;a++) {
-        const int i = id.get_or_insert(d.x[a],X.size());
-        if (i == X.size())
-          X.append(TV(d.x[a]));
-        tri[a] = i;
-      }
-      tris.append(tri);
+      for (int a=0;a<3;a++)
+        tri[a] = weld(TV(d.x[a]),batch);
+      batch.tris.append_assuming_enough_space(tri);
     }
-    return tuple(new_<TriangleSoup>(tris,X.size()),X);
-  } else { // ASCII
-    File f(filename,"r");
-
-    // Prepare for deduplication
-    Hashtable<Vector<double,3>,int> id;
-    Array<Vector<int,3>> tris;
-    Array<TV> X;
+  }
+};
 
-    // Read
-    int ns = 0, nl = 0;
-    char line[1024];
+struct StlAsciiReader : public MeshReader {
+  GEODE_NEW_FRIEND
+  File f;
+  Welder weld;
+  bool inside; // Are we inside a solid?
+  int ns, nl, nt;
+  char line[1024];
+protected:
+  StlAsciiReader(const string& filename, const int batch_size, const real weld)
+    : MeshReader(filename,batch_size)
+    , f(filename,"r")
+    , weld(weld)
+    , inside(false)
+    , ns(0)
+    , nl(0)
+    , nt(0) {}
+
+  // Read the next facet, returning false at the end of the file
+  bool facet(Vector<TV,3>& x) {
     for (;;) {
       nl++;
       if (!fgets(line,sizeof(line),f)) {
+        if (inside)
+          throw IOError(format("invalid ascii stl %s:%d: file ended inside solid",filename,nl));
         if (!ns)
           throw IOError(format("invalid ascii stl %s: no solids found",filename));
-        break;
+        return false;
       }
-      {
-        const char* p = skip_white(line);
-        if (!*p) continue;
+      const char* p = skip_white(line);
+      if (!*p) continue;
+      if (!inside) {
         if (strncmp(p,"solid ",6))
           throw IOError(format("invalid ascii stl %s:%d: expected 'solid ', got: %s",filename,nl,repr(p)));
+        inside = true;
+        continue;
       }
-      for (;;) {
+      if (!strncmp(p,"endsolid",8)) {
+        inside = false;
+        ns++;
+        continue;
+      }
+      if (strncmp(p,"facet normal ",13))
+        throw IOError(format("invalid ascii stl %s:%d: expected 'endsolid' or 'facet normal ', got: %s",
+          filename,nl,repr(p)));
+      static const int len[6] = {10,7,7,7,7,8};
+      static const char* expect[6] = {"outer loop","vertex ","vertex ","vertex ","endloop","endfacet"};
+      for (int a=0;a<6;a++) {
         nl++;
         if (!fgets(line,sizeof(line),f))
-          throw IOError(format("invalid ascii stl %s:%d: file ended inside solid",filename,nl));
-        {
-          const char* p = skip_white(line);
-          if (!*p) continue;
-          if (!strncmp(p,"endsolid",8))
-            break;
-          if (strncmp(p,"facet normal ",13))
-            throw IOError(format("invalid ascii stl %s:%d: expected 'endsolid' or 'facet normal ', got: %s",
-              filename,nl,repr(p)));
-        }
-        static const int len[6] = {10,7,7,7,7,8};
-        static const char* expect[6] = {"outer loop","vertex ","vertex ","vertex ","endloop","endfacet"};
-        Vector<int,3> tri;
-        for (int a=0;a<6;a++) {
-          nl++;
-          if (!fgets(line,sizeof(line),f))
-            throw IOError(format("invalid ascii stl %s:%d: file ended inside facet",filename,nl));
-          const char* p = skip_white(line);
-          if (!*p) { a--; continue; }
-          if (strncmp(p,expect[a],len[a]))
-            throw IOError(format("invalid ascii stl %s:%d: expected '%s', got: %s",filename,nl,expect[a],repr(p)));
-          if (1<=a && a<4) {
-            Vector<double,3> x;
-            if (sscanf(p+7,"%lg %lg %lg",&x.x,&x.y,&x.z) != 3)
-              throw IOError(format("invalid ascii stl %s:%d: invalid vertex line: %s",filename,nl,repr(p)));
-            const int i = id.get_or_insert(x,X.size());
-            if (i == X.size()) {
-              if (X.size()==numeric_limits<int>::max())
-                throw IOError(format("ascii stl %s has too many vertices, our limit is 2^31-1",filename));
-              X.append(x);
-            }
-            tri[a-1] = i;
-          }
+          throw IOError(format("invalid ascii stl %s:%d: file ended inside facet",filename,nl));
+        const char* p = skip_white(line);
+        if (!*p) { a--; continue; }
+        if (strncmp(p,expect[a],len[a]))
+          throw IOError(format("invalid ascii stl %s:%d: expected '%s', got: %s",filename,nl,expect[a],repr(p)));
+        if (1<=a && a<4) {
+          auto& y = x[a-1];
+          if (sscanf(p+7,"%lg %lg %lg",&y.x,&y.y,&y.z) != 3)
+            throw IOError(format("invalid ascii stl %s:%d: invalid vertex line: %s",filename,nl,repr(p)));
         }
-        if (tris.size()==numeric_limits<int>::max())
-          throw IOError(format("ascii stl %s has too many vertices, our limit is 2^31-1",filename));
-        tris.append(tri);
       }
-      ns++;
+      return true;
+    }
+  }
+
+  void fill(MeshBatch& batch) {
+    Vector<TV,3> x;
+    while (batch.X.size()+batch.tris.size() < batch_size && facet(x)) {
+      if (nt++==numeric_limits<int>::max())
+        throw IOError(format("ascii stl %s has too many triangles, our limit is 2^31-1",filename));
+      Vector<int,3> tri;
+      for (int a=0;a<3;a++)
+        tri[a] = weld(x[a],batch);
+      batch.tris.append(tri);
     }
-    return tuple(new_<TriangleSoup>(tris,X.size()),X);
   }
+};
 }
 
-static void write_stl(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
-  // We unconditionally write .stl files in binary.  Text formats for large data are silly.
-  File f(filename,"wb");
-  fprintf(f,"%-79s\n","Binary STL triangle mesh: http://en.wikipedia.org/wiki/STL_file");
-  const uint32_t count = tris.size();
-  fwrite(&count,sizeof(count),1,f);
+// Read everything left in a stream
+static Tuple<Ref<TriangleSoup>,Array<TV>> read_all(MeshReader& reader) {
+  Array<Vector<int,3>> tris;
+  Array<TV> X;
+  MeshBatch batch;
+  while (reader.read(batch)) {
+    X.extend(batch.X);
+    tris.extend(batch.tris);
+  }
+  return tuple(new_<TriangleSoup>(tris,X.size()),X);
+}
+
+// See http://en.wikipedia.org/wiki/STL_file for details
+static Ref<MeshReader> stl_reader(const string& filename, const int batch_size, const real weld) {
+  if (is_binary(filename))
+    return new_<StlBinaryReader>(filename,batch_size,weld);
+  else
+    return new_<StlAsciiReader>(filename,batch_size,weld);
+}
+
+static Tuple<Ref<TriangleSoup>,Array<TV>> read_stl(const string& filename) {
+  return read_all(*stl_reader(filename,numeric_limits<int>::max(),0));
+}
+
+template<class TX> static void write_stl_triangles(File& f, RawArray<const Vector<int,3>> tris, RawArray<TX> X) {
   for (const auto nodes : tris) {
     StlTriData d;
-    d.n = to_little_endian(Vector<float,3>(normal(X[nodes[0]],X[nodes[1]],X[nodes[2]])));
+    d.n = to_little_endian(Vector<float,3>(normal(TV(X[nodes[0]]),TV(X[nodes[1]]),TV(X[nodes[2]]))));
     for (int i=0;i<3;i++)
       d.x[i] = to_little_endian(Vector<float,3>(X[nodes[i]]));
     StlTri t;
@@ -203,6 +300,15 @@ static void write_stl(const string& filename, RawArray<const Vector<int,3>> tris
   }
 }
 
+static void write_stl(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
+  // We unconditionally write .stl files in binary.  Text formats for large data are silly.
+  File f(filename,"wb");
+  fprintf(f,"%-79s\n","Binary STL triangle mesh: http://en.wikipedia.org/wiki/STL_file");
+  const uint32_t count = tris.size();
+  fwrite(&count,sizeof(count),1,f);
+  write_stl_triangles(f,tris,X);
+}
+
 static const char* white = " \t\v\f\r\n";
 
 #ifdef _WIN32
@@ -211,92 +317,311 @@ static char* strtok_r(char* str, const char* delim, char** saveptr) {
 }
 #endif
 
-static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
-  File f(filename,"r");
+// Parse a double exactly as strtod does.  Short decimals take Clinger's fast path: a mantissa below 2^53 scaled by
+// a power of ten at most 10^22 involves only exact doubles and a single correctly rounded operation.  Everything
+// else (long mantissas, large exponents, hex, inf, nan, trailing characters) falls back to strtod.
+static double fast_strtod(const char* s, char** end) {
+  static const double powers[23] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                    1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+  const char* p = s;
+  const bool negative = *p=='-';
+  if (*p=='-' || *p=='+')
+    p++;
+  uint64_t m = 0;
+  int digits = 0, significant = 0, scale = 0;
+  for (;'0'<=*p && *p<='9';p++,digits++)
+    if (m || *p!='0') {
+      if (++significant > 19)
+        return strtod(s,end);
+      m = 10*m+(*p-'0');
+    }
+  if (*p=='.')
+    for (p++;'0'<=*p && *p<='9';p++,digits++) {
+      scale--;
+      if (m || *p!='0') {
+        if (++significant > 19)
+          return strtod(s,end);
+        m = 10*m+(*p-'0');
+      }
+    }
+  if (!digits)
+    return strtod(s,end);
+  if (*p=='e' || *p=='E') {
+    const char* q = p+1;
+    const bool negative_exponent = *q=='-';
+    if (*q=='-' || *q=='+')
+      q++;
+    if (!('0'<=*q && *q<='9'))
+      return strtod(s,end);
+    int e = 0;
+    for (;'0'<=*q && *q<='9';q++) {
+      if (e > 1000)
+        return strtod(s,end);
+      e = 10*e+(*q-'0');
+    }
+    scale += negative_exponent ? -e : e;
+    p = q;
+  }
+  if (*p || m>>53 || scale<-22 || scale>22)
+    return strtod(s,end);
+  const double x = scale<0 ? double(m)/powers[-scale] : double(m)*powers[scale];
+  *end = const_cast<char*>(p);
+  return negative ? -x : x;
+}
 
-  // Parse file
-  Array<TV> X, normals;
-  Array<TV2> texcoords;
-  Array<int> counts, vertices;
-  char orig[1024], line[1024];
-  int nl = 0;
-  while (fgets(orig,sizeof(orig),f)) {
+// Split text into chunks of whole lines for parallel parsing.  Returns chunk boundaries, and the number of lines
+// before each boundary.  A final line without a newline counts as a line.
+static Tuple<Array<const char*>,Array<int>> line_chunks(const char* begin, const char* end) {
+  const size_t chunk_size = 1<<22;
+  Array<const char*> bounds;
+  bounds.append(begin);
+  while (size_t(end-bounds.back()) > chunk_size) {
+    const char* p = bounds.back()+chunk_size;
+    const char* newline = (const char*)memchr(p,'\n',end-p);
+    if (!newline || newline+1==end)
+      break;
+    bounds.append(newline+1);
+  }
+  if (begin < end)
+    bounds.append(end);
+  const int n = bounds.size()-1;
+  Array<int> lines(n+1);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<n;c++) {
+    int count = 0;
+    for (const char* p=bounds[c];p<bounds[c+1];) {
+      const char* newline = (const char*)memchr(p,'\n',bounds[c+1]-p);
+      count++;
+      p = newline ? newline+1 : bounds[c+1];
+    }
+    lines[c+1] = count;
+  }
+  for (int c=0;c<n;c++)
+    lines[c+1] += lines[c];
+  return tuple(bounds,lines);
+}
+
+namespace {
+// Line by line obj parser shared by read_obj and ObjReader.  Lines come either from a file or from memory.
+struct ObjParser {
+  const string filename;
+  int nl;
+  Array<char> orig, line;
+  TV x; // Data for v, vn, and vt lines (x.z is zero for vt)
+  Array<int> face; // Zero based vertex ids for f lines
+
+  enum Kind { End, Skip, V, VN, VT, F };
+
+  // Line numbers in errors start after line nl
+  ObjParser(const string& filename, const int nl)
+    : filename(filename)
+    , nl(nl)
+    , orig(1024)
+    , line(1024) {}
+
+  // Parse lines from the file until we hit a v, vn, vt, or f command, or the end of the file
+  Kind next(FILE* f) {
+    while (fgets(orig.data(),orig.size(),f)) {
+      const auto kind = parse();
+      if (kind != Skip)
+        return kind;
+    }
+    return End;
+  }
+
+  // Parse one line from memory, advancing p past it.  Returns End if p is at the end.
+  Kind next(const char*& p, const char* end) {
+    if (p == end)
+      return End;
+    const char* newline = (const char*)memchr(p,'\n',end-p);
+    const char* next = newline ? newline+1 : end;
+    const int n = int(next-p);
+    if (n >= orig.size()) {
+      orig.resize(n+1,uninit);
+      line.resize(n+1,uninit);
+    }
+    memcpy(orig.data(),p,n);
+    orig[n] = 0;
+    p = next;
+    return parse();
+  }
+
+private:
+  // Parse the line in orig
+  Kind parse() {
     nl++;
-    strcpy(line,orig);
+    strcpy(line.data(),orig.data());
     char* save;
-    const char* cmd = strtok_r(line,white,&save);
+    const char* cmd = strtok_r(line.data(),white,&save);
     if (!cmd || cmd[0] == '#')
-      continue;
+      return Skip;
     else if (cmd[0]=='v' && (!cmd[1] || ((cmd[1]=='n' || cmd[1]=='t') && !cmd[2]))) { // cmd = v, vn, or vt
       int n = 0;
-      double x[4];
+      double y[4];
       for (int i=0;i<4;i++)
         if (const char* q = strtok_r(0,white,&save)) {
           char* end;
-          x[n++] = strtod(q,&end);
+          y[n++] = fast_strtod(q,&end);
           if (*end)
-            throw IOError(format("invalid obj file %s:%d: bad %s line: %s",filename,nl,cmd,repr(orig)));
+            throw IOError(format("invalid obj file %s:%d: bad %s line: %s",filename,nl,cmd,repr(orig.data())));
         }
       const int ne = !cmd[1] ? 3 : cmd[1]=='n' ? 3 : /*cmd[1]=='t'*/ 2;
       if (n != ne)
-        throw IOError(format("invalid obj file %s:%d: %s expected %d floats, got %d. Line: %s",filename,nl,cmd,ne,n,repr(orig)));
-      if (!cmd[1]) { // v
-        if (X.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many vertices (our limit is 2^31-1)",filename));
-        X.append(TV(x[0],x[1],x[2]));
-      } else if (cmd[1]=='n') { // vn
-        if (normals.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many normals (our limit is 2^31-1)",filename));
-        normals.append(TV(x[0],x[1],x[2]));
-      } else { // vt
-        if (texcoords.size()==numeric_limits<int>::max())
-          throw IOError(format("unsupported obj file %s: too many texcoords (our limit is 2^31-1)",filename));
-        texcoords.append(TV2(x[0],x[1]));
-      }
+        throw IOError(format("invalid obj file %s:%d: %s expected %d floats, got %d. Line: %s",
+          filename,nl,cmd,ne,n,repr(orig.data())));
+      x = TV(y[0],y[1],ne==3 ? y[2] : 0);
+      return !cmd[1] ? V : cmd[1]=='n' ? VN : VT;
     } else if (cmd[0]=='f' && !cmd[1]) { // cmd = f
-      int n = 0;
+      face.clear();
       while (const char* q = strtok_r(0,white,&save)) {
-        n++;
         char* end;
         const long v = strtol(q,&end,0);
         if (*end && *end != '/')
-          throw IOError(format("invalid obj file %s:%d: f expected ints, got %s",filename,nl,repr(orig)));
+          throw IOError(format("invalid obj file %s:%d: f expected ints, got %s",filename,nl,repr(orig.data())));
         // TODO: Don't skip face normal or face texcoord information
         if (long(unsigned(int(v))) != v)
           throw IOError(format("unsupported obj file %s:%d: f got invalid vertex id %ld",filename,nl,v));
-        vertices.append(int(v));
+        face.append(int(v)-1);
       }
-      if (n < 3)
+      if (face.size() < 3)
         throw IOError(format("invalid obj file %s:%d: f got fewer than 3 vertices",filename,nl));
-      counts.append(n);
+      return F;
     } else if (strcmp(cmd,"usemtl") || strcmp(cmd,"usemat") || strcmp(cmd,"mtllib")) {
       // TODO: Don't skip these fields?
+      return Skip;
     } else
       throw IOError(format("invalid obj file %s:%d: invalid command %s",filename,nl,repr(cmd)));
   }
+};
 
-  // Adjust vertices and check consistency
-  vertices -= 1;
+struct ObjReader : public MeshReader {
+  GEODE_NEW_FRIEND
+  File f;
+  ObjParser obj;
+protected:
+  ObjReader(const string& filename, const int batch_size)
+    : MeshReader(filename,batch_size)
+    , f(filename,"r")
+    , obj(filename,0) {}
+
+  void fill(MeshBatch& batch) {
+    while (batch.X.size()+batch.tris.size() < batch_size) {
+      const auto kind = obj.next(f);
+      if (kind == ObjParser::End)
+        break;
+      else if (kind == ObjParser::V) {
+        if (batch.vertex_offset+batch.X.size()==numeric_limits<int>::max())
+          throw IOError(format("unsupported obj file %s: too many vertices (our limit is 2^31-1)",filename));
+        batch.X.append(obj.x);
+      } else if (kind == ObjParser::F) {
+        // Faces may only refer to vertices we've already seen
+        const int nv = batch.vertex_offset+batch.X.size();
+        for (const int v : obj.face)
+          if (unsigned(v) >= unsigned(nv))
+            throw IOError(format("unsupported obj file %s:%d: face vertex %d is not in [1,%d], and streaming "
+                                 "requires vertices before the faces that use them",filename,obj.nl,v+1,nv));
+        const auto& p = obj.face;
+        for (int i=0;i<p.size()-2;i++)
+          batch.tris.append(vec(p[0],p[i+1],p[i+2]));
+      }
+    }
+  }
+};
+
+// Everything parsed from one chunk of an obj file
+struct ObjChunk {
+  Array<TV> X, normals;
+  Array<TV2> texcoords;
+  Array<int> counts, vertices;
+};
+}
+
+// Concatenate one field of all chunks, checking the total size
+template<class T> static Array<T> concatenate(const vector<ObjChunk>& chunks, Array<T> ObjChunk::*field,
+                                              const string& filename, const char* name) {
+  int64_t total = 0;
+  for (const auto& chunk : chunks)
+    total += (chunk.*field).size();
+  if (total > numeric_limits<int>::max())
+    throw IOError(format("unsupported obj file %s: too many %s (our limit is 2^31-1)",filename,name));
+  Array<T> all;
+  all.preallocate(int(total));
+  for (const auto& chunk : chunks)
+    all.extend(chunk.*field);
+  return all;
+}
+
+static Tuple<Ref<PolygonSoup>,Array<TV>> read_obj(const string& filename) {
+  // Parse line aligned chunks of the file in parallel
+  const auto file = new_<MappedFile>(filename);
+  const auto chunks = line_chunks(file->data,file->data+file->size);
+  const auto& bounds = chunks.x;
+  const auto& lines = chunks.y;
+  const int n = bounds.size()-1;
+  vector<ObjChunk> results(n);
+  vector<ExceptionValue> errors(n);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<n;c++) {
+    try {
+      auto& R = results[c];
+      ObjParser obj(filename,lines[c]);
+      const char* p = bounds[c];
+      for (;;) {
+        const auto kind = obj.next(p,bounds[c+1]);
+        if (kind == ObjParser::End)
+          break;
+        else if (kind == ObjParser::V)
+          R.X.append(obj.x);
+        else if (kind == ObjParser::VN)
+          R.normals.append(obj.x);
+        else if (kind == ObjParser::VT)
+          R.texcoords.append(TV2(obj.x.x,obj.x.y));
+        else if (kind == ObjParser::F) {
+          R.vertices.extend(obj.face);
+          R.counts.append(obj.face.size());
+        }
+      }
+    } catch (const std::exception& e) {
+      errors[c] = ExceptionValue(e);
+    }
+  }
+
+  // Report the first error in file order, as a serial parse would
+  for (const auto& error : errors)
+    if (error)
+      error.throw_();
+
+  // Concatenate in order
+  const auto X = concatenate(results,&ObjChunk::X,filename,"vertices"),
+             normals = concatenate(results,&ObjChunk::normals,filename,"normals");
+  const auto texcoords = concatenate(results,&ObjChunk::texcoords,filename,"texcoords");
+  const auto counts = concatenate(results,&ObjChunk::counts,filename,"faces"),
+             vertices = concatenate(results,&ObjChunk::vertices,filename,"face vertices");
+
+  // Check consistency
   for (const int v : vertices)
     if (!X.valid(v))
-      throw IOError(format("invalid obj file %s: face vertex %d out of valid range [1,%d]",filename,v+1,X.size()));
+      throw IOError(format("invalid obj file %s: face vertex %d out of valid range [1,%d]",filename,v+1,int(X.size())));
   if (normals.size() && normals.size() != X.size())
-    throw IOError(format("invalid obj file %s: %d vertices != %d normals",filename,X.size(),normals.size()));
+    throw IOError(format("invalid obj file %s: %d vertices != %d normals",filename,int(X.size()),int(normals.size())));
   if (texcoords.size() && texcoords.size() != X.size())
-    throw IOError(format("invalid obj file %s: %d vertices != %d texcoords",filename,X.size(),texcoords.size()));
+    throw IOError(format("invalid obj file %s: %d vertices != %d texcoords",filename,int(X.size()),int(texcoords.size())));
 
   // TODO: Don't discard normal and texcoord information
   return tuple(new_<PolygonSoup>(counts,vertices,X.size()),X);
 }
 
-static void write_obj_helper(File& f, RawArray<const TV> X) {
-  // Write format
+static void write_obj_header(File& f) {
   fputs("# Simple obj file format: http://en.wikipedia.org/wiki/Wavefront_.obj_file\n"
         "#   # Vertex at coordinates (x,y,z):\n"
         "#   v x y z\n"
         "#   # Triangle [quad] with vertices a,b,c[,d]:\n"
         "#   f a b c [d]\n"
         "#   # Vertices are indexed starting from 1\n",f);
+}
+static void write_obj_helper(File& f, RawArray<const TV> X) {
+  // Write format
+  write_obj_header(f);
 
   // Write vertices
   for (const auto x : X)
@@ -325,7 +650,7 @@ struct Line {
   Array<char> line, split;
   Array<const char*> words;
 
-  // TODO: Allow for longer lines
+  // TODO: Allow for longer lines when reading from files
   Line()
     : lineno(0), line(1024), split(1024) {}
 
@@ -333,6 +658,35 @@ struct Line {
     lineno++;
     if (!fgets(line.data(),line.size(),f))
       return false;
+    split_words();
+    return true;
+  }
+
+  // Read a line from memory of any length, advancing p past it
+  bool read(const char*& p, const char* end) {
+    lineno++;
+    if (p == end)
+      return false;
+    const char* newline = (const char*)memchr(p,'\n',end-p);
+    const char* next = newline ? newline+1 : end;
+    const int n = int(next-p);
+    if (n >= line.size()) {
+      line.resize(n+1,uninit);
+      split.resize(n+1,uninit);
+    }
+    memcpy(line.data(),p,n);
+    line[n] = 0;
+    p = next;
+    split_words();
+    return true;
+  }
+
+  string repr() const {
+    return geode::repr(line.data());
+  }
+
+private:
+  void split_words() {
     strcpy(split.data(),line.data());
     char* p = split.data();
     char* save;
@@ -341,11 +695,6 @@ struct Line {
       words.append(w);
       p = 0;
     }
-    return true;
-  }
-
-  string repr() const {
-    return geode::repr(line.data());
   }
 };
 
@@ -359,6 +708,10 @@ public:
   virtual void read_ascii(RawArray<const char*> words, int& i) = 0;
   virtual void read_binary_same_endian(FILE* f) = 0;
   virtual void read_binary_flip_endian(FILE* f) = 0;
+  virtual void clear() = 0; // Discard rows read so far
+  virtual const char* skip_binary(const char* p, const char* end) const = 0; // Skip one native endian entry
+  virtual Ref<PlyProp> empty_like(const int reserve) const = 0; // Same name and type, with no rows
+  virtual void extend(const PlyProp& other) = 0; // Append the rows of an empty_like copy
   virtual string type() const = 0;
 };
 
@@ -405,7 +758,7 @@ template<class T> static inline typename enable_if<is_integral<T>,T>::type parse
 
 template<class T> static inline typename enable_if<is_floating_point<T>,T>::type parse(const char* s) {
   char* end;
-  const double x = strtod(s,&end);
+  const double x = fast_strtod(s,&end);
   if (end[0])
     throw IOError(format("invalid %s value %s",ply_type_name<T>(),repr(s)));
   return x;
@@ -415,9 +768,9 @@ template<class T> struct PlyPropSingle : public PlyProp {
   GEODE_NEW_FRIEND
   Array<T> a;
 protected:
-  PlyPropSingle(const string& name, const int count)
+  PlyPropSingle(const string& name, const int reserve)
     : PlyProp(name) {
-    a.preallocate(count);
+    a.preallocate(reserve);
   }
 
   void read_ascii(RawArray<const char*> words, int& i) {
@@ -440,6 +793,24 @@ protected:
     a.append(flip_endian(x));
   }
 
+  void clear() {
+    a.clear();
+  }
+
+  const char* skip_binary(const char* p, const char* end) const {
+    if (end-p < int(sizeof(T)))
+      throw IOError(format("incomplete element (no %s)",name));
+    return p+sizeof(T);
+  }
+
+  Ref<PlyProp> empty_like(const int reserve) const {
+    return new_<PlyPropSingle>(name,reserve);
+  }
+
+  void extend(const PlyProp& other) {
+    a.extend(static_cast<const PlyPropSingle&>(other).a);
+  }
+
   string type() const {
     return ply_type_name<T>();
   }
@@ -451,9 +822,9 @@ template<class L,class T> struct PlyPropList : public PlyProp {
   Array<int> counts;
   Array<T> flat;
 protected:
-  PlyPropList(const string& name, const int n)
+  PlyPropList(const string& name, const int reserve)
     : PlyProp(name) {
-    counts.preallocate(n);
+    counts.preallocate(reserve);
   }
 
   void read_ascii(RawArray<const char*> words, int& i) {
@@ -494,6 +865,30 @@ protected:
       flat[offset+i] = flip_endian(flat[offset+i]);
   }
 
+  void clear() {
+    counts.clear();
+    flat.clear();
+  }
+
+  const char* skip_binary(const char* p, const char* end) const {
+    if (end-p < int(sizeof(L)))
+      throw IOError(format("incomplete element (no %s size)",name));
+    const L n = *(const L*)p;
+    if (size_t(end-p-sizeof(L)) < n*sizeof(T))
+      throw IOError(format("incomplete element (incomplete %s list)",name));
+    return p+sizeof(L)+n*sizeof(T);
+  }
+
+  Ref<PlyProp> empty_like(const int reserve) const {
+    return new_<PlyPropList>(name,reserve);
+  }
+
+  void extend(const PlyProp& other) {
+    const auto& o = static_cast<const PlyPropList&>(other);
+    counts.extend(o.counts);
+    flat.extend(o.flat);
+  }
+
   string type() const {
     return ply_type_name<T>();
   }
@@ -512,144 +907,254 @@ protected:
 };
 }
 
-static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
-  File f(filename,"rb");
-  Line line;
-  try {
-    // Read magic string
-    if (!line.read(f) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
-      cout << "words = "<<line.words<<endl;
-      throw IOError(format("expected magic string 'ply', got %s",repr(line)));
-    }
+// Read a ply header, returning the format: 1 for ascii, 2 for binary little endian, 3 for binary big endian.
+// Properties reserve space for at most reserve rows.
+static int read_ply_header(File& f, Line& line, vector<Ref<PlyElement>>& elements,
+                           Hashtable<string,Ref<PlyElement>>& element_names, const int reserve) {
+  // Read magic string
+  if (!line.read(f) || line.words.size()!=1 || strcmp(line.words[0],"ply")) {
+    cout << "words = "<<line.words<<endl;
+    throw IOError(format("expected magic string 'ply', got %s",repr(line)));
+  }
 
-    // Read rest of header
-    int fmt = 0; // 1 for ascii, 2 for binary little endian, 3 for binary big endian
-    vector<Ref<PlyElement>> elements;
-    Hashtable<string,Ref<PlyElement>> element_names;
-    for (;;) {
-      if (!line.read(f))
-        throw IOError("eof before end of header");
-      const auto words = line.words.raw();
-      if (!words.size() || !strcmp(words[0],"comment"))
-        continue;
-      else if (!strcmp(words[0],"format")) {
-        if (fmt)
-          throw IOError("duplicate format line");
+  // Read rest of header
+  int fmt = 0;
+  for (;;) {
+    if (!line.read(f))
+      throw IOError("eof before end of header");
+    const auto words = line.words.raw();
+    if (!words.size() || !strcmp(words[0],"comment"))
+      continue;
+    else if (!strcmp(words[0],"format")) {
+      if (fmt)
+        throw IOError("duplicate format line");
+      if (words.size() != 3)
+        throw IOError(format("invalid format line %s",repr(line)));
+      try {
+        const double version = parse<double>(words[2]);
+        if (version != 1)
+          throw IOError("");
+      } catch (const IOError&) {
+        throw IOError(format("unsupported version %s",repr(words[2])));
+      }
+      if      (!strcmp(words[1],"ascii"))                fmt = 1;
+      else if (!strcmp(words[1],"binary_little_endian")) fmt = 2;
+      else if (!strcmp(words[1],"binary_big_endian"))    fmt = 3;
+    } else if (!strcmp(words[0],"element")) {
+      try {
         if (words.size() != 3)
-          throw IOError(format("invalid format line %s",repr(line)));
-        try {
-          const double version = parse<double>(words[2]);
-          if (version != 1)
-            throw IOError("");
-        } catch (const IOError&) {
-          throw IOError(format("unsupported version %s",repr(words[2])));
-        }
-        if      (!strcmp(words[1],"ascii"))                fmt = 1;
-        else if (!strcmp(words[1],"binary_little_endian")) fmt = 2;
-        else if (!strcmp(words[1],"binary_big_endian"))    fmt = 3;
-      } else if (!strcmp(words[0],"element")) {
-        try {
-          if (words.size() != 3)
-            throw IOError("expected 'element <name> <count>'");
-          const auto E = new_<PlyElement>(words[1],parse<int>(words[2]));
-          if (!element_names.set(E->name,E))
-            throw IOError(format("duplicate element name %s",repr(E->name)));
-          elements.push_back(E);
-        } catch (const IOError& e) {
-          throw IOError(format("invalid element declaration %s: %s",repr(line),e.what()));
-        }
-      } else if (!strcmp(words[0],"property")) {
-        if (!elements.size())
-          throw IOError("property before element");
-        PlyElement& E = elements.back();
-        if (words.size() < 3)
-          throw IOError("incomplete property declaration, expected 'property [list uchar] type name'");
-        Ptr<PlyProp> prop;
-        #define SINGLE_CASE(name,T) \
-          else if (!strcmp(words[1],#name)) \
-            prop = new_<PlyPropSingle<T>>(words[2],E.count);
-        #define LIST_CASE(name,T) \
-          else if (!strcmp(words[3],#name)) \
-            prop = new_<PlyPropList<uint8_t,T>>(words[4],E.count);
-        if (!strcmp(words[1],"list")) {
-          if (words.size() != 5)
-            throw IOError("invalid list property declaration, expected 'property list uchar type name'");
-          if (strcmp(words[2],"uchar"))
-            throw IOError(format("unsupported list property declaration, only uchar sizes are supported, got %s",
-              repr(words[2])));
-          PLY_TYPE_NAMES(LIST_CASE)
-          else
-            throw IOError(format("invalid list property type %s",repr(words[3])));
-        } else {
-          if (words.size() != 3)
-            throw IOError("invalid single property declaration, expected 'property type name'");
-          PLY_TYPE_NAMES(SINGLE_CASE)
-          else
-            throw IOError(format("invalid property type %s",repr(words[1])));
-        }
-        if (!E.prop_names.set(prop->name,ref(prop)))
-          throw IOError(format("duplicate property name %s for element %s",repr(prop->name),repr(E.name)));
-        E.props.push_back(ref(prop));
-      } else if (!strcmp(words[0],"end_header"))
-        break;
-      else
-        throw IOError(format("invalid header command %s",repr(words[0])));
-    }
-    if (!fmt)
-      throw IOError("missing format declaration");
+          throw IOError("expected 'element <name> <count>'");
+        const auto E = new_<PlyElement>(words[1],parse<int>(words[2]));
+        if (!element_names.set(E->name,E))
+          throw IOError(format("duplicate element name %s",repr(E->name)));
+        elements.push_back(E);
+      } catch (const IOError& e) {
+        throw IOError(format("invalid element declaration %s: %s",repr(line),e.what()));
+      }
+    } else if (!strcmp(words[0],"property")) {
+      if (!elements.size())
+        throw IOError("property before element");
+      PlyElement& E = elements.back();
+      if (words.size() < 3)
+        throw IOError("incomplete property declaration, expected 'property [list uchar] type name'");
+      const int rows = min(E.count,reserve);
+      Ptr<PlyProp> prop;
+      #define SINGLE_CASE(name,T) \
+        else if (!strcmp(words[1],#name)) \
+          prop = new_<PlyPropSingle<T>>(words[2],rows);
+      #define LIST_CASE(name,T) \
+        else if (!strcmp(words[3],#name)) \
+          prop = new_<PlyPropList<uint8_t,T>>(words[4],rows);
+      if (!strcmp(words[1],"list")) {
+        if (words.size() != 5)
+          throw IOError("invalid list property declaration, expected 'property list uchar type name'");
+        if (strcmp(words[2],"uchar"))
+          throw IOError(format("unsupported list property declaration, only uchar sizes are supported, got %s",
+            repr(words[2])));
+        PLY_TYPE_NAMES(LIST_CASE)
+        else
+          throw IOError(format("invalid list property type %s",repr(words[3])));
+      } else {
+        if (words.size() != 3)
+          throw IOError("invalid single property declaration, expected 'property type name'");
+        PLY_TYPE_NAMES(SINGLE_CASE)
+        else
+          throw IOError(format("invalid property type %s",repr(words[1])));
+      }
+      if (!E.prop_names.set(prop->name,ref(prop)))
+        throw IOError(format("duplicate property name %s for element %s",repr(prop->name),repr(E.name)));
+      E.props.push_back(ref(prop));
+    } else if (!strcmp(words[0],"end_header"))
+      break;
+    else
+      throw IOError(format("invalid header command %s",repr(words[0])));
+  }
+  if (!fmt)
+    throw IOError("missing format declaration");
+  return fmt;
+}
 
-    #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
-      const int native = 2;
-    #elif GEODE_ENDIAN == GEODE_BIG_ENDIAN
-      const int native = 3;
-    #endif
+// Parse the words of ascii row i of element E into props, which are either E.props or empty_like copies
+static void read_ply_ascii_row(RawArray<const char*> words, const PlyElement& E,
+                               const vector<Ref<PlyProp>>& props, const int i) {
+  int n = 0;
+  for (const auto& prop : props) {
+    try {
+      prop->read_ascii(words,n);
+    } catch (const IOError& e) {
+      throw IOError(format("failed to read element %s, index %d, prop %s: %s",
+        repr(E.name),i,repr(prop->name),e.what()));
+    }
+  }
+  if (n != words.size())
+    throw IOError(format("failed to read element %s, index %d: extra fields",repr(E.name),i));
+}
 
-    // Read all elements
-    if (fmt == 1) {
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          if (!line.read(f))
-            throw IOError(format("failed to read element %s, index %d: unexpected end of file",repr(E->name),i));
-          int n = 0;
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_ascii(line.words,n);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
-          if (n != line.words.size())
-            throw IOError(format("failed to read element %s, index %d: extra fields",repr(E->name),i));
-        }
+// Read row i of element E
+static void read_ply_row(File& f, Line& line, const int fmt, const PlyElement& E, const int i) {
+  #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
+    const int native = 2;
+  #elif GEODE_ENDIAN == GEODE_BIG_ENDIAN
+    const int native = 3;
+  #endif
+
+  if (fmt == 1) {
+    if (!line.read(f))
+      throw IOError(format("failed to read element %s, index %d: unexpected end of file",repr(E.name),i));
+    read_ply_ascii_row(line.words,E,E.props,i);
+  } else {
+    for (const auto& prop : E.props) {
+      try {
+        if (fmt == native)
+          prop->read_binary_same_endian(f);
+        else
+          prop->read_binary_flip_endian(f);
+      } catch (const IOError& e) {
+        throw IOError(format("failed to read element %s, index %d, prop %s: %s",
+          repr(E.name),i,repr(prop->name),e.what()));
       }
-    } else if (fmt == native) {
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_binary_same_endian(f);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
-        }
-      }
-    } else { // fmt == nonnative
-      for (const auto& E : elements) {
-        for (const int i : range(E->count)) {
-          for (const auto& prop : E->props) {
-            try {
-              prop->read_binary_flip_endian(f);
-            } catch (const IOError& e) {
-              throw IOError(format("failed to read element %s, index %d, prop %s: %s",
-                repr(E->name),i,repr(prop->name),e.what()));
-            }
-          }
+    }
+  }
+}
+
+// Pull positions out of the rows of a vertex element read so far
+static void ply_positions(const PlyElement& vertex, RawArray<TV> X) {
+  for (const int i : range(3)) {
+    const string c(1,"xyz"[i]);
+    if (!vertex.prop_names.contains(c))
+      throw IOError(format("vertex element missing property %s",c));
+    const auto x_ = vertex.prop_names.get(c);
+    if (const auto* x = dynamic_cast<PlyPropSingle<float>*>(&*x_)) {
+      for (const int j : range(X.size()))
+        X[j][i] = x->a[j];
+    } else if (const auto& x = dynamic_cast<PlyPropSingle<double>*>(&*x_)) {
+      for (const int j : range(X.size()))
+        X[j][i] = x->a[j];
+    } else
+      throw IOError(format("vertex.%s has invalid type %s",c,x_->type()));
+  }
+}
+
+// Find the vertex indices of a face element
+static const PlyPropList<uint8_t,int>& ply_face_vertices(const PlyElement& face) {
+  if (!face.prop_names.contains("vertex_indices"))
+    throw IOError("face element missing vertex_indices");
+  const auto vertices = face.prop_names.get("vertex_indices");
+  if (const auto* v = dynamic_cast<PlyPropList<uint8_t,int>*>(&*vertices))
+    return *v;
+  else
+    throw IOError(format("face.vertex_indices has unsupported type %s",vertices->type()));
+}
+
+// Read all rows of an ascii ply body starting at byte offset start, in parallel.  Each row is one line, so line
+// aligned chunks of the body hold contiguous ranges of rows.  Chunks are parsed into empty_like properties, which
+// are appended to the element properties in order.  On error, line.lineno is set to the offending line.
+static void read_ply_ascii(const string& filename, const long start, Line& line,
+                           const vector<Ref<PlyElement>>& elements) {
+  const auto file = new_<MappedFile>(filename);
+  const auto chunks = line_chunks(file->data+start,file->data+file->size);
+  const auto& bounds = chunks.x;
+  const auto& lines = chunks.y;
+  const int n = bounds.size()-1;
+
+  // Rows before each element
+  const int ne = int(elements.size());
+  Array<int64_t> offsets(ne+1);
+  for (int e=0;e<ne;e++)
+    offsets[e+1] = offsets[e]+elements[e]->count;
+  const int64_t rows = offsets.back();
+
+  vector<vector<vector<Ref<PlyProp>>>> props(n); // chunk, element, property
+  vector<int> linenos(n);
+  vector<ExceptionValue> errors(n);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int c=0;c<n;c++) {
+    Line local;
+    local.lineno = line.lineno+lines[c];
+    try {
+      const int64_t r_end = min(int64_t(lines[c+1]),rows);
+      int64_t r = lines[c];
+      if (r >= r_end)
+        continue;
+      auto& P = props[c];
+      P.resize(ne);
+      int e = int(std::upper_bound(offsets.begin(),offsets.end(),r)-offsets.begin())-1;
+      const char* p = bounds[c];
+      for (;r<r_end;r++) {
+        while (r == offsets[e+1])
+          e++;
+        const auto& E = *elements[e];
+        if (P[e].empty()) {
+          const int reserve = int(min(r_end,offsets[e+1])-r);
+          for (const auto& prop : E.props)
+            P[e].push_back(prop->empty_like(reserve));
         }
+        local.read(p,bounds[c+1]);
+        read_ply_ascii_row(local.words,E,P[e],int(r-offsets[e]));
       }
+    } catch (const std::exception& e) {
+      errors[c] = ExceptionValue(e);
+      linenos[c] = local.lineno;
+    }
+  }
+
+  // Report the first error in file order, as a serial parse would
+  for (int c=0;c<n;c++)
+    if (errors[c]) {
+      line.lineno = linenos[c];
+      errors[c].throw_();
     }
+  const int64_t total = lines[n];
+  if (total < rows) {
+    const int e = int(std::upper_bound(offsets.begin(),offsets.end(),total)-offsets.begin())-1;
+    line.lineno += int(total)+1;
+    throw IOError(format("failed to read element %s, index %d: unexpected end of file",
+      repr(elements[e]->name),int(total-offsets[e])));
+  }
+
+  // Concatenate in order
+  for (int e=0;e<ne;e++)
+    for (const auto& P : props)
+      if (P.size() && P[e].size())
+        for (const int i : range(int(P[e].size())))
+          elements[e]->props[i]->extend(*P[e][i]);
+}
+
+static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
+  File f(filename,"rb");
+  Line line;
+  try {
+    vector<Ref<PlyElement>> elements;
+    Hashtable<string,Ref<PlyElement>> element_names;
+    const int fmt = read_ply_header(f,line,elements,element_names,numeric_limits<int>::max());
+
+    // Read all elements
+    if (fmt == 1)
+      read_ply_ascii(filename,ftell(f),line,elements);
+    else
+      for (const auto& E : elements)
+        for (const int i : range(E->count))
+          read_ply_row(f,line,fmt,E,i);
 
     // Pull out all the data we need
     // TODO: Don't discard all the rest of the data
@@ -657,60 +1162,136 @@ static Tuple<Ref<PolygonSoup>,Array<TV>> read_ply(const string& filename) {
       throw IOError("missing vertex element");
     const auto vertex = element_names.get("vertex");
     Array<TV> X(vertex->count,uninit);
-    for (const int i : range(3)) {
-      const string c(1,"xyz"[i]);
-      if (!vertex->prop_names.contains(c))
-        throw IOError(format("vertex element missing property %s",c));
-      const auto x_ = vertex->prop_names.get(c);
-      if (const auto* x = dynamic_cast<PlyPropSingle<float>*>(&*x_)) {
-        for (const int j : range(X.size()))
-          X[j][i] = x->a[j];
-      } else if (const auto& x = dynamic_cast<PlyPropSingle<double>*>(&*x_)) {
-        for (const int j : range(X.size()))
-          X[j][i] = x->a[j];
-      } else
-        throw IOError(format("vertex.%s has invalid type %s",c,x_->type()));
-    }
+    ply_positions(vertex,X);
     if (!element_names.contains("face"))
       throw IOError("missing face element");
-    const auto face = element_names.get("face");
-    if (!face->prop_names.contains("vertex_indices"))
-      throw IOError("face element missing vertex_indices");
-    const auto vertices = face->prop_names.get("vertex_indices");
-    if (const auto* v = dynamic_cast<PlyPropList<uint8_t,int>*>(&*vertices))
-      return tuple(new_<PolygonSoup>(v->counts,v->flat,X.size()),X);
-    else
-      throw IOError(format("face.vertex_indices has unsupported type %s",vertices->type()));
+    const auto& v = ply_face_vertices(element_names.get("face"));
+    return tuple(new_<PolygonSoup>(v.counts,v.flat,X.size()),X);
   } catch (const IOError& e) {
     throw IOError(format("invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
   }
 }
 
+namespace {
+struct PlyReader : public MeshReader {
+  GEODE_NEW_FRIEND
+  File f;
+  Line line;
+  int fmt;
+  vector<Ref<PlyElement>> elements;
+  Ptr<PlyElement> vertex, face;
+  const PlyPropList<uint8_t,int>* indices;
+  int element, row; // Next row to read
+protected:
+  PlyReader(const string& filename, const int batch_size)
+    : MeshReader(filename,batch_size)
+    , f(filename,"rb")
+    , fmt(0)
+    , indices(0)
+    , element(0)
+    , row(0) {
+    try {
+      Hashtable<string,Ref<PlyElement>> element_names;
+      fmt = read_ply_header(f,line,elements,element_names,batch_size);
+      if (!element_names.contains("vertex"))
+        throw IOError("missing vertex element");
+      if (!element_names.contains("face"))
+        throw IOError("missing face element");
+      vertex = element_names.get("vertex");
+      face = element_names.get("face");
+      indices = &ply_face_vertices(*face);
+      for (const auto& E : elements) {
+        if (&*E == &*face)
+          throw IOError("streaming requires the vertex element before the face element");
+        if (&*E == &*vertex)
+          break;
+      }
+    } catch (const IOError& e) {
+      throw IOError(format("invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
+    }
+  }
+
+  void fill(MeshBatch& batch) {
+    try {
+      // Read rows until the batch is full.  Rows of other elements are read and discarded immediately, and don't count
+      // toward the batch size, so that a large intervening element can't produce an empty batch before end of file.
+      int size = 0, nv = 0;
+      for (;;) {
+        while (element<int(elements.size()) && row==elements[element]->count) {
+          element++;
+          row = 0;
+        }
+        if (size>=batch_size || element==int(elements.size()))
+          break;
+        const auto& E = *elements[element];
+        read_ply_row(f,line,fmt,E,row++);
+        if (&E == &*vertex) {
+          size++;
+          nv++;
+        } else if (&E == &*face)
+          size += max(1,indices->counts.back()-2);
+        else
+          for (const auto& prop : E.props)
+            prop->clear();
+      }
+
+      // Convert to vertices and triangles
+      batch.X.resize(nv,uninit);
+      ply_positions(*vertex,batch.X);
+      const int total = batch.vertex_offset+nv;
+      int offset = 0;
+      for (const int n : indices->counts) {
+        const auto p = indices->flat.slice(offset,offset+n);
+        offset += n;
+        for (const int v : p)
+          if (unsigned(v) >= unsigned(total))
+            throw IOError(format("face vertex %d out of valid range [0,%d)",v,total));
+        for (int i=0;i<n-2;i++)
+          batch.tris.append(vec(p[0],p[i+1],p[i+2]));
+      }
+      for (const auto& E : elements)
+        for (const auto& prop : E->props)
+          prop->clear();
+    } catch (const IOError& e) {
+      throw IOError(format("invalid ply file %s:%d: %s",filename,line.lineno,e.what()));
+    }
+  }
+};
+}
+
+static void write_ply_vertices(File& f, RawArray<const TV> X) {
+  for (const auto& x : X) {
+    const auto y = to_little_endian(Vector<float,3>(x));
+    fwrite(&y,sizeof(y),1,f);
+  }
+}
+
+static void write_ply_triangles(File& f, RawArray<const Vector<int,3>> tris) {
+  for (const Vector<int,3>& t : tris) {
+    const uint8_t n = 3;
+    fwrite(&n,1,1,f);
+    fwrite(&to_little_endian(t),sizeof(t),1,f);
+  }
+}
+
 static void write_ply_helper(File& f, const int nfaces, RawArray<const TV> X) {
   fprintf(f,"ply\n"
             "format binary_little_endian 1.0\n"
             "comment Binary .ply file: http://en.wikipedia.org/wiki/PLY_(file_format)\n"
-            "element vertex %d\n"
+            "element vertex %lld\n"
             "property float x\n"
             "property float y\n"
             "property float z\n"
             "element face %d\n"
             "property list uchar int vertex_indices\n"
-            "end_header\n",X.size(),nfaces);
-  for (const auto& x : X) {
-    const auto y = to_little_endian(Vector<float,3>(x));
-    fwrite(&y,sizeof(y),1,f);
-  }
+            "end_header\n",(long long)X.size(),nfaces);
+  write_ply_vertices(f,X);
 }
 
 static void write_ply(const string& filename, RawArray<const Vector<int,3>> tris, RawArray<const TV> X) {
   File f(filename,"wb");
   write_ply_helper(f,tris.size(),X);
-  for (const Vector<int,3>& t : tris) {
-    const uint8_t n = 3;
-    fwrite(&n,1,1,f);
-    fwrite(&to_little_endian(t),sizeof(t),1,f);
-  }
+  write_ply_triangles(f,tris);
 }
 
 static void write_ply(const string& filename, const PolygonSoup& soup, RawArray<const TV> X) {
@@ -779,6 +1360,156 @@ static void write_x3d(const string& filename, const PolygonSoup& soup, RawArray<
   },X);
 }
 
+MeshWriter::MeshWriter(const string& filename)
+  : filename(filename)
+  , vertices_(0)
+  , triangles_(0)
+  , closed(false) {}
+
+MeshWriter::~MeshWriter() {}
+
+void MeshWriter::write(RawArray<const TV> X, RawArray<const Vector<int,3>> tris) {
+  if (closed)
+    throw ValueError(format("MeshWriter: %s is already closed",filename));
+  const int nv = vertices_+X.size();
+  for (const auto& t : tris)
+    for (const int v : t)
+      if (unsigned(v) >= unsigned(nv))
+        throw ValueError(format("MeshWriter: triangle vertex %d out of valid range [0,%d)",v,nv));
+  add(X,tris);
+  vertices_ = nv;
+  triangles_ += tris.size();
+}
+
+void MeshWriter::close() {
+  if (!closed) {
+    closed = true;
+    finish();
+  }
+}
+
+void MeshWriter::close_quietly() {
+  try {
+    close();
+  } catch (const std::exception& e) {
+    Log::cerr << format("MeshWriter: failed to finish %s: %s",filename,e.what()) << std::endl;
+  }
+}
+
+Ref<MeshWriter> MeshWriter::enter() {
+  return ref(*this);
+}
+
+void MeshWriter::exit(PyObject* type, PyObject* value, PyObject* traceback) {
+  close();
+}
+
+namespace {
+struct StlWriter : public MeshWriter {
+  GEODE_NEW_FRIEND
+  File f;
+  Array<Vector<float,3>> X; // Triangles may refer to any earlier vertex, so we keep them all
+protected:
+  StlWriter(const string& filename)
+    : MeshWriter(filename)
+    , f(filename,"wb") {
+    fprintf(f,"%-79s\n","Binary STL triangle mesh: http://en.wikipedia.org/wiki/STL_file");
+    const uint32_t count = 0; // Filled in by finish
+    fwrite(&count,sizeof(count),1,f);
+  }
+public:
+  ~StlWriter() {
+    close_quietly();
+  }
+protected:
+  void add(RawArray<const TV> X, RawArray<const Vector<int,3>> tris) {
+    for (const auto& x : X)
+      this->X.append(Vector<float,3>(x));
+    write_stl_triangles(f,tris,this->X.raw());
+  }
+
+  void finish() {
+    const uint32_t count = to_little_endian(uint32_t(triangles_));
+    fseek(f,80,SEEK_SET);
+    fwrite(&count,sizeof(count),1,f);
+    fflush(f);
+  }
+};
+
+struct ObjWriter : public MeshWriter {
+  GEODE_NEW_FRIEND
+  File f;
+protected:
+  ObjWriter(const string& filename)
+    : MeshWriter(filename)
+    , f(filename,"wb") {
+    write_obj_header(f);
+  }
+public:
+  ~ObjWriter() {
+    close_quietly();
+  }
+protected:
+  void add(RawArray<const TV> X, RawArray<const Vector<int,3>> tris) {
+    for (const auto x : X)
+      fprintf(f,"v %g %g %g\n",x.x,x.y,x.z);
+    for (const auto t : tris)
+      fprintf(f,"f %d %d %d\n",t.x+1,t.y+1,t.z+1);
+  }
+
+  void finish() {
+    fflush(f);
+  }
+};
+
+struct PlyWriter : public MeshWriter {
+  GEODE_NEW_FRIEND
+  File f, faces; // Faces must follow all vertices, so we spool them to a temporary file until finish
+  long counts; // Offset of the element count lines, which are rewritten by finish
+protected:
+  PlyWriter(const string& filename)
+    : MeshWriter(filename)
+    , f(filename,"wb") {
+    fputs("ply\n"
+          "format binary_little_endian 1.0\n"
+          "comment Binary .ply file: http://en.wikipedia.org/wiki/PLY_(file_format)\n",f);
+    counts = ftell(f);
+    header();
+  }
+public:
+  ~PlyWriter() {
+    close_quietly();
+  }
+protected:
+  // Fixed width counts let us rewrite the header in place
+  void header() {
+    fprintf(f,"element vertex %10d\n"
+              "property float x\n"
+              "property float y\n"
+              "property float z\n"
+              "element face %10d\n"
+              "property list uchar int vertex_indices\n"
+              "end_header\n",vertices_,triangles_);
+  }
+
+  void add(RawArray<const TV> X, RawArray<const Vector<int,3>> tris) {
+    write_ply_vertices(f,X);
+    write_ply_triangles(faces,tris);
+  }
+
+  void finish() {
+    fseek(faces,0,SEEK_SET);
+    char buffer[1<<16];
+    while (const size_t n = fread(buffer,1,sizeof(buffer),faces))
+      if (fwrite(buffer,1,n,f) < n)
+        throw IOError(format("failed to write ply file %s: %s",filename,strerror(errno)));
+    fseek(f,counts,SEEK_SET);
+    header();
+    fflush(f);
+  }
+};
+}
+
 static Tuple<Ref<TriangleSoup>,Array<TV>> convert(const Tuple<Ref<PolygonSoup>,Array<TV>>& d) {
   return tuple(d.x->triangle_mesh(),d.y);
 }
@@ -805,6 +1536,298 @@ Tuple<Ref<PolygonSoup>,Array<TV>> read_polygon_soup(const string& filename) {
     throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
 }
 
+Ref<MeshReader> mesh_reader(const string& filename, const int batch_size, const real weld) {
+  if (weld < 0)
+    throw ValueError(format("mesh_reader: expected nonnegative weld distance, got %g",weld));
+  const auto ext = path::extension(filename);
+  if      (ext == ".stl") return stl_reader(filename,batch_size,weld);
+  else if (ext == ".obj") return new_<ObjReader>(filename,batch_size);
+  else if (ext == ".ply") return new_<PlyReader>(filename,batch_size);
+  else
+    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
+}
+
+Ref<MeshWriter> mesh_writer(const string& filename) {
+  const auto ext = path::extension(filename);
+  if      (ext == ".stl") return new_<StlWriter>(filename);
+  else if (ext == ".obj") return new_<ObjWriter>(filename);
+  else if (ext == ".ply") return new_<PlyWriter>(filename);
+  else
+    throw ValueError(format("unsupported mesh filename '%s', expected one of .stl, .obj, .ply",filename));
+}
+
+// Decode a binary stl straight from the mapping, welding identical positions
+static Tuple<Ref<TriangleSoup>,Array<const Vector<float,3>>> map_stl(const Ref<MappedFile>& file) {
+  if (file->size < 84)
+    throw IOError(format("invalid binary stl '%s': incomplete header",file->filename));
+  uint32_t count;
+  memcpy(&count,file->data+80,sizeof(count));
+  if (count > (1u<<31)/3-1)
+    throw IOError(format("binary stl has too many triangles: %u > 2^31/3-1",count));
+  if ((file->size-84)/sizeof(StlTri) < count)
+    throw IOError(format("invalid binary stl '%s': failed to read triangles",file->filename));
+  Hashtable<Vector<float,3>,int> id;
+  Array<Vector<int,3>> tris(count,uninit);
+  Array<Vector<float,3>> X;
+  const char* p = file->data+84;
+  for (auto& tri : tris) {
+    StlTriData d;
+    memcpy(&d,p,sizeof(d));
+    p += sizeof(StlTri);
+    for (int a=0;a<3;a++) {
+      const int i = id.get_or_insert(d.x[a],X.size());
+      if (i == X.size())
+        X.append(d.x[a]);
+      tri[a] = i;
+    }
+  }
+  return tuple(new_<TriangleSoup>(tris,X.size()),Array<const Vector<float,3>>(X));
+}
+
+// Decode a native endian binary ply from the mapping.  Vertices are viewed in place if they are exactly float x,y,z.
+static Tuple<Ref<TriangleSoup>,Array<const Vector<float,3>>> map_ply(const Ref<MappedFile>& file) {
+  const string& filename = file->filename;
+  Line line;
+  try {
+    // Parse the header through stdio, then switch to the mapping
+    vector<Ref<PlyElement>> elements;
+    Hashtable<string,Ref<PlyElement>> element_names;
+    long start;
+    {
+      File f(filename,"rb");
+      const int fmt = read_ply_header(f,line,elements,element_names,0);
+      #if GEODE_ENDIAN == GEODE_LITTLE_ENDIAN
+        if (fmt != 2)
+      #else
+        if (fmt != 3)
+      #endif
+          throw IOError("memory mapping requires native endian binary ply");
+      start = ftell(f);
+    }
+    if (!element_names.contains("vertex"))
+      throw IOError("missing vertex element");
+    if (!element_names.contains("face"))
+      throw IOError("missing face element");
+    const auto& vertex = *element_names.get("vertex");
+    const auto& face = *element_names.get("face");
+    const auto& indices = ply_face_vertices(face);
+    int x[3];
+    for (const int i : range(3)) {
+      const string c(1,"xyz"[i]);
+      if (!vertex.prop_names.contains(c))
+        throw IOError(format("vertex element missing property %s",c));
+      const auto prop = vertex.prop_names.get(c);
+      if (!dynamic_cast<PlyPropSingle<float>*>(&*prop) && !dynamic_cast<PlyPropSingle<double>*>(&*prop))
+        throw IOError(format("vertex.%s has invalid type %s",c,prop->type()));
+      x[i] = int(std::find(vertex.props.begin(),vertex.props.end(),prop)-vertex.props.begin());
+    }
+    const bool direct = vertex.props.size()==3 && x[0]==0 && x[1]==1 && x[2]==2
+                     && dynamic_cast<PlyPropSingle<float>*>(&*vertex.props[0])
+                     && dynamic_cast<PlyPropSingle<float>*>(&*vertex.props[1])
+                     && dynamic_cast<PlyPropSingle<float>*>(&*vertex.props[2]);
+
+    // Walk the elements
+    const char* p = file->data+start;
+    const char* const end = file->data+file->size;
+    Array<const Vector<float,3>> X;
+    Array<Vector<int,3>> tris;
+    for (const auto& E : elements) {
+      if (&*E==&vertex && direct && size_t(p)%std::alignment_of<Vector<float,3>>::value==0) {
+        // View vertices in place
+        X = mapped_view<const Vector<float,3>>(file,p-file->data,E->count);
+        p += sizeof(Vector<float,3>)*E->count;
+      } else if (&*E==&vertex) {
+        Array<Vector<float,3>> Y(E->count,uninit);
+        for (auto& y : Y)
+          for (const int j : range(int(E->props.size()))) {
+            const char* q = E->props[j]->skip_binary(p,end);
+            for (const int i : range(3))
+              if (x[i]==j) {
+                if (q-p==int(sizeof(float)))
+                  memcpy(&y[i],p,sizeof(float));
+                else {
+                  double d;
+                  memcpy(&d,p,sizeof(double));
+                  y[i] = float(d);
+                }
+              }
+            p = q;
+          }
+        X = Y;
+      } else if (&*E==&face) {
+        tris.preallocate(E->count);
+        Array<int> poly;
+        for (const int f : range(E->count))
+          for (const auto& prop : E->props) {
+            const char* q = prop->skip_binary(p,end);
+            if (&*prop == &indices) {
+              const int n = uint8_t(*p);
+              poly.resize(n,uninit);
+              memcpy(poly.data(),p+1,n*sizeof(int));
+              for (const int v : poly)
+                if (unsigned(v) >= unsigned(vertex.count))
+                  throw IOError(format("face %d vertex %d out of valid range [0,%d)",f,v,vertex.count));
+              for (int i=0;i<n-2;i++)
+                tris.append(vec(poly[0],poly[i+1],poly[i+2]));
+            }
+            p = q;
+          }
+      } else
+        for (int r=0;r<E->count;r++)
+          for (const auto& prop : E->props)
+            p = prop->skip_binary(p,end);
+    }
+    return tuple(new_<TriangleSoup>(tris,X.size()),X);
+  } catch (const IOError& e) {
+    throw IOError(format("invalid ply file %s: %s",filename,e.what()));
+  }
+}
+
+Tuple<Ref<TriangleSoup>,Array<const Vector<float,3>>> map_soup(const string& filename) {
+  const auto ext = path::extension(filename);
+  if (ext == ".stl") {
+    if (!is_binary(filename))
+      throw IOError(format("map_soup: '%s' is an ascii stl, which can't be mapped; use read_soup",filename));
+    return map_stl(new_<MappedFile>(filename));
+  } else if (ext == ".ply")
+    return map_ply(new_<MappedFile>(filename));
+  else
+    throw ValueError(format("unsupported mapped mesh filename '%s', expected .stl or .ply",filename));
+}
+
+namespace {
+// Header of geode's native binary mesh format.  The raw arrays of a TriangleTopology and its vertex positions follow
+// in native byte order at 64 byte aligned offsets, in the order faces_, vertex_to_edge_, boundaries_, X.
+struct NativeMeshHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian; // 0x01020304 in the writer's byte order
+  uint32_t scalar; // sizeof(real)
+  int32_t n_vertices, n_faces, n_boundary_edges, erased_boundaries;
+  int32_t faces, vertices, boundaries; // Allocated array sizes, including erased entries
+};
+}
+static const char native_magic[8] = {'g','e','o','d','e','m','s','h'};
+
+static size_t native_align(const size_t offset) {
+  return (offset+63)&~size_t(63);
+}
+
+// Byte offsets of faces_, vertex_to_edge_, boundaries_, X, and the end of the file
+static Vector<size_t,5> native_offsets(const NativeMeshHeader& h) {
+  Vector<size_t,5> offsets;
+  offsets[0] = native_align(sizeof(NativeMeshHeader));
+  offsets[1] = native_align(offsets[0]+size_t(h.faces)*sizeof(TriangleTopology::FaceInfo));
+  offsets[2] = native_align(offsets[1]+size_t(h.vertices)*sizeof(HalfedgeId));
+  offsets[3] = native_align(offsets[2]+size_t(h.boundaries)*sizeof(TriangleTopology::BoundaryInfo));
+  offsets[4] = offsets[3]+size_t(h.vertices)*sizeof(TV);
+  return offsets;
+}
+
+void write_native_mesh(const string& filename, const TriangleTopology& mesh, RawField<const TV,VertexId> X) {
+  if (X.size() != mesh.allocated_vertices())
+    throw ValueError(format("write_native_mesh: expected %d vertex positions, got %d",mesh.allocated_vertices(),int(X.size())));
+  NativeMeshHeader h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,native_magic,sizeof(h.magic));
+  h.version = 1;
+  h.endian = 0x01020304;
+  h.scalar = sizeof(real);
+  h.n_vertices = mesh.n_vertices_;
+  h.n_faces = mesh.n_faces_;
+  h.n_boundary_edges = mesh.n_boundary_edges_;
+  h.erased_boundaries = mesh.erased_boundaries_.id;
+  h.faces = mesh.faces_.size();
+  h.vertices = mesh.vertex_to_edge_.size();
+  h.boundaries = mesh.boundaries_.size();
+  const auto offsets = native_offsets(h);
+
+  File f(filename,"wb");
+  const auto write = [&](const void* data, const size_t offset, const size_t bytes) {
+    static const char zeros[64] = {0};
+    const size_t at = size_t(ftell(f));
+    if (fwrite(zeros,1,offset-at,f) < offset-at || fwrite(data,1,bytes,f) < bytes)
+      throw IOError(format("failed to write %s: %s",filename,strerror(errno)));
+  };
+  write(&h,0,sizeof(h));
+  write(mesh.faces_.flat.data(),offsets[0],mesh.faces_.size()*sizeof(TriangleTopology::FaceInfo));
+  write(mesh.vertex_to_edge_.flat.data(),offsets[1],mesh.vertex_to_edge_.size()*sizeof(HalfedgeId));
+  write(mesh.boundaries_.data(),offsets[2],mesh.boundaries_.size()*sizeof(TriangleTopology::BoundaryInfo));
+  write(X.flat.data(),offsets[3],X.size()*sizeof(TV));
+}
+
+Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>> read_native_mesh(const string& filename) {
+  const auto file = new_<MappedFile>(filename);
+  NativeMeshHeader h;
+  if (file->size < sizeof(h))
+    throw IOError(format("invalid native mesh '%s': incomplete header",filename));
+  memcpy(&h,file->data,sizeof(h));
+  if (memcmp(h.magic,native_magic,sizeof(h.magic)))
+    throw IOError(format("invalid native mesh '%s': bad magic string",filename));
+  if (h.version != 1)
+    throw IOError(format("native mesh '%s' has unsupported version %d",filename,h.version));
+  if (h.endian != 0x01020304 || h.scalar != sizeof(real))
+    throw IOError(format("native mesh '%s' was written on a machine with different byte order or real size",filename));
+  if (h.faces < 0 || h.vertices < 0 || h.boundaries < 0)
+    throw IOError(format("invalid native mesh '%s': negative array sizes",filename));
+  const auto offsets = native_offsets(h);
+  if (file->size < offsets[4])
+    throw IOError(format("invalid native mesh '%s': expected %lld bytes, got %lld",
+      filename,(long long)offsets[4],(long long)file->size));
+
+  // Wrap the mapped arrays without copying
+  const auto mesh = new_<TriangleTopology>();
+  const_cast_(mesh->n_vertices_) = h.n_vertices;
+  const_cast_(mesh->n_faces_) = h.n_faces;
+  const_cast_(mesh->n_boundary_edges_) = h.n_boundary_edges;
+  const_cast_(mesh->erased_boundaries_) = HalfedgeId(h.erased_boundaries);
+  const_cast_(mesh->faces_) = Field<const TriangleTopology::FaceInfo,FaceId>(
+    mapped_view<const TriangleTopology::FaceInfo>(file,offsets[0],h.faces));
+  const_cast_(mesh->vertex_to_edge_) = Field<const HalfedgeId,VertexId>(
+    mapped_view<const HalfedgeId>(file,offsets[1],h.vertices));
+  const_cast_(mesh->boundaries_) = mapped_view<const TriangleTopology::BoundaryInfo>(file,offsets[2],h.boundaries);
+  const Field<const TV,VertexId> X(mapped_view<const TV>(file,offsets[3],h.vertices));
+
+  // Range check every id before handing the arrays to TriangleTopology, which trusts them
+  if (   unsigned(h.n_vertices) > unsigned(h.vertices) || unsigned(h.n_faces) > unsigned(h.faces)
+      || unsigned(h.n_boundary_edges) > unsigned(h.boundaries))
+    throw IOError(format("invalid native mesh '%s': counts exceed array sizes",filename));
+  const auto vertex_ok = [&](const VertexId v) { return unsigned(v.id) < unsigned(h.vertices); };
+  const auto halfedge_ok = [&](const HalfedgeId e) {
+    return e.id>=0 ? unsigned(e.id) < 3*unsigned(h.faces) : unsigned(-1-e.id) < unsigned(h.boundaries); };
+  const auto boundary_ok = [&](const HalfedgeId e) { return e.id<0 && halfedge_ok(e); };
+  const auto invalid = [&](const char* what, const int i) {
+    return IOError(format("invalid native mesh '%s': %s %d has an out of range id",filename,what,i)); };
+  if (mesh->erased_boundaries_.valid() && !boundary_ok(mesh->erased_boundaries_))
+    throw invalid("erased boundary list",0);
+  for (const int f : range(h.faces)) {
+    const auto& F = mesh->faces_.flat[f];
+    if (F.vertices.x.id == erased_id)
+      continue;
+    for (const int i : range(3))
+      if (!vertex_ok(F.vertices[i]) || !halfedge_ok(F.neighbors[i]))
+        throw invalid("face",f);
+  }
+  for (const int v : range(h.vertices)) {
+    const auto e = mesh->vertex_to_edge_.flat[v];
+    if (e.valid() && e.id != erased_id && !halfedge_ok(e))
+      throw invalid("vertex",v);
+  }
+  for (const int b : range(h.boundaries)) {
+    const auto& B = mesh->boundaries_[b];
+    if (B.src.id == erased_id ? B.next.valid() && !boundary_ok(B.next)
+                              : !vertex_ok(B.src) || !boundary_ok(B.prev) || !boundary_ok(B.next)
+                                || !(halfedge_ok(B.reverse) && B.reverse.id>=0))
+      throw invalid("boundary",b);
+  }
+  try {
+    mesh->assert_consistent();
+  } catch (const AssertionError& e) {
+    throw IOError(format("invalid native mesh '%s': inconsistent topology: %s",filename,e.what()));
+  }
+  return Tuple<Ref<const TriangleTopology>,Field<const TV,VertexId>>(mesh,X);
+}
+
 Tuple<Ref<TriangleTopology>,Array<TV>> read_mesh(const string& filename) {
   const auto soup = read_soup(filename);
   return tuple(new_<TriangleTopology>(soup.x),soup.y);
@@ -860,6 +1883,31 @@ static void write_mesh_py(const string& filename, PyObject* mesh, RawArray<const
 using namespace geode;
 
 void wrap_mesh_io() {
+  {
+    typedef MeshReader Self;
+    Class<Self>("MeshReader")
+      .GEODE_FIELD(filename)
+      .GEODE_FIELD(batch_size)
+      .GEODE_METHOD(vertices)
+      .GEODE_METHOD_2("read",read_py)
+      ;
+  } {
+    typedef MeshWriter Self;
+    Class<Self>("MeshWriter")
+      .GEODE_FIELD(filename)
+      .GEODE_METHOD(vertices)
+      .GEODE_METHOD(triangles)
+      .GEODE_METHOD(write)
+      .GEODE_METHOD(close)
+      .GEODE_METHOD_2("__enter__",enter)
+      .GEODE_METHOD_2("__exit__",exit)
+      ;
+  }
+  GEODE_FUNCTION(mesh_reader)
+  GEODE_FUNCTION(mesh_writer)
+  GEODE_FUNCTION(map_soup)
+  GEODE_FUNCTION(write_native_mesh)
+  GEODE_FUNCTION(read_native_mesh)
   GEODE_FUNCTION(read_soup)
   GEODE_FUNCTION(read_polygon_soup)
   GEODE_FUNCTION(read_mesh)
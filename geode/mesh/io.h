@@ -3,6 +3,8 @@
 
 #include <geode/mesh/TriangleSoup.h>
 #include <geode/mesh/TriangleTopology.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ref.h>
 namespace geode {
 
 // Read a mesh format as triangle or polygon soup
@@ -21,4 +23,101 @@ GEODE_EXPORT void write_mesh(const string& filename, const TriangleTopology& mes
 // id and have type Vector<real,3>. 
 GEODE_EXPORT void write_mesh(const string &filename, const MutableTriangleTopology &mesh);
 
+// Memory mapped loading of binary .stl and native endian binary .ply files, with float32 positions.  Ply vertices
+// consisting of exactly float x,y,z are returned as a view into the mapped file, which stays mapped as long as the
+// view exists.  Ply faces and stl triangles interleave other data with their indices, so they are decoded straight
+// from the mapping into new arrays.  Stl vertices are welded as in read_soup.
+GEODE_EXPORT Tuple<Ref<TriangleSoup>,Array<const Vector<float,3>>> map_soup(const string& filename);
+
+// Geode's native binary mesh format stores the raw arrays of a TriangleTopology and its vertex positions (indexed
+// by VertexId, including erased vertices), aligned so that read_native_mesh maps the file and uses the arrays in
+// place with no parsing or copying.  Files are only readable on machines with the same byte order and real size.
+// Reading still makes one validation pass over the topology, so corrupt files raise IOError instead of being trusted.
+GEODE_EXPORT void write_native_mesh(const string& filename, const TriangleTopology& mesh,
+                                    RawField<const Vector<real,3>,VertexId> X);
+GEODE_EXPORT Tuple<Ref<const TriangleTopology>,Field<const Vector<real,3>,VertexId>>
+read_native_mesh(const string& filename);
+
+// Streaming mesh I/O for files too large to hold in memory.
+//
+// A MeshReader reads .stl, .obj, or .ply files in batches of about batch_size vertices plus triangles.  Vertex ids
+// are global across the stream: each batch holds the vertices first seen in that batch, numbered consecutively from
+// vertex_offset, and triangles which may refer to any vertex read so far.  Polygons are split into triangle fans as
+// in PolygonSoup::triangle_mesh.  Obj and ply faces must follow the vertices they use.
+//
+// Stl files store positions per triangle, so their vertices are welded as they are read, using a hash table over
+// positions rounded to a grid of spacing weld (exact positions if weld is zero).  The table is the only state which
+// grows with the file, at one entry per welded vertex.
+
+struct MeshBatch {
+  int vertex_offset; // Global id of X[0]
+  Array<Vector<real,3>> X; // Vertices first read in this batch
+  Array<Vector<int,3>> tris; // Triangles read in this batch, using global vertex ids
+};
+
+class MeshReader : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const string filename;
+  const int batch_size; // Rough bound on vertices plus triangles per batch
+protected:
+  int vertices_; // Vertices read so far
+
+  GEODE_CORE_EXPORT MeshReader(const string& filename, const int batch_size);
+
+  // Read the next batch into empty arrays.  Leaves them empty only at the end of the file.
+  virtual void fill(MeshBatch& batch) = 0;
+public:
+  ~MeshReader();
+
+  int vertices() const { return vertices_; }
+
+  // Read the next batch, returning false at the end of the file
+  GEODE_CORE_EXPORT bool read(MeshBatch& batch);
+
+  // Read the next batch as (X,tris), which are empty at the end of the file
+  Tuple<Array<Vector<real,3>>,Array<Vector<int,3>>> read_py();
+};
+
+// A MeshWriter writes .stl, .obj, or .ply files incrementally.  Each write appends vertices, numbered after those
+// already written, followed by triangles which may refer to any vertex written so far.  Ply faces are spooled to a
+// temporary file until close, and stl writing keeps a float copy of the vertices.  The file is incomplete until
+// close is called.  A writer destroyed while still open closes itself, but can only log errors at that point, so call
+// close explicitly (or use a python with block) to see them.
+class MeshWriter : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const string filename;
+protected:
+  int vertices_, triangles_; // Written so far
+  bool closed;
+
+  GEODE_CORE_EXPORT MeshWriter(const string& filename);
+
+  virtual void add(RawArray<const Vector<real,3>> X, RawArray<const Vector<int,3>> tris) = 0;
+  virtual void finish() = 0;
+
+  // Close if still open, logging any errors.  finish is virtual, so subclass destructors must call this.
+  void close_quietly();
+public:
+  ~MeshWriter();
+
+  int vertices() const { return vertices_; }
+  int triangles() const { return triangles_; }
+
+  GEODE_CORE_EXPORT void write(RawArray<const Vector<real,3>> X, RawArray<const Vector<int,3>> tris);
+  GEODE_CORE_EXPORT void close();
+
+  // Context manager support: "with mesh_writer(filename) as writer:" closes the writer at the end of the block
+  Ref<MeshWriter> enter();
+  void exit(PyObject* type, PyObject* value, PyObject* traceback);
+};
+
+GEODE_EXPORT Ref<MeshReader> mesh_reader(const string& filename, const int batch_size=1<<16, const real weld=0);
+GEODE_EXPORT Ref<MeshWriter> mesh_writer(const string& filename);
+
 }
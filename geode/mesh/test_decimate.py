@@ -24,12 +24,18 @@ def test_decimate():
     mesh,X = loop_subdivide(mesh,X,steps=steps)
     mesh = TriangleTopology(mesh)
     def test(distance,boundary_distance=0):
-      md,Xd = decimate(mesh,X,distance=distance,boundary_distance=boundary_distance)
-      H = hausdorff((mesh,X),(md,Xd))
-      Hb = hausdorff((mesh,X),(md,Xd),boundary=1)
-      print('distance %g, boundary %g, H %g, Hb %g'%(distance,boundary_distance,H,Hb))
-      assert H<=distance
-      assert Hb<=boundary_distance
+      counts = []
+      for parallel in 0,1:
+        md,Xd = decimate(mesh,X,distance=distance,boundary_distance=boundary_distance,parallel=parallel)
+        H = hausdorff((mesh,X),(md,Xd))
+        Hb = hausdorff((mesh,X),(md,Xd),boundary=1)
+        print('distance %g, boundary %g, parallel %d, vertices %d, H %g, Hb %g'
+              %(distance,boundary_distance,parallel,md.n_vertices,H,Hb))
+        assert H<=distance
+        assert Hb<=boundary_distance
+        counts.append(md.n_vertices)
+      # Batched collapses should reach roughly the same resolution as the serial heap
+      assert counts[1]<=1.5*counts[0]+4
     test(distance=.01)
     test(distance=.05,boundary_distance=.02)
     test(distance=3,boundary_distance=.1)
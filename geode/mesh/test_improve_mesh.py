@@ -0,0 +1,36 @@
+#!/usr/bin/env python
+
+from __future__ import division,print_function
+from geode import *
+from geode.geometry.platonic import sphere_mesh
+import sys
+
+def sqr_magnitude(x):
+  return (x*x).sum(axis=-1)
+
+def qualities(mesh):
+  X = mesh.vertex_field(vertex_position_id)
+  x0,x1,x2 = X[mesh.elements().T]
+  area = magnitude(cross(x1-x0,x2-x0),axis=-1)/2
+  lrms2 = (sqr_magnitude(x1-x0)+sqr_magnitude(x2-x0)+sqr_magnitude(x2-x1))/3
+  return area/lrms2/(sqrt(3)/4)
+
+def test_improve_mesh(benchmark=False):
+  random.seed(81311)
+  soup,X = sphere_mesh(6 if benchmark else 3)
+  X = X+.3*magnitude(X[soup.elements[0,0]]-X[soup.elements[0,1]])*random.randn(*X.shape)
+  before = qualities(meshify(soup,X))
+  for parallel in 0,1:
+    with Log.scope('improve mesh, parallel %d'%parallel):
+      improved = improve_mesh(meshify(soup,X),min_quality=.4,max_distance=.1,max_silhouette_distance=.1,
+                              parallel=parallel)
+    improved.assert_consistent(True)
+    after = qualities(improved)
+    print('parallel %d: faces %d -> %d, min quality %g -> %g'
+          %(parallel,len(before),len(after),before.min(),after.min()))
+    assert after.min()>before.min()
+    assert (after<.4).sum()<(before<.4).sum()
+
+if __name__=='__main__':
+  Log.configure('improve mesh',0,0,100)
+  test_improve_mesh(benchmark='-b' in sys.argv)
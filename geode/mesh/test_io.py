@@ -2,7 +2,9 @@
 
 from __future__ import division,print_function,unicode_literals
 from geode import *
+from geode.geometry.platonic import *
 import hashlib
+import struct
 
 def test_io():
   soup = TriangleSoup([(0,1,2),(2,3,4)])
@@ -105,5 +107,142 @@ end_header
       open(f.name,'w').write(ascii[ext])
       check_read()
 
+def test_stream():
+  random.seed(8123)
+  soup = TriangleSoup(random.randint(0,40,size=(100,3)).astype(int32))
+  X = random.randint(-100,100,size=(40,3))/8
+  for ext in '.stl .obj .ply'.split():
+    f = named_tmpfile(suffix=ext)
+    # Write in several pieces, each adding vertices and triangles which use any earlier vertex
+    writer = mesh_writer(f.name)
+    v = soup.elements.max(axis=1)
+    for lo,hi in (0,10),(10,25),(25,40):
+      writer.write(X[lo:hi],soup.elements[(lo<=v)&(v<hi)])
+    order = argsort(digitize(v,[10,25]),kind='mergesort')
+    writer.close()
+    assert writer.vertices()==len(X)
+    assert writer.triangles()==len(soup.elements)
+    soup2,X2 = read_soup(f.name)
+    for batch_size in 1,7,1<<16:
+      batches = list(stream_mesh(f.name,batch_size))
+      assert batch_size>=len(X)+len(soup.elements) or len(batches)>1
+      X3 = concatenate([b[0] for b in batches])
+      tris3 = concatenate([b[1] for b in batches])
+      assert all(X2==X3)
+      assert all(soup2.elements==tris3)
+      assert all(X3[tris3]==X[soup.elements[order]])
+      if ext!='.stl':
+        assert all(X==X3)
+        assert all(soup.elements[order]==tris3)
+
+  # Rows of other ply elements don't count toward the batch size, so a large element between vertices and faces
+  # can't produce an empty batch before the faces
+  f = named_tmpfile(suffix='.ply')
+  open(f.name,'w').write('ply\nformat ascii 1.0\nelement vertex 3\nproperty double x\nproperty double y\nproperty double z\n'
+                         'element edge 20\nproperty int vertex1\nproperty int vertex2\n'
+                         'element face 2\nproperty list uchar int vertex_indices\nend_header\n'
+                         '0 0 0\n1 0 0\n0 1 0\n'+'0 1\n'*20+'3 0 1 2\n3 0 2 1\n')
+  for batch_size in 1,7,1<<16:
+    batches = list(stream_mesh(f.name,batch_size))
+    assert all(len(X)+len(tris) for X,tris in batches)
+    assert all(concatenate([b[1] for b in batches])==[(0,1,2),(0,2,1)])
+
+  # Welding merges nearby stl vertices
+  f = named_tmpfile(suffix='.stl')
+  writer = mesh_writer(f.name)
+  writer.write(asarray([(0,0,0),(1,0,0),(0,1,0),(1,1,0),(1.001,0,0),(0,1.001,0)]),asarray([(0,1,2),(3,5,4)],dtype=int32))
+  writer.close()
+  assert len(concatenate([b[0] for b in stream_mesh(f.name)]))==6
+  welded = list(stream_mesh(f.name,weld=.01))
+  assert len(welded)==1
+  assert len(welded[0][0])==4
+  assert all(welded[0][1]==[(0,1,2),(3,2,1)])
+
+  # A with block closes the writer, and a writer dropped without close finishes the file on destruction
+  for ext in '.stl .obj .ply'.split():
+    f = named_tmpfile(suffix=ext)
+    with mesh_writer(f.name) as writer:
+      writer.write(X,soup.elements)
+    soup2,X2 = read_soup(f.name)
+    assert all(X2[soup2.elements]==X[soup.elements])
+    writer = mesh_writer(f.name)
+    writer.write(X,soup.elements)
+    del writer
+    soup2,X2 = read_soup(f.name)
+    assert all(X2[soup2.elements]==X[soup.elements])
+
+def test_mapped():
+  soup,X = sphere_mesh(1)
+  mesh = TriangleTopology(soup)
+  soup = TriangleSoup(mesh.elements())
+  X = (8*X).astype(float32).astype(float64)
+  for ext in '.stl','.ply':
+    f = named_tmpfile(suffix=ext)
+    write_mesh(f.name,soup,X)
+    soup2,X2 = read_soup(f.name)
+    soup3,X3 = map_soup(f.name)
+    assert X3.dtype==float32
+    assert all(soup2.elements==soup3.elements)
+    assert all(X2==X3)
+
+  # Native meshes round trip without parsing
+  f = named_tmpfile(suffix='.gmesh')
+  write_native_mesh(f.name,mesh,X)
+  mesh2,X2 = read_native_mesh(f.name)
+  mesh2.assert_consistent(True)
+  assert mesh2.n_vertices==mesh.n_vertices
+  assert all(mesh2.elements()==mesh.elements())
+  assert all(X2==X)
+
+  # Corrupt counts and ids are rejected instead of trusted.  The header is 48 bytes, with n_faces at byte 24, and the
+  # face array starts at byte 64 with the first vertex of face 0.
+  data = bytearray(open(f.name,'rb').read())
+  for offset,value in (24,1<<20),(64,1<<20),(64,-5):
+    bad = data[:]
+    struct.pack_into(str('i'),bad,offset,value)
+    g = named_tmpfile(suffix='.gmesh')
+    open(g.name,'wb').write(bad)
+    try:
+      read_native_mesh(g.name)
+      assert False
+    except IOError:
+      pass
+
+def test_parallel_ascii():
+  # Large enough to split into several chunks
+  random.seed(1731)
+  n = 100000
+  X = random.randn(n,3)
+  X[::3] = around(X[::3],3)
+  tris = random.randint(0,n,size=(n,3)).astype(int32)
+  lines = dict(v='\n'.join('v %r %r %r'%tuple(x) for x in X),
+               f='\n'.join('f %d %d %d'%tuple(t+1) for t in tris),
+               xyz='\n'.join('%r %r %r'%tuple(x) for x in X),
+               tris='\n'.join('3 %d %d %d'%tuple(t) for t in tris))
+  text = {'.obj':'# big\n%(v)s\n%(f)s\n'%lines,
+          '.ply':'ply\nformat ascii 1.0\nelement vertex %d\nproperty double x\nproperty double y\nproperty double z\n'
+                 'element face %d\nproperty list uchar int vertex_indices\nend_header\n%s\n%s'%(n,n,lines['xyz'],lines['tris'])}
+  for ext in '.obj','.ply':
+    f = named_tmpfile(suffix=ext)
+    open(f.name,'w').write(text[ext])
+    soup,X2 = read_soup(f.name)
+    assert all(X==X2)
+    assert all(soup.elements==tris)
+
+    # Errors report the first bad line in the file
+    bad = text[ext].split('\n')
+    first = len(bad)-n//2
+    bad[first] = bad[first-1] = 'v 1 2 x' if ext=='.obj' else '1 2 x'
+    bad[-3] = bad[first]
+    open(f.name,'w').write('\n'.join(bad))
+    try:
+      read_soup(f.name)
+      assert False
+    except IOError as e:
+      assert ':%d:'%first in str(e)
+
 if __name__=='__main__':
   test_io()
+  test_stream()
+  test_mapped()
+  test_parallel_ascii()
@@ -2,15 +2,314 @@
 // Class Buffer
 //#####################################################################
 #include <geode/python/Buffer.h>
-using namespace geode;
+#include <geode/math/integer_log.h>
+#include <geode/python/exceptions.h>
+#include <geode/python/stl.h>
+#include <geode/python/wrap.h>
+#include <geode/utility/format.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <string.h>
+#ifdef __clang__
+#include <pthread.h>
+#endif
+namespace geode {
+
+using std::vector;
+
+// Each buffer is immediately preceded by a header recording where it came from, so that buffers can be freed
+// correctly regardless of the current backend or thread.
+namespace {
+enum { malloc_kind, pool_kind, arena_kind };
+struct Header {
+  void* owner; // The start of the malloc block, or the arena chunk
+  size_t bytes;
+  int kind;
+  int size_class;
+};
+const size_t header_size = 32; // Keeps data 16 byte aligned relative to the header
+static_assert(sizeof(Header)<=header_size,"Header is too large");
+const size_t prefix = header_size+offsetof(Buffer,data);
+
+// Pool size class c holds up to 64<<c bytes.  Blocks are sized for the maximum alignment so that they can be reused
+// after the alignment changes.
+const int pool_classes = 15;
+const size_t max_alignment = 64;
+const size_t pool_cache_bytes = 1<<20; // Per size class and thread
+
+struct ThreadBuffers {
+  BufferStats stats;
+  void* cache[pool_classes]; // Free blocks, linked through their first word
+  size_t cached[pool_classes];
+};
+}
+
+// While a chunk is being filled, its reference count is biased by arena_bias so that frees on other threads never
+// reach zero, and allocations and frees on the arena's thread adjust ArenaScope::pending without atomics.  Once the
+// arena moves on, the bias is replaced by pending, leaving the exact number of live buffers.
+struct ArenaChunk {
+  std::atomic<int64_t> refs;
+};
+const int64_t arena_bias = int64_t(1)<<60;
+
+static BufferBackend backend = malloc_backend;
+static size_t alignment = 16;
+static GEODE_THREAD_LOCAL ThreadBuffers* thread_buffers = 0;
+static GEODE_THREAD_LOCAL ArenaScope* thread_arena = 0;
+
+namespace {
+// Per-thread blocks are allocated on first use, and never freed so that counts survive thread exit.  Pool caches are
+// freed at thread exit, however.
+struct Registry {
+  std::mutex mutex;
+  vector<ThreadBuffers*> threads;
+};
+static Registry& registry() {
+  static Registry registry;
+  return registry;
+}
+}
 
-// Must match memory allocation routine in header
-#ifndef _WIN32
-#define free_buffer free
+static void trim(ThreadBuffers& T) {
+  for (int c=0;c<pool_classes;c++) {
+    while (const auto block = T.cache[c]) {
+      T.cache[c] = *(void**)block;
+      free(block);
+    }
+    T.cached[c] = 0;
+  }
+}
+
+// Free a thread's pool cache as the thread exits.  Every size class is then marked full, so that pool blocks freed
+// later in thread teardown go straight back to malloc.
+static void thread_exit(void* buffers) {
+  auto& T = *(ThreadBuffers*)buffers;
+  trim(T);
+  for (int c=0;c<pool_classes;c++)
+    T.cached[c] = size_t(-1);
+}
+
+#ifdef __clang__
+// GEODE_THREAD_LOCAL is __thread under clang, which has no destructors, so we use a pthread key instead
+static pthread_key_t exit_key;
+static void at_thread_exit(ThreadBuffers* buffers) {
+  static std::once_flag once;
+  std::call_once(once,[](){ pthread_key_create(&exit_key,thread_exit); });
+  pthread_setspecific(exit_key,buffers);
+}
 #else
-#define free_buffer _aligned_free
+namespace {
+struct ExitGuard {
+  ThreadBuffers* buffers;
+  ~ExitGuard() {
+    if (buffers)
+      thread_exit(buffers);
+  }
+};
+}
+static thread_local ExitGuard exit_guard;
+static void at_thread_exit(ThreadBuffers* buffers) {
+  exit_guard.buffers = buffers;
+}
 #endif
 
+static ThreadBuffers& new_thread_buffers() {
+  auto buffers = new ThreadBuffers;
+  memset(buffers,0,sizeof(ThreadBuffers));
+  auto& R = registry();
+  {
+    std::lock_guard<std::mutex> lock(R.mutex);
+    R.threads.push_back(buffers);
+  }
+  at_thread_exit(buffers);
+  return *(thread_buffers = buffers);
+}
+
+static inline ThreadBuffers& local_buffers() {
+  const auto buffers = thread_buffers;
+  return buffers ? *buffers : new_thread_buffers();
+}
+
+static inline size_t pool_limit(const int c) {
+  return std::max(size_t(2),pool_cache_bytes>>(6+c));
+}
+
+static inline Header& header(Buffer* self) {
+  return *(Header*)((char*)self-header_size);
+}
+
+static char* system_malloc(ThreadBuffers& T, const size_t size) {
+  const auto start = (char*)malloc(size);
+  if (!start)
+    throw std::bad_alloc();
+  T.stats.mallocs++;
+  T.stats.malloc_bytes += size;
+  return start;
+}
+
+static inline char* align_up(char* p, const size_t alignment) {
+  return (char*)(((uintptr_t)p+alignment-1)&~(uintptr_t)(alignment-1));
+}
+
+// Initialize a buffer whose data starts at the given aligned address
+static inline Buffer* place_buffer(char* data, void* owner, const size_t bytes, const int kind, const int size_class) {
+  const auto self = (Buffer*)(data-offsetof(Buffer,data));
+  auto& H = header(self);
+  H.owner = owner;
+  H.bytes = bytes;
+  H.kind = kind;
+  H.size_class = size_class;
+  return GEODE_PY_OBJECT_INIT(self,&Buffer::pytype);
+}
+
+Buffer* Buffer::allocate(const size_t bytes) {
+  auto& T = local_buffers();
+  T.stats.calls++;
+  T.stats.bytes += bytes;
+  const size_t alignment = geode::alignment;
+
+  // Carve small buffers out of the current arena chunk
+  if (const auto arena = thread_arena) {
+    if (bytes <= arena->chunk_bytes/4) {
+      char* data = arena->next ? align_up(arena->next+prefix,alignment) : 0;
+      if (!data || data+bytes > arena->end) {
+        if (arena->chunk)
+          arena->retire();
+        const auto chunk = (ArenaChunk*)system_malloc(T,arena->chunk_bytes);
+        new(&chunk->refs) std::atomic<int64_t>(arena_bias);
+        arena->chunk = chunk;
+        arena->end = (char*)chunk+arena->chunk_bytes;
+        data = align_up((char*)(chunk+1)+prefix,alignment);
+      }
+      arena->next = data+bytes;
+      arena->pending++;
+      T.stats.arena_calls++;
+      T.stats.arena_bytes += bytes;
+      return place_buffer(data,arena->chunk,bytes,arena_kind,0);
+    }
+  }
+
+  // Reuse a cached block of the right size class if possible
+  if (backend==pool_backend && bytes<=size_t(64)<<(pool_classes-1)) {
+    const int c = bytes<=64 ? 0 : integer_log(uint64_t(bytes-1))-5;
+    auto start = (char*)T.cache[c];
+    if (start) {
+      T.cache[c] = *(void**)start;
+      T.cached[c]--;
+      T.stats.pool_hits++;
+    } else
+      start = system_malloc(T,(size_t(64)<<c)+prefix+max_alignment-1);
+    return place_buffer(align_up(start+prefix,alignment),start,bytes,pool_kind,c);
+  }
+
+  const auto start = system_malloc(T,bytes+prefix+alignment-1);
+  return place_buffer(align_up(start+prefix,alignment),start,bytes,malloc_kind,0);
+}
+
+static inline void release(ArenaChunk* chunk, const int64_t count) {
+  if (chunk->refs.fetch_sub(count,std::memory_order_acq_rel)==count)
+    free(chunk);
+}
+
+void ArenaScope::retire() {
+  release(chunk,arena_bias-pending);
+  chunk = 0;
+  next = end = 0;
+  pending = 0;
+}
+
+void Buffer::deallocate(PyObject* object) {
+  // Read the header before anything is written to the block, since the two may overlap
+  const auto& H = header((Buffer*)object);
+  const auto owner = H.owner;
+  const auto bytes = H.bytes;
+  const int kind = H.kind,
+            c = H.size_class;
+  auto& T = local_buffers();
+  T.stats.frees++;
+  T.stats.freed_bytes += bytes;
+  if (kind==pool_kind && T.cached[c]<pool_limit(c)) {
+    *(void**)owner = T.cache[c];
+    T.cache[c] = owner;
+    T.cached[c]++;
+  } else if (kind==arena_kind) {
+    const auto arena = thread_arena;
+    if (arena && arena->chunk==owner)
+      arena->pending--;
+    else
+      release((ArenaChunk*)owner,1);
+  } else
+    free(owner);
+}
+
+void set_buffer_backend(const BufferBackend backend, const int alignment) {
+  if (!(alignment==16 || alignment==32 || alignment==64))
+    throw ValueError(format("set_buffer_backend: alignment must be 16, 32, or 64, got %d",alignment));
+  geode::backend = backend;
+  geode::alignment = alignment;
+}
+
+BufferBackend buffer_backend() {
+  return backend;
+}
+
+int buffer_alignment() {
+  return int(alignment);
+}
+
+void trim_buffer_pool() {
+  trim(local_buffers());
+}
+
+ArenaScope::ArenaScope(const size_t chunk_bytes)
+  : previous(thread_arena)
+  , chunk_bytes(std::max(chunk_bytes,size_t(4096)))
+  , chunk(0)
+  , next(0)
+  , end(0)
+  , pending(0) {
+  thread_arena = this;
+}
+
+ArenaScope::~ArenaScope() {
+  assert(thread_arena==this);
+  thread_arena = previous;
+  if (chunk)
+    retire();
+}
+
+BufferStats buffer_stats() {
+  auto& R = registry();
+  std::lock_guard<std::mutex> lock(R.mutex);
+  BufferStats total;
+  memset(&total,0,sizeof(BufferStats));
+  for (const auto buffers : R.threads) {
+    const auto& S = buffers->stats;
+    total.calls += S.calls;
+    total.bytes += S.bytes;
+    total.frees += S.frees;
+    total.freed_bytes += S.freed_bytes;
+    total.mallocs += S.mallocs;
+    total.malloc_bytes += S.malloc_bytes;
+    total.pool_hits += S.pool_hits;
+    total.arena_calls += S.arena_calls;
+    total.arena_bytes += S.arena_bytes;
+  }
+  return total;
+}
+
+void clear_buffer_stats() {
+  auto& R = registry();
+  std::lock_guard<std::mutex> lock(R.mutex);
+  for (const auto buffers : R.threads)
+    memset(&buffers->stats,0,sizeof(BufferStats));
+}
+
 #ifdef GEODE_PYTHON
 
 PyTypeObject Buffer::pytype = {
@@ -19,7 +318,7 @@ PyTypeObject Buffer::pytype = {
     "geode.Buffer",             // tp_name
     sizeof(Buffer),             // tp_basicsize
     0,                          // tp_itemsize
-    (destructor)free_buffer,    // tp_dealloc
+    Buffer::deallocate,         // tp_dealloc
     0,                          // tp_print
     0,                          // tp_getattr
     0,                          // tp_setattr
@@ -61,8 +360,49 @@ PyTypeObject Buffer::pytype = {
 #else // non-python stub
 
 PyTypeObject Buffer::pytype = {
-  "geode.Buffer",                  // tp_name
-  (void(*)(PyObject*))free_buffer, // tp_dealloc
+  "geode.Buffer",     // tp_name
+  Buffer::deallocate, // tp_dealloc
 };
 
 #endif
+
+}
+using namespace geode;
+
+#ifdef GEODE_PYTHON
+
+static void set_buffer_backend_py(const string& backend, const int alignment) {
+  if (backend=="malloc")
+    set_buffer_backend(malloc_backend,alignment);
+  else if (backend=="pool")
+    set_buffer_backend(pool_backend,alignment);
+  else
+    throw ValueError(format("set_buffer_backend: unknown backend '%s', expected 'malloc' or 'pool'",backend));
+}
+
+static std::map<string,uint64_t> buffer_stats_py() {
+  const auto S = buffer_stats();
+  std::map<string,uint64_t> stats;
+  stats["calls"] = S.calls;
+  stats["bytes"] = S.bytes;
+  stats["frees"] = S.frees;
+  stats["freed_bytes"] = S.freed_bytes;
+  stats["mallocs"] = S.mallocs;
+  stats["malloc_bytes"] = S.malloc_bytes;
+  stats["pool_hits"] = S.pool_hits;
+  stats["arena_calls"] = S.arena_calls;
+  stats["arena_bytes"] = S.arena_bytes;
+  return stats;
+}
+
+#endif
+
+void wrap_buffer() {
+#ifdef GEODE_PYTHON
+  GEODE_FUNCTION_2(set_buffer_backend,set_buffer_backend_py)
+  GEODE_FUNCTION_2(buffer_stats,buffer_stats_py)
+  GEODE_FUNCTION(buffer_alignment)
+  GEODE_FUNCTION(trim_buffer_pool)
+  GEODE_FUNCTION(clear_buffer_stats)
+#endif
+}
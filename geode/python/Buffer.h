@@ -6,6 +6,16 @@
 // Since it's a python object, it has a reference count, and can be shared.
 // No destructors are called, so is_trivially_destructible<T> must be true.
 //
+// All buffers are allocated by Buffer::allocate, which dispatches to one of several backends:
+//
+//   malloc_backend: one malloc per buffer (the default)
+//   pool_backend: a thread local cache of freed buffers in power of two size classes, falling back to malloc for
+//     sizes above 1MB.  Buffers may be freed on any thread; they land in the freeing thread's cache.
+//   ArenaScope: while an ArenaScope is active on a thread, that thread's buffers are carved out of large chunks,
+//     which are released in bulk rather than buffer by buffer.
+//
+// Each buffer records which backend it came from, so the backend and alignment can be changed at any time.
+//
 //#####################################################################
 #pragma once
 
@@ -15,6 +25,7 @@
 #include <geode/utility/type_traits.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 namespace geode {
 
 struct Buffer {
@@ -28,25 +39,66 @@ private:
   void operator=(const Buffer&);
 public:
 
-  template<class T> static Buffer* new_(const int m) {
+  template<class T> static Buffer* new_(const index_t m) {
     static_assert(is_trivially_destructible<T>::value,"Array<T> never calls destructors, so T cannot have any");
-
-#if defined(__MINGW32__)
-    // MinGW headers break declaration of _aligned_malloc unless you are very careful about include order
-    // We use __mingw_aligned_malloc which seems more robust
-    Buffer* self = (Buffer*)__mingw_aligned_malloc(16+m*sizeof(T),16);
-#elif defined(_WIN32)
-    // Windows doesn't guarantee 16 byte alignment, so use _aligned_malloc
-    Buffer* self = (Buffer*)_aligned_malloc(16+m*sizeof(T),16);
-#else
-    // On other platforms, malloc should be 16 byte aligned
-    Buffer* self = (Buffer*)malloc(16+m*sizeof(T));
-#endif
-    return GEODE_PY_OBJECT_INIT(self,&pytype);
+    return allocate(m*sizeof(T));
   }
+
+  // Allocate a buffer with room for the given number of bytes, aligned to buffer_alignment()
+  GEODE_CORE_EXPORT static Buffer* allocate(const size_t bytes);
+
+  // Return a buffer to its backend.  This is the type's tp_dealloc, called when the reference count reaches zero.
+  GEODE_CORE_EXPORT static void deallocate(PyObject* object);
 };
 
 // Check alignment constraints
 static_assert(offsetof(Buffer,data)==16,"data must be 16 byte aligned for SSE purposes");
 
+enum BufferBackend { malloc_backend, pool_backend };
+
+// Choose the backend and data alignment (16, 32, or 64 bytes) for subsequent allocations.  Use 64 for AVX-512 or to
+// keep arrays on separate cache lines.  Not synchronized, so call this before starting threads which allocate.
+GEODE_CORE_EXPORT void set_buffer_backend(const BufferBackend backend, const int alignment=16);
+GEODE_CORE_EXPORT BufferBackend buffer_backend();
+GEODE_CORE_EXPORT int buffer_alignment();
+
+// Free the calling thread's pool_backend cache.  Each thread's cache is also freed when the thread exits.
+GEODE_CORE_EXPORT void trim_buffer_pool();
+
+// While alive, buffers allocated on the constructing thread are carved out of chunks of the given size (buffers
+// larger than a quarter chunk fall back to the usual backend).  Freeing an arena buffer does not reuse its space;
+// instead, each chunk is released in one piece once the arena has moved past it and all of its buffers are freed.
+// Buffers which outlive the scope are safe, and keep their chunk alive until they are freed.  Scopes nest, and must
+// be destroyed in reverse order on the thread which created them.  Other threads, such as OpenMP workers, are
+// unaffected.
+class ArenaScope {
+  friend struct Buffer;
+  ArenaScope* const previous;
+  const size_t chunk_bytes;
+  struct ArenaChunk* chunk; // The chunk currently being filled
+  char* next;
+  char* end;
+  int64_t pending; // Live buffers in chunk which haven't been added to its reference count
+
+  ArenaScope(const ArenaScope&);
+  void operator=(const ArenaScope&);
+  void retire(); // Hand the current chunk over to its buffers
+public:
+  GEODE_CORE_EXPORT explicit ArenaScope(const size_t chunk_bytes=1<<16);
+  GEODE_CORE_EXPORT ~ArenaScope();
+};
+
+// Allocation counts summed over all threads.  Each thread counts separately without synchronization, so totals are
+// exact only when no buffers are being allocated or freed.
+struct BufferStats {
+  uint64_t calls, bytes; // Buffer::allocate calls, and requested bytes
+  uint64_t frees, freed_bytes;
+  uint64_t mallocs, malloc_bytes; // Calls which reached malloc, including pool refills and arena chunks
+  uint64_t pool_hits; // Allocations served from a thread's pool cache
+  uint64_t arena_calls, arena_bytes; // Allocations served from an ArenaScope
+};
+
+GEODE_CORE_EXPORT BufferStats buffer_stats();
+GEODE_CORE_EXPORT void clear_buffer_stats();
+
 }
@@ -122,6 +122,7 @@ void wrap_python() {
   GEODE_WRAP(object)
   GEODE_WRAP(python_function)
   GEODE_WRAP(exceptions)
+  GEODE_WRAP(buffer)
   GEODE_WRAP(test_class)
   GEODE_WRAP(numpy)
 
@@ -145,5 +146,6 @@ void wrap_python() {
   }
 
   python::add_object("real",(PyObject*)PyArray_DescrFromType(NumpyScalar<real>::value));
+  python::add_object("index_dtype",(PyObject*)PyArray_DescrFromType(NumpyScalar<index_t>::value));
 #endif
 }
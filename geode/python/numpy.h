@@ -273,6 +273,15 @@ from_numpy_helper(Types<Array<T,d>>, PyObject& array) {
   return Array<T,d>(counts,(T*)PyArray_DATA((PyArrayObject*)&array),base?base:&array);
 }
 
+// One dimensional arrays have index_t sizes
+template<class T> inline Array<T>
+from_numpy_helper(Types<Array<T,1>>, PyObject& array) {
+  PyObject* base = PyArray_BASE((PyArrayObject*)&array);
+  const npy_intp n = PyArray_DIMS((PyArrayObject*)&array)[0];
+  GEODE_ASSERT(n==npy_intp(index_t(n)));
+  return Array<T>(index_t(n),(T*)PyArray_DATA((PyArrayObject*)&array),base?base:&array);
+}
+
 // Build an NdArray<T,d> from a compatible numpy array
 template<class T> inline NdArray<T>
 from_numpy_helper(Types<NdArray<T>>, PyObject& array) {
@@ -2,6 +2,8 @@
 // Class Random
 //#####################################################################
 #include <geode/random/Random.h>
+#include <geode/array/Array2d.h>
+#include <geode/math/constants.h>
 #include <geode/python/Class.h>
 #include <geode/vector/Frame.h>
 #include <geode/vector/Rotation.h>
@@ -83,6 +85,93 @@ real Random::normal() {
   }
 }
 
+// Counters per thread block in bulk generation
+static const int bulk_counters = 1024;
+
+// Call f(i,bits) for items i in [0,n), where bits holds the k threefry outputs for counters [counter+k*i,counter+k*(i+1)).
+// Items are split across threads in blocks, but each item's counters are fixed, so results don't depend on the split.
+template<class F> void Random::bulk(const int n, const int k, const F& f) {
+  GEODE_ASSERT(n>=0 && 0<k && k<=bulk_counters);
+  const uint128_t start = counter;
+  counter = counter+uint128_t(uint64_t(k)*n);
+  const int items = bulk_counters/k,
+            blocks = (n+items-1)/items;
+  const uint128_t key = seed;
+  #pragma omp parallel
+  {
+    uint128_t bits[bulk_counters];
+    #pragma omp for
+    for (int b=0;b<blocks;b++) {
+      const int lo = b*items,
+                hi = min(n,lo+items);
+      threefry(key,start+uint128_t(uint64_t(k)*lo),RawArray<uint128_t>(k*(hi-lo),bits));
+      for (int i=lo;i<hi;i++)
+        f(i,bits+k*(i-lo));
+    }
+  }
+}
+
+// Split a threefry output into words of real size
+static const int words = sizeof(uint128_t)/sizeof(Random::RealBits);
+static_assert(words%2==0,"Box-Muller needs pairs of words");
+
+static inline Random::RealBits word(const uint128_t bits, const int i) {
+  return cast_uint128<Random::RealBits>(bits>>(8*sizeof(Random::RealBits)*i));
+}
+
+// Uniform in (0,1], so that logs are finite
+static inline real positive_uniform(const Random::RealBits bits) {
+  const int digits = numeric_limits<real>::digits;
+  return ldexp(real((bits>>(8*sizeof(Random::RealBits)-digits))+1),-digits);
+}
+
+// Fill x[0],...,x[m-1] with normals computed from words of bits, two at a time
+static inline void box_muller(real* x, const int m, const uint128_t* bits) {
+  for (int j=0;j<m;j+=2) {
+    const real r = sqrt(-2*log(positive_uniform(word(bits[j/words],j%words)))),
+               t = 2*pi*ldexp((real)1,-8*(int)sizeof(real))*word(bits[j/words],j%words+1);
+    x[j] = r*cos(t);
+    if (j+1<m)
+      x[j+1] = r*sin(t);
+  }
+}
+
+void Random::bulk_uniform(RawArray<real> x, const real a, const real b) {
+  GEODE_ASSERT(a<b);
+  const int n = x.size();
+  const real scale = ldexp(b-a,-8*(int)sizeof(real));
+  bulk((n+words-1)/words,1,[=](const int i, const uint128_t* bits) {
+    for (int j=0;j<words && words*i+j<n;j++)
+      x[words*i+j] = a+scale*word(*bits,j);
+  });
+}
+
+void Random::bulk_normal(RawArray<real> x) {
+  const int n = x.size();
+  bulk((n+words-1)/words,1,[=](const int i, const uint128_t* bits) {
+    box_muller(x.data()+words*i,min(words,n-words*i),bits);
+  });
+}
+
+template<class TV> void Random::bulk_direction(RawArray<TV> x) {
+  typedef typename TV::Scalar T;
+  static_assert(is_same<T,real>::value,"");
+  const int d = TV::m;
+  if (!d)
+    return;
+  bulk(x.size(),(d+words-1)/words,[=](const int i, const uint128_t* bits) {
+    TV v;
+    box_muller(&v[0],d,bits);
+    const T sqr_magnitude = v.sqr_magnitude();
+    if (sqr_magnitude) // Fails with probability zero
+      x[i] = v/sqrt(sqr_magnitude);
+    else {
+      x[i] = TV();
+      x[i][0] = 1;
+    }
+  });
+}
+
 // The result should consist of all (dependent) binomially distributed random values
 static vector<Array<int>> random_bits_test(Random& random, int steps) {
   vector<Array<int>> all;
@@ -145,6 +234,31 @@ Array<int> Random::uniform_int_py(int lo, int hi, int size) {
   return result;
 }
 
+Array<real> Random::bulk_normal_py(int size) {
+  Array<real> result(size,uninit);
+  bulk_normal(result);
+  return result;
+}
+
+Array<real> Random::bulk_uniform_py(int size) {
+  Array<real> result(size,uninit);
+  bulk_uniform(result,0,1);
+  return result;
+}
+
+Array<real,2> Random::bulk_direction_py(int d, int size) {
+  Array<real,2> result(size,d,uninit);
+  if (d==1)
+    bulk_direction(vector_view<1>(result.flat));
+  else if (d==2)
+    bulk_direction(vector_view<2>(result.flat));
+  else if (d==3)
+    bulk_direction(vector_view<3>(result.flat));
+  else
+    throw ValueError(format("Random.bulk_direction: expected d in 1, 2, or 3, got %d",d));
+  return result;
+}
+
 static Rotation<Vector<real,2> > rotation_helper(const Vector<real,2>& v) {
   return Rotation<Vector<real,2>>::from_complex(v.complex());
 }
@@ -163,8 +277,10 @@ template<class TV> Frame<TV> Random::frame(const TV& v0,const TV& v1) {
 }
 
 #define INSTANTIATE(d) \
+  template GEODE_CORE_EXPORT void Random::bulk_direction(RawArray<Vector<real,d>>); \
   template GEODE_CORE_EXPORT Rotation<Vector<real,d>> Random::rotation(); \
   template GEODE_CORE_EXPORT Frame<Vector<real,d>> Random::frame(const Vector<real,d>&,const Vector<real,d>&);
+template GEODE_CORE_EXPORT void Random::bulk_direction(RawArray<Vector<real,1>>);
 INSTANTIATE(2)
 INSTANTIATE(3)
 
@@ -179,6 +295,9 @@ void wrap_Random() {
     .GEODE_METHOD_2("normal",normal_py)
     .GEODE_METHOD_2("uniform",uniform_py)
     .GEODE_METHOD_2("uniform_int",uniform_int_py)
+    .GEODE_METHOD_2("bulk_normal",bulk_normal_py)
+    .GEODE_METHOD_2("bulk_uniform",bulk_uniform_py)
+    .GEODE_METHOD_2("bulk_direction",bulk_direction_py)
     ;
 
   GEODE_FUNCTION(random_bits_test)
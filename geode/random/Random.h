@@ -93,13 +93,24 @@ public:
     return ldexp((real)1,-8*(int)sizeof(real))*bits<RealBits>();
   }
 
+  // Bulk generation.  Each call consumes a fresh range of counters, and sample i depends only on seed, the counter
+  // at the start of the call, and i.  The range is split across threads, so results are independent of thread count.
+  // Values differ from those produced by the same number of scalar calls.
+  GEODE_CORE_EXPORT void bulk_uniform(RawArray<real> x, const real a, const real b); // in [a,b)
+  GEODE_CORE_EXPORT void bulk_normal(RawArray<real> x); // Box-Muller, so no rejection
+  template<class TV> GEODE_CORE_EXPORT void bulk_direction(RawArray<TV> x); // Normalized Gaussian vectors
+
   Array<real> normal_py(int size);
   Array<real> uniform_py(int size);
   Array<int> uniform_int_py(int lo, int hi, int size);
+  Array<real> bulk_normal_py(int size);
+  Array<real> bulk_uniform_py(int size);
+  Array<real,2> bulk_direction_py(int d, int size);
   template<class TV> GEODE_CORE_EXPORT Rotation<TV> rotation();
   template<class TV> GEODE_CORE_EXPORT Frame<TV> frame(const TV& v0,const TV& v1);
 private:
   template<class Int, int N> Int n_bits();
+  template<class F> void bulk(const int n, const int k, const F& f);
 };
 
 // In [a,b)
@@ -4,10 +4,15 @@
 #pragma once
 
 #include <geode/random/forward.h>
+#include <geode/array/RawArray.h>
 #include <geode/math/uint128.h>
 namespace geode {
 
 // Note that we put key first to match currying, unlike Salmon et al.
 GEODE_CORE_EXPORT uint128_t threefry(uint128_t key, uint128_t ctr) GEODE_CONST;
 
+// Set out[i] = threefry(key,ctr+i).  Several counters are processed at once in independent lanes so that the
+// compiler can vectorize the rounds.
+GEODE_CORE_EXPORT void threefry(uint128_t key, uint128_t ctr, RawArray<uint128_t> out);
+
 }
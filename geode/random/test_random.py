@@ -111,12 +111,35 @@ def test_distributions():
   X = random.uniform(n)
   assert all(0<=X) and all(X<1)
   test('uniform',scipy.stats.uniform,arange(.005,1,.01),X)
+  # Test bulk versions
+  test('bulk normal',scipy.stats.norm,arange(-3,3.001,.03),random.bulk_normal(n))
+  X = random.bulk_uniform(n)
+  assert all(0<=X) and all(X<1)
+  test('bulk uniform',scipy.stats.uniform,arange(.005,1,.01),X)
   # Test uniform int
   for lo,hi in (0,7),(-4,4):
     X = random.uniform_int(lo,hi,n)
     assert X.dtype==int32 and all(lo<=X) and all(X<hi)
     test('int %d %d'%(lo,hi),scipy.stats.randint(lo,hi),arange(lo,hi-1)+.5,X)
 
+def test_bulk():
+  # Bulk uniforms take two reals from each counter in order, matching scalar threefry
+  seed,n = 7,1001
+  random = Random(seed)
+  X = random.bulk_uniform(n)
+  mask = 2**64-1
+  bits = [threefry(seed,i) for i in xrange((n+1)//2)]
+  expected = [((b>>64*j)&mask)*2.**-64 for b in bits for j in 0,1][:n]
+  assert all(X==expected)
+  # The next call starts at the next counter
+  assert random.bulk_uniform(1)[0]==(threefry(seed,(n+1)//2)&mask)*2.**-64
+  # Directions are unit length and unbiased
+  for d in 1,2,3:
+    D = random.bulk_direction(d,100000)
+    assert D.shape==(100000,d)
+    assert allclose(sqrt((D**2).sum(axis=1)),1)
+    assert abs(D.mean(axis=0)).max()<.01
+
 def test_permute():
   # Note: This tests only that random_permute(n,_) is a valid permutation, not for pseudorandomness.
   numpy.random.seed(7810131)
@@ -140,6 +163,7 @@ def test_permute():
     assert len(perms)==fac
 
 if __name__=='__main__':
+  test_bulk()
   test_permute()
   test_bits()
   test_distributions()
@@ -0,0 +1,6 @@
+from __future__ import absolute_import
+
+from geode import *
+
+KrylovSolver = {2:KrylovSolver2d,3:KrylovSolver3d}
+ForceOperator = {2:ForceOperator2d,3:ForceOperator3d}
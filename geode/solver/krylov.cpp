@@ -0,0 +1,282 @@
+// Preconditioned conjugate gradient and MINRES for symmetric block systems
+
+#include <geode/solver/krylov.h>
+#include <geode/python/Class.h>
+#include <geode/python/stl.h>
+#include <geode/utility/format.h>
+#include <cmath>
+#include <limits>
+namespace geode {
+
+using std::numeric_limits;
+typedef real T;
+template<> GEODE_DEFINE_TYPE(ForceOperator<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(ForceOperator<Vector<T,3>>)
+template<> GEODE_DEFINE_TYPE(KrylovSolver<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(KrylovSolver<Vector<T,3>>)
+
+template<class TV> static typename TV::Scalar inner(RawArray<const TV> x, RawArray<const TV> y) {
+  typename TV::Scalar sum = 0;
+  #pragma omp parallel for reduction(+:sum)
+  for (int i=0;i<x.size();i++)
+    sum += dot(x[i],y[i]);
+  return sum;
+}
+
+template<class TV> ForceOperator<TV>::ForceOperator(const vector<Ref<const Force<TV>>>& forces, Array<const T> mass,
+                                                    const T mass_scale, const T force_scale)
+  : Base(mass.size())
+  , forces(forces)
+  , mass(mass)
+  , mass_scale(mass_scale)
+  , force_scale(force_scale) {}
+
+template<class TV> ForceOperator<TV>::~ForceOperator() {}
+
+template<class TV> void ForceOperator<TV>::multiply(RawArray<const TV> x, RawArray<TV> y) const {
+  const int n = this->size();
+  GEODE_ASSERT(x.size()==n && y.size()==n);
+  dF.resize(n,uninit);
+  dF.zero();
+  for (const auto& force : forces)
+    force->add_elastic_differential(dF,x);
+  #pragma omp parallel for
+  for (int i=0;i<n;i++)
+    y[i] = mass_scale*mass[i]*x[i]-force_scale*dF[i];
+}
+
+template<class TV> Array<SymmetricMatrix<typename TV::Scalar,TV::m>> ForceOperator<TV>::diagonal_blocks() const {
+  const int n = this->size();
+  Array<SymmetricMatrix<T,d>> D(n);
+  for (const auto& force : forces)
+    force->add_elastic_gradient_block_diagonal(D);
+  for (int i=0;i<n;i++)
+    D[i] = -force_scale*D[i]+mass_scale*mass[i];
+  return D;
+}
+
+template<class TV> KrylovSolver<TV>::KrylovSolver(const string& preconditioner, const T tolerance,
+                                                  const int max_iterations)
+  : preconditioner(preconditioner)
+  , tolerance(tolerance)
+  , max_iterations(max_iterations)
+  , kind(preconditioner=="none" ? 0 : preconditioner=="jacobi" ? 1 : preconditioner=="block" ? 2 : -1) {
+  if (kind < 0)
+    throw ValueError(format("KrylovSolver: unknown preconditioner '%s', expected 'none', 'jacobi', or 'block'",
+      preconditioner));
+}
+
+template<class TV> KrylovSolver<TV>::~KrylovSolver() {}
+
+template<class TV> void KrylovSolver<TV>::setup(const SolidMatrixBase<TV>& A, RawArray<TV> x, RawArray<const TV> b) {
+  const int n = A.size();
+  GEODE_ASSERT(x.size()==n && b.size()==n);
+  for (auto* u : {&r,&z,&p,&q,&v,&w,&w1,&w2})
+    u->resize(n,uninit);
+
+  // Invert the diagonal blocks
+  if (kind) {
+    const auto D = A.diagonal_blocks();
+    GEODE_ASSERT(D.size()==n);
+    if (kind == 1)
+      jacobi.resize(n,uninit);
+    else
+      blocks.resize(n,uninit);
+    for (int i=0;i<n;i++) {
+      if (kind == 1) {
+        const auto diagonal = D[i].diagonal_part();
+        if (!(diagonal.min()>0))
+          throw ValueError(format("KrylovSolver: jacobi preconditioner needs a positive diagonal, block %d has "
+                                  "diagonal entry %g",i,diagonal.min()));
+        jacobi[i] = diagonal.inverse();
+      } else {
+        if (!D[i].positive_definite())
+          throw ValueError(format("KrylovSolver: block preconditioner needs positive definite diagonal blocks, "
+                                  "block %d is %s",i,str(D[i])));
+        blocks[i] = D[i].inverse();
+      }
+    }
+  }
+}
+
+template<class TV> void KrylovSolver<TV>::precondition(RawArray<const TV> r, RawArray<TV> z) const {
+  const int n = r.size();
+  if (kind == 0)
+    z = r;
+  else if (kind == 1) {
+    #pragma omp parallel for
+    for (int i=0;i<n;i++)
+      z[i] = jacobi[i]*r[i];
+  } else {
+    #pragma omp parallel for
+    for (int i=0;i<n;i++)
+      z[i] = blocks[i]*r[i];
+  }
+}
+
+template<class TV> typename TV::Scalar KrylovSolver<TV>::residual(const SolidMatrixBase<TV>& A, RawArray<const TV> x,
+                                                RawArray<const TV> b) {
+  A.multiply(x,q);
+  T rr = 0, bb = 0;
+  for (int i=0;i<x.size();i++) {
+    rr += sqr_magnitude(b[i]-q[i]);
+    bb += sqr_magnitude(b[i]);
+  }
+  return bb ? sqrt(rr/bb) : 0;
+}
+
+template<class TV> Tuple<int,typename TV::Scalar> KrylovSolver<TV>::cg(const SolidMatrixBase<TV>& A, RawArray<TV> x,
+                                                                       RawArray<const TV> b) {
+  setup(A,x,b);
+  const int n = x.size();
+  const T b_norm = sqrt(inner(b,b));
+  if (!b_norm) {
+    x.zero();
+    return tuple(0,T(0));
+  }
+
+  A.multiply(x,q);
+  for (int i=0;i<n;i++)
+    r[i] = b[i]-q[i];
+  precondition(r,z);
+  p.copy(z);
+  T rz = inner<TV>(r,z);
+  int k = 0;
+  for (;k<max_iterations;k++) {
+    if (sqrt(inner<TV>(r,r)) <= tolerance*b_norm)
+      break;
+    A.multiply(p,q);
+    const T pq = inner<TV>(p,q);
+    if (!(pq>0))
+      throw RuntimeError(format("KrylovSolver.cg: matrix is not positive definite (p'Ap = %g at iteration %d)",
+        pq,k));
+    const T alpha = rz/pq;
+    #pragma omp parallel for
+    for (int i=0;i<n;i++) {
+      x[i] += alpha*p[i];
+      r[i] -= alpha*q[i];
+    }
+    precondition(r,z);
+    const T rz_next = inner<TV>(r,z),
+            beta = rz_next/rz;
+    rz = rz_next;
+    #pragma omp parallel for
+    for (int i=0;i<n;i++)
+      p[i] = z[i]+beta*p[i];
+  }
+  return tuple(k,residual(A,x,b));
+}
+
+// Preconditioned MINRES, following Paige and Saunders as implemented in scipy.sparse.linalg.minres.  r and z hold
+// the last two Lanczos vectors r1 and r2, q holds the preconditioned Lanczos vector y, and w, w1, w2 hold the last
+// three search directions.  Vectors are rotated by swapping buffers.
+template<class TV> Tuple<int,typename TV::Scalar> KrylovSolver<TV>::minres(const SolidMatrixBase<TV>& A, RawArray<TV> x,
+                                                                           RawArray<const TV> b) {
+  setup(A,x,b);
+  const int n = x.size();
+  if (!inner(b,b)) {
+    x.zero();
+    return tuple(0,T(0));
+  }
+
+  A.multiply(x,q);
+  for (int i=0;i<n;i++)
+    r[i] = b[i]-q[i];
+  z.copy(r);
+  precondition(r,q);
+  T beta1 = inner<TV>(r,q);
+  if (beta1 < 0)
+    throw ValueError("KrylovSolver.minres: preconditioner is not positive definite");
+  beta1 = sqrt(beta1);
+  w.zero();
+  w1.zero();
+  w2.zero();
+
+  T old_beta = 0, beta = beta1, dbar = 0, epsilon = 0, phibar = beta1, cs = -1, sn = 0;
+  int k = 0;
+  while (k<max_iterations && phibar>tolerance*beta1) {
+    k++;
+    // Lanczos step
+    const T s = 1/beta;
+    #pragma omp parallel for
+    for (int i=0;i<n;i++)
+      v[i] = s*q[i];
+    A.multiply(v,q);
+    if (k >= 2) {
+      const T c = beta/old_beta;
+      #pragma omp parallel for
+      for (int i=0;i<n;i++)
+        q[i] -= c*r[i];
+    }
+    const T alpha = inner<TV>(v,q),
+            c = alpha/beta;
+    #pragma omp parallel for
+    for (int i=0;i<n;i++)
+      q[i] -= c*z[i];
+    r.swap(z);
+    z.swap(q);
+    precondition(z,q);
+    old_beta = beta;
+    beta = inner<TV>(z,q);
+    if (beta < 0)
+      throw ValueError("KrylovSolver.minres: preconditioner is not positive definite");
+    beta = sqrt(beta);
+
+    // Apply the previous rotation, then compute and apply the next one
+    const T old_epsilon = epsilon,
+            delta = cs*dbar+sn*alpha,
+            gbar = sn*dbar-cs*alpha;
+    epsilon = sn*beta;
+    dbar = -cs*beta;
+    const T gamma = max(sqrt(sqr(gbar)+sqr(beta)),numeric_limits<T>::min());
+    cs = gbar/gamma;
+    sn = beta/gamma;
+    const T phi = cs*phibar;
+    phibar *= sn;
+
+    // Update the search directions and the solution
+    w1.swap(w2);
+    w2.swap(w);
+    const T inv_gamma = 1/gamma;
+    #pragma omp parallel for
+    for (int i=0;i<n;i++) {
+      w[i] = inv_gamma*(v[i]-old_epsilon*w1[i]-delta*w2[i]);
+      x[i] += phi*w[i];
+    }
+  }
+  return tuple(k,residual(A,x,b));
+}
+
+template class ForceOperator<Vector<T,2>>;
+template class ForceOperator<Vector<T,3>>;
+template class KrylovSolver<Vector<T,2>>;
+template class KrylovSolver<Vector<T,3>>;
+}
+using namespace geode;
+
+template<int d> static void wrap_helper() {
+  typedef Vector<T,d> TV;
+  {typedef ForceOperator<TV> Self;
+  Class<Self>(d==2?"ForceOperator2d":"ForceOperator3d")
+    .GEODE_INIT(const vector<Ref<const Force<TV>>>&,Array<const T>,T,T)
+    .GEODE_FIELD(forces)
+    .GEODE_FIELD(mass)
+    .GEODE_FIELD(mass_scale)
+    .GEODE_FIELD(force_scale)
+    ;}
+
+  {typedef KrylovSolver<TV> Self;
+  Class<Self>(d==2?"KrylovSolver2d":"KrylovSolver3d")
+    .GEODE_INIT(const string&,T,int)
+    .GEODE_FIELD(preconditioner)
+    .GEODE_FIELD(tolerance)
+    .GEODE_FIELD(max_iterations)
+    .GEODE_METHOD(cg)
+    .GEODE_METHOD(minres)
+    ;}
+}
+
+void wrap_krylov() {
+  wrap_helper<2>();
+  wrap_helper<3>();
+}
@@ -0,0 +1,82 @@
+// Preconditioned conjugate gradient and MINRES for symmetric block systems
+#pragma once
+
+#include <geode/force/Force.h>
+#include <geode/python/Ref.h>
+#include <geode/structure/Tuple.h>
+#include <geode/vector/DiagonalMatrix.h>
+#include <geode/vector/SolidMatrix.h>
+#include <geode/vector/SymmetricMatrix.h>
+#include <vector>
+namespace geode {
+
+using std::vector;
+
+// The matrix free operator
+//
+//   A = mass_scale M - force_scale sum_f dF_f/dX
+//
+// where M is the diagonal mass matrix and dF_f/dX is the elastic differential of each force at its last
+// update_position.  For a backward Euler step, use mass_scale = 1 and force_scale = dt^2.
+template<class TV> class ForceOperator : public SolidMatrixBase<TV> {
+  typedef typename TV::Scalar T;
+  enum {d=TV::m};
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef SolidMatrixBase<TV> Base;
+
+  const vector<Ref<const Force<TV>>> forces;
+  const Array<const T> mass;
+  T mass_scale, force_scale;
+private:
+  mutable Array<TV> dF; // Reused by multiply
+protected:
+  GEODE_CORE_EXPORT ForceOperator(const vector<Ref<const Force<TV>>>& forces, Array<const T> mass,
+                                  const T mass_scale, const T force_scale);
+public:
+  ~ForceOperator();
+
+  GEODE_CORE_EXPORT void multiply(RawArray<const TV> x, RawArray<TV> y) const;
+  GEODE_CORE_EXPORT Array<SymmetricMatrix<T,TV::m>> diagonal_blocks() const; // Via add_elastic_gradient_block_diagonal
+};
+
+// Krylov solvers for A x = b with symmetric A, given by any SolidMatrixBase.  Work vectors are kept between solves,
+// so a solver reused for systems of the same size does not allocate.  The preconditioner is one of
+//
+//   "none"
+//   "jacobi": the inverse diagonal of A
+//   "block": the inverse dxd diagonal blocks of A
+//
+// recomputed from A.diagonal_blocks() at the start of each solve.  Preconditioners must be positive definite.
+template<class TV> class KrylovSolver : public Object {
+  typedef typename TV::Scalar T;
+  enum {d=TV::m};
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const string preconditioner;
+  T tolerance; // Relative residual: |b-Ax| <= tolerance |b| for cg, and the preconditioned analogue for minres
+  int max_iterations;
+private:
+  const int kind; // 0 for none, 1 for jacobi, 2 for block
+  Array<DiagonalMatrix<T,d>> jacobi;
+  Array<SymmetricMatrix<T,d>> blocks;
+  Array<TV> r, z, p, q, v, w, w1, w2; // Work vectors
+protected:
+  GEODE_CORE_EXPORT KrylovSolver(const string& preconditioner, const T tolerance, const int max_iterations);
+public:
+  ~KrylovSolver();
+
+  // Solve A x = b starting from the initial guess in x, returning the number of iterations and the final relative
+  // residual |b-Ax|/|b|.  cg requires A positive definite, and minres works for any symmetric A.
+  GEODE_CORE_EXPORT Tuple<int,T> cg(const SolidMatrixBase<TV>& A, RawArray<TV> x, RawArray<const TV> b);
+  GEODE_CORE_EXPORT Tuple<int,T> minres(const SolidMatrixBase<TV>& A, RawArray<TV> x, RawArray<const TV> b);
+
+private:
+  void setup(const SolidMatrixBase<TV>& A, RawArray<TV> x, RawArray<const TV> b);
+  void precondition(RawArray<const TV> r, RawArray<TV> z) const;
+  T residual(const SolidMatrixBase<TV>& A, RawArray<const TV> x, RawArray<const TV> b);
+};
+
+}
@@ -3,4 +3,5 @@
 void wrap_solver() {
   GEODE_WRAP(brent)
   GEODE_WRAP(powell)
+  GEODE_WRAP(krylov)
 }
@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+from geode.force import *
+from geode.solver import KrylovSolver,ForceOperator
+from numpy import *
+
+def spring_system():
+  # A backward Euler system for a randomly perturbed spring grid, both assembled and matrix free
+  random.seed(18131)
+  n = 8
+  mesh = grid_topology(n,n)
+  X0 = zeros((n+1,n+1,3))
+  X0[:,:,:2] = transpose(indices((n+1,n+1)),(1,2,0))/n
+  X0 = X0.reshape(-1,3)
+  X = X0+.1/n*random.randn(*X0.shape)
+  mass = 1+random.rand(len(X))
+  springs = edge_springs(mesh,mass,X0,100,1.2)
+  springs.update_position(X,False)
+  dt = .1
+  structure = SolidMatrixStructure(len(X))
+  springs.structure(structure)
+  A = SolidMatrix[3](structure)
+  springs.add_elastic_gradient(A)
+  A.scale(-dt**2)
+  A.add_diagonal_scalars(mass)
+  return A,ForceOperator[3]([springs],mass,1,dt**2),len(X)
+
+def test_operator():
+  A,op,n = spring_system()
+  x = random.randn(n,3)
+  y,z = empty_like(x),empty_like(x)
+  A.multiply(x,y)
+  op.multiply(x,z)
+  assert relative_error(y,z)<1e-10
+  assert relative_error(A.diagonal_blocks(),op.diagonal_blocks())<1e-10
+
+def test_krylov():
+  A,op,n = spring_system()
+  b = random.randn(n,3)
+  exact = linalg.solve(A.dense(),b.ravel()).reshape(-1,3)
+  for preconditioner in 'none','jacobi','block':
+    solver = KrylovSolver[3](preconditioner,1e-10,1000)
+    for matrix in A,op:
+      for method in solver.cg,solver.minres:
+        x = zeros_like(b)
+        iters,residual = method(matrix,x,b)
+        print preconditioner,method.__name__,iters,residual
+        assert 0<iters<1000
+        assert residual<1e-8
+        assert relative_error(x,exact)<1e-6
+
+if __name__=='__main__':
+  test_krylov()
@@ -0,0 +1,111 @@
+//#####################################################################
+// Class MappedFile
+//#####################################################################
+#include <geode/utility/MappedFile.h>
+#include <geode/python/Class.h>
+#include <geode/utility/const_cast.h>
+#include <errno.h>
+#include <cstring>
+#ifdef _WIN32
+#define WINDOWS_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace geode {
+
+GEODE_DEFINE_TYPE(MappedFile)
+
+#ifdef _WIN32
+
+// Open and map the file, storing the mapping handle
+static char* map_file(const string& filename, size_t& size, void*& mapping) {
+  const HANDLE file = CreateFileA(filename.c_str(),GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,0);
+  if (file == INVALID_HANDLE_VALUE)
+    throw IOError(format("can't open '%s' for mapping: error %d",filename,int(GetLastError())));
+  LARGE_INTEGER n;
+  if (!GetFileSizeEx(file,&n)) {
+    CloseHandle(file);
+    throw IOError(format("can't get size of '%s': error %d",filename,int(GetLastError())));
+  }
+  size = size_t(n.QuadPart);
+  mapping = 0;
+  if (!size) {
+    CloseHandle(file);
+    return 0;
+  }
+  mapping = CreateFileMappingA(file,0,PAGE_WRITECOPY,0,0,0);
+  CloseHandle(file);
+  if (!mapping)
+    throw IOError(format("can't map '%s': error %d",filename,int(GetLastError())));
+  const auto data = (char*)MapViewOfFile(mapping,FILE_MAP_COPY,0,0,0);
+  if (!data) {
+    CloseHandle(mapping);
+    throw IOError(format("can't map '%s': error %d",filename,int(GetLastError())));
+  }
+  return data;
+}
+
+MappedFile::MappedFile(const string& filename)
+  : filename(filename)
+  , size(0)
+  , data(map_file(filename,const_cast_(size),mapping)) {}
+
+MappedFile::~MappedFile() {
+  if (data) {
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+  }
+}
+
+#else
+
+static char* map_file(const string& filename, size_t& size) {
+  const int fd = open(filename.c_str(),O_RDONLY);
+  if (fd < 0)
+    throw IOError(format("can't open '%s' for mapping: %s",filename,strerror(errno)));
+  struct stat st;
+  if (fstat(fd,&st) < 0) {
+    const int error = errno;
+    close(fd);
+    throw IOError(format("can't stat '%s': %s",filename,strerror(error)));
+  }
+  size = size_t(st.st_size);
+  if (!size) {
+    close(fd);
+    return 0;
+  }
+  void* const data = mmap(0,size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+  const int error = errno;
+  close(fd); // The mapping keeps its own reference to the file
+  if (data == MAP_FAILED)
+    throw IOError(format("can't map '%s': %s",filename,strerror(error)));
+  return (char*)data;
+}
+
+MappedFile::MappedFile(const string& filename)
+  : filename(filename)
+  , size(0)
+  , data(map_file(filename,const_cast_(size))) {}
+
+MappedFile::~MappedFile() {
+  if (data)
+    munmap(data,size);
+}
+
+#endif
+
+}
+using namespace geode;
+
+void wrap_mapped_file() {
+  typedef MappedFile Self;
+  Class<Self>("MappedFile")
+    .GEODE_INIT(const string&)
+    .GEODE_FIELD(filename)
+    .GEODE_FIELD(size)
+    ;
+}
@@ -0,0 +1,55 @@
+//#####################################################################
+// Class MappedFile
+//#####################################################################
+//
+// A memory mapping of an entire file, for loading large binary data without reading or copying it.
+//
+// The mapping is private and copy-on-write: pages are shared with the page cache until written, and writes never
+// reach the file.  Arrays returned by mapped_view hold a reference to the MappedFile as their owner, so the file
+// stays mapped for as long as any view exists, including views passed to python.
+//
+//#####################################################################
+#pragma once
+
+#include <geode/array/Array.h>
+#include <geode/python/Object.h>
+#include <geode/python/Ref.h>
+#include <geode/python/exceptions.h>
+#include <geode/utility/format.h>
+#include <type_traits>
+namespace geode {
+
+class MappedFile : public Object {
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef Object Base;
+
+  const string filename;
+  const size_t size;
+  char* const data; // Null if the file is empty
+protected:
+#ifdef _WIN32
+  void* mapping; // File mapping handle, set while mapping data
+#endif
+
+  GEODE_CORE_EXPORT MappedFile(const string& filename);
+public:
+  ~MappedFile();
+};
+
+// View n elements of type T starting at the given byte offset of a mapped file.  Throws IOError if the elements
+// extend past the end of the file or are misaligned for T.
+template<class T> static inline Array<T> mapped_view(const Ref<MappedFile>& file, const size_t offset, const int n) {
+  if (n < 0 || offset > file->size || (file->size-offset)/sizeof(T) < size_t(n))
+    throw IOError(format("mapped file '%s' is too short: %d elements of size %d at offset %lld exceed %lld bytes",
+      file->filename,n,int(sizeof(T)),(long long)offset,(long long)file->size));
+  if (!n)
+    return Array<T>();
+  char* const start = file->data+offset;
+  if (size_t(start)%std::alignment_of<T>::value)
+    throw IOError(format("mapped file '%s': offset %lld is misaligned for %d byte alignment",
+      file->filename,(long long)offset,int(std::alignment_of<T>::value)));
+  return Array<T>(n,reinterpret_cast<T*>(start),file.borrow_owner());
+}
+
+}
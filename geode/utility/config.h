@@ -18,6 +18,20 @@ typedef double real;
 #endif
 }
 
+// Choose the index type for one dimensional arrays (Array, RawArray, Nested offsets, Field).  The default int keeps
+// arrays compact and fast; build with index=int64 for arrays with 2^31 or more elements.  Multidimensional array
+// shapes and element ids remain int either way.
+#include <stdint.h>
+namespace geode {
+#ifdef GEODE_INDEX64
+typedef int64_t index_t;
+typedef uint64_t uindex_t;
+#else
+typedef int index_t;
+typedef unsigned uindex_t;
+#endif
+}
+
 // Mostly sizeof(size_t) will work, but not for preprocessor stuff
 // Warning: SIZEOF_SIZE_T may exists, but only when Python support is enabled
 #if defined(__GNUC__)
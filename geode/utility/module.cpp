@@ -101,6 +101,7 @@ void wrap_utility() {
   GEODE_FUNCTION(geode_endian_matches_native)
 
   GEODE_WRAP(base64)
+  GEODE_WRAP(mapped_file)
   GEODE_WRAP(resource)
   GEODE_WRAP(format)
   GEODE_WRAP(process)
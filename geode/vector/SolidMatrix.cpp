@@ -12,6 +12,8 @@
 #include <geode/utility/const_cast.h>
 namespace geode {
 
+using std::vector;
+
 typedef real T;
 
 GEODE_DEFINE_TYPE(SolidMatrixStructure)
@@ -21,6 +23,8 @@ template<> GEODE_DEFINE_TYPE(SolidMatrix<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(SolidMatrix<Vector<T,3>>)
 template<> GEODE_DEFINE_TYPE(SolidDiagonalMatrix<Vector<T,2>>)
 template<> GEODE_DEFINE_TYPE(SolidDiagonalMatrix<Vector<T,3>>)
+template<> GEODE_DEFINE_TYPE(SolidBlockMatrix<Vector<T,2>>)
+template<> GEODE_DEFINE_TYPE(SolidBlockMatrix<Vector<T,3>>)
 
 SolidMatrixStructure::
 SolidMatrixStructure(int n)
@@ -63,6 +67,11 @@ SolidMatrixBase(int n)
 template<class TV> SolidMatrixBase<TV>::
 ~SolidMatrixBase() {}
 
+template<class TV> Array<SymmetricMatrix<typename TV::Scalar,TV::m>> SolidMatrixBase<TV>::
+diagonal_blocks() const {
+  GEODE_NOT_IMPLEMENTED(format("%s does not provide diagonal blocks",typeid(*this).name()));
+}
+
 template<class TV> SolidMatrix<TV>::
 SolidMatrix(const SolidMatrixStructure& structure)
   : Base(structure.n), next_outer(0) {
@@ -226,9 +235,9 @@ entries() const {
   return tuple(J,I,C);
 }
 
-template<class TV> void SolidMatrix<TV>::
-add_multiply_outers(RawArray<const TV> x, RawArray<TV> y) const {
-  GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
+template<class TV> static void add_multiply_outers(const vector<Tuple<Array<const int>,typename TV::Scalar,Array<TV>>>& outers,
+                                                   RawArray<const TV> x, RawArray<TV> y) {
+  typedef typename TV::Scalar T;
   for (int o=0;o<(int)outers.size();o++) {
     RawArray<const int> nodes = outers[o].x;
     T B = outers[o].y;
@@ -244,6 +253,12 @@ add_multiply_outers(RawArray<const TV> x, RawArray<TV> y) const {
   }
 }
 
+template<class TV> void SolidMatrix<TV>::
+add_multiply_outers(RawArray<const TV> x, RawArray<TV> y) const {
+  GEODE_ASSERT(valid() && x.size()==this->size() && y.size()==this->size());
+  geode::add_multiply_outers(outers,x,y);
+}
+
 template<class TV> void SolidMatrix<TV>::
 multiply(RawArray<const TV> x, RawArray<TV> y) const {
   y.zero();
@@ -330,6 +345,21 @@ dense() const {
   return final;
 }
 
+template<class TV> Array<SymmetricMatrix<typename TV::Scalar,TV::m>> SolidMatrix<TV>::
+diagonal_blocks() const {
+  GEODE_ASSERT(valid());
+  Array<SymmetricMatrix<T,d>> D(this->size(),uninit);
+  for (int i=0;i<this->size();i++)
+    D[i] = assume_symmetric(sparse_A(i,0));
+  for (const auto& outer : outers) {
+    RawArray<const int> nodes = outer.x;
+    RawArray<const TV> U = outer.z;
+    for (int a=0;a<nodes.size();a++)
+      D[nodes[a]] += scaled_outer_product(outer.y,U[a]);
+  }
+  return D;
+}
+
 template<class TV> Ref<SolidDiagonalMatrix<TV>> SolidMatrix<TV>::
 inverse_block_diagonal() const {
   GEODE_ASSERT(!outers.size());
@@ -356,6 +386,11 @@ multiply(RawArray<const TV> x,RawArray<TV> y) const {
     y[i] = A[i]*x[i];
 }
 
+template<class TV> Array<SymmetricMatrix<typename TV::Scalar,TV::m>> SolidDiagonalMatrix<TV>::
+diagonal_blocks() const {
+  return A.copy();
+}
+
 template<class TV> typename TV::Scalar SolidDiagonalMatrix<TV>::
 inner_product(RawArray<const TV> x,RawArray<const TV> y) const {
   T sum = 0;
@@ -364,12 +399,149 @@ inner_product(RawArray<const TV> x,RawArray<const TV> y) const {
   return sum;
 }
 
+template<class TV> SolidBlockMatrix<TV>::
+SolidBlockMatrix(const SolidMatrix<TV>& matrix)
+  : Base(matrix.size()) {
+  GEODE_ASSERT(matrix.valid());
+  for (const auto& outer : matrix.outers)
+    const_cast_(outers).push_back(tuple(outer.x,outer.y,outer.z.copy()));
+  const auto& sparse_j = matrix.sparse_j;
+  const int n = sparse_j.size();
+
+  // Row i holds its upper triangle from the SolidMatrix plus the transposes of column i.  Visiting rows in order
+  // appends transposed entries (i,j) to row j before row j's own entries, so columns come out sorted.
+  Array<int> lengths(n,uninit);
+  for (int i=0;i<n;i++)
+    lengths[i] = sparse_j.size(i);
+  for (const int j : sparse_j.flat)
+    lengths[j]++;
+  for (int i=0;i<n;i++)
+    lengths[i]--; // The diagonal was counted twice
+  Nested<int> J(lengths);
+  Array<index_t> next = J.offsets.slice(0,n).copy();
+  Array<int> forward(sparse_j.flat.size(),uninit),
+             backward(sparse_j.flat.size(),uninit),
+             diagonal(n,uninit);
+  for (int i=0;i<n;i++)
+    for (int f=sparse_j.offsets[i];f<sparse_j.offsets[i+1];f++) {
+      const int j = sparse_j.flat[f];
+      forward[f] = next[i];
+      J.flat[next[i]++] = j;
+      if (i == j) {
+        backward[f] = -1;
+        diagonal[i] = forward[f];
+      } else {
+        backward[f] = next[j];
+        J.flat[next[j]++] = i;
+      }
+    }
+  const_cast_(this->J) = J;
+  const_cast_(A) = Array<TMatrix>(J.flat.size(),uninit);
+  const_cast_(this->forward) = forward;
+  const_cast_(this->backward) = backward;
+  const_cast_(this->diagonal) = diagonal;
+  update(matrix);
+}
+
+template<class TV> SolidBlockMatrix<TV>::
+~SolidBlockMatrix() {}
+
+template<class TV> void SolidBlockMatrix<TV>::
+update(const SolidMatrix<TV>& matrix) {
+  GEODE_ASSERT(matrix.valid() && matrix.size()==this->size() && matrix.sparse_A.flat.size()==forward.size()
+               && matrix.outers.size()==outers.size());
+  const auto S = matrix.sparse_A.flat;
+  #pragma omp parallel for
+  for (int f=0;f<S.size();f++) {
+    A[forward[f]] = S[f];
+    if (backward[f] >= 0)
+      A[backward[f]] = S[f].transposed();
+  }
+  for (int o=0;o<(int)outers.size();o++) {
+    GEODE_ASSERT(outers[o].x.size()==matrix.outers[o].x.size());
+    const_cast_(outers[o].y) = matrix.outers[o].y;
+    outers[o].z.copy(matrix.outers[o].z);
+  }
+}
+
+template<class TV> void SolidBlockMatrix<TV>::
+multiply(RawArray<const TV> x, RawArray<TV> y) const {
+  const int n = this->size();
+  GEODE_ASSERT(x.size()==n && y.size()==n);
+  const index_t* offsets = J.offsets.data();
+  const int* columns = J.flat.data();
+  const TMatrix* blocks = A.data();
+  #pragma omp parallel for
+  for (int i=0;i<n;i++) {
+    TV sum;
+    for (int k=offsets[i];k<offsets[i+1];k++)
+      sum += blocks[k]*x[columns[k]];
+    y[i] = sum;
+  }
+  add_multiply_outers(outers,x,y);
+}
+
+template<class TV> void SolidBlockMatrix<TV>::
+multiply_multiple(RawArray<const TV,2> x, RawArray<TV,2> y) const {
+  const int n = this->size(),
+            r = x.n;
+  GEODE_ASSERT(x.m==n && y.sizes()==x.sizes());
+  const index_t* offsets = J.offsets.data();
+  const int* columns = J.flat.data();
+  const TMatrix* blocks = A.data();
+  #pragma omp parallel for
+  for (int i=0;i<n;i++) {
+    TV* yi = y[i].data();
+    for (int s=0;s<r;s++)
+      yi[s] = TV();
+    for (int k=offsets[i];k<offsets[i+1];k++) {
+      const TMatrix a = blocks[k];
+      const TV* xj = x[columns[k]].data();
+      for (int s=0;s<r;s++)
+        yi[s] += a*xj[s];
+    }
+  }
+
+  // Outers are low rank, so apply them serially one vector at a time
+  for (int o=0;o<(int)outers.size();o++) {
+    RawArray<const int> nodes = outers[o].x;
+    const T B = outers[o].y;
+    if (!B)
+      continue;
+    RawArray<const TV> U = outers[o].z;
+    for (int s=0;s<r;s++) {
+      T sum = 0;
+      for (int a=0;a<nodes.size();a++)
+        sum += dot(U[a],x(nodes[a],s));
+      sum *= B;
+      for (int a=0;a<nodes.size();a++)
+        y(nodes[a],s) += sum*U[a];
+    }
+  }
+}
+
+template<class TV> Array<SymmetricMatrix<typename TV::Scalar,TV::m>> SolidBlockMatrix<TV>::
+diagonal_blocks() const {
+  Array<SymmetricMatrix<T,d>> D(this->size(),uninit);
+  for (int i=0;i<this->size();i++)
+    D[i] = assume_symmetric(A[diagonal[i]]);
+  for (const auto& outer : outers) {
+    RawArray<const int> nodes = outer.x;
+    RawArray<const TV> U = outer.z;
+    for (int a=0;a<nodes.size();a++)
+      D[nodes[a]] += scaled_outer_product(outer.y,U[a]);
+  }
+  return D;
+}
+
 template class SolidMatrixBase<Vector<T,2>>;
 template class SolidMatrixBase<Vector<T,3>>;
 template class SolidMatrix<Vector<T,2>>;
 template class SolidMatrix<Vector<T,3>>;
 template class SolidDiagonalMatrix<Vector<T,2>>;
 template class SolidDiagonalMatrix<Vector<T,3>>;
+template class SolidBlockMatrix<Vector<T,2>>;
+template class SolidBlockMatrix<Vector<T,3>>;
 
 }
 using namespace geode;
@@ -378,6 +550,7 @@ template<int d> static void wrap_helper() {
   {typedef SolidMatrixBase<Vector<T,d>> Self;
   Class<Self>(d==2?"SolidMatrixBase2d":"SolidMatrixBase3d")
     .GEODE_METHOD(multiply)
+    .GEODE_METHOD(diagonal_blocks)
     ;}
 
   {typedef SolidMatrix<Vector<T,d>> Self;
@@ -403,6 +576,15 @@ template<int d> static void wrap_helper() {
   Class<Self>(d==2?"SolidDiagonalMatrix2d":"SolidDiagonalMatrix3d")
     .GEODE_METHOD(inner_product)
     ;}
+
+  {typedef SolidBlockMatrix<Vector<T,d>> Self;
+  Class<Self>(d==2?"SolidBlockMatrix2d":"SolidBlockMatrix3d")
+    .GEODE_INIT(const SolidMatrix<Vector<T,d>>&)
+    .GEODE_FIELD(J)
+    .GEODE_FIELD(A)
+    .GEODE_METHOD(update)
+    .GEODE_METHOD(multiply_multiple)
+    ;}
 }
 
 void wrap_solid_matrix() {
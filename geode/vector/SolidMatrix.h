@@ -69,6 +69,9 @@ public:
   }
 
   virtual void multiply(RawArray<const TV> x,RawArray<TV> y) const = 0;
+
+  // The symmetric diagonal blocks, used for preconditioning.  Throws NotImplementedError if unavailable.
+  GEODE_CORE_EXPORT virtual Array<SymmetricMatrix<T,TV::m>> diagonal_blocks() const;
 };
 
 template<class TV> class SolidMatrix : public SolidMatrixBase<TV> {
@@ -120,6 +123,7 @@ public:
   GEODE_CORE_EXPORT Tuple<Array<int>,Array<int>,Array<T> > entries() const ;
   GEODE_CORE_EXPORT void multiply(RawArray<const TV> x,RawArray<TV> y) const ;
   GEODE_CORE_EXPORT T inner_product(RawArray<const TV> x,RawArray<const TV> y) const ;
+  GEODE_CORE_EXPORT Array<SymmetricMatrix<T,TV::m>> diagonal_blocks() const; // Includes outers
   Ref<SolidDiagonalMatrix<TV> > inverse_block_diagonal() const;
   GEODE_CORE_EXPORT Box<T> diagonal_range() const ;
   Array<T,2> dense() const;
@@ -147,6 +151,43 @@ public:
 
   GEODE_CORE_EXPORT void multiply(RawArray<const TV> x,RawArray<TV> y) const ;
   GEODE_CORE_EXPORT T inner_product(RawArray<const TV> x,RawArray<const TV> y) const ;
+  GEODE_CORE_EXPORT Array<SymmetricMatrix<T,TV::m>> diagonal_blocks() const;
+};
+
+// A SolidMatrix in block compressed sparse row form, storing both triangles explicitly.  Each row is computed
+// independently, so multiplies run in parallel without scattering to other rows, and the blocks of a row are
+// contiguous for vectorized inner loops.  Structure is computed once; update refreshes values from a SolidMatrix with
+// the same structure.
+template<class TV> class SolidBlockMatrix : public SolidMatrixBase<TV> {
+  typedef typename TV::Scalar T;
+  enum {d=TV::m};
+  typedef Matrix<T,d> TMatrix;
+public:
+  GEODE_DECLARE_TYPE(GEODE_CORE_EXPORT)
+  typedef SolidMatrixBase<TV> Base;
+
+  const Nested<const int> J; // Sorted column indices of each row
+  const Array<TMatrix> A; // Blocks, parallel to J.flat
+private:
+  const Array<const int> forward, backward; // Positions in A of each SolidMatrix block and its transpose (-1 for diagonal)
+  const Array<const int> diagonal; // Position in A of each diagonal block
+  const std::vector<Tuple<Array<const int>,T,Array<TV>>> outers;
+
+protected:
+  GEODE_CORE_EXPORT SolidBlockMatrix(const SolidMatrix<TV>& matrix);
+public:
+  GEODE_CORE_EXPORT ~SolidBlockMatrix();
+
+  // Copy values from matrix, which must have the same structure as the matrix we were built from
+  GEODE_CORE_EXPORT void update(const SolidMatrix<TV>& matrix);
+
+  GEODE_CORE_EXPORT void multiply(RawArray<const TV> x,RawArray<TV> y) const ;
+
+  // Multiply several vectors at once: y(i,r) = sum_j A(i,j) x(j,r) for each of the x.n right hand sides.
+  // Each block is loaded once per row rather than once per vector.
+  GEODE_CORE_EXPORT void multiply_multiple(RawArray<const TV,2> x,RawArray<TV,2> y) const ;
+
+  GEODE_CORE_EXPORT Array<SymmetricMatrix<T,TV::m>> diagonal_blocks() const;
 };
 
 }
@@ -113,7 +113,7 @@ multiply_helper(RawArray<const TV> x,RawArray<TV> result) const
 {
     const int rows = this->rows();
     GEODE_ASSERT(columns()<=x.size() && rows<=result.size());
-    RawArray<const int> offsets = J.offsets;
+    RawArray<const index_t> offsets = J.offsets;
     RawArray<const int> J_flat = J.flat;
     RawArray<const T> A_flat = A.flat;
     for(int i=0;i<rows;i++){
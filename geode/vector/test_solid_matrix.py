@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+
+from __future__ import division
+from geode import *
+from numpy import *
+import sys
+
+def random_solid_matrix(d,n,degree,outers=True):
+  structure = SolidMatrixStructure(n)
+  edges = random.randint(n,size=(degree*n,2))
+  for i,j in edges:
+    structure.add_entry(i,j)
+  nodes = [random.randint(n,size=5) for _ in xrange(2 if outers else 0)]
+  for o in nodes:
+    structure.add_outer(1,o)
+  A = SolidMatrix[d](structure)
+  for i,j in edges:
+    A.add_entry(i,j,random.randn(d,d))
+  A.add_diagonal_scalars(random.rand(n))
+  for o in nodes:
+    A.add_outer(random.randn(),random.randn(len(o),d))
+  return A
+
+def test_block_matrix(benchmark=False):
+  random.seed(7131)
+  for d in 2,3:
+    n = 200000 if benchmark else 50
+    A = random_solid_matrix(d,n,6 if benchmark else 3,outers=not benchmark)
+    B = SolidBlockMatrix[d](A)
+    x = random.randn(n,d)
+    y = empty_like(x)
+    z = empty_like(x)
+    with Log.scope('SolidMatrix%dd multiply'%d):
+      for _ in xrange(20 if benchmark else 1):
+        A.multiply(x,y)
+    with Log.scope('SolidBlockMatrix%dd multiply'%d):
+      for _ in xrange(20 if benchmark else 1):
+        B.multiply(x,z)
+    assert relative_error(y,z)<1e-12
+    if not benchmark:
+      assert relative_error(dot(A.dense(),x.ravel()),z.ravel())<1e-12
+      assert relative_error(A.diagonal_blocks(),B.diagonal_blocks())<1e-12
+
+    # Several right hand sides at once
+    r = 4
+    X = random.randn(n,r,d)
+    Y = empty_like(X)
+    with Log.scope('SolidBlockMatrix%dd multiply_multiple, %d vectors'%(d,r)):
+      for _ in xrange(20 if benchmark else 1):
+        B.multiply_multiple(X,Y)
+    for s in xrange(r):
+      B.multiply(X[:,s].copy(),z)
+      assert relative_error(Y[:,s],z)<1e-12
+
+    # Updating values in place matches rebuilding
+    A.scale(-2)
+    A.add_scalar(3)
+    B.update(A)
+    A.multiply(x,y)
+    B.multiply(x,z)
+    assert relative_error(y,z)<1e-12
+
+if __name__=='__main__':
+  Log.configure('solid matrix',0,0,100)
+  test_block_matrix(benchmark='-b' in sys.argv)